@@ -0,0 +1,350 @@
+#include "allocStats.h"
+
+#ifdef EXPRIVIA_ALLOC_STATS
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+#if defined(__GLIBC__)
+#include <malloc.h>
+#define ALLOC_STATS_WRAP_C_ALLOCATOR
+#endif
+
+
+//------------------------------------------------------------------------------
+// Recording data
+//------------------------------------------------------------------------------
+// Everything here is constant initialized: allocations happen before main()
+// and after the static destructors too.
+//------------------------------------------------------------------------------
+namespace {
+
+enum {
+    cMaxPhases = 16,
+    cMaxSites = 64,
+};
+
+struct AtomicCounters {
+    std::atomic<uint64_t> allocations;
+    std::atomic<uint64_t> bytes;
+
+    inline void add(size_t size){
+        allocations.fetch_add(1,std::memory_order_relaxed);
+        bytes.fetch_add(size,std::memory_order_relaxed);
+    }
+};
+
+template<int N>
+struct CounterTable {
+    const char *names[N];   // [0] is the implicit "not in any scope" entry
+    AtomicCounters counters[N];
+    int count;              // registered entries, guarded by registerMutex
+};
+
+CounterTable<cMaxPhases> phaseTable;
+CounterTable<cMaxSites> siteTable;
+std::atomic<uint64_t> frees;
+std::atomic<uint64_t> freedBytes;
+std::mutex registerMutex;
+
+thread_local int currentPhase;
+thread_local int currentSite;
+thread_local uint64_t threadAllocations;
+thread_local uint64_t threadBytes;
+
+//------------------------------------------------------------------------------
+template<int N>
+int registerName(CounterTable<N>& table, const char *name){
+    std::lock_guard<std::mutex> lock(registerMutex);
+    for(int i=1;i<=table.count;++i)
+        if(!strcmp(table.names[i],name))
+            return i;
+    if(table.count+1>=N)
+        return 0;
+    table.names[++table.count] = name;
+    return table.count;
+}
+//------------------------------------------------------------------------------
+template<int N>
+std::vector<AllocStats::NamedCounters> snapshot(const CounterTable<N>& table,
+                                                const char *unscopedName)
+{
+    std::vector<AllocStats::NamedCounters> result;
+    std::lock_guard<std::mutex> lock(registerMutex);
+    for(int i=0;i<=table.count;++i){
+        AllocStats::NamedCounters named;
+        named.name = i ? table.names[i] : unscopedName;
+        named.counters.allocations = table.counters[i].allocations.load();
+        named.counters.bytes = table.counters[i].bytes.load();
+        if(named.counters.allocations)
+            result.push_back(named);
+    }
+    return result;
+}
+//------------------------------------------------------------------------------
+std::mutex& stationMutex(){
+    static std::mutex mutex;
+    return mutex;
+}
+//------------------------------------------------------------------------------
+std::vector<AllocStats::StationCounters>& stationRecords(){
+    static std::vector<AllocStats::StationCounters> records;
+    return records;
+}
+//------------------------------------------------------------------------------
+
+} // namespace
+
+
+//------------------------------------------------------------------------------
+// class AllocStats implementation
+//------------------------------------------------------------------------------
+// Scopes
+//------------------------------------------------------------------------------
+AllocStats::PhaseScope::PhaseScope(int phaseId) : _previous(currentPhase){
+    currentPhase = phaseId;
+}
+//------------------------------------------------------------------------------
+AllocStats::PhaseScope::~PhaseScope(){
+    currentPhase = _previous;
+}
+//------------------------------------------------------------------------------
+AllocStats::SiteScope::SiteScope(int siteId) : _previous(currentSite){
+    currentSite = siteId;
+}
+//------------------------------------------------------------------------------
+AllocStats::SiteScope::~SiteScope(){
+    currentSite = _previous;
+}
+//------------------------------------------------------------------------------
+AllocStats::StationScope::StationScope(uint32_t serial) : _serial(serial),
+    _allocations(threadAllocations),_bytes(threadBytes)
+{
+}
+//------------------------------------------------------------------------------
+AllocStats::StationScope::~StationScope(){
+    StationCounters station;
+    station.serial = _serial;
+    station.allocations = threadAllocations-_allocations;
+    station.bytes = threadBytes-_bytes;
+
+    std::lock_guard<std::mutex> lock(stationMutex());
+    stationRecords().push_back(station);
+}
+//------------------------------------------------------------------------------
+// Accessors
+//------------------------------------------------------------------------------
+bool AllocStats::wrapsCAllocator(){
+#ifdef ALLOC_STATS_WRAP_C_ALLOCATOR
+    return true;
+#else
+    return false;
+#endif
+}
+//------------------------------------------------------------------------------
+AllocStats::Counters AllocStats::total(){
+    Counters result;
+    for(int i=0;i<cMaxPhases;++i){
+        result.allocations += phaseTable.counters[i].allocations.load();
+        result.bytes += phaseTable.counters[i].bytes.load();
+    }
+    result.frees = frees.load();
+    result.freedBytes = freedBytes.load();
+    return result;
+}
+//------------------------------------------------------------------------------
+std::vector<AllocStats::NamedCounters> AllocStats::phases(){
+    return snapshot(phaseTable,"(other)");
+}
+//------------------------------------------------------------------------------
+std::vector<AllocStats::NamedCounters> AllocStats::topSites(size_t maxCount){
+    std::vector<NamedCounters> sites = snapshot(siteTable,"(unattributed)");
+    std::sort(sites.begin(),sites.end(),
+              [](const NamedCounters& a, const NamedCounters& b){
+                  return a.counters.bytes>b.counters.bytes;
+              });
+    if(sites.size()>maxCount)
+        sites.resize(maxCount);
+    return sites;
+}
+//------------------------------------------------------------------------------
+std::vector<AllocStats::StationCounters> AllocStats::stations(){
+    std::lock_guard<std::mutex> lock(stationMutex());
+    return stationRecords();
+}
+//------------------------------------------------------------------------------
+uint64_t AllocStats::peakRSS(){
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if(GetProcessMemoryInfo(GetCurrentProcess(),&counters,sizeof(counters)))
+        return counters.PeakWorkingSetSize;
+    return 0;
+#else
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF,&usage))
+        return 0;
+#if defined(__APPLE__)
+    return uint64_t(usage.ru_maxrss);
+#else
+    return uint64_t(usage.ru_maxrss)*1024; // KiB
+#endif
+#endif
+}
+//------------------------------------------------------------------------------
+// Methods
+//------------------------------------------------------------------------------
+int AllocStats::registerPhase(const char *name){
+    return registerName(phaseTable,name);
+}
+//------------------------------------------------------------------------------
+int AllocStats::registerSite(const char *name){
+    return registerName(siteTable,name);
+}
+//------------------------------------------------------------------------------
+void AllocStats::recordAllocation(size_t bytes){
+    phaseTable.counters[currentPhase].add(bytes);
+    siteTable.counters[currentSite].add(bytes);
+    ++threadAllocations;
+    threadBytes += bytes;
+}
+//------------------------------------------------------------------------------
+void AllocStats::recordFree(size_t bytes){
+    frees.fetch_add(1,std::memory_order_relaxed);
+    freedBytes.fetch_add(bytes,std::memory_order_relaxed);
+}
+//------------------------------------------------------------------------------
+
+
+#ifdef ALLOC_STATS_WRAP_C_ALLOCATOR
+//------------------------------------------------------------------------------
+// C allocator wrappers (glibc)
+//------------------------------------------------------------------------------
+// glibc supports replacing malloc & co. in the executable; operator new and
+// Qt's container data end up here. Sizes are the usable sizes, so that the
+// live byte count (bytes-freedBytes) is exact.
+//------------------------------------------------------------------------------
+extern "C" {
+
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void __libc_free(void *ptr);
+
+//------------------------------------------------------------------------------
+void *malloc(size_t size){
+    void *ptr = __libc_malloc(size);
+    if(ptr)
+        AllocStats::recordAllocation(malloc_usable_size(ptr));
+    return ptr;
+}
+//------------------------------------------------------------------------------
+void *calloc(size_t count, size_t size){
+    void *ptr = __libc_calloc(count,size);
+    if(ptr)
+        AllocStats::recordAllocation(malloc_usable_size(ptr));
+    return ptr;
+}
+//------------------------------------------------------------------------------
+void *realloc(void *ptr, size_t size){
+    size_t oldSize = ptr ? malloc_usable_size(ptr) : 0;
+    void *newPtr = __libc_realloc(ptr,size);
+    if(newPtr){
+        if(ptr)
+            AllocStats::recordFree(oldSize);
+        AllocStats::recordAllocation(malloc_usable_size(newPtr));
+    }else if(ptr && !size)
+        AllocStats::recordFree(oldSize); // realloc(ptr,0) frees
+    return newPtr;
+}
+//------------------------------------------------------------------------------
+void *memalign(size_t alignment, size_t size){
+    void *ptr = __libc_memalign(alignment,size);
+    if(ptr)
+        AllocStats::recordAllocation(malloc_usable_size(ptr));
+    return ptr;
+}
+//------------------------------------------------------------------------------
+void *aligned_alloc(size_t alignment, size_t size){
+    return memalign(alignment,size);
+}
+//------------------------------------------------------------------------------
+int posix_memalign(void **ptr, size_t alignment, size_t size){
+    if(!alignment || (alignment & (alignment-1)) || alignment%sizeof(void *))
+        return EINVAL;
+    void *result = memalign(alignment,size);
+    if(!result)
+        return ENOMEM;
+    *ptr = result;
+    return 0;
+}
+//------------------------------------------------------------------------------
+void free(void *ptr){
+    if(ptr){
+        AllocStats::recordFree(malloc_usable_size(ptr));
+        __libc_free(ptr);
+    }
+}
+//------------------------------------------------------------------------------
+
+} // extern "C"
+
+#else
+//------------------------------------------------------------------------------
+// operator new/delete replacements (other C libraries)
+//------------------------------------------------------------------------------
+void *operator new(std::size_t size){
+    void *ptr = std::malloc(size ? size : 1);
+    if(!ptr)
+        throw std::bad_alloc();
+    AllocStats::recordAllocation(size);
+    return ptr;
+}
+//------------------------------------------------------------------------------
+void *operator new[](std::size_t size){
+    return operator new(size);
+}
+//------------------------------------------------------------------------------
+void *operator new(std::size_t size, const std::nothrow_t&) noexcept{
+    void *ptr = std::malloc(size ? size : 1);
+    if(ptr)
+        AllocStats::recordAllocation(size);
+    return ptr;
+}
+//------------------------------------------------------------------------------
+void *operator new[](std::size_t size, const std::nothrow_t& tag) noexcept{
+    return operator new(size,tag);
+}
+//------------------------------------------------------------------------------
+void operator delete(void *ptr) noexcept{
+    if(ptr){
+        AllocStats::recordFree(0);
+        std::free(ptr);
+    }
+}
+//------------------------------------------------------------------------------
+void operator delete[](void *ptr) noexcept{
+    operator delete(ptr);
+}
+//------------------------------------------------------------------------------
+void operator delete(void *ptr, std::size_t) noexcept{
+    operator delete(ptr);
+}
+//------------------------------------------------------------------------------
+void operator delete[](void *ptr, std::size_t) noexcept{
+    operator delete(ptr);
+}
+//------------------------------------------------------------------------------
+#endif // ALLOC_STATS_WRAP_C_ALLOCATOR
+
+#endif // EXPRIVIA_ALLOC_STATS
@@ -0,0 +1,111 @@
+#ifndef ALLOCSTATS_H
+#define ALLOCSTATS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+//------------------------------------------------------------------------------
+// class AllocStats
+//------------------------------------------------------------------------------
+// Heap allocation accounting, compiled in with EXPRIVIA_ALLOC_STATS.
+// Every allocation is charged to the current phase and site of the calling
+// thread (see the ALLOC_STATS_* scope macros below); station scopes record
+// the allocations done while a station was being checked. With glibc the
+// C allocator itself is wrapped, so Qt's QString/QByteArray data is counted
+// too; elsewhere only operator new/delete are.
+//
+// The recording path uses atomics and plain thread locals only: it never
+// allocates and costs a few uncontended atomic increments per allocation.
+// Without EXPRIVIA_ALLOC_STATS the macros expand to nothing.
+//------------------------------------------------------------------------------
+class AllocStats
+{
+    public:
+        // Types
+        struct Counters {
+            inline Counters() : allocations(0), bytes(0), frees(0),
+                                freedBytes(0) {}
+
+            uint64_t allocations;
+            uint64_t bytes;
+            uint64_t frees;
+            uint64_t freedBytes; // only known when the C allocator is wrapped
+        };
+        struct NamedCounters {
+            const char *name;
+            Counters counters;
+        };
+        struct StationCounters {
+            uint32_t serial;
+            uint64_t allocations;
+            uint64_t bytes;
+        };
+        class PhaseScope {
+        public:
+            explicit PhaseScope(int phaseId);
+            ~PhaseScope();
+        private:
+            int _previous;
+        };
+        class SiteScope {
+        public:
+            explicit SiteScope(int siteId);
+            ~SiteScope();
+        private:
+            int _previous;
+        };
+        class StationScope {
+        public:
+            explicit StationScope(uint32_t serial);
+            ~StationScope();
+        private:
+            uint32_t _serial;
+            uint64_t _allocations;
+            uint64_t _bytes;
+        };
+        // Accessors
+        static bool wrapsCAllocator();
+        static Counters total();
+        static std::vector<NamedCounters> phases();
+        static std::vector<NamedCounters> topSites(size_t maxCount);
+        static std::vector<StationCounters> stations();
+        static uint64_t peakRSS(); // bytes, 0 if unknown
+        // Methods
+        static int registerPhase(const char *name);
+        static int registerSite(const char *name);
+        static void recordAllocation(size_t bytes);
+        static void recordFree(size_t bytes);
+    private:
+        // Private constructor (unimplemented!)
+        AllocStats();
+};
+
+
+//------------------------------------------------------------------------------
+// Scope macros: 'name' must be a string literal (kept by pointer)
+//------------------------------------------------------------------------------
+#define ALLOC_STATS_CONCAT2(a,b) a##b
+#define ALLOC_STATS_CONCAT(a,b) ALLOC_STATS_CONCAT2(a,b)
+
+#ifdef EXPRIVIA_ALLOC_STATS
+#define ALLOC_STATS_PHASE(name) \
+    static const int ALLOC_STATS_CONCAT(allocStatsPhaseId,__LINE__) = \
+        AllocStats::registerPhase(name); \
+    AllocStats::PhaseScope ALLOC_STATS_CONCAT(allocStatsPhase,__LINE__)( \
+        ALLOC_STATS_CONCAT(allocStatsPhaseId,__LINE__))
+#define ALLOC_STATS_SITE(name) \
+    static const int ALLOC_STATS_CONCAT(allocStatsSiteId,__LINE__) = \
+        AllocStats::registerSite(name); \
+    AllocStats::SiteScope ALLOC_STATS_CONCAT(allocStatsSite,__LINE__)( \
+        ALLOC_STATS_CONCAT(allocStatsSiteId,__LINE__))
+#define ALLOC_STATS_STATION(serial) \
+    AllocStats::StationScope ALLOC_STATS_CONCAT(allocStatsStation,__LINE__)(serial)
+#else
+#define ALLOC_STATS_PHASE(name)
+#define ALLOC_STATS_SITE(name)
+#define ALLOC_STATS_STATION(serial)
+#endif
+
+#endif // ALLOCSTATS_H
@@ -0,0 +1,474 @@
+#include "configurationCheck.h"
+
+#include "allocStats.h"
+#include "checkEngine.h"
+#include "probeSheetReader.h"
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QProcess>
+#include <QTextStream>
+#include <QVector>
+#include <QtTest>
+
+
+//------------------------------------------------------------------------------
+// class CheckKernelsBench
+//------------------------------------------------------------------------------
+// QBENCHMARK suite of the per row and per element routines of
+// ConfigurationCheck, fed with the project's probe sheet CSV and the station
+// files of 'stations'. Besides Qt Test's own report, every benchmark records
+// ns/op and allocations/op (through AllocStats) of all the QBENCHMARK
+// iterations; the results are saved as JSON and, given a previous results
+// file (--baseline), compared with it.
+//------------------------------------------------------------------------------
+class CheckKernelsBench : public QObject
+{
+    Q_OBJECT
+    public:
+        // Constructor
+        CheckKernelsBench(const QString& jsonFilename,
+                          const QString& baselineFilename);
+    private slots:
+        void initTestCase();
+        void readCSVRow();
+        void ipValueAssign();
+        void ipValueToString();
+        void ipPortToXmlCodedString();
+        void engineCheck();
+        void isParameterValueValid();
+        void cleanupTestCase();
+    private:
+        // Types
+        typedef ConfigurationCheck CC_t;
+        struct Result {
+            QString name;
+            qint64 operations;
+            double nsPerOp;
+            double allocationsPerOp;
+            double bytesPerOp;
+        };
+        class Measurement;
+        class FindingCounter;
+        struct Station {
+            const ProbeConfig *probeConfig;
+            QByteArray data;
+        };
+        struct CheckedValue {
+            const ProbeConfig *probeConfig;
+            const CC_t::ProbeParameterDef *paramDef;
+            QString value;
+            bool firstOfStation;
+        };
+        // Data
+        QString _jsonFilename;
+        QString _baselineFilename;
+        CC_t _check;
+        QByteArray _csvData;
+        int _csvRowCount;
+        QVector<QString> _dottedQuads;
+        QVector<IPValue> _ipValues;
+        QVector<IPPort> _ipPorts;
+        QVector<Station> _stations;
+        QVector<CheckedValue> _checkedValues;
+        QVector<Result> _results;
+        // Helpers
+        void loadStation(const QString& filename,
+                         const ProbeConfig *probeConfig);
+        void addResult(const Result& result);
+        static QString gitRevision(const QString& rootPath);
+};
+
+
+//------------------------------------------------------------------------------
+// class CheckKernelsBench::Measurement
+//------------------------------------------------------------------------------
+// Time and allocations of all the iterations of one QBENCHMARK block, each
+// doing 'operations' operations.
+//------------------------------------------------------------------------------
+class CheckKernelsBench::Measurement
+{
+    public:
+        // Constructor
+        Measurement(CheckKernelsBench& bench, const char *name,
+                    qint64 operations) :
+            _bench(bench),_name(name),_operations(operations),_iterations(0),
+            _start(AllocStats::total())
+        {
+            _timer.start();
+        }
+        // Methods
+        inline void countIteration() { ++_iterations; }
+        void finish(){
+            qint64 ns = _timer.nsecsElapsed();
+            AllocStats::Counters end = AllocStats::total();
+            double operations = double(qMax<qint64>(1,_iterations*_operations));
+            Result result;
+            result.name = _name;
+            result.operations = _iterations*_operations;
+            result.nsPerOp = double(ns)/operations;
+            result.allocationsPerOp = double(end.allocations-_start.allocations)/
+                                      operations;
+            result.bytesPerOp = double(end.bytes-_start.bytes)/operations;
+            _bench.addResult(result);
+        }
+    private:
+        // Data
+        CheckKernelsBench& _bench;
+        const char *_name;
+        qint64 _operations;
+        qint64 _iterations;
+        AllocStats::Counters _start;
+        QElapsedTimer _timer;
+        // Private copy constructor and assignment (unimplemented!)
+        Measurement(const Measurement&);
+        Measurement& operator=(const Measurement&);
+};
+
+
+//------------------------------------------------------------------------------
+// class CheckKernelsBench::FindingCounter
+//------------------------------------------------------------------------------
+// Core engine findings counted, not logged.
+//------------------------------------------------------------------------------
+class CheckKernelsBench::FindingCounter : public CheckEngine::FindingSink
+{
+    public:
+        // Constructor
+        inline FindingCounter() : wrongValues(0), parseErrors(0) {}
+        // Methods
+        virtual void wrongValue(const CheckEngine::Finding& finding){
+            Q_UNUSED(finding)
+            ++wrongValues;
+        }
+        virtual void parseError(const char *reason, size_t offset){
+            Q_UNUSED(reason) Q_UNUSED(offset)
+            ++parseErrors;
+        }
+        // Public data
+        qint64 wrongValues;
+        qint64 parseErrors;
+};
+
+
+//------------------------------------------------------------------------------
+// class CheckKernelsBench implementation
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+CheckKernelsBench::CheckKernelsBench(const QString& jsonFilename,
+    const QString& baselineFilename) :
+    _jsonFilename(jsonFilename),_baselineFilename(baselineFilename),
+    _csvRowCount(0)
+{
+}
+//------------------------------------------------------------------------------
+// Slots
+//------------------------------------------------------------------------------
+void CheckKernelsBench::initTestCase(){
+    const QString& rootPath = _check.rootPath();
+    if(rootPath.isEmpty())
+        QFAIL("Cannot find expected directory tree project root.");
+
+    // Probe sheet: raw bytes for readCSVRow(), parsed rows for the rest
+    QFile csvFile(rootPath+CC_t::_csvFilename);
+    QVERIFY2(csvFile.open(QIODevice::ReadOnly),qPrintable(csvFile.fileName()));
+    _csvData = csvFile.readAll();
+    _check.setProbeSheetFilename(csvFile.fileName());
+    _check._inputXmlFilename = CC_t::inputXmlFilename();
+    try{
+        _check.readProbeSheet(_check._sheet,csvFile.fileName());
+    }catch(...){
+        QFAIL("Cannot read the probe sheet.");
+    }
+    {
+        QBuffer in(&_csvData);
+        in.open(QIODevice::ReadOnly | QIODevice::Text);
+        ProbeSheet sheet;
+        ProbeSheetReader reader(sheet);
+        QStringList row;
+        while(reader.readCSVRow(uint(_csvRowCount+1),in,row))
+            ++_csvRowCount;
+    }
+
+    for(QMap<CC_t::ProbeSerialNr_t,ProbeConfig>::const_iterator it=
+            _check._sheet.probes.constBegin();
+        it!=_check._sheet.probes.constEnd();
+        ++it)
+    {
+        _ipValues << it->ip << it->netmask << it->gateway;
+        _dottedQuads << it->ip.toString() << it->netmask.toString()
+                     << it->gateway.toString();
+    }
+
+    // Station files: their bytes and checked values, as the check pass
+    // locates them
+    QDirIterator dirs(rootPath+"stations",QDir::Dirs | QDir::NoDotAndDotDot);
+    while(dirs.hasNext()){
+        dirs.next();
+        QMap<CC_t::ProbeSerialNr_t,ProbeConfig>::const_iterator probe =
+            _check._sheet.probes.constFind(dirs.fileName().toUInt());
+        if(probe!=_check._sheet.probes.constEnd())
+            loadStation(dirs.filePath()+'/'+_check._inputXmlFilename,&*probe);
+    }
+    QVERIFY2(!_stations.isEmpty(),"No station file matching the probe sheet.");
+    qInfo() << _csvRowCount << "CSV rows," << _stations.size() << "stations,"
+            << _checkedValues.size() << "checked values," << _ipPorts.size()
+            << "ports.";
+}
+//------------------------------------------------------------------------------
+void CheckKernelsBench::readCSVRow(){
+    Measurement measurement(*this,"readCSVRow",_csvRowCount);
+    ProbeSheet sheet;
+    ProbeSheetReader reader(sheet);
+    QStringList row;
+    QBENCHMARK{
+        QBuffer in(&_csvData);
+        in.open(QIODevice::ReadOnly | QIODevice::Text);
+        uint lineNum = 0;
+        while(reader.readCSVRow(++lineNum,in,row))
+            ;
+        measurement.countIteration();
+    }
+    measurement.finish();
+}
+//------------------------------------------------------------------------------
+void CheckKernelsBench::ipValueAssign(){
+    Measurement measurement(*this,"IPValue::assign",_dottedQuads.size());
+    IPValue value;
+    int32_t sum = 0;
+    QBENCHMARK{
+        for(int i=0;i<_dottedQuads.size();++i){
+            value = _dottedQuads.at(i);
+            sum += value.toInt32();
+        }
+        measurement.countIteration();
+    }
+    measurement.finish();
+    QVERIFY(sum || _dottedQuads.isEmpty());
+}
+//------------------------------------------------------------------------------
+void CheckKernelsBench::ipValueToString(){
+    Measurement measurement(*this,"IPValue::toString",_ipValues.size());
+    int length = 0;
+    QBENCHMARK{
+        for(int i=0;i<_ipValues.size();++i)
+            length += _ipValues.at(i).toString().size();
+        measurement.countIteration();
+    }
+    measurement.finish();
+    QVERIFY(length || _ipValues.isEmpty());
+}
+//------------------------------------------------------------------------------
+void CheckKernelsBench::ipPortToXmlCodedString(){
+    Measurement measurement(*this,"IPPort::toXmlCodedString",_ipPorts.size());
+    int length = 0;
+    QBENCHMARK{
+        for(int i=0;i<_ipPorts.size();++i)
+            length += _ipPorts.at(i).toXmlCodedString().size();
+        measurement.countIteration();
+    }
+    measurement.finish();
+    QVERIFY(length || _ipPorts.isEmpty());
+}
+//------------------------------------------------------------------------------
+void CheckKernelsBench::engineCheck(){
+    // Per station: expected values and core engine check pass, as in
+    // checkStationWithEngine()
+    Measurement measurement(*this,"CheckEngine::check",_stations.size());
+    FindingCounter findings;
+    QBENCHMARK{
+        for(int i=0;i<_stations.size();++i){
+            const Station& station = _stations.at(i);
+            _check.setExpectations(_check._sheet,*station.probeConfig,_check._ruleGroups);
+            _check._engine.check(ByteView(station.data.constData(),
+                                          size_t(station.data.size())),
+                                 _check._expectations.constData(),findings);
+        }
+        measurement.countIteration();
+    }
+    measurement.finish();
+    QVERIFY(!findings.parseErrors);
+    qInfo() << findings.wrongValues << "wrong values met.";
+}
+//------------------------------------------------------------------------------
+void CheckKernelsBench::isParameterValueValid(){
+    // Per checked value: the comparison of an offset index hit
+    Measurement measurement(*this,"isParameterValueValid",_checkedValues.size());
+    CheckContext& context = _check._checkContext;
+    int wrong = 0;
+    QBENCHMARK{
+        for(int i=0;i<_checkedValues.size();++i){
+            const CheckedValue& checked = _checkedValues.at(i);
+            if(checked.firstOfStation)
+                context.beginStation(_check._checks.size());
+            if(!_check.isParameterValueValid(*checked.probeConfig,
+                                             *checked.paramDef,checked.value,
+                                             context))
+                ++wrong;
+        }
+        measurement.countIteration();
+    }
+    measurement.finish();
+    qInfo() << wrong << "wrong values met.";
+}
+//------------------------------------------------------------------------------
+void CheckKernelsBench::cleanupTestCase(){
+    QJsonArray results;
+    for(int i=0;i<_results.size();++i){
+        const Result& result = _results.at(i);
+        QJsonObject object;
+        object["name"] = result.name;
+        object["operations"] = double(result.operations);
+        object["ns_per_op"] = result.nsPerOp;
+        object["allocs_per_op"] = result.allocationsPerOp;
+        object["bytes_per_op"] = result.bytesPerOp;
+        results.append(object);
+    }
+    QJsonObject root;
+    root["revision"] = gitRevision(_check.rootPath());
+    root["date"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    root["qt"] = QString(qVersion());
+    root["alloc_stats_wraps_c_allocator"] = AllocStats::wrapsCAllocator();
+    root["results"] = results;
+
+    QFile jsonFile(_jsonFilename);
+    if(!jsonFile.open(QIODevice::Truncate | QIODevice::WriteOnly) ||
+       jsonFile.write(QJsonDocument(root).toJson())<0)
+        qCritical() << "Cannot write benchmark results" << _jsonFilename;
+    else
+        qInfo() << "Benchmark results written to" << _jsonFilename;
+
+    // Side by side with a previous run
+    QTextStream out(stdout);
+    QMap<QString,QJsonObject> baseline;
+    QString baselineRevision;
+    if(!_baselineFilename.isEmpty()){
+        QFile baselineFile(_baselineFilename);
+        QJsonObject baselineRoot;
+        if(baselineFile.open(QIODevice::ReadOnly))
+            baselineRoot = QJsonDocument::fromJson(baselineFile.readAll()).object();
+        if(baselineRoot.isEmpty())
+            qCritical() << "Cannot read baseline results" << _baselineFilename;
+        baselineRevision = baselineRoot["revision"].toString();
+        QJsonArray baselineResults = baselineRoot["results"].toArray();
+        for(int i=0;i<baselineResults.size();++i){
+            QJsonObject object = baselineResults.at(i).toObject();
+            baseline.insert(object["name"].toString(),object);
+        }
+    }
+    out << QString("%1 %2 %3 %4\n").arg("benchmark",-28).arg("ns/op",12)
+                                   .arg("allocs/op",10).arg("bytes/op",10);
+    for(int i=0;i<_results.size();++i){
+        const Result& result = _results.at(i);
+        out << QString("%1 %2 %3 %4").arg(result.name,-28)
+                                     .arg(result.nsPerOp,12,'f',2)
+                                     .arg(result.allocationsPerOp,10,'f',2)
+                                     .arg(result.bytesPerOp,10,'f',1);
+        QMap<QString,QJsonObject>::const_iterator it = baseline.constFind(result.name);
+        if(it!=baseline.constEnd()){
+            double baselineNs = (*it)["ns_per_op"].toDouble();
+            out << QString("   %1: %2 ns/op (%3%4%), %5 allocs/op")
+                       .arg(baselineRevision.isEmpty() ? QString("baseline")
+                                                       : baselineRevision)
+                       .arg(baselineNs,0,'f',2)
+                       .arg(result.nsPerOp>=baselineNs ? "+" : "")
+                       .arg(baselineNs>0 ? 100.0*(result.nsPerOp-baselineNs)/baselineNs
+                                         : 0.0,0,'f',1)
+                       .arg((*it)["allocs_per_op"].toDouble(),0,'f',2);
+        }
+        out << '\n';
+    }
+    out.flush();
+}
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+void CheckKernelsBench::loadStation(const QString& filename,
+    const ProbeConfig *probeConfig)
+{
+    QFile file(filename);
+    if(!file.open(QIODevice::ReadOnly))
+        return;
+    Station station = { probeConfig, file.readAll() };
+    _stations.append(station);
+
+    // Values whose bytes are the value itself, as the offset index keeps them
+    ByteView document(station.data.constData(),size_t(station.data.size()));
+    FindingCounter findings;
+    _check.setExpectations(_check._sheet,*probeConfig,_check._ruleGroups);
+    if(!_check._engine.check(document,_check._expectations.constData(),findings))
+        return;
+    const std::vector<CheckEngine::Location>& locations = _check._engine.locations();
+    bool firstOfStation = true;
+    for(int i=0;i<int(locations.size());++i){
+        const CheckEngine::Location& location = locations[size_t(i)];
+        if(location.checkIndex!=i || !location.verbatim)
+            continue;
+        CheckedValue checked = { probeConfig, _check._checksByIndex.at(i),
+                                 QString::fromUtf8(document.data()+location.offset,
+                                                   int(location.length)),
+                                 firstOfStation };
+        _checkedValues.append(checked);
+        firstOfStation = false;
+        if(checked.paramDef->name.endsWith("Port"))
+            _ipPorts.append(IPPort(checked.value));
+    }
+}
+//------------------------------------------------------------------------------
+void CheckKernelsBench::addResult(const Result& result){
+    // Qt Test may call a benchmark more than once: the last run counts
+    for(int i=0;i<_results.size();++i)
+        if(_results.at(i).name==result.name){
+            _results[i] = result;
+            return;
+        }
+    _results.append(result);
+}
+//------------------------------------------------------------------------------
+QString CheckKernelsBench::gitRevision(const QString& rootPath){
+    QProcess git;
+    git.setWorkingDirectory(rootPath);
+    git.start("git",QStringList() << "rev-parse" << "--short" << "HEAD");
+    if(!git.waitForFinished(5000) || git.exitCode())
+        return QString();
+    return QString::fromLatin1(git.readAllStandardOutput()).trimmed();
+}
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+// main
+//------------------------------------------------------------------------------
+// checkKernelsBench [--json FILE] [--baseline FILE] [Qt Test options]
+//------------------------------------------------------------------------------
+int main(int argc, char *argv[]){
+    QCoreApplication app(argc,argv);
+
+    QStringList args = app.arguments();
+    QString jsonFilename = "checkKernelsBench.json", baselineFilename;
+    for(int i=1;i+1<args.size();){
+        if(args.at(i)=="--json")
+            jsonFilename = args.at(i+1);
+        else if(args.at(i)=="--baseline")
+            baselineFilename = args.at(i+1);
+        else{
+            ++i;
+            continue;
+        }
+        args.removeAt(i);
+        args.removeAt(i);
+    }
+
+    CheckKernelsBench bench(jsonFilename,baselineFilename);
+    return QTest::qExec(&bench,args);
+}
+
+#include "checkKernelsBench.moc"
@@ -0,0 +1,69 @@
+# Qt Test (QBENCHMARK) micro-benchmarks of the ConfigurationCheck hot
+# routines, fed with the probe sheet CSV and the station files of the project.
+# Built in release mode by ../qMiraProbeXMLCheckAll.pro, after the core
+# library it links; run from its build directory, e.g.:
+#   ./checkKernelsBench --json new.json --baseline old.json
+# ns/op, allocations/op and bytes/op go to checkKernelsBench.json (--json).
+
+QT += core xml widgets testlib
+CONFIG += console c++14 release
+CONFIG -= app_bundle
+
+TARGET = checkKernelsBench
+
+# Same check switches as ../qMiraProbeXMLCheck.pro, plus the allocation
+# accounting needed for allocations/op
+DEFINES += EXPRIVIA_CHECK_TIME_INTERVALS
+DEFINES += EXPRIVIA_ALLOC_STATS
+win32: LIBS += -lpsapi
+
+INCLUDEPATH += ..
+
+SOURCES += \
+        checkKernelsBench.cpp \
+        ../allocStats.cpp \
+        ../bumpArena.cpp \
+        ../checkContext.cpp \
+        ../checkProfile.cpp \
+        ../configurationCheck.cpp \
+        ../findingSummary.cpp \
+        ../inflater.cpp \
+        ../ioRing.cpp \
+        ../ipPlan.cpp \
+        ../pluginHost.cpp \
+        ../probeSheet.cpp \
+        ../probeSheetReader.cpp \
+        ../sampleAudit.cpp \
+        ../startupSnapshot.cpp \
+        ../stationIO.cpp \
+        ../stationManifest.cpp \
+        ../stationOffsetIndex.cpp \
+        ../stationTemplate.cpp \
+        ../traceRecorder.cpp \
+        ../typedValidator.cpp \
+        ../xlsxReader.cpp
+
+HEADERS += \
+        ../allocStats.h \
+        ../bumpArena.h \
+        ../checkContext.h \
+        ../checkProfile.h \
+        ../configurationCheck.h \
+        ../findingSummary.h \
+        ../inflater.h \
+        ../ioRing.h \
+        ../ipPlan.h \
+        ../pluginHost.h \
+        ../probeSheet.h \
+        ../probeSheetReader.h \
+        ../sampleAudit.h \
+        ../startupSnapshot.h \
+        ../stationIO.h \
+        ../stationManifest.h \
+        ../stationOffsetIndex.h \
+        ../stationTemplate.h \
+        ../traceRecorder.h \
+        ../typedValidator.h \
+        ../xlsxReader.h
+
+include(../core/core.pri)
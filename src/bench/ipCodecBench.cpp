@@ -0,0 +1,108 @@
+#include "ipCodec.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+
+//------------------------------------------------------------------------------
+// IPCodec micro-benchmark
+//------------------------------------------------------------------------------
+// Reports nanoseconds per operation of the conversions done for every CSV cell
+// and every checked XML element. 'sink' keeps the optimizer from dropping the
+// loops.
+//------------------------------------------------------------------------------
+namespace {
+
+volatile uint32_t sink;
+
+//------------------------------------------------------------------------------
+template<typename Fn>
+void bench(const char *name, size_t operations, Fn fn){
+    fn(); // Warm up
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto elapsed = std::chrono::steady_clock::now()-start;
+    double ns = double(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           elapsed).count());
+    std::printf("%-28s %10zu ops %8.2f ns/op\n",name,operations,ns/operations);
+}
+//------------------------------------------------------------------------------
+
+} // namespace
+
+//------------------------------------------------------------------------------
+int main(){
+    const size_t cCount = 100000;
+
+    std::vector<std::string> dottedQuads, xmlIPv4s, xmlPorts;
+    std::string csv;
+    dottedQuads.reserve(cCount);
+    xmlIPv4s.reserve(cCount);
+    xmlPorts.reserve(cCount);
+    for(size_t i=0;i<cCount;++i){
+        uint32_t addr = 0xC0A80000u+uint32_t(i*2654435761u % 0x3FFFFFu);
+        char buffer[IPCodec::cMaxDottedQuadLength];
+        dottedQuads.emplace_back(buffer,IPCodec::formatDottedQuad(addr,buffer));
+        xmlIPv4s.emplace_back(buffer,IPCodec::formatXmlIPv4(addr,buffer));
+        xmlPorts.emplace_back(buffer,IPCodec::formatXmlPort(uint32_t(i%65536),buffer));
+        csv += "S" + std::to_string(i) + ",\"Station\"," + dottedQuads.back() +
+               ",255.255.255.0\n";
+    }
+
+    bench("parseDottedQuad",cCount,[&]{
+        uint32_t acc = 0, addr = 0;
+        for(const std::string& s : dottedQuads){
+            IPCodec::parseDottedQuad(s.data(),s.data()+s.size(),addr);
+            acc += addr;
+        }
+        sink = acc;
+    });
+    bench("formatDottedQuad",cCount,[&]{
+        char buffer[IPCodec::cMaxDottedQuadLength];
+        uint32_t acc = 0;
+        for(size_t i=0;i<cCount;++i)
+            acc += uint32_t(IPCodec::formatDottedQuad(uint32_t(i*2654435761u),buffer));
+        sink = acc;
+    });
+    bench("parseXmlIPv4",cCount,[&]{
+        uint32_t acc = 0, addr = 0;
+        for(const std::string& s : xmlIPv4s){
+            IPCodec::parseXmlIPv4(s.data(),s.data()+s.size(),addr);
+            acc += addr;
+        }
+        sink = acc;
+    });
+    bench("formatXmlIPv4",cCount,[&]{
+        char buffer[IPCodec::cMaxInt32Length];
+        uint32_t acc = 0;
+        for(size_t i=0;i<cCount;++i)
+            acc += uint32_t(IPCodec::formatXmlIPv4(uint32_t(i*2654435761u),buffer));
+        sink = acc;
+    });
+    bench("parseXmlPort",cCount,[&]{
+        uint32_t acc = 0, port = 0;
+        for(const std::string& s : xmlPorts){
+            IPCodec::parseXmlPort(s.data(),s.data()+s.size(),port);
+            acc += port;
+        }
+        sink = acc;
+    });
+    bench("formatXmlPort",cCount,[&]{
+        char buffer[IPCodec::cMaxUInt32Length];
+        uint32_t acc = 0;
+        for(size_t i=0;i<cCount;++i)
+            acc += uint32_t(IPCodec::formatXmlPort(uint32_t(i%65536),buffer));
+        sink = acc;
+    });
+
+    std::vector<uint32_t> column(cCount);
+    bench("parseCSVColumn (per row)",cCount,[&]{
+        size_t rows = IPCodec::parseCSVColumn(csv.data(),csv.data()+csv.size(),2,
+                                              column.data(),column.size());
+        sink = uint32_t(rows)+column[rows/2];
+    });
+    return 0;
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,13 @@
+# Micro-benchmark of the IPCodec conversions (no Qt needed).
+# Build and run in release mode: qmake && make && ./ipCodecBench
+
+CONFIG += console c++14 release
+CONFIG -= qt app_bundle
+
+INCLUDEPATH += ../core
+
+SOURCES += \
+        ipCodecBench.cpp
+
+HEADERS += \
+        ../core/ipCodec.h
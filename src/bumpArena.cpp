@@ -0,0 +1,82 @@
+#include "bumpArena.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+
+//------------------------------------------------------------------------------
+// class BumpArena implementation
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+BumpArena::BumpArena(size_t chunkSize) : _chunkSize(chunkSize), _capacity(0),
+    _first(nullptr), _current(nullptr), _next(nullptr)
+{
+}
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+BumpArena::~BumpArena(){
+    while(_first){
+        Chunk *next = _first->next;
+        std::free(_first);
+        _first = next;
+    }
+}
+//------------------------------------------------------------------------------
+// Methods
+//------------------------------------------------------------------------------
+void *BumpArena::allocate(size_t size, size_t alignment){
+    if(_current){
+        char *ptr = align(_next,alignment);
+        if(ptr<=_current->end() && size_t(_current->end()-ptr)>=size){
+            _next = ptr+size;
+            return ptr;
+        }
+    }
+    return allocateSlow(size,alignment);
+}
+//------------------------------------------------------------------------------
+void BumpArena::reset(){
+    _current = _first;
+    _next = _first ? _first->begin() : nullptr;
+}
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+char *BumpArena::align(char *ptr, size_t alignment){
+    uintptr_t addr = reinterpret_cast<uintptr_t>(ptr);
+    return ptr+((alignment-addr%alignment)%alignment);
+}
+//------------------------------------------------------------------------------
+void *BumpArena::allocateSlow(size_t size, size_t alignment){
+    // Move on to the chunks kept from before the last reset first
+    while(_current && _current->next){
+        _current = _current->next;
+        _next = _current->begin();
+        char *ptr = align(_next,alignment);
+        if(size_t(_current->end()-ptr)>=size){
+            _next = ptr+size;
+            return ptr;
+        }
+    }
+
+    size_t chunkSize = size+alignment>_chunkSize ? size+alignment : _chunkSize;
+    Chunk *chunk = static_cast<Chunk *>(std::malloc(sizeof(Chunk)+chunkSize));
+    if(!chunk)
+        throw std::bad_alloc();
+    chunk->next = nullptr;
+    chunk->size = chunkSize;
+    _capacity += chunkSize;
+    if(_current)
+        _current->next = chunk;
+    else
+        _first = chunk;
+    _current = chunk;
+
+    char *ptr = align(chunk->begin(),alignment);
+    _next = ptr+size;
+    return ptr;
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,53 @@
+#ifndef BUMPARENA_H
+#define BUMPARENA_H
+
+#include <cstddef>
+
+
+//------------------------------------------------------------------------------
+// class BumpArena
+//------------------------------------------------------------------------------
+// Bump allocator for short lived data: allocating moves a pointer forward,
+// nothing is freed individually and reset() rewinds to the first chunk in
+// O(1). Chunks are kept across resets, so once the arena has grown to the
+// largest working set allocating no longer touches the heap.
+//------------------------------------------------------------------------------
+class BumpArena
+{
+    public:
+        // Constructor
+        explicit BumpArena(size_t chunkSize = 16*1024);
+        // Destructor
+        ~BumpArena();
+        // Accessors
+        inline size_t capacity()const { return _capacity; }
+        // Methods
+        void *allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+        template<typename T>
+        inline T *allocateArray(size_t count){
+            return static_cast<T *>(allocate(count*sizeof(T),alignof(T)));
+        }
+        void reset();
+    private:
+        // Types
+        struct Chunk {
+            Chunk *next;
+            size_t size;
+            inline char *begin() { return reinterpret_cast<char *>(this+1); }
+            inline char *end() { return begin()+size; }
+        };
+        // Data
+        size_t _chunkSize;
+        size_t _capacity;
+        Chunk *_first;
+        Chunk *_current;
+        char *_next;
+        // Private copy constructor and assignment (unimplemented!)
+        BumpArena(const BumpArena&);
+        BumpArena& operator=(const BumpArena&);
+        // Helpers
+        static char *align(char *ptr, size_t alignment);
+        void *allocateSlow(size_t size, size_t alignment);
+};
+
+#endif // BUMPARENA_H
@@ -0,0 +1,92 @@
+#include "checkContext.h"
+
+#include "ipCodec.h"
+#include <climits>
+#include <cstring>
+
+
+//------------------------------------------------------------------------------
+// class CheckContext implementation
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+CheckContext::CheckContext() : inSize(0), inLastModified(0),
+    performedCheckCount(0)
+{
+    filename.reserve(512);
+    inData.reserve(128*1024);
+    elementPath.reserve(512);
+    elementPathLengths.reserve(16);
+}
+//------------------------------------------------------------------------------
+// Methods
+//------------------------------------------------------------------------------
+void CheckContext::beginStation(int checkCount){
+    // Files are left open by a station bailing out early
+    inFile.close();
+    outFile.close();
+
+    _arena.reset();
+    elementPath.truncate(0);
+    elementPathLengths.resize(0);
+    performedCheckCount = 0;
+    validator.beginStation();
+
+    fixedValues.resize(checkCount);
+    for(int i=0;i<checkCount;++i)
+        if(!fixedValues.at(i).isNull())
+            fixedValues[i] = QString();
+}
+//------------------------------------------------------------------------------
+bool CheckContext::readInput(){
+    qint64 size = inFile.size();
+    if(size<=0 || size>INT_MAX || !inFile.seek(0))
+        return false;
+    inData.resize(int(size));
+    return inFile.read(inData.data(),size)==size;
+}
+//------------------------------------------------------------------------------
+void CheckContext::pushElement(const QStringRef& tag, const QStringRef& name){
+    elementPathLengths.append(elementPath.size());
+    if(elementPath.size())
+        elementPath += '/';
+    elementPath += tag;
+    elementPath += '(';
+    if(name.isEmpty())
+        elementPath += '*';
+    else
+        elementPath += name;
+    elementPath += ')';
+}
+//------------------------------------------------------------------------------
+void CheckContext::popElement(){
+    if(elementPathLengths.size())
+        elementPath.truncate(elementPathLengths.takeLast());
+}
+//------------------------------------------------------------------------------
+const QString& CheckContext::latin1View(QString& holder, const char *latin1,
+    int size)
+{
+    if(size<0)
+        size = int(strlen(latin1));
+    QChar *chars = _arena.allocateArray<QChar>(size_t(size));
+    for(int i=0;i<size;++i)
+        chars[i] = QLatin1Char(latin1[i]);
+    holder.setRawData(chars,size);
+    return holder;
+}
+//------------------------------------------------------------------------------
+const QString& CheckContext::uintView(QString& holder, quint32 value){
+    ushort *chars = _arena.allocateArray<ushort>(IPCodec::cMaxUInt32Length);
+    size_t size = IPCodec::formatUInt32(value,chars);
+    holder.setRawData(reinterpret_cast<const QChar *>(chars),int(size));
+    return holder;
+}
+//------------------------------------------------------------------------------
+const QString& CheckContext::dottedQuadView(QString& holder, qint32 addr){
+    ushort *chars = _arena.allocateArray<ushort>(IPCodec::cMaxDottedQuadLength);
+    size_t size = IPCodec::formatDottedQuad(uint32_t(addr),chars);
+    holder.setRawData(reinterpret_cast<const QChar *>(chars),int(size));
+    return holder;
+}
+//------------------------------------------------------------------------------
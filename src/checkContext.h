@@ -0,0 +1,64 @@
+#ifndef CHECKCONTEXT_H
+#define CHECKCONTEXT_H
+
+#include <QFile>
+#include <QFileInfo>
+#include <QString>
+#include <QVector>
+#include "bumpArena.h"
+#include "stationOffsetIndex.h"
+#include "typedValidator.h"
+
+
+//------------------------------------------------------------------------------
+// class CheckContext
+//------------------------------------------------------------------------------
+// Everything a worker needs to check station files, kept from one station to
+// the next: files, input buffer, element path stack and scratch strings keep
+// their allocations, transient texts live in an arena that is rewound by
+// beginStation(). Views are QStrings set with setRawData() over arena memory:
+// they are valid until the next view is taken on the same holder or the next
+// station begins.
+//------------------------------------------------------------------------------
+class CheckContext
+{
+    public:
+        // Constructor
+        CheckContext();
+        // Methods
+        void beginStation(int checkCount);
+        bool readInput();
+        void pushElement(const QStringRef& tag, const QStringRef& name);
+        void popElement();
+        const QString& latin1View(QString& holder, const char *latin1,
+                                  int size = -1);
+        const QString& uintView(QString& holder, quint32 value);
+        const QString& dottedQuadView(QString& holder, qint32 addr);
+        // Public data
+        QString filename;   // scratch for building file paths
+        QFile inFile;
+        QFileInfo inFileInfo;
+        qint64 inSize;          // input fingerprint, from the file info or
+        qint64 inLastModified;  // the prefetch (msecs since epoch)
+        QByteArray inData;
+        QFile outFile;
+        QString elementPath;
+        QVector<int> elementPathLengths;
+        QByteArray window;  // offset index reads
+        QVector<StationOffsetIndex::Slot> offsetSlots;
+        QVector<QString> fixedValues; // by check index, null: value is right
+        int performedCheckCount;
+        TypedValidator validator; // check pass, EXPRIVIA_TYPED_VALIDATION
+        // View holders
+        QString checkedValue;
+        QString expectedValue;
+        QString gotValue;
+    private:
+        // Data
+        BumpArena _arena;
+        // Private copy constructor and assignment (unimplemented!)
+        CheckContext(const CheckContext&);
+        CheckContext& operator=(const CheckContext&);
+};
+
+#endif // CHECKCONTEXT_H
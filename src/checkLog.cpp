@@ -0,0 +1,125 @@
+#include "checkLog.h"
+
+#include <QFile>
+#include <QLoggingCategory>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QTextStream>
+#include "traceRecorder.h"
+
+
+//------------------------------------------------------------------------------
+// class CheckLog implementation
+//------------------------------------------------------------------------------
+// Static data
+//------------------------------------------------------------------------------
+CheckLog * CheckLog::_log = nullptr;
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+CheckLog::CheckLog(const QString& filename, QObject *parent) : QObject(parent),
+    _file(new QFile(filename,this)), _stream(nullptr), _previousHandler(nullptr)
+{
+}
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+CheckLog::~CheckLog(){
+    if(_log==this){
+        qInstallMessageHandler(_previousHandler);
+        _log = nullptr;
+    }
+    if(_stream){
+        _stream->flush();
+        delete _stream;
+    }
+    _file->close();
+}
+//------------------------------------------------------------------------------
+// Accessors
+//------------------------------------------------------------------------------
+QString CheckLog::filename()const{
+    return _file->fileName();
+}
+//------------------------------------------------------------------------------
+// Methods
+//------------------------------------------------------------------------------
+bool CheckLog::open(){
+    if(_log || !_file->open(QIODevice::Truncate | QIODevice::WriteOnly))
+        return false;
+
+    // needed to see log messages in QtCreator console!
+    QLoggingCategory::defaultCategory()->setEnabled(QtDebugMsg, true);
+
+    _stream = new QTextStream(_file);
+    _log = this;
+    _previousHandler = qInstallMessageHandler(messageOutputHandler);
+    return true;
+}
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+void CheckLog::messageOutputHandler(QtMsgType type,
+    const QMessageLogContext &context, const QString &msg)
+{
+    static char msgBuff[1024];
+    static const char * types[] = {
+        "Debug   ",
+        "Info    ",
+        "Warning ",
+        "Critical",
+        "Fatal   "
+    };
+    static QMutex mutex;
+
+    QMutexLocker lock(&mutex);
+
+    QByteArray localMsg = msg.length() && msg.at(0)=='\"'
+                          ? msg.midRef(1,msg.length()-2).toLocal8Bit()
+                          : msg.toLocal8Bit();
+    const char *typeStr;
+    bool debug = false;
+    switch (type) {
+        case QtDebugMsg:
+            typeStr = types[0];
+            debug = true;
+            break;
+        case QtInfoMsg:
+            typeStr = types[1];
+            break;
+        case QtWarningMsg:
+            typeStr = types[2];
+            break;
+        case QtCriticalMsg:
+            typeStr = types[3];
+            break;
+        case QtFatalMsg:
+            typeStr = types[4];
+            break;
+        default:
+            fprintf(stderr, "messageOutputHandler() internal error: unknown log type!");
+            ::abort();
+    }
+
+    if(debug)
+        sprintf(msgBuff, "%s: %s (%s:%u, %s)\n", typeStr,
+                         localMsg.constData(), context.file,
+                         context.line, context.function);
+    else
+        sprintf(msgBuff, "%s: %s\n", typeStr, localMsg.constData());
+    msgBuff[sizeof(msgBuff)-1] = 0;
+
+    fprintf(stderr, msgBuff);
+
+    if(_log){
+        TRACE_SPAN("log flush");
+        *_log->_stream << msgBuff;
+        _log->_stream->flush();
+
+        size_t len = strlen(msgBuff);
+        if(len)
+            msgBuff[len-1] = 0;
+        emit _log->lineLogged(msgBuff);
+     }
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,53 @@
+#ifndef CHECKLOG_H
+#define CHECKLOG_H
+
+#include <QObject>
+#include <QString>
+
+
+//------------------------------------------------------------------------------
+// Forwards
+//------------------------------------------------------------------------------
+class QFile;
+class QTextStream;
+
+
+//------------------------------------------------------------------------------
+// class CheckLog
+//------------------------------------------------------------------------------
+// The Qt message handler of a run: every message goes to stderr and to the
+// log file, and comes out of lineLogged() for a front end to show, from
+// whatever thread it was logged in. One at a time: open() installs it, the
+// destructor takes it out again.
+//------------------------------------------------------------------------------
+class CheckLog : public QObject
+{
+    Q_OBJECT
+    public:
+        // Constructor
+        explicit CheckLog(const QString& filename, QObject *parent = nullptr);
+        // Destructor
+        ~CheckLog();
+        // Accessors
+        QString filename()const;
+        // Methods
+        bool open();
+    signals:
+        void lineLogged(const QString& line);
+    private:
+        // Data
+        static CheckLog *_log;
+
+        QFile *_file;
+        QTextStream *_stream;
+        QtMessageHandler _previousHandler;
+        // Helpers
+        static void messageOutputHandler(QtMsgType type,
+                                         const QMessageLogContext &context,
+                                         const QString &msg);
+        // Private copy constructor and assignment (unimplemented!)
+        CheckLog(const CheckLog&);
+        CheckLog& operator=(const CheckLog&);
+};
+
+#endif // CHECKLOG_H
@@ -0,0 +1,80 @@
+#include "checkProfile.h"
+
+#include <QFile>
+
+
+//------------------------------------------------------------------------------
+// class CheckProfile implementation
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+CheckProfile::CheckProfile() : ruleGroups(0), wrongValueCount(0),
+    modifiedCount(0), unmatchedCount(0), failureCount(0)
+{
+}
+//------------------------------------------------------------------------------
+// Accessors
+//------------------------------------------------------------------------------
+bool CheckProfile::setRules(const QString& rules){
+    // "basic" or rule groups joined by '+', e.g. "time_intervals+service_mode"
+    ruleGroups = 0;
+    QStringList groups = rules.split('+');
+    for(int i=0;i<groups.size();++i){
+        if(groups.at(i)=="time_intervals")
+            ruleGroups |= rgTimeIntervals;
+        else if(groups.at(i)=="service_mode")
+            ruleGroups |= rgServiceMode;
+        else if(groups.at(i)!="basic")
+            return false;
+    }
+    return true;
+}
+//------------------------------------------------------------------------------
+QString CheckProfile::rulesText()const{
+    QString rules = "basic";
+    if(ruleGroups & rgTimeIntervals)
+        rules += "+time_intervals";
+    if(ruleGroups & rgServiceMode)
+        rules += "+service_mode";
+    return rules;
+}
+//------------------------------------------------------------------------------
+QString CheckProfile::summary()const{
+    return QString::asprintf("Profile %s (%s): %u wrong values, "
+                             "%u fixed to 'modified_stations_%s', %u without "
+                             "configuration, %u failures",
+                             name.toUtf8().constData(),
+                             rulesText().toUtf8().constData(),wrongValueCount,
+                             modifiedCount,name.toUtf8().constData(),
+                             unmatchedCount,failureCount);
+}
+//------------------------------------------------------------------------------
+// Methods
+//------------------------------------------------------------------------------
+void CheckProfile::addUnmatched(uint serial){
+    log << QString::asprintf("Critical: Cannot check Envinet's "
+                             "configuration station file dir %u: corresponding "
+                             "profile configuration not found.",serial);
+    ++unmatchedCount;
+}
+//------------------------------------------------------------------------------
+void CheckProfile::addFailure(const QString& message){
+    log << "Critical: "+message;
+    ++failureCount;
+}
+//------------------------------------------------------------------------------
+void CheckProfile::finish(){
+    // The findings report, then the summary as the last line
+    QStringList lines = findings.report();
+    for(int i=0;i<lines.size();++i)
+        log << "Warning : "+lines.at(i);
+    log << "Info    : "+summary();
+}
+//------------------------------------------------------------------------------
+bool CheckProfile::writeLog(const QString& filename)const{
+    QFile logFile(filename);
+    return logFile.open(QIODevice::Truncate | QIODevice::WriteOnly |
+                        QIODevice::Text) &&
+           logFile.write((log.join('\n')+'\n').toUtf8())>=0;
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,53 @@
+#ifndef CHECKPROFILE_H
+#define CHECKPROFILE_H
+
+#include <QString>
+#include <QStringList>
+#include "findingSummary.h"
+#include "probeSheet.h"
+#include "stationManifest.h"
+
+
+//------------------------------------------------------------------------------
+// class CheckProfile
+//------------------------------------------------------------------------------
+// A further set of rule groups checked in the same run as the main one,
+// against its own probe sheet: the values the main check located compared
+// again, findings in log_<name>.log and fixed stations (with their manifest)
+// in modified_stations_<name>. Nothing of it reaches the main log but the
+// summary() line.
+//------------------------------------------------------------------------------
+class CheckProfile
+{
+    public:
+        // Types
+        enum RuleGroup { // checks beyond the basic ones
+            rgTimeIntervals = 0x1,
+            rgServiceMode   = 0x2,
+        };
+        // Constructor
+        CheckProfile();
+        // Accessors
+        bool setRules(const QString& rules);
+        QString rulesText()const;
+        QString summary()const;
+        // Methods
+        void addUnmatched(uint serial);
+        void addFailure(const QString& message);
+        void finish();
+        bool writeLog(const QString& filename)const;
+        // Public data
+        QString name;       // log_<name>.log, modified_stations_<name>
+        uint ruleGroups;
+        QString sheetFilename; // empty: the main one
+        ProbeSheet sheet;
+        QStringList log;
+        FindingSummary findings;
+        StationManifest manifest; // modified_stations_<name>
+        uint wrongValueCount;
+        uint modifiedCount;
+        uint unmatchedCount;
+        uint failureCount;
+};
+
+#endif // CHECKPROFILE_H
@@ -2,8 +2,29 @@
 #define CONFIGURATIONCHECK_H
 
 #include<QThread>
+#include<QSet>
 #include<QString>
-#include<QTextStream>
+#include "checkContext.h"
+#include "checkEngine.h"
+#include "checkProfile.h"
+#include "findingSummary.h"
+#include "pluginHost.h"
+#include "probeSheet.h"
+#include "sampleAudit.h"
+#include "stationClasses.h"
+#include "stationImage.h"
+#include "stationIO.h"
+#include "stationManifest.h"
+#include "stationOffsetIndex.h"
+#include "stationPatch.h"
+#include "stationTemplate.h"
+#include "symbolPool.h"
+
+//------------------------------------------------------------------------------
+// Forwards
+//------------------------------------------------------------------------------
+class ProbeSheetReader;
+class QIODevice;
 
 
 //------------------------------------------------------------------------------
@@ -12,12 +33,27 @@
 class ConfigurationCheck : public QThread
 {
     Q_OBJECT
+    friend class CheckKernelsBench; // bench/checkKernelsBench.cpp
     public:
         // Constructor
         ConfigurationCheck(QObject *parent = nullptr);
         // Accessors
         const QString& rootPath()const;
+        static QString findRootPath();
+        static QString inputXmlFilename();
+        void setProbeSheetFilename(const QString& filename);
+        void setTemplateFilename(const QString& filename); // generation mode
+        void setTraceFilename(const QString& filename);
+        bool failed()const;
         // Methods
+        bool addProfile(const QString& name, const QString& rules,
+                        const QString& sheetFilename = QString());
+        void enablePatchOutput(); // patches instead of fixed station files
+        void enableImageOutput(); // binary images of the checked stations
+        bool enableSampling(double confidence, double margin,
+                            const QString& strata, quint32 seed); // audit mode
+        void setFindingsDetailed(bool detailed); // a log line per finding
+        bool addPlugin(const QString& filename); // station visitor library
         void stop();
     protected:
         virtual void run();
@@ -27,66 +63,9 @@ class ConfigurationCheck : public QThread
     private:
         // Constants
         enum {
-            cMinProbeSerial = 30000,
-            cMaxProbeSerial = 30999,
+            cStationIODepth = 32, // stations in flight through the I/O ring
         };
         // Types
-        struct CSVField {
-            const QString name;
-            int colNum;
-        };
-        union IPValue {
-            // Constructors
-            inline IPValue() : _addr(0) {}
-            inline IPValue(int32_t addr) : _addr(addr) {}
-            inline IPValue(const QString& ipLikeString) { assign(ipLikeString); }
-            // Accessors
-            QString toString()const;
-            inline int32_t toInt32()const { return _addr; }
-            // Operators
-            IPValue& operator=(int32_t rhs);
-            IPValue& operator=(const QString& ipLikeString);
-            inline operator bool()const { return _addr; }
-            inline bool operator !()const { return !_addr; }
-            /* TBR
-            inline bool operator==(const IPValue& rhs)const { return addr==rhs.addr; }
-            inline bool operator!=(const IPValue& rhs)const  { return addr!=rhs.addr; }
-            */
-        private:
-            // Data
-            int32_t _addr;
-            uchar _fields[4];
-            // Helpers
-            void assign(const QString& ipLikeString);
-        };
-        class IPPort {
-        public:
-            // Constructors
-            inline IPPort() : _port(0) {}
-            inline IPPort(uint32_t port) : _port(port) {}
-            inline IPPort(const IPPort& src) : _port(src._port) {}
-            inline IPPort(const QString& xmlCodedValue) { assign(xmlCodedValue); }
-            // Accessors
-            QString toXmlCodedString()const;
-            // Operators
-            IPPort& operator=(uint32_t value);
-            IPPort& operator=(const QString& xmlCodedValue);
-            inline operator bool()const { return _port; }
-            inline bool operator !()const { return !_port; }
-        private:
-            uint32_t _port;
-            // Helpers
-            void assign(const QString& xmlCodedValue);
-        };
-        struct ProbeConfig {
-            inline ProbeConfig() : serial(0), checked(false) {}
-
-            uint serial;
-            IPValue ip;
-            IPValue netmask;
-            IPValue gateway;
-            bool checked;
-        };
         enum ProbeParameter {
             ppSerialNr,
             ppStationId,
@@ -126,11 +105,12 @@ class ConfigurationCheck : public QThread
             // Constructors
             inline ProbeParameterDef(ProbeParameter which_,
                               const QString& name_) :
-                which(which_),name(name_)
+                which(which_),name(name_),checkIndex(-1)
             {
             }
             inline ProbeParameterDef(const ProbeParameterDef& src) :
-                which(src.which),name(src.name)
+                which(src.which),name(src.name),checkIndex(src.checkIndex),
+                tagName(src.tagName),nameAttribute(src.nameAttribute)
             {
             }
             // Operators
@@ -138,7 +118,19 @@ class ConfigurationCheck : public QThread
             // Public (const) data
             mutable ProbeParameter which;
             mutable QString name;
+            mutable int checkIndex; // position in _checks (key order)
+            mutable QByteArray tagName; // "Element" of ".../Element(Gateway)"
+            mutable QByteArray nameAttribute; // ' name="Gateway"'
+        };
+        struct ExpectedValue {
+            const char *literal; // null: ip or number
+            bool isIP;
+            IPValue ip;
+            quint32 number;
         };
+        class EngineSink;   // core engine findings and elements
+        class EngineOutput; // core engine output to a QIODevice
+        class TemplateSink; // core engine parse errors of the station template
         typedef uint ProbeSerialNr_t;
         typedef QString ElementPath_t;
         /* TBR
@@ -147,29 +139,21 @@ class ConfigurationCheck : public QThread
         */
         // Data
         static const QString _csvFilename;
-        static CSVField _csvFields[];
-        static const CSVField& _csvHeaderProbeSN;
-        static const CSVField& _csvHeaderProbeIP;
-        static const CSVField& _csvHeaderProbeNetMask;
-        static const CSVField& _csvHeaderProbeGateway;
-        static const CSVField& _csvHeaderProbeCentral0IP;
-        static const CSVField& _csvHeaderProbeCentral0SNTP;
-        static const CSVField& _csvHeaderProbeGlobalSNTP;
-        static const CSVField& _csvHeaderProbeNewUpdaterIP;
+        static const QString _xlsxFilename;
         static const QString _inputFirmwareVersion;
         static const QString _outputFirmwareVersion;
+        static const QString _offsetIndexFilename;
+        static const QString _ipPlanAllowlistFilename;
+        static const QString _manifestFilename;
+        static const QString _startupSnapshotFilename;
 
         bool _stop; // no use to make it thread safe!
+        bool _failed;
         QString _rootPath;
+        QString _probeSheetFilename; // .xlsx or CSV, "-" is CSV on stdin
         //TBR QMap<ElementPath_t,CheckFnPtr_t> _checks;
         QMap<ElementPath_t,ProbeParameterDef> _checks;
-        IPValue _central0IP;
-        IPPort _central0Port;
-        IPValue _central0SNTP;
-        IPValue _globalSNTP;
-        IPValue _newUpdaterIP;
-        IPPort _newUpdaterPort;
-        QMap<ProbeSerialNr_t,ProbeConfig> _csvProbes;
+        ProbeSheet _sheet; // the main one
         QString _inputXmlFilename;
         QString _outputXmlFilename;
         uint _processedConfigCount;
@@ -177,22 +161,140 @@ class ConfigurationCheck : public QThread
         uint _invalidEnvinetProbeSerialDirCount;
         uint _processingFailureCount;
         uint _modifiedConfigCount;
+        StationOffsetIndex _offsetIndex;
+        uint _offsetIndexHitCount;
+        uint _typedValueCount;
+        uint _typedViolationCount;
+        uint _typedInvalidStationCount;
+        CheckContext _checkContext;
+        StationIO _stationIO;
+        QString _templateFilename;
+        StationTemplate _template;
+        bool _generating;
+        uint _generatedConfigCount;
+        uint _existingConfigCount;
+        uint _ipPlanFindingCount;
+        QString _traceFilename;
+        CheckEngine _engine;
+        quint64 _engineBytes;   // scanned by CheckEngine::check()
+        quint64 _skippedBytes;  // of which skipped unparsed
+        QVector<const ProbeParameterDef *> _checksByIndex;
+        QVector<StationTemplate::Value> _expectedTexts; // by check index
+        QVector<CheckEngine::Expectation> _expectations;
+        uint _ruleGroups; // of the main run
+        int _mainCheckCount;
+        QVector<CheckProfile> _profiles;
+        std::vector<CheckEngine::Location> _profileLocations;
+        StationClasses _stationClasses; // EXPRIVIA_STATION_CLASSES
+        std::vector<CheckEngine::Location> _classLocations;
+        SymbolPool::LocalCache _symbols; // typed validation
+        QVector<QString> _symbolStrings; // by symbol, decoded
+        bool _symbolStringsUtf8;
+        bool _patchOutput;
+        QVector<QByteArray> _checkPaths; // by check index
+        std::vector<CheckEngine::Fix> _fixes;
+        StationPatch _patch;
+        std::string _patchText;
+        bool _imageOutput;
+        StationImage _image;
+        std::string _imageData;
+        QByteArray _fixedData;
+        QSet<quint32> _imageLayouts; // layout CRCs written
+        uint _imageCount;
+        quint64 _imageBytes;
+        StationManifest _manifest; // modified_stations
+        FindingSummary _findings;
+        PluginHost _plugins;
+        SampleAudit _audit;
+        QVector<int> _auditParameters; // by check index, -1: not audited
+        QVector<bool> _auditMismatches; // by audited parameter
         // Helpers
         [[ noreturn ]] void fatal(const QString& msg)const;
-        bool readCSVRow(unsigned lineNum, QTextStream &in, QStringList& row);
-        void parseCSVHeaderLine(QStringList& row);
-        void parseIPandPort(const QString& inIPAndPort, IPValue& outIPValue,
-                            IPPort& outPort);
-        void parseCSVProbeConfiguration(ProbeConfig& probeConfig,
-                                        QStringList& row);
-        void parseCSVSecondLine(ProbeConfig& probeConfig, QStringList& row);
-        void addProbeConfig(uint lineNum, ProbeConfig& probeConfig);
-        void readConfigurationsFromCSV();
-        bool checkProbeParameter(const ProbeConfig& probeConfig,
-                                 const ProbeParameterDef& paramDef,
-                                 QString& value);
-        void checkProbeConfiguration(const ProbeConfig& probeConfig);
+        void addChecks(uint ruleGroups);
+        void indexChecks();
+        static uint ruleGroup(ProbeParameter which);
+        void checkStationConfigurations();
+        bool usesOffsetIndex()const;
+        void auditStationConfigurations();
+        void recordAuditSample(const ProbeConfig& probeConfig,
+                               const CheckContext& context);
+        QString probeSheetPath()const;
+        void openProbeSheet(ProbeSheetReader& reader,
+                            const QString& filename)const;
+        void readProbeSheet(ProbeSheet& sheet, const QString& filename);
+        bool loadSnapshot();
+        void saveSnapshot();
+        void loadProbeSheet();
+        void expectedParameter(const ProbeSheet& sheet,
+                               const ProbeConfig& probeConfig,
+                               const ProbeParameterDef& paramDef,
+                               ExpectedValue& expected)const;
+        const QString& expectedParameterValue(const ProbeConfig& probeConfig,
+                                              const ProbeParameterDef& paramDef,
+                                              bool& isIP,
+                                              CheckContext& context)const;
+        void expectedParameterXml(const ProbeConfig& probeConfig,
+                                  const ProbeParameterDef& paramDef,
+                                  StationTemplate::Value& value)const;
+        static void expectedValueXml(const ExpectedValue& expected,
+                                     StationTemplate::Value& value);
+        bool isParameterValueValid(const ProbeConfig& probeConfig,
+                                   const ProbeParameterDef& paramDef,
+                                   const QString& value,
+                                   CheckContext& context)const;
+        quint32 checkPlanSignature()const;
+        bool checkProbeConfigurationFromOffsetIndex(
+            const ProbeConfig& probeConfig, CheckContext& context,
+            bool inMemory);
+        void reportTypedViolation(const ProbeConfig& probeConfig,
+                                  CheckContext& context,
+                                  TypedValidator::Violation violation);
+        int setExpectations(const ProbeSheet& sheet,
+                            const ProbeConfig& probeConfig, uint ruleGroups);
+        bool checkStationWithEngine(const ProbeConfig& probeConfig,
+                                    CheckContext& context);
+        bool writeFixedStation(CheckContext& context, QIODevice& out);
+        bool writeStationPatch(CheckContext& context, QIODevice& out);
+        QString modifiedStationFilename()const;
+        void writeStationImage(const ProbeConfig& probeConfig,
+                               CheckContext& context, bool dirty);
+        static bool saveFile(const QString& filename, ByteView bytes);
+        void stationInputFilename(uint serial, QString& filename)const;
+        void checkProbeConfiguration(const ProbeConfig& probeConfig,
+                                     StationIO::Request *read = nullptr);
+        void writeModifiedStation(const ProbeConfig& probeConfig,
+                                  CheckContext& context);
+        void submitModifiedStation(const ProbeConfig& probeConfig,
+                                   CheckContext& context);
+        void writeManifest(const StationManifest& manifest,
+                           const QString& dirName);
+        void submitStationWrite(StationIO::Request *write,
+                                const char *dirName, uint serial,
+                                const QString& filename);
+        void finishStationWrite(const ProbeConfig& probeConfig,
+                                const StationIO::Request& write);
+        void scheduleProbeConfiguration(const ProbeConfig& probeConfig);
+        void completeStationIO(bool wait);
+        void throttleStationIO(int depth);
+        void drainStationIO();
+        void compileStationTemplate();
+        void generateStationConfigurations();
+        void writeGeneratedStation(const ProbeConfig& probeConfig,
+                                   const QVector<StationTemplate::Value>& values);
         void checkProbeConfigurations();
+        void checkProbeConfigurationsFromCSVStream();
+        void checkIPPlan();
+        void readProfileSheets();
+        void checkProfiles(const ProbeConfig& probeConfig, CheckContext& context);
+        bool writeProfileStation(CheckProfile& profile, CheckContext& context,
+                                 uint serial);
+        void finishProfiles();
+        void reportUnmatchedStation(uint serial);
+        void reportProgress(int value);
+        void printFindingSummary();
+        void printSummary();
+        void printGenerationSummary(qint64 elapsedMs);
+        void printAuditSummary();
 };
 
 #endif // CONFIGURATIONCHECK_H
@@ -1,165 +1,265 @@
 #include "configurationCheck.h"
 
-#include "systemendianess.h"
+#include "allocStats.h"
+#include "checkEngine.h"
+#include "crc32c.h"
+#include "ipCodec.h"
+#include "ipPlan.h"
+#include "probeSheetReader.h"
+#include "sha256.h"
+#include "traceRecorder.h"
+#include <algorithm>
+#include <cstring>
 #include <QString>
 #include <QtDebug>
 #include <QApplication>
+#include <QBuffer>
 #include <QFile>
+#include <QFileInfo>
 #include <QDir>
 #include <QDirIterator>
-#include <QXmlStreamReader>
-#include <QXmlStreamWriter>
+#include <QElapsedTimer>
+#include <QSaveFile>
+
+#if defined(EXPRIVIA_STATION_CLASSES) && defined(EXPRIVIA_TYPED_VALIDATION)
+// Class members are checked at their located values only: the typed
+// validation would see the representative of each class and nothing else
+#error "EXPRIVIA_STATION_CLASSES cannot be combined with EXPRIVIA_TYPED_VALIDATION"
+#endif
+#if defined(EXPRIVIA_SUBTREE_SKIP) && defined(EXPRIVIA_TYPED_VALIDATION)
+// The typed validation takes every element: the engine skips nothing for it
+#error "EXPRIVIA_SUBTREE_SKIP cannot be combined with EXPRIVIA_TYPED_VALIDATION"
+#endif
 
 
 //------------------------------------------------------------------------------
-// union ConfigurationCheck::IPValue implementation
-//------------------------------------------------------------------------------
-// Accessors
-//------------------------------------------------------------------------------
-QString ConfigurationCheck::IPValue::toString()const{
-    QString value;
-    for(unsigned i=0;i<4;++i){
-        value += QString::number(_fields[SystemEndianess::bigEndian() ? i : 3-i]);
-        if(i<3)
-            value += '.';
-    }
-    return value;
-}
+// class ConfigurationCheck::ProbeParameterDef implementation
 //------------------------------------------------------------------------------
 // Operators
 //------------------------------------------------------------------------------
-ConfigurationCheck::IPValue& ConfigurationCheck::IPValue::operator=(int32_t rhs)
+ConfigurationCheck::ProbeParameterDef& ConfigurationCheck::ProbeParameterDef::operator=(
+    const ProbeParameterDef& rhs)
 {
-    _addr=rhs;
+    which = rhs.which;
+    rhs.name = rhs.name;
     return *this;
 }
 //------------------------------------------------------------------------------
-ConfigurationCheck::IPValue& ConfigurationCheck::IPValue::operator=(
-    const QString& ipLikeString)
-{
-    assign(ipLikeString);
-    return *this;
-}
+
+
 //------------------------------------------------------------------------------
-// Helpers
+// class ConfigurationCheck implementation
 //------------------------------------------------------------------------------
-void ConfigurationCheck::IPValue::assign(const QString& ipLikeString){
-    _addr = 0;
-    QStringList fields = ipLikeString.split(".");
-    if(fields.size()==4){
-        bool ok;
-        for(int i=0;i<4;++i){
-            uint field = fields[i].toUInt(&ok);
-            if(!ok || field>255){
-                _addr = 0;
-                return;
-            }
-            _fields[SystemEndianess::bigEndian() ? i : 3-i] = uchar(field);
-        }
-    }
-}
+// Static data
 //------------------------------------------------------------------------------
+typedef ConfigurationCheck CC_t;
 
-
+const QString CC_t::_csvFilename = "Exprivia Mira probes configurations V2.1.csv";
+const QString CC_t::_xlsxFilename = "Exprivia Mira probes configurations V2.1.xlsx";
+const QString CC_t::_inputFirmwareVersion   = "1.5.6";
+const QString CC_t::_outputFirmwareVersion  = "1.5.6";
+const QString CC_t::_offsetIndexFilename    = "station_offsets.idx";
+const QString CC_t::_ipPlanAllowlistFilename = "ip_plan_allowlist.txt";
+const QString CC_t::_manifestFilename        = "manifest.txt";
+const QString CC_t::_startupSnapshotFilename = "startup.snap";
+//------------------------------------------------------------------------------
+// Constructor
 //------------------------------------------------------------------------------
-// class ConfigurationCheck::IPPort implementation
+ConfigurationCheck::ConfigurationCheck(QObject *parent) : QThread(parent),
+    _stop(false),_failed(false),
+    _processedConfigCount(0),_noCorrespondingExpriviaProbeConfigurationCount(0),
+    _invalidEnvinetProbeSerialDirCount(0),_processingFailureCount(0),
+    _modifiedConfigCount(0),_offsetIndexHitCount(0),_typedValueCount(0),
+    _typedViolationCount(0),_typedInvalidStationCount(0),_generating(false),
+    _generatedConfigCount(0),_existingConfigCount(0),_ipPlanFindingCount(0),
+    _engineBytes(0),_skippedBytes(0),_ruleGroups(0),_mainCheckCount(0),_symbolStringsUtf8(false),
+    _patchOutput(false),_imageOutput(false),_imageCount(0),_imageBytes(0)
+{
+    _rootPath = findRootPath();
+    if(_rootPath.isEmpty())
+        return;
+
+#ifdef EXPRIVIA_CHECK_TIME_INTERVALS
+    _ruleGroups |= CheckProfile::rgTimeIntervals;
+#endif
+#ifdef EXPRIVIA_CHECK_SERVICE_MODE
+    _ruleGroups |= CheckProfile::rgServiceMode;
+#endif
+    addChecks(_ruleGroups);
+    indexChecks();
+#ifdef EXPRIVIA_SUBTREE_SKIP
+    _engine.setSubtreeSkipping(true);
+#endif
+}
 //------------------------------------------------------------------------------
 // Accessors
+const QString& ConfigurationCheck::rootPath()const{
+    return _rootPath;
+}
 //------------------------------------------------------------------------------
-QString ConfigurationCheck::IPPort::toXmlCodedString()const {
-    return QString::number((_port << 16) + 1);
+QString ConfigurationCheck::findRootPath(){
+    QString rootPath = QCoreApplication::applicationDirPath() + "/../../";
+    if(!QFile::exists(rootPath+"src/qMiraProbeXMLCheck.pro")){
+        rootPath += "../";
+        if(!QFile::exists(rootPath+"src/qMiraProbeXMLCheck.pro"))
+            return QString();
+    }
+    return rootPath;
 }
 //------------------------------------------------------------------------------
-// Operators
+QString ConfigurationCheck::inputXmlFilename(){
+    return QString::asprintf("ConfigV%sExpriviaN.xml",
+                             _inputFirmwareVersion.toUtf8().constData());
+}
 //------------------------------------------------------------------------------
-ConfigurationCheck::IPPort& ConfigurationCheck::IPPort::operator=(
-    uint32_t value)
-{
-    _port = value;
-    if(_port>65535)
-        _port = 0;
-    return *this;
+void ConfigurationCheck::setProbeSheetFilename(const QString& filename){
+    _probeSheetFilename = filename;
 }
 //------------------------------------------------------------------------------
-ConfigurationCheck::IPPort& ConfigurationCheck::IPPort::operator=(
-    const QString& xmlCodedValue)
-{
-    assign(xmlCodedValue);
-    return *this;
+void ConfigurationCheck::setTraceFilename(const QString& filename){
+    _traceFilename = filename;
 }
 //------------------------------------------------------------------------------
-// Helpers
+void ConfigurationCheck::setTemplateFilename(const QString& filename){
+    _templateFilename = filename;
+}
 //------------------------------------------------------------------------------
-void ConfigurationCheck::IPPort::assign(const QString& xmlCodedValue){
-    _port = (xmlCodedValue.toUInt() & 0xFFFF0000) >> 16;
+bool ConfigurationCheck::failed()const{
+    return _failed;
 }
 //------------------------------------------------------------------------------
-
-
+// Methods
 //------------------------------------------------------------------------------
-// class ConfigurationCheck::ProbeParameterDef implementation
+bool ConfigurationCheck::addProfile(const QString& name, const QString& rules,
+    const QString& sheetFilename)
+{
+    CheckProfile profile;
+    profile.name = name;
+    profile.sheetFilename = sheetFilename;
+    if(!profile.setRules(rules)){
+        qCritical() << "Unknown profile rules" << rules;
+        return false;
+    }
+    if(name.isEmpty() || name.contains('/') || name.contains('\\')){
+        qCritical() << "Invalid profile name" << name;
+        return false;
+    }
+    // The check plan becomes the union of all the rule groups: every check
+    // is located by the one parse, the main run still compares its own only
+    addChecks(profile.ruleGroups);
+    indexChecks();
+    _profiles.append(profile);
+    return true;
+}
 //------------------------------------------------------------------------------
-// Operators
+void ConfigurationCheck::enablePatchOutput(){
+    _patchOutput = true;
+}
 //------------------------------------------------------------------------------
-ConfigurationCheck::ProbeParameterDef& ConfigurationCheck::ProbeParameterDef::operator=(
-    const ProbeParameterDef& rhs)
+void ConfigurationCheck::enableImageOutput(){
+    _imageOutput = true;
+}
+//------------------------------------------------------------------------------
+bool ConfigurationCheck::enableSampling(double confidence, double margin,
+    const QString& strata, quint32 seed)
 {
-    which = rhs.which;
-    rhs.name = rhs.name;
-    return *this;
+    // strata: "serial[:RANGE]" (serials RANGE by RANGE) or "subnet"
+    SampleAudit::Strata kind = SampleAudit::stSerialRange;
+    uint serialRange = 100;
+    bool ok = true;
+    if(strata=="subnet")
+        kind = SampleAudit::stSubnet;
+    else if(strata.startsWith("serial:"))
+        serialRange = strata.mid(7).toUInt(&ok);
+    else if(strata!="serial")
+        ok = false;
+    if(!ok || !_audit.configure(confidence,margin,kind,serialRange,seed)){
+        qCritical() << "Invalid sampling parameters: confidence" << confidence
+                    << "margin" << margin << "strata" << strata;
+        return false;
+    }
+    return true;
 }
 //------------------------------------------------------------------------------
-
-
+void ConfigurationCheck::setFindingsDetailed(bool detailed){
+    _findings.setDetailed(detailed);
+}
 //------------------------------------------------------------------------------
-// class ConfigurationCheck implementation
+bool ConfigurationCheck::addPlugin(const QString& filename){
+    return _plugins.load(filename);
+}
 //------------------------------------------------------------------------------
-// Static data
+void ConfigurationCheck::stop(){
+    _stop = true;
+}
 //------------------------------------------------------------------------------
-typedef ConfigurationCheck CC_t;
+void ConfigurationCheck::run(){
+    qInfo() << "Check starting.";
+#ifdef EXPRIVIA_TRACE
+    TraceRecorder::setThreadName("check");
+    if(!_traceFilename.isEmpty())
+        TraceRecorder::start();
+#else
+    if(!_traceFilename.isEmpty())
+        qWarning() << "Tracing not compiled in (EXPRIVIA_TRACE), no trace written.";
+#endif
 
-const QString CC_t::_csvFilename = "Exprivia Mira probes configurations V2.1.csv";
-CC_t::CSVField CC_t::_csvFields[] = {
-    {"MIRA SN"          , -1 },
-    {"PROBE IP"         , -1 },
-    {"SUBNET MASK"      , -1 },
-    {"GATEWAY"          , -1 },
-    {"Central 0 IP"     , -1 },
-    {"Central 0 SNTP"   , -1 },
-    {"Global NTP List"  , -1 },
-    {"New Updater IP"   , -1 }
-};
+    try{
+        TRACE_SPAN("run");
+        if(_rootPath.length())
+            qInfo() << "App path:" << _rootPath;
+        else
+            fatal("Cannot find expected directory tree project root.");
 
-const CC_t::CSVField& CC_t::_csvHeaderProbeSN = CC_t::_csvFields[0];
-const CC_t::CSVField& CC_t::_csvHeaderProbeIP = CC_t::_csvFields[1];
-const CC_t::CSVField& CC_t::_csvHeaderProbeNetMask = CC_t::_csvFields[2];
-const CC_t::CSVField& CC_t::_csvHeaderProbeGateway = CC_t::_csvFields[3];
-const CC_t::CSVField& CC_t::_csvHeaderProbeCentral0IP = CC_t::_csvFields[4];
-const CC_t::CSVField& CC_t::_csvHeaderProbeCentral0SNTP = CC_t::_csvFields[5];
-const CC_t::CSVField& CC_t::_csvHeaderProbeGlobalSNTP = CC_t::_csvFields[6];
-const CC_t::CSVField& CC_t::_csvHeaderProbeNewUpdaterIP = CC_t::_csvFields[7];
+        _inputXmlFilename = inputXmlFilename();
+        _outputXmlFilename = QString::asprintf("ConfigV%sExpriviaN.xml",
+                                         _outputFirmwareVersion.toUtf8().constData());
+        if(_stationIO.init(cStationIODepth))
+            qInfo() << "Station files read and written through io_uring.";
 
-const QString CC_t::_inputFirmwareVersion   = "1.5.6";
-const QString CC_t::_outputFirmwareVersion  = "1.5.6";
-//------------------------------------------------------------------------------
-// Constructor
-//------------------------------------------------------------------------------
-ConfigurationCheck::ConfigurationCheck(QObject *parent) : QThread(parent),
-    _stop(false),_processedConfigCount(0),
-    _noCorrespondingExpriviaProbeConfigurationCount(0),
-    _invalidEnvinetProbeSerialDirCount(0),_processingFailureCount(0),
-    _modifiedConfigCount(0)
-{
-    _rootPath = qApp->applicationDirPath() + "/../../";
-    if(!QFile::exists(_rootPath+"src/qMiraProbeXMLCheck.pro")){
-        _rootPath += "../";
-        if(!QFile::exists(_rootPath+"src/qMiraProbeXMLCheck.pro")){
-            _rootPath = "";
-            return;
+        // Generation mode: station files for the probes lacking one, nothing
+        // gets checked
+        _generating = !_templateFilename.isEmpty();
+        if(_generating)
+            generateStationConfigurations();
+        else{
+            // Plugins see the stations of the check pass, their reports
+            // written at the end
+            _plugins.visitors().beginRun(_rootPath.toUtf8().constData());
+            if(_audit.isEnabled())
+                auditStationConfigurations();
+            else
+                checkStationConfigurations();
+            _plugins.visitors().endRun();
         }
+    }catch(...)
+    {
+        _failed = true;
+    }
+#ifdef EXPRIVIA_TRACE
+    if(TraceRecorder::isEnabled()){
+        TraceRecorder::stop();
+        if(TraceRecorder::write(_traceFilename))
+            qInfo() << "Trace written to" << _traceFilename << "("
+                    << TraceRecorder::eventCount() << "spans,"
+                    << TraceRecorder::droppedCount() << "dropped).";
+        else
+            qCritical() << "Cannot write trace file" << _traceFilename;
     }
+#endif
 
-    // set up XML checks
+    qInfo() << "Check done.";
+}
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+void ConfigurationCheck::fatal(const QString& msg) const {
+    qCritical(msg.toUtf8().constData());
+    throw -1;
+}
+//------------------------------------------------------------------------------
+void ConfigurationCheck::addChecks(uint ruleGroups){
+    // set up XML checks: the basic ones, plus those of the rule groups
     _checks.insert("ConfigurationEntries(*)/Category(System)/Entry(SerialNr)",
                    ProbeParameterDef(ppSerialNr,"SerialNr"));
     _checks.insert("ConfigurationEntries(*)/Category(System)/Entry(StationId)",
@@ -182,14 +282,14 @@ ConfigurationCheck::ConfigurationCheck(QObject *parent) : QThread(parent),
                    ProbeParameterDef(ppTimeServer3,"Time Server 3"));
     _checks.insert("ConfigurationEntries(*)/Category(Communication)/Category(Central Connection Information)/Category(Central 0)/Entry(Enable)",
                    ProbeParameterDef(ppCentral0Enable,"Central 0 Enable"));
-#ifdef EXPRIVIA_CHECK_TIME_INTERVALS
-    _checks.insert("ConfigurationEntries(*)/Category(Communication)/Category(Central Connection Information)/Category(Central 0)/Entry(Communication Time)/Element(Repeat Base)",
-                   ProbeParameterDef(ppCentral0RepeatBase,"Central 0 Repeat Base"));
-    _checks.insert("ConfigurationEntries(*)/Category(Communication)/Category(Central Connection Information)/Category(Central 0)/Entry(Communication Time)/Element(Repeat On Success)",
-                   ProbeParameterDef(ppCentral0RepeatOnSuccess,"Central 0 Repeat On Success"));
-    _checks.insert("ConfigurationEntries(*)/Category(Communication)/Category(Central Connection Information)/Category(Central 0)/Entry(Communication Time)/Element(Repeat On Failure)",
-                   ProbeParameterDef(ppCentral0RepeatOnFailure,"Central 0 Repeat On Failure"));
-#endif
+    if(ruleGroups & CheckProfile::rgTimeIntervals){
+        _checks.insert("ConfigurationEntries(*)/Category(Communication)/Category(Central Connection Information)/Category(Central 0)/Entry(Communication Time)/Element(Repeat Base)",
+                       ProbeParameterDef(ppCentral0RepeatBase,"Central 0 Repeat Base"));
+        _checks.insert("ConfigurationEntries(*)/Category(Communication)/Category(Central Connection Information)/Category(Central 0)/Entry(Communication Time)/Element(Repeat On Success)",
+                       ProbeParameterDef(ppCentral0RepeatOnSuccess,"Central 0 Repeat On Success"));
+        _checks.insert("ConfigurationEntries(*)/Category(Communication)/Category(Central Connection Information)/Category(Central 0)/Entry(Communication Time)/Element(Repeat On Failure)",
+                       ProbeParameterDef(ppCentral0RepeatOnFailure,"Central 0 Repeat On Failure"));
+    }
     _checks.insert("ConfigurationEntries(*)/Category(Communication)/Category(Central Connection Information)/Category(Central 0)/Entry(Device List)/Category(Device 0)/Element(TCP/IP: Port / Serial: Address High)",
                    ProbeParameterDef(ppCentral0Port,"Central 0 Port"));
     _checks.insert("ConfigurationEntries(*)/Category(Communication)/Category(Central Connection Information)/Category(Central 0)/Entry(Device List)/Category(Device 0)/Element(TCP/IP: IP Address / Serial: Address Low)",
@@ -216,532 +316,1375 @@ ConfigurationCheck::ConfigurationCheck(QObject *parent) : QThread(parent),
                    ProbeParameterDef(ppUpdaterIPAddress,"Updater IP Address"));
     _checks.insert("ConfigurationEntries(*)/Category(Communication)/Category(Central Connection Information)/Category(Special)/Category(Updater)/Entry(Device List)/Category(Device 0)/Element(TCP/IP: SNTP Server Ip / Serial: Destination Ip)",
                    ProbeParameterDef(ppUpdaterSNTPServerIp,"Updater SNTP Server Ip"));
-#ifdef EXPRIVIA_CHECK_SERVICE_MODE
-    _checks.insert("ConfigurationEntries(*)/Category(Communication)/Category(Central Connection Information)/Category(Special)/Category(Service Mode)/Entry(Communication Time)/Element(Repeat Base)",
-                   ProbeParameterDef(ppServiceModeRepeatBase,"Service Mode Repeat Base"));
-    _checks.insert("ConfigurationEntries(*)/Category(Communication)/Category(Central Connection Information)/Category(Special)/Category(Service Mode)/Entry(Communication Time)/Element(Repeat On Success)",
-                   ProbeParameterDef(ppServiceModeRepeatOnSuccess,"Service Mode Repeat On Success"));
-    _checks.insert("ConfigurationEntries(*)/Category(Communication)/Category(Central Connection Information)/Category(Special)/Category(Service Mode)/Entry(Communication Time)/Element(Repeat On Failure)",
-                   ProbeParameterDef(ppServiceModeRepeatOnFailure,"Service Mode Repeat On Failure"));
-    _checks.insert("ConfigurationEntries(*)/Category(Communication)/Category(Central Connection Information)/Category(Special)/Category(Service Mode)/Entry(Device List)/Category(Device 0)/Element(TCP/IP: Port / Serial: Address High)",
-                   ProbeParameterDef(ppServiceModePort,"Service Mode Port"));
-    _checks.insert("ConfigurationEntries(*)/Category(Communication)/Category(Central Connection Information)/Category(Special)/Category(Service Mode)/Entry(Device List)/Category(Device 0)/Element(TCP/IP: IP Address / Serial: Address Low)",
-                   ProbeParameterDef(ppServiceModeIPAddress,"Service Mode IP Address"));
-    _checks.insert("ConfigurationEntries(*)/Category(Communication)/Category(Central Connection Information)/Category(Special)/Category(Service Mode)/Entry(Device List)/Category(Device 0)/Element(TCP/IP: SNTP Server Ip / Serial: Destination Ip)",
-                   ProbeParameterDef(ppServiceModeSNTPServerIp,"Service Mode SNTP Server Ip"));
-#endif
+    if(ruleGroups & CheckProfile::rgServiceMode){
+        _checks.insert("ConfigurationEntries(*)/Category(Communication)/Category(Central Connection Information)/Category(Special)/Category(Service Mode)/Entry(Communication Time)/Element(Repeat Base)",
+                       ProbeParameterDef(ppServiceModeRepeatBase,"Service Mode Repeat Base"));
+        _checks.insert("ConfigurationEntries(*)/Category(Communication)/Category(Central Connection Information)/Category(Special)/Category(Service Mode)/Entry(Communication Time)/Element(Repeat On Success)",
+                       ProbeParameterDef(ppServiceModeRepeatOnSuccess,"Service Mode Repeat On Success"));
+        _checks.insert("ConfigurationEntries(*)/Category(Communication)/Category(Central Connection Information)/Category(Special)/Category(Service Mode)/Entry(Communication Time)/Element(Repeat On Failure)",
+                       ProbeParameterDef(ppServiceModeRepeatOnFailure,"Service Mode Repeat On Failure"));
+        _checks.insert("ConfigurationEntries(*)/Category(Communication)/Category(Central Connection Information)/Category(Special)/Category(Service Mode)/Entry(Device List)/Category(Device 0)/Element(TCP/IP: Port / Serial: Address High)",
+                       ProbeParameterDef(ppServiceModePort,"Service Mode Port"));
+        _checks.insert("ConfigurationEntries(*)/Category(Communication)/Category(Central Connection Information)/Category(Special)/Category(Service Mode)/Entry(Device List)/Category(Device 0)/Element(TCP/IP: IP Address / Serial: Address Low)",
+                       ProbeParameterDef(ppServiceModeIPAddress,"Service Mode IP Address"));
+        _checks.insert("ConfigurationEntries(*)/Category(Communication)/Category(Central Connection Information)/Category(Special)/Category(Service Mode)/Entry(Device List)/Category(Device 0)/Element(TCP/IP: SNTP Server Ip / Serial: Destination Ip)",
+                       ProbeParameterDef(ppServiceModeSNTPServerIp,"Service Mode SNTP Server Ip"));
+    }
 }
 //------------------------------------------------------------------------------
-// Accessors
-const QString& ConfigurationCheck::rootPath()const{
-    return _rootPath;
+void ConfigurationCheck::indexChecks(){
+    // Check indexes, fast path tags and core engine plan: again whenever
+    // checks get added
+    _engine.clear();
+    _checksByIndex.clear();
+    _checkPaths.clear();
+    _mainCheckCount = 0;
+    int checkIndex = 0;
+    for(QMap<ElementPath_t,ProbeParameterDef>::iterator it=_checks.begin();
+        it!=_checks.end();
+        ++it)
+    {
+        it->checkIndex = checkIndex++;
+
+        const ElementPath_t& path = it.key();
+        int segmentStart = path.lastIndexOf('/')+1;
+        int nameStart = path.indexOf('(',segmentStart)+1;
+        it->tagName = path.mid(segmentStart,nameStart-1-segmentStart).toLatin1();
+        it->nameAttribute = " name=\"" +
+                            path.mid(nameStart,path.length()-1-nameStart).toLatin1() +
+                            '\"';
+
+        QByteArray enginePath = path.toLatin1();
+        _engine.addCheck(ByteView(enginePath.constData(),size_t(enginePath.size())),
+                         it->checkIndex);
+        _checksByIndex.append(&*it);
+        _checkPaths.append(enginePath);
+        if((ruleGroup(it->which) & _ruleGroups)==ruleGroup(it->which))
+            ++_mainCheckCount;
+    }
+    _expectedTexts.resize(_checks.size());
+    _expectations.resize(_checks.size());
 }
 //------------------------------------------------------------------------------
-// Methods
-void ConfigurationCheck::stop(){
-    _stop = true;
+uint ConfigurationCheck::ruleGroup(ProbeParameter which){
+    switch(which){
+        case ppCentral0RepeatBase:
+        case ppCentral0RepeatOnSuccess:
+        case ppCentral0RepeatOnFailure:
+            return CheckProfile::rgTimeIntervals;
+        case ppServiceModeRepeatBase:
+        case ppServiceModeRepeatOnSuccess:
+        case ppServiceModeRepeatOnFailure:
+        case ppServiceModePort:
+        case ppServiceModeIPAddress:
+        case ppServiceModeSNTPServerIp:
+            return CheckProfile::rgServiceMode;
+        default:
+            return 0; // basic
+    }
 }
 //------------------------------------------------------------------------------
-void ConfigurationCheck::run(){
-    qInfo() << "Check starting.";
-
-    try{
-        if(_rootPath.length())
-            qInfo() << "App path:" << _rootPath;
-        else
-            fatal("Cannot find expected directory tree project root.");
-
-        QDir stationsCheckedDir(_rootPath+"modified_stations");
-        if(stationsCheckedDir.exists() && !stationsCheckedDir.removeRecursively())
-            fatal("Failed to remove target checked stations directory");
-
-        qInfo() << "Begin reading Exprivia probe configurations";
-        readConfigurationsFromCSV();
-        qInfo() << "Reading Exprivia probe configurations done ("
-                << _csvProbes.size() << " found).";
-        if(!_csvProbes.size())
-            fatal("No configured probes found.");
-
-        _inputXmlFilename = QString::asprintf("ConfigV%sExpriviaN.xml",
-                                         _inputFirmwareVersion.toUtf8().constData());
-        _outputXmlFilename = QString::asprintf("ConfigV%sExpriviaN.xml",
-                                         _outputFirmwareVersion.toUtf8().constData());
+void ConfigurationCheck::checkStationConfigurations(){
+    QDir stationsCheckedDir(_rootPath+"modified_stations");
+    if(stationsCheckedDir.exists() && !stationsCheckedDir.removeRecursively())
+        fatal("Failed to remove target checked stations directory");
+    QDir imagesDir(_rootPath+"station_images");
+    if(_imageOutput){
+        if(imagesDir.exists() && !imagesDir.removeRecursively())
+            fatal("Failed to remove target station images directory");
+        if(!imagesDir.mkpath("layouts"))
+            fatal("Cannot create station images directory");
+    }
+#ifdef EXPRIVIA_STATION_OFFSET_INDEX
+    if(usesOffsetIndex()){
+        ALLOC_STATS_PHASE("offset index");
+        TRACE_SPAN("offset index load");
+        if(_offsetIndex.load(_rootPath+_offsetIndexFilename,checkPlanSignature(),
+                             _checks.size()))
+            qInfo() << "Station offset index loaded (" << _offsetIndex.size()
+                    << " stations).";
+    }
+#endif
+    if(!_profiles.isEmpty())
+        readProfileSheets();
+#ifdef EXPRIVIA_STREAMING_CSV
+    // Nothing to stream on a warm start
+    if(loadSnapshot())
         checkProbeConfigurations();
-    }catch(...)
-    {
+    else{
+        qInfo() << "Begin streaming Exprivia probe configurations";
+        checkProbeConfigurationsFromCSVStream();
+        saveSnapshot();
     }
+#else
+    qInfo() << "Begin reading Exprivia probe configurations";
+    loadProbeSheet();
+    qInfo() << "Reading Exprivia probe configurations done ("
+            << _sheet.probes.size() << " found).";
+    if(!_sheet.probes.size())
+        fatal("No configured probes found.");
 
-    qInfo() << "Check done.";
+    checkProbeConfigurations();
+#endif
+#ifdef EXPRIVIA_STATION_OFFSET_INDEX
+    // Not after a stop either: what it holds is that of an incomplete run
+    if(usesOffsetIndex() && !_stop && _offsetIndex.isDirty()){
+        ALLOC_STATS_PHASE("offset index");
+        TRACE_SPAN("offset index save");
+        if(!_offsetIndex.save(_rootPath+_offsetIndexFilename))
+            qCritical() << "Cannot save station offset index.";
+    }
+#endif
 }
 //------------------------------------------------------------------------------
-// Helpers
-//------------------------------------------------------------------------------
-void ConfigurationCheck::fatal(const QString& msg) const {
-    qCritical(msg.toUtf8().constData());
-    throw -1;
+bool ConfigurationCheck::usesOffsetIndex()const{
+    // Not with profiles: their union check plan is not that of a normal run.
+    // Not with images or plugins either: every station has to be read
+    return _profiles.isEmpty() && !_imageOutput && _plugins.isEmpty();
 }
 //------------------------------------------------------------------------------
-bool ConfigurationCheck::readCSVRow(uint lineNum, QTextStream &in,
-    QStringList& row)
-{
-    // vik: adapted from https://stackoverflow.com/questions/27318631/parsing-through-a-csv-file-in-qt
-
-    static const int delta[][5] = {
-        //  ,    "   \n    ?  eof
-        {   1,   2,  -1,   0,  -1  }, // 0: parsing (store char)
-        {   1,   2,  -1,   0,  -1  }, // 1: parsing (store column)
-        {   3,   4,   3,   3,  -2  }, // 2: quote entered (no-op)
-        {   3,   4,   3,   3,  -2  }, // 3: parsing inside quotes (store char)
-        {   1,   3,  -1,   0,  -1  }, // 4: quote exited (no-op)
-        // -1: end of row, store column, success
-        // -2: eof inside quotes
-    };
-
-    row.clear();
-
-    if (in.atEnd())
-        return false;
-
-    int state = 0, t = 0;
-    char ch = 0;
-    QString cell;
-
-    while (state >= 0) {
-
-        if (in.atEnd())
-            t = 4;
-        else {
-            in >> ch;
-            if (ch == ',') t = 0;
-            else if (ch == '\"') t = 1;
-            else if (ch == '\n') t = 2;
-            else if(ch == '\r'){
-                qint64 pos = in.pos();
-                in >> ch;
-                if(ch != '\n')
-                    in.seek(pos);
-            }
-            else t = 3;
-        }
-
-        state = delta[state][t];
+void ConfigurationCheck::auditStationConfigurations(){
+    // Sampling audit: stations checked in the order of the sample until the
+    // mismatch rates are known to the margin. Read only: no station file
+    // gets written, nor the offset index
+#ifdef EXPRIVIA_STATION_OFFSET_INDEX
+    if(_plugins.isEmpty()){
+        TRACE_SPAN("offset index load");
+        if(_offsetIndex.load(_rootPath+_offsetIndexFilename,checkPlanSignature(),
+                             _checks.size()))
+            qInfo() << "Station offset index loaded (" << _offsetIndex.size()
+                    << " stations).";
+    }
+#endif
+    qInfo() << "Begin reading Exprivia probe configurations";
+    loadProbeSheet();
+    qInfo() << "Reading Exprivia probe configurations done ("
+            << _sheet.probes.size() << " found).";
 
-        switch (state) {
-        case 0:
-        case 3:
-            cell += ch;
-            break;
-        case -1:
-        case 1:
-            row.append(cell);
-            cell = "";
-            break;
+    // The checks of the main run, one audited parameter each
+    QStringList parameters;
+    _auditParameters.fill(-1,_checksByIndex.size());
+    for(int i=0;i<_checksByIndex.size();++i){
+        const ProbeParameterDef& paramDef = *_checksByIndex.at(i);
+        if((ruleGroup(paramDef.which) & _ruleGroups)==ruleGroup(paramDef.which)){
+            _auditParameters[i] = parameters.size();
+            parameters << paramDef.name;
         }
-
     }
+    _audit.setParameters(parameters);
+    _auditMismatches.resize(parameters.size());
 
-    if (state == -2)
-        fatal(QString::asprintf("CSV line %d: End-of-file found while inside quotes.",
-                                 lineNum));
-
-    return true;
-}
-//------------------------------------------------------------------------------
-void ConfigurationCheck::parseCSVHeaderLine(QStringList& row){
-    const uint expectedFieldCount = sizeof(_csvFields)/sizeof(CSVField);
-    uint fieldCount = 0;
-    for(int i=0;i<row.size();++i){
-        const QString& fieldName = row.at(i);
-        for(uint j=0;j<expectedFieldCount;++j){
-            CSVField& csvField = _csvFields[j];
-            if(fieldName.simplified()==csvField.name){
-                if(csvField.colNum==-1){
-                    csvField.colNum = int(i);
-                    fieldCount++;
-                    break;
-                }else
-                    fatal(QString::asprintf("CSV header: duplicated column '%s'.",
-                           fieldName.toUtf8().constData()));
-            }
-        }
+    // The population: station directories with a probe sheet row
+    QDirIterator it(QDir(_rootPath+"/stations"), QDirIterator::NoIteratorFlags);
+    bool ok;
+    while(!_stop && it.hasNext()) {
+        it.next();
+        uint serial = it.fileName().toUInt(&ok);
+        if(!ok || !it.fileInfo().isDir())
+            continue;
+        QMap<ProbeSerialNr_t,ProbeConfig>::const_iterator probe =
+            _sheet.probes.constFind(serial);
+        if(probe!=_sheet.probes.constEnd())
+            _audit.addCandidate(serial,_audit.stratumKey(serial,
+                                                         probe->ip.toInt32(),
+                                                         probe->netmask.toInt32()));
     }
+    _audit.plan();
+    if(!_audit.populationSize())
+        fatal("No station directory matches a probe of the probe sheet.");
+    qInfo() << "Sampling" << _audit.populationSize() << "stations in"
+            << _audit.strataCount() << "strata, up to" << _audit.plannedSize()
+            << "to be checked (seed" << _audit.seed() << ")";
 
-    if(expectedFieldCount!=fieldCount){
-        qCritical() << "CSV header missing expected colums:";
-        for(uint j=0;j<expectedFieldCount;++j)
-            if(_csvFields[j].colNum==-1)
-                qCritical() << QString::asprintf("    %s",_csvFields[j].name.toUtf8().constData());
-        fatal("Bailing out");
+    const QVector<uint>& order = _audit.order();
+    emit setProgressRange(0,_audit.plannedSize());
+    for(int i=0;i<order.size() && !_stop && !_audit.isPrecise();++i){
+        ProbeConfig& probeConfig = _sheet.probes[order.at(i)];
+        probeConfig.checked = true;
+        scheduleProbeConfiguration(probeConfig);
+        reportProgress(qMin(i+1,_audit.plannedSize()));
     }
+    drainStationIO();
+    printAuditSummary();
 }
 //------------------------------------------------------------------------------
-void ConfigurationCheck::parseIPandPort(const QString& inIPAndPort,
-    IPValue& outIPValue, IPPort& outPort)
+void ConfigurationCheck::recordAuditSample(const ProbeConfig& probeConfig,
+    const CheckContext& context)
 {
-    QStringList ipAndPort = inIPAndPort.split(":");
-    if(ipAndPort.size()==2){
-        outIPValue = ipAndPort.at(0);
-        outPort = ipAndPort.at(1).toUInt();
-    }
+    // Checked stations only: those failing to be read or parsed are not
+    // part of the sample
+    _auditMismatches.fill(false);
+    for(int i=0;i<_auditParameters.size() && i<context.fixedValues.size();++i)
+        if(_auditParameters.at(i)>=0 && !context.fixedValues.at(i).isNull())
+            _auditMismatches[_auditParameters.at(i)] = true;
+    _audit.addStation(probeConfig.serial,_auditMismatches);
 }
 //------------------------------------------------------------------------------
-void ConfigurationCheck::parseCSVProbeConfiguration(ProbeConfig& probeConfig,
-    QStringList& row)
-{
-    probeConfig.serial = row.at(_csvHeaderProbeSN.colNum).toUInt();
-
-    probeConfig.ip = row.at(_csvHeaderProbeIP.colNum);
-    probeConfig.netmask = row.at(_csvHeaderProbeNetMask.colNum);
-    probeConfig.gateway= row.at(_csvHeaderProbeGateway.colNum);
+QString ConfigurationCheck::probeSheetPath()const{
+    if(!_probeSheetFilename.isEmpty())
+        return _probeSheetFilename;
+#ifdef EXPRIVIA_XLSX_INPUT
+    return _rootPath+_xlsxFilename;
+#else
+    return _rootPath+_csvFilename;
+#endif
 }
 //------------------------------------------------------------------------------
-void ConfigurationCheck::parseCSVSecondLine(ProbeConfig& probeConfig,
-    QStringList& row)
+void ConfigurationCheck::openProbeSheet(ProbeSheetReader& reader,
+    const QString& filename)const
 {
-    parseIPandPort(row.at(_csvHeaderProbeCentral0IP.colNum), _central0IP,
-                   _central0Port);
-    _central0SNTP = row.at(_csvHeaderProbeCentral0SNTP.colNum);
-    _globalSNTP = row.at(_csvHeaderProbeGlobalSNTP.colNum);
-    parseIPandPort(row.at(_csvHeaderProbeNewUpdaterIP.colNum), _newUpdaterIP,
-                   _newUpdaterPort);
-
-    parseCSVProbeConfiguration(probeConfig,row);
+    if(!reader.open(filename))
+        fatal(reader.errorString());
 }
 //------------------------------------------------------------------------------
-void ConfigurationCheck::addProbeConfig(uint lineNum, ProbeConfig& probeConfig){
-    if(!probeConfig.serial || probeConfig.serial<cMinProbeSerial ||
-       probeConfig.serial>cMaxProbeSerial)
-    {
-        qCritical() << QString::asprintf("Probe at CSV line %d has no serial, skipped",
-                                         lineNum);
-        return;
-    }
+void ConfigurationCheck::readProbeSheet(ProbeSheet& sheet,
+    const QString& filename)
+{
+    ALLOC_STATS_PHASE("csv");
+    TRACE_SPAN("probe sheet");
+    ProbeSheetReader reader(sheet);
+    openProbeSheet(reader,filename);
 
-    bool skip = false;
-    if(!probeConfig.ip && (skip=true))
-        qCritical() << QString::asprintf("Probe %u (CSV line %d) has invalid IP, skipped",
-                                         probeConfig.serial, lineNum);
-    if(!probeConfig.netmask && (skip=true))
-        qCritical() << QString::asprintf("Probe %u (CSV line %d) has invalid Netmask, skipped",
-                                         probeConfig.serial, lineNum);
-    if(!probeConfig.gateway && (skip=true))
-        qCritical() << QString::asprintf("Probe %u (CSV line %d) has invalid Gateway, skipped",
-                                         probeConfig.serial, lineNum);
-
-    if(!skip)
-        _csvProbes.insert(probeConfig.serial,probeConfig);
-}
-//------------------------------------------------------------------------------
-void ConfigurationCheck::readConfigurationsFromCSV(){
-    QFile csv(_rootPath+_csvFilename);
-    if(!csv.open(QFile::ReadOnly | QFile::Text))
-        fatal("Cannot open probe configuration CSV file");
-
-    QTextStream in(&csv);
-    QStringList row;
-
-    if(readCSVRow(1, in, row)){
-        parseCSVHeaderLine(row);
-
-        uint lineNum = 2;
-        if(readCSVRow(lineNum, in, row)){
-            ProbeConfig probeConfig;
-            parseCSVSecondLine(probeConfig,row);
-            if(!_central0IP)
-                fatal("Central0 IP not found or invalid");
-            if(!_central0Port)
-                fatal("Central0 port not found or invalid");
-            if(!_central0SNTP)
-                fatal("Central0 SNTP not found or invalid");
-            if(!_globalSNTP)
-                fatal("Global SNTP not found or invalid");
-            if(!_newUpdaterIP)
-                fatal("New updater server IP not found or invalid");
-            if(!_newUpdaterPort)
-                fatal("New updater server port not found or invalid");
-
-            addProbeConfig(lineNum,probeConfig);
-
-            while(!_stop && readCSVRow(++lineNum, in, row)){
-                parseCSVProbeConfiguration(probeConfig,row);
-                addProbeConfig(lineNum,probeConfig);
-            }
-        }
+    ProbeConfig probeConfig;
+    if(reader.readHeader(probeConfig)){
+        sheet.addProbe(reader.lineNumber(),probeConfig);
+        while(!_stop && reader.readProbe(probeConfig))
+            sheet.addProbe(reader.lineNumber(),probeConfig);
     }
+    if(!reader.errorString().isEmpty())
+        fatal(reader.errorString());
 
-    if(!_csvProbes.size())
-        fatal("No probe configurations read from CSV file");
+    if(!sheet.probes.size())
+        fatal("No probe configurations read from the probe sheet");
+}
+//------------------------------------------------------------------------------
+bool ConfigurationCheck::loadSnapshot(){
+    // Warm start: the main sheet as a previous run loaded it, see
+    // ProbeSheet::loadSnapshot()
+#ifdef EXPRIVIA_STARTUP_SNAPSHOT
+    ALLOC_STATS_PHASE("csv");
+    TRACE_SPAN("startup snapshot");
+    QString sheetFilename = probeSheetPath();
+    if(!_sheet.loadSnapshot(_rootPath+_startupSnapshotFilename,sheetFilename))
+        return false;
+    qInfo() << "Probe sheet:" << sheetFilename << "from the startup snapshot ("
+            << _sheet.probes.size() << "probes)";
+    return true;
+#else
+    return false;
+#endif
 }
 //------------------------------------------------------------------------------
-bool ConfigurationCheck::checkProbeParameter(
-    const ConfigurationCheck::ProbeConfig& probeConfig,
-    const ConfigurationCheck::ProbeParameterDef& paramDef,QString& value)
+void ConfigurationCheck::saveSnapshot(){
+    // Only for a sheet read to the end
+    if(!_sheet.isSnapshotPending() || _stop)
+        return;
+    TRACE_SPAN("startup snapshot save");
+    if(_sheet.saveSnapshot(_rootPath+_startupSnapshotFilename,probeSheetPath()))
+        qInfo() << "Startup snapshot saved (" << _sheet.probes.size() << "probes).";
+    else
+        qCritical() << "Cannot save the startup snapshot.";
+}
+//------------------------------------------------------------------------------
+void ConfigurationCheck::loadProbeSheet(){
+    if(loadSnapshot())
+        return;
+    readProbeSheet(_sheet,probeSheetPath());
+    saveSnapshot();
+}
+//------------------------------------------------------------------------------
+void ConfigurationCheck::expectedParameter(const ProbeSheet& sheet,
+    const ProbeConfig& probeConfig, const ProbeParameterDef& paramDef,
+    ExpectedValue& expected)const
 {
-    bool isIP = false;
-    QString expectedValue;
+    bool& isIP = expected.isIP;
+    const char *&literal = expected.literal;
+    IPValue& ip = expected.ip;
+    quint32& number = expected.number;
+    isIP = false;
+    literal = nullptr;
+    ip = 0;
+    number = 0;
     switch(paramDef.which){
         case ppSerialNr:
         case ppStationId:
-            expectedValue = QString::number(probeConfig.serial);
+            number = probeConfig.serial;
             break;
         case ppUseDHCP:
-            expectedValue = '0';
+            literal = "0";
             break;
         case ppIpAddress:
             isIP = true;
-            expectedValue = probeConfig.ip.toString();
+            ip = probeConfig.ip;
             break;
         case ppSubnetMask:
             isIP = true;
-            expectedValue = probeConfig.netmask.toString();
+            ip = probeConfig.netmask;
             break;
         case ppGateway:
             isIP = true;
-            expectedValue = probeConfig.gateway.toString();
+            ip = probeConfig.gateway;
             break;
         case ppTimeServer0:
             isIP = true;
-            expectedValue = _globalSNTP.toString();
+            ip = sheet.globalSNTP;
             break;
         case ppTimeServer1:
-            expectedValue = '0';
+            literal = "0";
             break;
         case ppTimeServer2:
-            expectedValue = '0';
+            literal = "0";
             break;
         case ppTimeServer3:
-            expectedValue = '0';
+            literal = "0";
             break;
         case ppCentral0Enable:
-            expectedValue = '1';
+            literal = "1";
             break;
         case ppCentral0RepeatBase:
-            expectedValue = "60";
+            literal = "60";
             break;
         case ppCentral0RepeatOnSuccess:
-            expectedValue = "60";
+            literal = "60";
             break;
         case ppCentral0RepeatOnFailure:
-            expectedValue = "60";
+            literal = "60";
             break;
         case ppCentral0Port:
-            expectedValue = _central0Port.toXmlCodedString();
+            number = sheet.central0Port.toXmlCoded();
             break;
         case ppCentral0IPAddress:
             isIP = true;
-            expectedValue = _central0IP.toString();
+            ip = sheet.central0IP;
             break;
         case ppCentral0SNTPServerIp:
             isIP = true;
-            expectedValue = _central0SNTP.toString();
+            ip = sheet.central0SNTP;
             break;
         case ppCentral1Enable:
-            expectedValue = '0';
+            literal = "0";
             break;
         case ppCentral2Enable:
-            expectedValue = '0';
+            literal = "0";
             break;
         case ppCentral3Enable:
-            expectedValue = '0';
+            literal = "0";
             break;
         case ppCentral4Enable:
-            expectedValue = '0';
+            literal = "0";
             break;
         case ppUpdaterRepeatBase:
         case ppServiceModeRepeatBase:
-            expectedValue = "10";
+            literal = "10";
             break;
         case ppUpdaterRepeatOnSuccess:
         case ppServiceModeRepeatOnSuccess:
-            expectedValue = "20";
+            literal = "20";
             break;
         case ppUpdaterRepeatOnFailure:
         case ppServiceModeRepeatOnFailure:
-            expectedValue = "30";
+            literal = "30";
             break;
         case ppUpdaterPort:
         case ppServiceModePort:
-            expectedValue = _newUpdaterPort.toXmlCodedString();
+            number = sheet.newUpdaterPort.toXmlCoded();
             break;
         case ppUpdaterIPAddress:
         case ppServiceModeIPAddress:
             isIP = true;
-            expectedValue = _newUpdaterIP.toString();
+            ip = sheet.newUpdaterIP;
             break;
         case ppUpdaterSNTPServerIp:
         case ppServiceModeSNTPServerIp:
             isIP = true;
-            expectedValue = _central0SNTP.toString();
+            ip = sheet.central0SNTP;
             break;
          default: // Foresee future enum expansion: ignore warning!
             qCritical() << "Internal error: XML check unknown ProbeParameter";
+            literal = "";
             break;
     }
-
-    QString ipValue = IPValue(value.toInt()).toString();
-    bool dirty = isIP ? expectedValue!=ipValue : expectedValue!=value;
-    if(dirty){
-        qWarning() << "probe " << probeConfig.serial << " - Wrong"
-                   << paramDef.name << ", expected: " << expectedValue
-                   << " got:" << (isIP ? ipValue : value) << " (FIXING!)";
-        value = isIP ? QString::number(IPValue(expectedValue).toInt32())
-                     : expectedValue;
-    }
-    return dirty;
 }
 //------------------------------------------------------------------------------
-void ConfigurationCheck::checkProbeConfiguration(const ProbeConfig& probeConfig)
+const QString& ConfigurationCheck::expectedParameterValue(
+    const ProbeConfig& probeConfig,
+    const ProbeParameterDef& paramDef,bool& isIP,
+    CheckContext& context)const
 {
-    QString inFilename = _rootPath + "stations/" +
-                         QString::number(probeConfig.serial) +
-                         "/" + _inputXmlFilename;
-    QFile inFile(inFilename);
-    if(!inFile.open(QIODevice::ReadOnly)) {
-        qInfo() << "Cannot open the Envinet station file " << inFile.fileName();
-        ++_processingFailureCount;
-        return;
+    ExpectedValue expected;
+    expectedParameter(_sheet,probeConfig,paramDef,expected);
+    isIP = expected.isIP;
+    if(expected.literal)
+        return context.latin1View(context.expectedValue,expected.literal);
+    if(isIP)
+        return context.dottedQuadView(context.expectedValue,expected.ip.toInt32());
+    return context.uintView(context.expectedValue,expected.number);
+}
+//------------------------------------------------------------------------------
+void ConfigurationCheck::expectedParameterXml(const ProbeConfig& probeConfig,
+    const ProbeParameterDef& paramDef, StationTemplate::Value& value)const
+{
+    ExpectedValue expected;
+    expectedParameter(_sheet,probeConfig,paramDef,expected);
+    expectedValueXml(expected,value);
+}
+//------------------------------------------------------------------------------
+void ConfigurationCheck::expectedValueXml(const ExpectedValue& expected,
+    StationTemplate::Value& value)
+{
+    // As written in the station file: addresses as signed int32
+    if(expected.literal){
+        value.length = int(qMin(strlen(expected.literal),
+                                size_t(StationTemplate::cMaxValueLength)));
+        memcpy(value.text,expected.literal,size_t(value.length));
+    }else if(expected.isIP)
+        value.length = int(IPCodec::formatInt32(expected.ip.toInt32(),value.text));
+    else
+        value.length = int(IPCodec::formatUInt32(expected.number,value.text));
+}
+//------------------------------------------------------------------------------
+bool ConfigurationCheck::isParameterValueValid(
+    const ProbeConfig& probeConfig,
+    const ProbeParameterDef& paramDef,
+    const QString& value, CheckContext& context)const
+{
+    bool isIP;
+    const QString& expectedValue = expectedParameterValue(probeConfig,paramDef,
+                                                          isIP,context);
+    return isIP ? expectedValue==context.dottedQuadView(
+                                     context.gotValue,
+                                     IPValue::fromXmlString(value).toInt32())
+                : expectedValue==value;
+}
+//------------------------------------------------------------------------------
+quint32 ConfigurationCheck::checkPlanSignature()const{
+    uint signature = qHash(_inputXmlFilename);
+    for(QMap<ElementPath_t,ProbeParameterDef>::const_iterator it=_checks.begin();
+        it!=_checks.end();
+        ++it)
+        signature = qHash(it.key(),signature*31+uint(it->which));
+#ifdef EXPRIVIA_TYPED_VALIDATION
+    // Indexed stations validated clean: not so for an index built without
+    signature = signature*31+1;
+#endif
+    return signature;
+}
+//------------------------------------------------------------------------------
+bool ConfigurationCheck::checkProbeConfigurationFromOffsetIndex(
+    const ProbeConfig& probeConfig, CheckContext& context, bool inMemory)
+{
+    const StationOffsetIndex::Entry *entry = _offsetIndex.find(probeConfig.serial,
+                                                               context.inSize,
+                                                               context.inLastModified);
+    if(!entry || entry->valueSlots.size()!=_checks.size())
+        return false;
+
+    // All checked values live in one region of the file: read just that,
+    // unless the whole file has already been read in
+    qint64 begin = context.inSize, end = 0;
+    for(int i=0;i<entry->valueSlots.size();++i){
+        const StationOffsetIndex::Slot& slot = entry->valueSlots.at(i);
+        begin = qMin(begin,slot.tagOffset);
+        end = qMax(end,slot.offset+slot.length+2);
+    }
+    if(begin>=end || end>context.inSize)
+        return false;
+    if(inMemory)
+        begin = 0;
+    else{
+        if(!context.inFile.seek(begin))
+            return false;
+        context.window.resize(int(end-begin));
+        if(context.inFile.read(context.window.data(),end-begin)!=end-begin)
+            return false;
     }
-    QXmlStreamReader xmlReader;
-    xmlReader.setDevice(&inFile);
+    const QByteArray& window = inMemory ? context.inData : context.window;
 
-    QString outFilename = _rootPath+"tmp.xml";
-    QFile outFile(outFilename);
-    if(!outFile.open(QIODevice::Truncate | QIODevice::WriteOnly |
-                     QIODevice::Text)) {
-        qInfo() << "Cannot open the temp station file " << outFile.fileName();
-        ++_processingFailureCount;
+    QMap<ElementPath_t,ProbeParameterDef>::const_iterator check = _checks.begin();
+    for(int i=0;i<entry->valueSlots.size();++i,++check){
+        const StationOffsetIndex::Slot& slot = entry->valueSlots.at(i);
+        if(slot.checkIndex!=check->checkIndex)
+            return false;
+
+        // Cheap sanity check of the surrounding tag: '<Tag ... name="Name">'
+        // right before the value and a closing tag right after it
+        const QByteArray& tagName = check->tagName;
+        int tagStart = int(slot.tagOffset-begin);
+        int valueStart = int(slot.offset-begin);
+        int valueEnd = valueStart+slot.length;
+        if(tagStart<0 || valueStart<=tagStart+tagName.size() ||
+           window.at(tagStart)!='<' ||
+           memcmp(window.constData()+tagStart+1,tagName.constData(),
+                  size_t(tagName.size())) ||
+           window.at(valueStart-1)!='>' ||
+           window.at(valueEnd)!='<' || window.at(valueEnd+1)!='/')
+            return false;
+        int nameAttributeAt = window.indexOf(check->nameAttribute,tagStart);
+        if(nameAttributeAt<0 ||
+           nameAttributeAt+check->nameAttribute.size()>valueStart ||
+           window.indexOf('>',tagStart)!=valueStart-1)
+            return false;
+
+        const QString& value = context.latin1View(context.checkedValue,
+                                                  window.constData()+valueStart,
+                                                  slot.length);
+        if(value.contains('<') ||
+           !isParameterValueValid(probeConfig,*check,value,context))
+            return false;
+    }
+    return true;
+}
+//------------------------------------------------------------------------------
+void ConfigurationCheck::reportTypedViolation(const ProbeConfig& probeConfig,
+    CheckContext& context, TypedValidator::Violation violation)
+{
+    if(violation==TypedValidator::tvNone)
+        return;
+    static const char *const kinds[] = {
+        "", "malformed", "out of range", "wrong size", "not in list",
+    };
+    qWarning() << "probe " << probeConfig.serial << " - Invalid"
+               << context.elementPath << "(" << kinds[violation] << "):"
+               << context.validator.detail();
+    ++_typedViolationCount;
+}
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+// class ConfigurationCheck::EngineSink
+//------------------------------------------------------------------------------
+// Core engine findings reported into the main log, or into the log of a
+// profile; the elements, when asked for, go to the typed validator with the
+// element path kept for its messages. Texts shown in the log are decoded from
+// the document encoding (UTF-8 unless declared otherwise, anything else read as Latin-1).
+// Tags, attribute names and attribute values are symbols of the process
+// wide pool, each decoded once into a QString the elements share.
+//------------------------------------------------------------------------------
+class ConfigurationCheck::EngineSink : public CheckEngine::FindingSink,
+                                       public CheckEngine::ElementSink
+{
+    public:
+        // Constructor
+        EngineSink(ConfigurationCheck& check, const ProbeConfig& probeConfig,
+                   CheckContext& context, CheckProfile *profile = nullptr);
+        // Methods
+        virtual void wrongValue(const CheckEngine::Finding& finding);
+        virtual void parseError(const char *reason, size_t offset);
+        virtual void startElement(const XmlScanner& scanner);
+        virtual void text(ByteView raw);
+        virtual void endElement(const XmlScanner& scanner);
+    private:
+        // Data
+        ConfigurationCheck& _check;
+        const ProbeConfig& _probeConfig;
+        CheckContext& _context;
+        CheckProfile *_profile;
+        std::string _decoded;
+        QString _tag;
+        QString _name;
+        QString _text;
+        QXmlStreamAttributes _attributes;
+        // Helpers
+        const QString& view(QString& holder, ByteView bytes);
+        QString symbolString(ByteView bytes);
+        bool isUtf8()const;
+        ByteView decoded(ByteView raw);
+};
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+ConfigurationCheck::EngineSink::EngineSink(ConfigurationCheck& check,
+    const ProbeConfig& probeConfig, CheckContext& context, CheckProfile *profile) :
+    _check(check),_probeConfig(probeConfig),_context(context),_profile(profile)
+{
+}
+//------------------------------------------------------------------------------
+// Methods
+//------------------------------------------------------------------------------
+void ConfigurationCheck::EngineSink::wrongValue(const CheckEngine::Finding& finding){
+    const ProbeParameterDef& paramDef = *_check._checksByIndex.at(finding.checkIndex);
+    const CheckEngine::Expectation& expected = *finding.expected;
+    if(expected.isIPv4){
+        uint32_t addr;
+        if(!IPCodec::parseXmlIPv4(finding.got.begin(),finding.got.end(),addr))
+            addr = 0;
+        _context.dottedQuadView(_context.expectedValue,IPCodec::toInt32(expected.ipv4));
+        _context.dottedQuadView(_context.gotValue,IPCodec::toInt32(addr));
+    }else{
+        view(_context.expectedValue,expected.text);
+        view(_context.gotValue,finding.got);
+    }
+    if(_profile){
+        // Same line as in the main log
+        if(_check._findings.isDetailed())
+            _profile->log << "Warning : "+FindingSummary::findingLine(
+                                 _probeConfig.serial,paramDef.name,
+                                 _context.expectedValue,_context.gotValue);
+        _profile->findings.add(_probeConfig.serial,paramDef.name,
+                               _context.expectedValue,_context.gotValue);
         return;
     }
-    QXmlStreamWriter xmlWriter(&outFile);
-    xmlWriter.setDevice(&outFile);
-    xmlWriter.setAutoFormatting(false);
+    if(_check._findings.isDetailed())
+        qWarning() << "probe " << _probeConfig.serial << " - Wrong"
+                   << paramDef.name << ", expected: " << _context.expectedValue
+                   << " got:" << _context.gotValue << " (FIXING!)";
+    _check._findings.add(_probeConfig.serial,paramDef.name,
+                         _context.expectedValue,_context.gotValue);
+    // Deep copy of the fix, e.g. for the sampling audit
+    QString& fixedValue = _context.fixedValues[finding.checkIndex];
+    view(fixedValue,expected.text);
+    fixedValue = QString(fixedValue.unicode(),fixedValue.size());
+}
+//------------------------------------------------------------------------------
+void ConfigurationCheck::EngineSink::parseError(const char *reason, size_t offset){
+    qInfo() << "Failure while parsing the station file "
+            << _context.inFile.fileName() << " reason: " << reason
+            << "(byte" << quint64(offset) << ")";
+    ++_check._processingFailureCount;
+}
+//------------------------------------------------------------------------------
+void ConfigurationCheck::EngineSink::startElement(const XmlScanner& scanner){
+    // Tags and attributes out of the symbol pool: shared strings, no copy
+    _tag = symbolString(scanner.name());
+    _name = symbolString(decoded(scanner.attribute("name")));
+    _context.pushElement(QStringRef(&_tag),QStringRef(&_name));
 
-    QStringList elementPathList;
-    QString elementTag;
-    QStringRef elementName;
-    QXmlStreamAttributes attributes;
-    QString elementPath;
-    bool dirty = false;
-    QString unimplemented;
-    ProbeParameterDef *parameterToBeChecked = nullptr;
-    int performedCheckCount = 0;
-    QString characters;
-    while(!xmlReader.atEnd()){
-        QXmlStreamReader::TokenType	token = xmlReader.tokenType();
-        switch(token){
-            case QXmlStreamReader::NoToken:
-                break;
-            case QXmlStreamReader::Invalid:
-                qInfo() << "Failure while parsing the station file "
-                        << inFile.fileName() << " reason: "
-                        << xmlReader.errorString();
-                ++_processingFailureCount;
-                return;
-            case QXmlStreamReader::StartDocument:
-                xmlWriter.setCodec(xmlReader.documentEncoding().toUtf8().constData());
-                xmlWriter.writeStartDocument(xmlReader.documentVersion().toString(),
-                                             xmlReader.isStandaloneDocument());
-                break;
-            case QXmlStreamReader::EndDocument:
-                xmlWriter.writeEndDocument();
-                break;
-            case QXmlStreamReader::StartElement:
-                elementTag = xmlReader.name().toString();
-                xmlWriter.writeStartElement(elementTag);
-
-                attributes = xmlReader.attributes();
-                elementName = attributes.value("name");
-                elementTag += '(' +
-                              (elementName.isEmpty() ? "*"
-                                                     : elementName.toString()) +
-                               ')';
-                elementPathList.append(elementTag);
-                elementPath = elementPathList.join('/');
-
-                //TBR qInfo() << elementPath;
-                {
-                QMap<ElementPath_t,ProbeParameterDef>::iterator it = _checks.find(elementPath);
-                parameterToBeChecked = it!=_checks.end() ? &*it : nullptr;
-                }
+    _attributes.resize(0);
+    const std::vector<XmlScanner::Attribute>& attributes = scanner.attributes();
+    for(size_t i=0;i<attributes.size();++i)
+        _attributes.append(symbolString(attributes[i].name),
+                           symbolString(decoded(attributes[i].value)));
+    _context.validator.startElement(QStringRef(&_tag),_attributes);
+}
+//------------------------------------------------------------------------------
+void ConfigurationCheck::EngineSink::text(ByteView raw){
+    view(_text,decoded(raw));
+    _check.reportTypedViolation(_probeConfig,_context,
+                                _context.validator.characters(QStringRef(&_text)));
+}
+//------------------------------------------------------------------------------
+void ConfigurationCheck::EngineSink::endElement(const XmlScanner& /*scanner*/){
+    _check.reportTypedViolation(_probeConfig,_context,
+                                _context.validator.endElement());
+    _context.popElement();
+}
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+const QString& ConfigurationCheck::EngineSink::view(QString& holder,
+    ByteView bytes)
+{
+    if(isUtf8()){
+        holder = QString::fromUtf8(bytes.data(),int(bytes.size()));
+        return holder;
+    }
+    return _context.latin1View(holder,bytes.data(),int(bytes.size()));
+}
+//------------------------------------------------------------------------------
+QString ConfigurationCheck::EngineSink::symbolString(ByteView bytes){
+    // Decoded once per symbol, again only if a file comes in another encoding
+    if(bytes.isEmpty())
+        return QString();
+    uint32_t symbol = _check._symbols.intern(bytes);
+    const QString *decodedString;
+    if(symbol==SymbolPool::cNoSymbol){
+        // Pool full: a copy of its own
+        decodedString = &view(_text,bytes);
+        return QString(decodedString->unicode(),decodedString->size());
+    }
 
-                xmlWriter.writeAttributes(attributes);
-                break;
-            case QXmlStreamReader::EndElement:
-                xmlWriter.writeEndElement();
-                elementPathList.removeLast();
-                elementPath = elementPathList.join('/');
-                //TBR qInfo() << elementPath;
-                break;
-            case QXmlStreamReader::Characters:
-                if(xmlReader.isCDATA())
-                    xmlWriter.writeDTD(xmlReader.text().toString());
-                else{
-                    characters = xmlReader.text().toString();
-                    if(parameterToBeChecked){
-                        dirty |= checkProbeParameter(probeConfig,
-                                                     *parameterToBeChecked,
-                                                     characters);
-                        parameterToBeChecked=nullptr;
-                        ++performedCheckCount;
-                    }
-                    xmlWriter.writeCharacters(characters);
-                }
-                break;
-            case QXmlStreamReader::Comment:
-                xmlWriter.writeComment(xmlReader.text().toString());
-                break;
-            //--------------------------
-            // Unimplemented!
-            //--------------------------
-            case QXmlStreamReader::DTD:
-                unimplemented = "DTD";
-                break;
-            case QXmlStreamReader::EntityReference:
-                unimplemented = "EntityReference";
-                break;
-            case QXmlStreamReader::ProcessingInstruction:
-                unimplemented = "ProcessingInstruction";
-                break;
+    QVector<QString>& strings = _check._symbolStrings;
+    bool utf8 = isUtf8();
+    if(utf8!=_check._symbolStringsUtf8){
+        strings.clear();
+        _check._symbolStringsUtf8 = utf8;
+    }
+    if(int(symbol)>=strings.size())
+        strings.resize(int(symbol)+1);
+    QString& string = strings[int(symbol)];
+    if(string.isNull()){
+        decodedString = &view(_text,bytes);
+        string = QString(decodedString->unicode(),decodedString->size());
+    }
+    return string;
+}
+//------------------------------------------------------------------------------
+bool ConfigurationCheck::EngineSink::isUtf8()const{
+    ByteView encoding = _check._engine.documentEncoding();
+    return encoding.isEmpty() ||
+           (encoding.size()==5 && !qstrnicmp(encoding.data(),"UTF-8",5));
+}
+//------------------------------------------------------------------------------
+ByteView ConfigurationCheck::EngineSink::decoded(ByteView raw){
+    return raw.contains('&') && XmlScanner::decode(raw,_decoded)
+           ? ByteView(_decoded) : raw;
+}
+//------------------------------------------------------------------------------
+// class ConfigurationCheck::EngineOutput
+//------------------------------------------------------------------------------
+class ConfigurationCheck::EngineOutput : public CheckEngine::OutputSink
+{
+    public:
+        // Constructor
+        inline EngineOutput(QIODevice& device) : _device(device) {}
+        // Methods
+        virtual bool write(ByteView bytes){
+            return _device.write(bytes.data(),qint64(bytes.size()))==
+                   qint64(bytes.size());
         }
+    private:
+        // Data
+        QIODevice& _device;
+};
+//------------------------------------------------------------------------------
+int ConfigurationCheck::setExpectations(const ProbeSheet& sheet,
+    const ProbeConfig& probeConfig, uint ruleGroups)
+{
+    // Checks out of the rule groups are located only
+    int activeCount = 0;
+    for(int i=0;i<_checksByIndex.size();++i){
+        const ProbeParameterDef& paramDef = *_checksByIndex.at(i);
+        CheckEngine::Expectation& expectation = _expectations[i];
+        uint group = ruleGroup(paramDef.which);
+        expectation.active = (group & ruleGroups)==group;
+        if(!expectation.active)
+            continue;
+        ++activeCount;
+
+        ExpectedValue expected;
+        expectedParameter(sheet,probeConfig,paramDef,expected);
+        StationTemplate::Value& text = _expectedTexts[i];
+        expectedValueXml(expected,text);
+        expectation.text = ByteView(text.text,size_t(text.length));
+        expectation.isIPv4 = expected.isIP;
+        expectation.ipv4 = uint32_t(expected.ip.toInt32());
+    }
+    return activeCount;
+}
+//------------------------------------------------------------------------------
+bool ConfigurationCheck::checkStationWithEngine(const ProbeConfig& probeConfig,
+    CheckContext& context)
+{
+    // Check pass on the raw bytes of the input: the expected values as
+    // written in the file, no UTF-16 on the way unless for the log and the
+    // typed validator
+    setExpectations(_sheet,probeConfig,_ruleGroups);
+    EngineSink sink(*this,probeConfig,context);
+#ifdef EXPRIVIA_TYPED_VALIDATION
+    CheckEngine::ElementSink *elements = &sink;
+#else
+    CheckEngine::ElementSink *elements = nullptr;
+#endif
+    ByteView document(context.inData.constData(),size_t(context.inData.size()));
+    QByteArray stationFilename;
+    if(!_plugins.isEmpty()){
+        // Plugins first, each element passed on to the typed validation
+        stationFilename = context.inFile.fileName().toUtf8();
+        StationVisitor::Probe probe = {
+            probeConfig.serial, uint32_t(probeConfig.ip.toInt32()),
+            uint32_t(probeConfig.netmask.toInt32()),
+            uint32_t(probeConfig.gateway.toInt32()),
+            stationFilename.constData(), document, 0
+        };
+        _plugins.visitors().startDocument(probe,elements);
+        elements = &_plugins.visitors();
+    }
+#ifdef EXPRIVIA_STATION_CLASSES
+    // A station with the markup of a known class: only its checked values
+    // are looked at, none of its other elements. Plugins want every element:
+    // no class then (nor with the typed validation, refused at build time)
+    bool classMember = false;
+    if(_plugins.isEmpty()){
+        TRACE_SPAN("station class match");
+        classMember = _stationClasses.match(document,_classLocations);
+    }
+    if(classMember)
+        _engine.checkLocated(document,_classLocations,_expectations.constData(),
+                             sink);
+    else
+#endif
+    {
+        bool checked = _engine.check(document,_expectations.constData(),sink,
+                                     elements);
+        if(!_plugins.isEmpty())
+            _plugins.visitors().endDocument(checked ? _engine.wrongValueCount()
+                                                    : -1);
+        if(!checked)
+            return false;
+        _engineBytes += document.size();
+        _skippedBytes += _engine.skippedByteCount();
+    }
+    context.performedCheckCount = _engine.performedCheckCount();
+#ifdef EXPRIVIA_STATION_CLASSES
+    if(!classMember)
+        _stationClasses.insert(probeConfig.serial,document,_engine.locations());
+#endif
+    if(!_profiles.isEmpty())
+        _profileLocations = _engine.locations();
 
-        if(unimplemented.length()){
-            qInfo() << "Failure while parsing the station file "
-                    << inFile.fileName() << " unimplemented '"
-                    << unimplemented << "' handling was requested!";
+#ifdef EXPRIVIA_STATION_OFFSET_INDEX
+    // Only values whose bytes are the value itself can be compared in place
+    const std::vector<CheckEngine::Location>& locations = _engine.locations();
+    for(int i=0;i<int(locations.size());++i){
+        const CheckEngine::Location& location = locations[size_t(i)];
+        if(location.checkIndex!=i || !location.verbatim)
+            continue;
+        StationOffsetIndex::Slot& slot = context.offsetSlots[i];
+        slot.checkIndex = i;
+        slot.tagOffset = qint64(location.tagOffset);
+        slot.offset = qint64(location.offset);
+        slot.length = int(location.length);
+    }
+#endif
+    return true;
+}
+//------------------------------------------------------------------------------
+bool ConfigurationCheck::writeFixedStation(CheckContext& context,
+    QIODevice& out)
+{
+    // Right after checkStationWithEngine(): the input copied byte by byte,
+    // the wrong values replaced
+    EngineOutput output(out);
+    ByteView document(context.inData.constData(),size_t(context.inData.size()));
+    return _engine.writeFixed(document,_expectations.constData(),output);
+}
+//------------------------------------------------------------------------------
+bool ConfigurationCheck::writeStationPatch(CheckContext& context,
+    QIODevice& out)
+{
+    // Same moment as writeFixedStation(): the replacements only, with what
+    // it takes to rebuild the fixed file out of the input (see StationPatch)
+    ByteView document(context.inData.constData(),size_t(context.inData.size()));
+    _engine.fixes(_expectations.constData(),_fixes);
+    _patch.begin(document);
+    for(size_t i=0;i<_fixes.size();++i){
+        const CheckEngine::Fix& fix = _fixes[i];
+        const QByteArray& path = _checkPaths.at(fix.checkIndex);
+        _patch.add(fix.offset,fix.length,ByteView(fix.text),
+                   ByteView(path.constData(),size_t(path.size())));
+    }
+    _patch.end();
+    _patch.write(_patchText);
+    return out.write(_patchText.data(),qint64(_patchText.size()))==
+           qint64(_patchText.size());
+}
+//------------------------------------------------------------------------------
+QString ConfigurationCheck::modifiedStationFilename()const{
+    return _patchOutput ? _outputXmlFilename+".patch" : _outputXmlFilename;
+}
+//------------------------------------------------------------------------------
+void ConfigurationCheck::writeStationImage(const ProbeConfig& probeConfig,
+    CheckContext& context, bool dirty)
+{
+    // The station as it should be: fixed when it needed fixes. The first
+    // station of every layout is kept too, as the layout to decode with
+    ALLOC_STATS_SITE("station image");
+    TRACE_SPAN("image");
+    ByteView document(context.inData.constData(),size_t(context.inData.size()));
+    if(dirty){
+        QBuffer fixedBuffer(&_fixedData);
+        fixedBuffer.open(QIODevice::Truncate | QIODevice::WriteOnly);
+        if(!writeFixedStation(context,fixedBuffer)){
+            qCritical() << "Cannot write the station image for probe"
+                        << probeConfig.serial;
             ++_processingFailureCount;
             return;
         }
+        fixedBuffer.close();
+        document = ByteView(_fixedData.constData(),size_t(_fixedData.size()));
+    }
+    if(!_image.compile(document,_imageData)){
+        qInfo() << "Cannot compile the station image of probe"
+                << probeConfig.serial << ":" << _image.errorString();
+        ++_processingFailureCount;
+        return;
+    }
 
-        xmlReader.readNext();
+    QString imagesPath = _rootPath+"station_images/";
+    quint32 layoutCrc = _image.layoutCrc();
+    if(!_imageLayouts.contains(layoutCrc)){
+        QString layoutFilename = imagesPath+"layouts/"+
+                                 QString::asprintf("%08x.xml",layoutCrc);
+        if(!saveFile(layoutFilename,document)){
+            qCritical() << "Cannot create station layout file" << layoutFilename;
+            ++_processingFailureCount;
+            return;
+        }
+        _imageLayouts.insert(layoutCrc);
+    }
+    if(!saveFile(imagesPath+QString::number(probeConfig.serial)+".msti",
+                 ByteView(_imageData))){
+        qCritical() << "Cannot create station image for probe"
+                    << probeConfig.serial;
+        ++_processingFailureCount;
+        return;
+    }
+    ++_imageCount;
+    _imageBytes += _imageData.size();
+}
+//------------------------------------------------------------------------------
+bool ConfigurationCheck::saveFile(const QString& filename, ByteView bytes){
+    QSaveFile file(filename);
+    return file.open(QIODevice::WriteOnly) &&
+           file.write(bytes.data(),qint64(bytes.size()))==qint64(bytes.size()) &&
+           file.commit();
+}
+//------------------------------------------------------------------------------
+void ConfigurationCheck::stationInputFilename(uint serial,
+    QString& filename)const
+{
+    char serialChars[IPCodec::cMaxUInt32Length];
+    QLatin1String serialString(serialChars,
+                               int(IPCodec::formatUInt32(serial,serialChars)));
+    filename.truncate(0);
+    filename += _rootPath;
+    filename += QLatin1String("stations/");
+    filename += serialString;
+    filename += '/';
+    filename += _inputXmlFilename;
+}
+//------------------------------------------------------------------------------
+void ConfigurationCheck::checkProbeConfiguration(const ProbeConfig& probeConfig,
+    StationIO::Request *read)
+{
+    ALLOC_STATS_PHASE("station check");
+    ALLOC_STATS_STATION(probeConfig.serial);
+    TRACE_SPAN_ARG("station",probeConfig.serial);
+    CheckContext& context = _checkContext;
+    context.beginStation(_checks.size());
+
+    // read: the station file has been prefetched through the I/O ring,
+    // otherwise it is opened and read here
+    QFile& inFile = context.inFile;
+    if(read){
+        if(read->failedStep!=StationIO::stNone){
+            qInfo() << (read->failedStep==StationIO::stRead ? "Cannot read"
+                                                           : "Cannot open")
+                    << "the Envinet station file " << QFile::decodeName(read->path);
+            ++_processingFailureCount;
+            return;
+        }
+        context.inSize = read->size;
+        context.inLastModified = read->lastModified;
+        context.inData.swap(read->data); // the old buffer goes to the request
+    }else{
+        TRACE_SPAN("open");
+        stationInputFilename(probeConfig.serial,context.filename);
+        inFile.setFileName(context.filename);
+        if(!inFile.open(QIODevice::ReadOnly)) {
+            qInfo() << "Cannot open the Envinet station file " << inFile.fileName();
+            ++_processingFailureCount;
+            return;
+        }
+#ifdef EXPRIVIA_STATION_OFFSET_INDEX
+        context.inFileInfo.setFile(inFile);
+        context.inSize = context.inFileInfo.size();
+        context.inLastModified = context.inFileInfo.lastModified().toMSecsSinceEpoch();
+#endif
+    }
+#ifdef EXPRIVIA_STATION_OFFSET_INDEX
+    {
+        ALLOC_STATS_SITE("offset index check");
+        TRACE_SPAN("offset index check");
+        if(checkProbeConfigurationFromOffsetIndex(probeConfig,context,read)){
+            ++_offsetIndexHitCount;
+            _findings.addChecked(probeConfig.serial);
+            inFile.close();
+            if(_audit.isEnabled())
+                recordAuditSample(probeConfig,context);
+            return;
+        }
+    }
+    StationOffsetIndex::Slot unlocated = { -1, 0, 0, 0 };
+    context.offsetSlots.fill(unlocated,_checks.size());
+#endif
+    {
+        ALLOC_STATS_SITE("station file read");
+        TRACE_SPAN("read");
+        if(!read && !context.readInput()){
+            qInfo() << "Cannot read the Envinet station file " << inFile.fileName();
+            ++_processingFailureCount;
+            return;
+        }
     }
     inFile.close();
-    outFile.close();
 
-    if(performedCheckCount!=_checks.size())
+    bool dirty = false;
+    {
+        TRACE_SPAN("parse and check");
+        if(!checkStationWithEngine(probeConfig,context))
+            return;
+        dirty = _engine.wrongValueCount()>0;
+    }
+
+    if(context.performedCheckCount!=_mainCheckCount)
         qWarning() << "Not all due checks have been performed, probe "
                    << probeConfig.serial;
+    _findings.addChecked(probeConfig.serial);
+#ifdef EXPRIVIA_TYPED_VALIDATION
+    _typedValueCount += context.validator.checkedValueCount();
+    if(context.validator.violationCount())
+        ++_typedInvalidStationCount;
+#endif
 
-    if(dirty){
-        QString dstDirPath = _rootPath + "modified_stations/" +
-                             QString::number(probeConfig.serial)+"/";
+#ifdef EXPRIVIA_STATION_OFFSET_INDEX
+    // Stations with invalid typed values stay out: they get parsed, and
+    // reported, again next time
+    bool allSlotsLocated = context.performedCheckCount==_mainCheckCount &&
+                           !context.validator.violationCount();
+    for(int i=0;allSlotsLocated && i<context.offsetSlots.size();++i)
+        allSlotsLocated = context.offsetSlots.at(i).checkIndex==i;
+    if(allSlotsLocated)
+        _offsetIndex.insert(probeConfig.serial,context.inSize,
+                            context.inLastModified,context.offsetSlots);
+    else
+        _offsetIndex.remove(probeConfig.serial);
+#endif
+
+    if(_audit.isEnabled()){
+        recordAuditSample(probeConfig,context);
+        return;
+    }
+    if(dirty && read)
+        submitModifiedStation(probeConfig,context);
+    else if(dirty)
+        writeModifiedStation(probeConfig,context);
+    if(_imageOutput)
+        writeStationImage(probeConfig,context,dirty);
+    if(!_profiles.isEmpty())
+        checkProfiles(probeConfig,context);
+}
+//------------------------------------------------------------------------------
+void ConfigurationCheck::writeModifiedStation(const ProbeConfig& probeConfig,
+    CheckContext& context)
+{
+    // Only the stations needing a fix are written: the buffered input with
+    // the fixes located by the check pass
+    ALLOC_STATS_SITE("modified file");
+    TRACE_SPAN("write");
+    QString outFilename = _rootPath+"tmp.xml";
+    QFile& outFile = context.outFile;
+    outFile.setFileName(outFilename);
+    if(!outFile.open(QIODevice::Truncate | QIODevice::WriteOnly)) {
+        qInfo() << "Cannot open the temp station file " << outFile.fileName();
+        ++_processingFailureCount;
+        return;
+    }
+    // Byte copy: no newline translation
+    DigestDevice digest(outFile,QIODevice::NotOpen);
+    bool written = _patchOutput ? writeStationPatch(context,digest)
+                                : writeFixedStation(context,digest);
+    outFile.close();
+    if(!written){
+        qCritical() << "Cannot write the modified XML station file for probe"
+                    << probeConfig.serial;
+        ++_processingFailureCount;
+        QFile::remove(outFilename);
+        return;
+    }
 
-        bool error;
-        if((error = !QDir().mkpath(dstDirPath)))
-            qCritical() << "Cannot create modified XML file directory '" <<
-                           dstDirPath << "'.";
+    QString dstDirPath = _rootPath + "modified_stations/" +
+                         QString::number(probeConfig.serial)+"/";
 
-        if(!error &&
-           (error = !QFile::rename(outFilename,dstDirPath+_outputXmlFilename)))
-        {
+    bool error;
+    if((error = !QDir().mkpath(dstDirPath)))
+        qCritical() << "Cannot create modified XML file directory '" <<
+                       dstDirPath << "'.";
+
+    if(!error){
+        TRACE_SPAN("rename");
+        if((error = !QFile::rename(outFilename,
+                                   dstDirPath+modifiedStationFilename())))
             qCritical() << "Cannot create modified XML station file for probe"
                         << probeConfig.serial;
+    }
+    if(error)
+        ++_processingFailureCount;
+    else{
+        ++_modifiedConfigCount;
+        _manifest.add(probeConfig.serial,modifiedStationFilename(),digest,
+                      ByteView(context.inData.constData(),
+                               size_t(context.inData.size())));
+    }
+}
+//------------------------------------------------------------------------------
+void ConfigurationCheck::submitModifiedStation(const ProbeConfig& probeConfig,
+    CheckContext& context)
+{
+    // Same output as the blocking path, into memory: the I/O ring then
+    // creates the directory, writes a temporary file next to the final one
+    // and renames it, while the next stations are checked
+    ALLOC_STATS_SITE("modified file");
+    TRACE_SPAN("write");
+    StationIO::Request *write = _stationIO.acquire(StationIO::kWrite);
+    write->cookie = &probeConfig;
+    QBuffer outBuffer(&write->data);
+    outBuffer.open(QIODevice::Truncate | QIODevice::WriteOnly);
+    DigestDevice digest(outBuffer,QIODevice::NotOpen);
+    bool written = _patchOutput ? writeStationPatch(context,digest)
+                                : writeFixedStation(context,digest);
+    outBuffer.close();
+    if(!written){
+        qCritical() << "Cannot write the modified XML station file for probe"
+                    << probeConfig.serial;
+        ++_processingFailureCount;
+        _stationIO.release(write);
+        return;
+    }
+    // Taken out again by finishStationWrite() should the write fail
+    _manifest.add(probeConfig.serial,modifiedStationFilename(),digest,
+                  ByteView(context.inData.constData(),size_t(context.inData.size())));
+    submitStationWrite(write,"modified_stations",probeConfig.serial,
+                       modifiedStationFilename());
+}
+//------------------------------------------------------------------------------
+void ConfigurationCheck::writeManifest(const StationManifest& manifest,
+    const QString& dirName)
+{
+    // None for a tree with no files: no empty tree created for it either
+    if(manifest.isEmpty())
+        return;
+    TRACE_SPAN("manifest");
+    QString dirPath = _rootPath+dirName;
+    if(!QDir().mkpath(dirPath) || !manifest.write(dirPath+'/'+_manifestFilename))
+        qCritical() << "Cannot write the output manifest" << dirName+'/'+
+                       _manifestFilename;
+}
+//------------------------------------------------------------------------------
+void ConfigurationCheck::submitStationWrite(StationIO::Request *write,
+    const char *dirName, uint serial, const QString& filename)
+{
+    QString dstDirPath = _rootPath + dirName;
+    write->parentDirPath = QFile::encodeName(dstDirPath);
+    dstDirPath += '/' + QString::number(serial);
+    write->dirPath = QFile::encodeName(dstDirPath);
+    dstDirPath += '/' + filename;
+    write->path = QFile::encodeName(dstDirPath);
+    write->tmpPath = QFile::encodeName(dstDirPath+".tmp");
+    _stationIO.submit(write);
+}
+//------------------------------------------------------------------------------
+void ConfigurationCheck::finishStationWrite(const ProbeConfig& probeConfig,
+    const StationIO::Request& write)
+{
+    const char *kind = _generating ? "generated" : "modified";
+    if(write.failedStep==StationIO::stNone){
+        ++(_generating ? _generatedConfigCount : _modifiedConfigCount);
+        return;
+    }
+    if(!_generating)
+        _manifest.remove(probeConfig.serial);
+
+    if(write.failedStep==StationIO::stMkdir)
+        qCritical() << "Cannot create" << kind << "XML file directory '" <<
+                       QFile::decodeName(write.dirPath) << "'.";
+    else{
+        qCritical() << "Cannot create" << kind << "XML station file for probe"
+                    << probeConfig.serial;
+        QFile::remove(QFile::decodeName(write.tmpPath));
+    }
+    ++_processingFailureCount;
+}
+//------------------------------------------------------------------------------
+void ConfigurationCheck::scheduleProbeConfiguration(
+    const ProbeConfig& probeConfig)
+{
+    if(!_stationIO.isAsync()){
+        checkProbeConfiguration(probeConfig);
+        return;
+    }
+
+    StationIO::Request *read = _stationIO.acquire(StationIO::kRead);
+    read->cookie = &probeConfig;
+    stationInputFilename(probeConfig.serial,_checkContext.filename);
+    read->path = QFile::encodeName(_checkContext.filename);
+    _stationIO.submit(read);
+
+    // Completion driven: the stations already read are checked right away,
+    // waiting happens only with the ring full. Rows piped from stdin are
+    // checked one at a time, as they arrive.
+    throttleStationIO(_probeSheetFilename=="-" ? 1 : _stationIO.depth());
+}
+//------------------------------------------------------------------------------
+void ConfigurationCheck::completeStationIO(bool wait){
+    // wait: handles one request, blocking until there is one; otherwise
+    // handles those already finished
+    for(;;){
+        StationIO::Request *request;
+        {
+            TRACE_SPAN(wait ? "io wait" : "io poll");
+            request = _stationIO.next(wait);
         }
-        if(error)
-            ++_processingFailureCount;
+        if(!request)
+            break;
+        const ProbeConfig& probeConfig =
+            *static_cast<const ProbeConfig *>(request->cookie);
+        if(request->kind==StationIO::kRead)
+            checkProbeConfiguration(probeConfig,request);
         else
-            ++_modifiedConfigCount;
-    }else
-        QFile::remove(outFilename);
+            finishStationWrite(probeConfig,*request);
+        _stationIO.release(request);
+        if(wait)
+            break;
+    }
+    if(_stationIO.failed())
+        fatal("Station I/O ring failure");
+}
+//------------------------------------------------------------------------------
+void ConfigurationCheck::throttleStationIO(int depth){
+    completeStationIO(false);
+    while(_stationIO.pending()>=depth)
+        completeStationIO(true);
+}
+//------------------------------------------------------------------------------
+void ConfigurationCheck::drainStationIO(){
+    while(_stationIO.pending())
+        completeStationIO(true);
+}
+//------------------------------------------------------------------------------
+// class ConfigurationCheck::TemplateSink
+//------------------------------------------------------------------------------
+// Station template locating: the values do not matter, a parse error does.
+//------------------------------------------------------------------------------
+class ConfigurationCheck::TemplateSink : public CheckEngine::FindingSink
+{
+    public:
+        // Constructor
+        inline TemplateSink() : reason(""), offset(0) {}
+        // Methods
+        virtual void wrongValue(const CheckEngine::Finding& finding){
+            Q_UNUSED(finding)
+        }
+        virtual void parseError(const char *reason, size_t offset){
+            this->reason = reason;
+            this->offset = offset;
+        }
+        // Public data
+        const char *reason;
+        size_t offset;
+};
+//------------------------------------------------------------------------------
+void ConfigurationCheck::compileStationTemplate(){
+    // The reference file is located like a checked station: every check must
+    // find its value there, once, for the template to be usable
+    ALLOC_STATS_PHASE("template");
+    TRACE_SPAN("template");
+    CheckContext& context = _checkContext;
+    context.beginStation(_checks.size());
+    QFile& inFile = context.inFile;
+    inFile.setFileName(_templateFilename);
+    if(!inFile.open(QIODevice::ReadOnly) || !context.readInput())
+        fatal("Cannot read the station template "+_templateFilename);
+    inFile.close();
+
+    // Every check compared with an empty text: the values do not matter. A
+    // check met twice is a parse error of the engine
+    TemplateSink sink;
+    CheckEngine::Expectation anyValue = { ByteView(), false, 0, true };
+    _expectations.fill(anyValue);
+    ByteView document(context.inData.constData(),size_t(context.inData.size()));
+    if(!_engine.check(document,_expectations.constData(),sink))
+        fatal(QString("Failure while parsing the station template, reason: %1 "
+                      "(byte %2)").arg(sink.reason).arg(quint64(sink.offset)));
+
+    QVector<StationOffsetIndex::Slot>& valueSlots = context.offsetSlots;
+    valueSlots.resize(_checks.size());
+    const std::vector<CheckEngine::Location>& locations = _engine.locations();
+    for(int i=0;i<valueSlots.size();++i){
+        // Only values whose bytes are the value itself can be replaced
+        const CheckEngine::Location& location = locations[size_t(i)];
+        if(location.checkIndex!=i || !location.verbatim)
+            fatal("Cannot locate "+_checksByIndex.at(i)->name+
+                  " in the station template");
+        StationOffsetIndex::Slot& slot = valueSlots[i];
+        slot.checkIndex = i;
+        slot.tagOffset = qint64(location.tagOffset);
+        slot.offset = qint64(location.offset);
+        slot.length = int(location.length);
+    }
+    if(!_template.compile(context.inData,valueSlots))
+        fatal("Cannot compile the station template");
+}
+//------------------------------------------------------------------------------
+void ConfigurationCheck::generateStationConfigurations(){
+    QDir generatedDir(_rootPath+"generated_stations");
+    if(generatedDir.exists() && !generatedDir.removeRecursively())
+        fatal("Failed to remove target generated stations directory");
+
+    qInfo() << "Station template:" << _templateFilename;
+    compileStationTemplate();
+
+    qInfo() << "Begin reading Exprivia probe configurations";
+    readProbeSheet(_sheet,probeSheetPath());
+    qInfo() << "Reading Exprivia probe configurations done ("
+            << _sheet.probes.size() << " found).";
+
+    ALLOC_STATS_PHASE("generation");
+    TRACE_SPAN("generation");
+    QElapsedTimer timer;
+    timer.start();
+    emit setProgressRange(0,_sheet.probes.size());
+    int currItem = 0;
+    CheckContext& context = _checkContext;
+    QVector<StationTemplate::Value> values(_checks.size());
+    for(QMap<ProbeSerialNr_t,ProbeConfig>::iterator it=_sheet.probes.begin();
+        !_stop && it!=_sheet.probes.end();
+        ++it)
+    {
+        reportProgress(++currItem);
+        stationInputFilename(it->serial,context.filename);
+        if(QFile::exists(context.filename)){
+            ++_existingConfigCount;
+            continue;
+        }
+
+        for(QMap<ElementPath_t,ProbeParameterDef>::const_iterator check=_checks.begin();
+            check!=_checks.end();
+            ++check)
+            expectedParameterXml(*it,*check,values[check->checkIndex]);
+
+        if(_stationIO.isAsync()){
+            StationIO::Request *write = _stationIO.acquire(StationIO::kWrite);
+            write->cookie = &*it;
+            _template.render(values,write->data);
+            submitStationWrite(write,"generated_stations",it->serial,
+                               _outputXmlFilename);
+            throttleStationIO(_stationIO.depth());
+        }else
+            writeGeneratedStation(*it,values);
+    }
+    drainStationIO();
+    printGenerationSummary(timer.elapsed());
+}
+//------------------------------------------------------------------------------
+void ConfigurationCheck::writeGeneratedStation(const ProbeConfig& probeConfig,
+    const QVector<StationTemplate::Value>& values)
+{
+    TRACE_SPAN_ARG("write",probeConfig.serial);
+    CheckContext& context = _checkContext;
+    _template.render(values,context.window);
+
+    QString dstDirPath = _rootPath + "generated_stations/" +
+                         QString::number(probeConfig.serial)+"/";
+    if(!QDir().mkpath(dstDirPath)){
+        qCritical() << "Cannot create generated XML file directory '" <<
+                       dstDirPath << "'.";
+        ++_processingFailureCount;
+        return;
+    }
+    QFile& outFile = context.outFile;
+    outFile.setFileName(dstDirPath+_outputXmlFilename);
+    if(!outFile.open(QIODevice::Truncate | QIODevice::WriteOnly) ||
+       outFile.write(context.window)!=context.window.size())
+    {
+        qCritical() << "Cannot create generated XML station file for probe"
+                    << probeConfig.serial;
+        outFile.close();
+        outFile.remove();
+        ++_processingFailureCount;
+        return;
+    }
+    outFile.close();
+    ++_generatedConfigCount;
 }
 //------------------------------------------------------------------------------
 void ConfigurationCheck::checkProbeConfigurations(){
@@ -769,17 +1712,13 @@ void ConfigurationCheck::checkProbeConfigurations(){
         if(fileInfo.isDir() && ok){
             ++_processedConfigCount;
 
-            if(serial>=cMinProbeSerial && serial<=cMaxProbeSerial){
-                QMap<ProbeSerialNr_t,ProbeConfig>::iterator it2 = _csvProbes.find(serial);
-                if(it2!=_csvProbes.end()){
+            if(serial>=ProbeSheet::cMinProbeSerial && serial<=ProbeSheet::cMaxProbeSerial){
+                QMap<ProbeSerialNr_t,ProbeConfig>::iterator it2 = _sheet.probes.find(serial);
+                if(it2!=_sheet.probes.end()){
                     it2->checked = true;
-                    checkProbeConfiguration(*it2);
-                }else{
-                    qCritical() << QString::asprintf("Cannot check Envinet's "
-                                   "configuration station file dir %d: corresponding "
-                                   " Exprivia configuration not found.", serial);
-                    ++_noCorrespondingExpriviaProbeConfigurationCount;
-                }
+                    scheduleProbeConfiguration(*it2);
+                }else
+                    reportUnmatchedStation(serial);
             }else{
                 qCritical() << QString::asprintf("Cannot check Envinet's "
                                "configuration station file dir %d: invalid "
@@ -788,19 +1727,271 @@ void ConfigurationCheck::checkProbeConfigurations(){
             }
         }
 
-        emit setProgressValue(++currItem);
+        reportProgress(++currItem);
+    }
+    drainStationIO();
+    writeManifest(_manifest,"modified_stations");
+
+#ifdef EXPRIVIA_IP_PLAN_CHECK
+    checkIPPlan();
+#endif
+    printSummary();
+}
+//------------------------------------------------------------------------------
+void ConfigurationCheck::checkProbeConfigurationsFromCSVStream(){
+    // Station side first, directory names only: true once checked
+    QMap<ProbeSerialNr_t,bool> stationDirs;
+    int currItem = 0;
+    {
+        QDirIterator it(QDir(_rootPath+"/stations"), QDirIterator::NoIteratorFlags);
+        bool ok;
+        while(!_stop && it.hasNext()) {
+            it.next();
+
+            QFileInfo fileInfo = it.fileInfo();
+            uint serial = fileInfo.fileName().toUInt(&ok);
+            if(fileInfo.isDir() && ok){
+                ++_processedConfigCount;
+
+                if(serial>=ProbeSheet::cMinProbeSerial && serial<=ProbeSheet::cMaxProbeSerial){
+                    stationDirs.insert(serial,false);
+                    continue; // progress counted once checked or reported
+                }
+                qCritical() << QString::asprintf("Cannot check Envinet's "
+                               "configuration station file dir %d: invalid "
+                               " station serial.", serial);
+                ++_invalidEnvinetProbeSerialDirCount;
+            }
+            ++currItem;
+        }
+        emit setProgressRange(0,currItem+stationDirs.size());
+        reportProgress(currItem);
+    }
+
+    // CSV side: the line 2 global values are pinned before anything else,
+    // then every row is checked against its station as soon as it is parsed
+    ProbeSheetReader reader(_sheet);
+    openProbeSheet(reader,probeSheetPath());
+    ProbeConfig probeConfig;
+    for(bool header=true;header || !_stop;header=false){
+        ProbeConfig *csvProbe;
+        {
+            // Reading the row and validating it, not the station check
+            ALLOC_STATS_PHASE("csv");
+            TRACE_SPAN("probe sheet row");
+            if(!(header ? reader.readHeader(probeConfig)
+                        : reader.readProbe(probeConfig)))
+                break;
+            csvProbe = _sheet.addProbe(reader.lineNumber(),probeConfig);
+        }
+        QMap<ProbeSerialNr_t,bool>::iterator dir =
+            csvProbe ? stationDirs.find(csvProbe->serial) : stationDirs.end();
+        if(dir!=stationDirs.end()){
+            dir.value() = csvProbe->checked = true;
+            scheduleProbeConfiguration(*csvProbe);
+            reportProgress(++currItem);
+        }
+    }
+    if(!reader.errorString().isEmpty())
+        fatal(reader.errorString());
+    drainStationIO();
+    qInfo() << "Streaming Exprivia probe configurations done ("
+            << _sheet.probes.size() << " found).";
+    if(!_sheet.probes.size())
+        fatal("No probe configurations read from the probe sheet");
+
+    // Both sides exhausted: the stations left have no CSV row
+    for(QMap<ProbeSerialNr_t,bool>::const_iterator it=stationDirs.constBegin();
+        !_stop && it!=stationDirs.constEnd();
+        ++it)
+    {
+        if(!it.value()){
+            reportUnmatchedStation(it.key());
+            reportProgress(++currItem);
+        }
+    }
+    writeManifest(_manifest,"modified_stations");
+
+#ifdef EXPRIVIA_IP_PLAN_CHECK
+    checkIPPlan();
+#endif
+    printSummary();
+}
+//------------------------------------------------------------------------------
+void ConfigurationCheck::checkIPPlan(){
+    // Beyond the per row checks of ProbeSheet::addProbe(): the sheet probes and the
+    // global endpoints against each other
+    TRACE_SPAN("ip plan");
+    IPPlan ipPlan;
+    QString allowlistFilename = _rootPath+_ipPlanAllowlistFilename;
+    int badLine;
+    if(QFile::exists(allowlistFilename) &&
+       !ipPlan.loadAllowlist(allowlistFilename,badLine))
+        qCritical() << "Cannot read the IP plan allowlist" << allowlistFilename
+                    << "( line" << badLine << ")";
+    for(QMap<ProbeSerialNr_t,ProbeConfig>::const_iterator it=_sheet.probes.constBegin();
+        it!=_sheet.probes.constEnd();
+        ++it)
+    {
+        ipPlan.addProbe(it->serial,quint32(it->ip.toInt32()),
+                        quint32(it->netmask.toInt32()),
+                        quint32(it->gateway.toInt32()));
     }
+    if(_sheet.central0IP)
+        ipPlan.addEndpoint("Central 0 IP",quint32(_sheet.central0IP.toInt32()));
+    if(_sheet.central0SNTP)
+        ipPlan.addEndpoint("Central 0 SNTP",quint32(_sheet.central0SNTP.toInt32()));
+    if(_sheet.globalSNTP)
+        ipPlan.addEndpoint("Global NTP",quint32(_sheet.globalSNTP.toInt32()));
+    if(_sheet.newUpdaterIP)
+        ipPlan.addEndpoint("New Updater IP",quint32(_sheet.newUpdaterIP.toInt32()));
 
+    QVector<IPPlan::Finding> findings = ipPlan.analyze();
+    for(int i=0;i<findings.size();++i)
+        qWarning() << "IP plan:" << ipPlan.describe(findings.at(i));
+    _ipPlanFindingCount = uint(findings.size());
+}
+//------------------------------------------------------------------------------
+void ConfigurationCheck::readProfileSheets(){
+    // Read in full before the main sheet, which may be streamed
+    for(int i=0;i<_profiles.size();++i){
+        CheckProfile& profile = _profiles[i];
+        QDir outDir(_rootPath+"modified_stations_"+profile.name);
+        if(outDir.exists() && !outDir.removeRecursively())
+            fatal("Failed to remove target checked stations directory of profile "+
+                  profile.name);
+        if(profile.sheetFilename.isEmpty())
+            profile.sheetFilename = probeSheetPath();
+        if(profile.sheetFilename=="-")
+            fatal("Profile "+profile.name+": the probe sheet cannot be read "
+                  "from standard input");
+
+        qInfo() << "Profile" << profile.name << ": reading probe configurations";
+        readProbeSheet(profile.sheet,profile.sheetFilename);
+    }
+}
+//------------------------------------------------------------------------------
+void ConfigurationCheck::checkProfiles(const ProbeConfig& probeConfig,
+    CheckContext& context)
+{
+    // The values located by the main check compared with the expectations
+    // of every profile: no further parse, a fixed copy where needed
+    TRACE_SPAN("profiles");
+    ByteView document(context.inData.constData(),size_t(context.inData.size()));
+    for(int i=0;i<_profiles.size();++i){
+        CheckProfile& profile = _profiles[i];
+        QMap<uint,ProbeConfig>::const_iterator it =
+            profile.sheet.probes.constFind(probeConfig.serial);
+        if(it==profile.sheet.probes.constEnd()){
+            profile.addUnmatched(probeConfig.serial);
+            continue;
+        }
+
+        int activeCount = setExpectations(profile.sheet,*it,profile.ruleGroups);
+        EngineSink sink(*this,*it,context,&profile);
+        _engine.checkLocated(document,_profileLocations,_expectations.constData(),
+                             sink);
+        if(_engine.performedCheckCount()!=activeCount)
+            profile.log << QString::asprintf("Warning : Not all due checks have "
+                           "been performed, probe %u",probeConfig.serial);
+        profile.findings.addChecked(probeConfig.serial);
+        profile.wrongValueCount += uint(_engine.wrongValueCount());
+        if(_engine.wrongValueCount() &&
+           writeProfileStation(profile,context,probeConfig.serial))
+            ++profile.modifiedCount;
+    }
+}
+//------------------------------------------------------------------------------
+bool ConfigurationCheck::writeProfileStation(CheckProfile& profile,
+    CheckContext& context, uint serial)
+{
+    TRACE_SPAN("profile write");
+    QString dstDirPath = _rootPath+"modified_stations_"+profile.name+'/'+
+                         QString::number(serial)+'/';
+    QString dstFilename = dstDirPath+modifiedStationFilename();
+    if(!QDir().mkpath(dstDirPath)){
+        profile.addFailure("Cannot create modified XML file directory '"+
+                           dstDirPath+"'.");
+        return false;
+    }
+
+    QFile& outFile = context.outFile;
+    outFile.setFileName(dstFilename+".tmp");
+    bool written = outFile.open(QIODevice::Truncate | QIODevice::WriteOnly);
+    DigestDevice digest(outFile,QIODevice::NotOpen);
+    written = written && (_patchOutput ? writeStationPatch(context,digest)
+                                       : writeFixedStation(context,digest));
+    outFile.close();
+    if(!written || !QFile::rename(outFile.fileName(),dstFilename)){
+        QFile::remove(outFile.fileName());
+        profile.addFailure(QString::asprintf("Cannot create modified XML "
+                                             "station file for probe %u",serial));
+        return false;
+    }
+    profile.manifest.add(serial,modifiedStationFilename(),digest,
+                         ByteView(context.inData.constData(),
+                                  size_t(context.inData.size())));
+    return true;
+}
+//------------------------------------------------------------------------------
+void ConfigurationCheck::finishProfiles(){
+    // Per profile: summary in the main log, findings in log_<name>.log
+    for(int i=0;i<_profiles.size();++i){
+        CheckProfile& profile = _profiles[i];
+        profile.findings.setDetailed(_findings.isDetailed());
+        profile.finish();
+        qInfo() << profile.summary();
+        writeManifest(profile.manifest,"modified_stations_"+profile.name);
+
+        QString logFilename = _rootPath+"log_"+profile.name+".log";
+        if(!profile.writeLog(logFilename))
+            qCritical() << "Cannot write profile log" << logFilename;
+    }
+}
+//------------------------------------------------------------------------------
+void ConfigurationCheck::reportUnmatchedStation(uint serial){
+    qCritical() << QString::asprintf("Cannot check Envinet's "
+                   "configuration station file dir %d: corresponding "
+                   " Exprivia configuration not found.", serial);
+    ++_noCorrespondingExpriviaProbeConfigurationCount;
+}
+//------------------------------------------------------------------------------
+void ConfigurationCheck::reportProgress(int value){
+    // Queued to the GUI thread: the span shows the posting cost
+    TRACE_SPAN("progress");
+    emit setProgressValue(value);
+}
+//------------------------------------------------------------------------------
+void ConfigurationCheck::printFindingSummary(){
+    // One row per (parameter, expected, got), the rare ones probe by probe
+    if(!_findings.findingCount())
+        return;
+    QStringList lines = _findings.report();
+    qInfo() << "--------------------------------------------------------------------------------";
+    qInfo().noquote() << QString::asprintf("Wrong values: %u in %d patterns%s",
+                             _findings.findingCount(),_findings.patternCount(),
+                             _findings.isDetailed() ? " (each one logged above)"
+                                                    : "");
+    qInfo() << "--------------------------------------------------------------------------------";
+    for(int i=0;i<lines.size();++i)
+        qWarning().noquote() << lines.at(i);
+}
+//------------------------------------------------------------------------------
+void ConfigurationCheck::printSummary(){
+    TRACE_SPAN("summary");
+    printFindingSummary();
     QList<const ProbeConfig *> uncheckedConfigs;
-    for(QMap<ProbeSerialNr_t,ProbeConfig>::iterator it=_csvProbes.begin();
-        it!=_csvProbes.end();
+    for(QMap<ProbeSerialNr_t,ProbeConfig>::iterator it=_sheet.probes.begin();
+        it!=_sheet.probes.end();
         ++it)
     {
         if(!it->checked)
             uncheckedConfigs.push_back(&*it);
     }
 
-    QString checkTimeIntervals, checkServiceMode;
+    QString checkTimeIntervals, checkServiceMode, stationOffsetIndex, streamingCSV;
+    QString xlsxInput, ioUring, typedValidation, ipPlanCheck, trace;
+    QString stationClasses, allocStats, subtreeSkip, startupSnapshot;
 #ifdef EXPRIVIA_CHECK_TIME_INTERVALS
     checkTimeIntervals = "ON";
 #else
@@ -811,6 +2002,61 @@ void ConfigurationCheck::checkProbeConfigurations(){
 #else
     checkServiceMode = "OFF";
 #endif
+#ifdef EXPRIVIA_STATION_OFFSET_INDEX
+    stationOffsetIndex = "ON";
+#else
+    stationOffsetIndex = "OFF";
+#endif
+#ifdef EXPRIVIA_STREAMING_CSV
+    streamingCSV = "ON";
+#else
+    streamingCSV = "OFF";
+#endif
+#ifdef EXPRIVIA_XLSX_INPUT
+    xlsxInput = "ON";
+#else
+    xlsxInput = "OFF";
+#endif
+#ifdef EXPRIVIA_IO_URING
+    ioUring = "ON";
+#else
+    ioUring = "OFF";
+#endif
+#ifdef EXPRIVIA_TYPED_VALIDATION
+    typedValidation = "ON";
+#else
+    typedValidation = "OFF";
+#endif
+#ifdef EXPRIVIA_IP_PLAN_CHECK
+    ipPlanCheck = "ON";
+#else
+    ipPlanCheck = "OFF";
+#endif
+#ifdef EXPRIVIA_TRACE
+    trace = "ON";
+#else
+    trace = "OFF";
+#endif
+#ifdef EXPRIVIA_STATION_CLASSES
+    stationClasses = "ON";
+#else
+    stationClasses = "OFF";
+#endif
+#ifdef EXPRIVIA_ALLOC_STATS
+    allocStats = "ON";
+#else
+    allocStats = "OFF";
+#endif
+#ifdef EXPRIVIA_SUBTREE_SKIP
+    subtreeSkip = "ON";
+#else
+    subtreeSkip = "OFF";
+#endif
+#ifdef EXPRIVIA_STARTUP_SNAPSHOT
+    startupSnapshot = "ON";
+#else
+    startupSnapshot = "OFF";
+#endif
 
     qInfo() << "--------------------------------------------------------------------------------";
     qInfo() << "Summary";
@@ -818,9 +2064,24 @@ void ConfigurationCheck::checkProbeConfigurations(){
     qInfo() << "Configuration switches";
     qInfo() << "    EXPRIVIA_CHECK_TIME_INTERVALS:" << checkTimeIntervals;
     qInfo() << "    EXPRIVIA_CHECK_SERVICE_MODE  :" << checkServiceMode;
+    qInfo() << "    EXPRIVIA_STATION_OFFSET_INDEX:" << stationOffsetIndex;
+    qInfo() << "    EXPRIVIA_STREAMING_CSV       :" << streamingCSV;
+    qInfo() << "    EXPRIVIA_XLSX_INPUT          :" << xlsxInput;
+    qInfo() << "    EXPRIVIA_IO_URING            :" << ioUring;
+    qInfo() << "    EXPRIVIA_TYPED_VALIDATION    :" << typedValidation;
+    qInfo() << "    EXPRIVIA_IP_PLAN_CHECK       :" << ipPlanCheck;
+    qInfo() << "    EXPRIVIA_TRACE               :" << trace;
+    qInfo() << "    EXPRIVIA_STATION_CLASSES     :" << stationClasses;
+    qInfo() << "    EXPRIVIA_ALLOC_STATS         :" << allocStats;
+    qInfo() << "    EXPRIVIA_SUBTREE_SKIP        :" << subtreeSkip;
+    qInfo() << "    EXPRIVIA_STARTUP_SNAPSHOT    :" << startupSnapshot;
+    qInfo() << "Station I/O:" << (_stationIO.isAsync()
+                                  ? QString::asprintf("io_uring, %d stations in flight",
+                                                     _stationIO.depth())
+                                  : QString("QFile (blocking)"));
     qInfo() << "XML filenames";
     qInfo() << "    input :" << _inputXmlFilename;
-    qInfo() << "    output:" << _outputXmlFilename;
+    qInfo() << "    output:" << modifiedStationFilename();
     qInfo() << "Total Envinet configurations (dir/file) processed:"
             << _processedConfigCount;
     qInfo() << "   Skipped because of invalid Envinet Probe Serial (dir name):"
@@ -831,11 +2092,160 @@ void ConfigurationCheck::checkProbeConfigurations(){
             << _processingFailureCount;
     qInfo() << "   Fixed (failed parameters check) to corresponding dir/file in 'modified_stations':"
             << _modifiedConfigCount;
+    qInfo() << "   Validated through the station offset index (no full parse):"
+            << _offsetIndexHitCount;
+    qInfo() << "   Listed in 'modified_stations/" + _manifestFilename + "':"
+            << _manifest.size() << "(CRC-32C:"
+            << (Crc32c::isHardwareAccelerated() ? "SSE4.2" : "tables")
+            << ", SHA-256:"
+            << (Sha256::isHardwareAccelerated() ? "SHA extensions" : "portable")
+            << ")";
+    if(_imageOutput)
+        qInfo() << "   Compiled to a binary image in 'station_images':"
+                << _imageCount << "(" << _imageBytes << "bytes,"
+                << _imageLayouts.size() << "layouts)";
+#ifdef EXPRIVIA_TYPED_VALIDATION
+    qInfo() << "   With invalid typed values (please see reason above):"
+            << _typedInvalidStationCount << "(" << _typedViolationCount
+            << "violations in" << _typedValueCount << "values)";
+#endif
+    if(_skippedBytes)
+        qInfo() << "Station bytes skipped unparsed (no checked element below):"
+                << _skippedBytes << "of" << _engineBytes;
+    if(!_plugins.isEmpty())
+        qInfo() << "Plugins run in the check pass:" << _plugins.names().join(", ");
+    if(_symbols.pool().symbolCount())
+        qInfo() << "Symbol pool (tags and attributes):"
+                << _symbols.pool().symbolCount() << "symbols in"
+                << quint64(_symbols.pool().memoryUsage()) << "bytes";
+#ifdef EXPRIVIA_IP_PLAN_CHECK
+    qInfo() << "IP plan inconsistencies (please see reason above):"
+            << _ipPlanFindingCount;
+#endif
+#ifdef EXPRIVIA_STATION_CLASSES
+    qInfo() << "Station classes:" << _stationClasses.classCount()
+            << "(stations checked against their class:"
+            << _stationClasses.memberCount() << ")";
+    std::vector<unsigned> outliers = _stationClasses.outliers();
+    if(outliers.size() || _stationClasses.refusedCount()){
+        QStringList serials;
+        for(size_t i=0;i<outliers.size();++i)
+            serials << QString::number(outliers[i]);
+        qInfo() << "Stations in no common class:" << outliers.size()
+                << "(" << serials.join(' ') << ")";
+        if(_stationClasses.refusedCount())
+            qInfo() << "Stations left unclassified (class table full):"
+                    << _stationClasses.refusedCount();
+    }
+#endif
+    finishProfiles();
     if(uncheckedConfigs.size()){
         qInfo() << "Following exprivia configurations had no corresponding "
                    "Envinet station file configuration:";
         for(int i=0;i<uncheckedConfigs.size();++i)
             qInfo() << QString::asprintf("    %d", uncheckedConfigs.at(i)->serial);
     }
+
+#ifdef EXPRIVIA_ALLOC_STATS
+    AllocStats::Counters total = AllocStats::total();
+    qInfo() << "Heap allocations (counting"
+            << (AllocStats::wrapsCAllocator() ? "malloc/free)" : "operator new/delete)");
+    qInfo() << QString::asprintf("    total: %llu allocations, %llu bytes, %llu frees",
+                                 (unsigned long long)total.allocations,
+                                 (unsigned long long)total.bytes,
+                                 (unsigned long long)total.frees);
+    if(AllocStats::wrapsCAllocator())
+        qInfo() << QString::asprintf("    live now: %llu bytes",
+                                     (unsigned long long)(total.bytes-total.freedBytes));
+    qInfo() << QString::asprintf("    peak RSS: %llu KiB",
+                                 (unsigned long long)AllocStats::peakRSS()/1024);
+
+    std::vector<AllocStats::NamedCounters> phases = AllocStats::phases();
+    for(size_t i=0;i<phases.size();++i)
+        qInfo() << QString::asprintf("    phase %-20s: %10llu allocations, %12llu bytes",
+                                     phases[i].name,
+                                     (unsigned long long)phases[i].counters.allocations,
+                                     (unsigned long long)phases[i].counters.bytes);
+
+    std::vector<AllocStats::StationCounters> stations = AllocStats::stations();
+    if(stations.size()){
+        std::sort(stations.begin(),stations.end(),
+                  [](const AllocStats::StationCounters& a,
+                     const AllocStats::StationCounters& b){
+                      return a.allocations<b.allocations;
+                  });
+        unsigned long long allocations = 0, bytes = 0;
+        for(size_t i=0;i<stations.size();++i){
+            allocations += stations[i].allocations;
+            bytes += stations[i].bytes;
+        }
+        qInfo() << QString::asprintf("    per station (%d checked): mean %llu allocations "
+                                     "(%llu bytes), median %llu, min %llu, max %llu "
+                                     "(station %u)",
+                                     int(stations.size()),
+                                     allocations/stations.size(),
+                                     bytes/stations.size(),
+                                     (unsigned long long)stations[stations.size()/2].allocations,
+                                     (unsigned long long)stations.front().allocations,
+                                     (unsigned long long)stations.back().allocations,
+                                     stations.back().serial);
+    }
+
+    std::vector<AllocStats::NamedCounters> sites = AllocStats::topSites(10);
+    qInfo() << "    top allocation sites (by bytes):";
+    for(size_t i=0;i<sites.size();++i)
+        qInfo() << QString::asprintf("        %-20s: %10llu allocations, %12llu bytes",
+                                     sites[i].name,
+                                     (unsigned long long)sites[i].counters.allocations,
+                                     (unsigned long long)sites[i].counters.bytes);
+#endif
+}
+//------------------------------------------------------------------------------
+void ConfigurationCheck::printGenerationSummary(qint64 elapsedMs){
+    qInfo() << "Summary";
+    qInfo() << "Station template:" << _templateFilename << "("
+            << _template.slotCount() << "value slots)";
+    qInfo() << "Station I/O:" << (_stationIO.isAsync()
+                                  ? QString::asprintf("io_uring, %d stations in flight",
+                                                     _stationIO.depth())
+                                  : QString("QFile (blocking)"));
+    qInfo() << "Output XML filename:" << _outputXmlFilename;
+    qInfo() << "Total Exprivia probe configurations processed:" << _sheet.probes.size();
+    qInfo() << "   Skipped because of an existing Envinet station file:"
+            << _existingConfigCount;
+    qInfo() << "   Failed to write the configuration XML file (please see reason above):"
+            << _processingFailureCount;
+    qInfo() << "   Generated to corresponding dir/file in 'generated_stations':"
+            << _generatedConfigCount;
+    qInfo() << QString::asprintf("Generated in %lld ms (%.0f files/s)",
+                                 (long long)elapsedMs,
+                                 elapsedMs ? _generatedConfigCount*1000.0/elapsedMs
+                                           : 0.0);
+}
+//------------------------------------------------------------------------------
+void ConfigurationCheck::printAuditSummary(){
+    printFindingSummary();
+    qInfo() << "--------------------------------------------------------------------------------";
+    qInfo() << "Audit summary";
+    qInfo() << "--------------------------------------------------------------------------------";
+    qInfo() << "Stations sampled:" << _audit.sampleSize() << "of"
+            << _audit.populationSize() << "(planned at most"
+            << _audit.plannedSize() << ", seed" << _audit.seed() << ")";
+    qInfo() << "   Strata:" << _audit.strataCount()
+            << (_audit.strata()==SampleAudit::stSubnet
+                ? QString("subnets of the probe sheet")
+                : QString::asprintf("serial ranges of %u",_audit.serialRange()));
+    qInfo() << "   Failed to parse/handle configuration XML file (not sampled):"
+            << _processingFailureCount;
+    qInfo() << "   Validated through the station offset index (no full parse):"
+            << _offsetIndexHitCount;
+    qInfo() << QString::asprintf("Precision %s: %.0f%% confidence, margin %.1f%%",
+                                 _audit.isPrecise() ? "reached" : "NOT reached",
+                                 _audit.confidence()*100,_audit.margin()*100);
+    qInfo() << "Estimated mismatch rates (in the sample, rate [interval], fleet"
+               " estimate):";
+    QStringList lines = _audit.report();
+    for(int i=0;i<lines.size();++i)
+        qInfo().noquote() << lines.at(i);
 }
 //------------------------------------------------------------------------------
@@ -0,0 +1,455 @@
+#include "consoleCommands.h"
+
+#include "configurationCheck.h"
+#include "fleetIndex.h"
+#include "stationImage.h"
+#include "stationPatch.h"
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QtDebug>
+
+
+//------------------------------------------------------------------------------
+// class ConsoleCommands implementation
+//------------------------------------------------------------------------------
+// Static data
+//------------------------------------------------------------------------------
+const ConsoleCommands::Command ConsoleCommands::_commands[] = {
+    { "check", &ConsoleCommands::check,
+      "check [--sheet FILE | --sheet -] [--trace FILE] [--patch] [--images]\n"
+      "      [--all-findings] [--profile NAME:RULES[:SHEET]]... [--plugin FILE]...\n"
+      "    Run the configurations check without GUI. --sheet replaces the probe\n"
+      "    configurations sheet of the project root: an .xlsx workbook (first\n"
+      "    worksheet) or a CSV export; '-' reads CSV from standard input, e.g.\n"
+      "    piped from the sheet export while it is being written. --csv is an\n"
+      "    alias of --sheet. --trace writes a Chrome trace (JSON) of the run,\n"
+      "    to be opened in Perfetto. Each --profile is evaluated too, out of\n"
+      "    the same parse of every station: RULES is 'basic' or rule groups\n"
+      "    joined by '+' ('time_intervals', 'service_mode'), SHEET defaults to\n"
+      "    the main sheet; findings go to log_NAME.log, fixed station files to\n"
+      "    'modified_stations_NAME'. --patch writes a patch of each fixed file\n"
+      "    (<output file>.patch) instead of the file: see 'apply'. --images\n"
+      "    compiles every checked station, fixed if need be, into a binary\n"
+      "    image 'station_images/SERIAL.msti', the layouts met going to\n"
+      "    'station_images/layouts': see 'decode'. Wrong values are reported\n"
+      "    at the end, one row per parameter, expected and found value with\n"
+      "    the serials concerned as ranges, probe by probe for the rare ones\n"
+      "    only; --all-findings logs every one of them as it is found. Each\n"
+      "    --plugin loads a shared object exporting stationVisitorApiVersion()\n"
+      "    and createStationVisitor() (see core/stationVisitor.h): its hooks\n"
+      "    run in the same pass as the check, over every element and value of\n"
+      "    every station file." },
+    { "audit", &ConsoleCommands::audit,
+      "audit [--sheet FILE | --sheet -] [--trace FILE] [--confidence C]\n"
+      "      [--margin M] [--strata serial[:RANGE] | subnet] [--seed N]\n"
+      "    Estimate the fleet mismatch rate of every checked parameter out of a\n"
+      "    random sample of stations, stratified by serial ranges (RANGE\n"
+      "    serials each, 100 by default) or by the subnets of the sheet, with\n"
+      "    C confidence intervals (0.95 by default). Stations are checked until\n"
+      "    every interval is within +/-M (0.05 by default). Nothing is written;\n"
+      "    the same seed draws the same sample." },
+    { "apply", &ConsoleCommands::apply,
+      "apply PATCH BASE OUTPUT\n"
+      "    Rebuild a fixed station file out of its patch (check --patch) and\n"
+      "    the station file the patch was made from. Nothing is written unless\n"
+      "    BASE and the result are the files the patch was made for." },
+    { "compile", &ConsoleCommands::compile,
+      "compile STATION IMAGE\n"
+      "    Compile a station file into a binary image: its values keyed by\n"
+      "    entry id, without the markup (the layout, see 'decode')." },
+    { "decode", &ConsoleCommands::decode,
+      "decode IMAGE OUTPUT [LAYOUT]\n"
+      "    Turn a binary image back into the station file, byte for byte.\n"
+      "    LAYOUT is any station file with the markup of the compiled one;\n"
+      "    by default the one of the image in 'layouts' next to IMAGE." },
+    { "generate", &ConsoleCommands::generate,
+      "generate --template FILE [--sheet FILE | --sheet -] [--trace FILE]\n"
+      "    Write a station file in 'generated_stations' for every probe of the\n"
+      "    sheet without one in 'stations': FILE, a reference station file, gets\n"
+      "    the probe's values in place of those of the checked parameters and is\n"
+      "    copied verbatim otherwise." },
+    { "index", &ConsoleCommands::index,
+      "index\n"
+      "    Build or incrementally update the fleet index of all station files." },
+    { "query", &ConsoleCommands::query,
+      "query [--where PATH=VALUE | PATH!=VALUE | PATH~PREFIX]...\n"
+      "      [--count-by PATH | --histogram PATH [--buckets N] | --paths [PATH]]\n"
+      "    Query the fleet index. PATH uses the check path notation, e.g.\n"
+      "    \"Entry(StaticIp)/Element(Gateway)\"; any unambiguous trailing part\n"
+      "    of a path is accepted. Without --count-by/--histogram the matching\n"
+      "    station serials are listed." },
+};
+
+const QString ConsoleCommands::_fleetIndexFilename = "fleet.idx";
+//------------------------------------------------------------------------------
+// Methods
+//------------------------------------------------------------------------------
+bool ConsoleCommands::isCommand(const char *name){
+    for(size_t i=0;i<sizeof(_commands)/sizeof(Command);++i)
+        if(!strcmp(name,_commands[i].name))
+            return true;
+    return false;
+}
+//------------------------------------------------------------------------------
+int ConsoleCommands::exec(const QStringList& arguments){
+    QString rootPath = ConfigurationCheck::findRootPath();
+    if(rootPath.isEmpty()){
+        qCritical() << "Cannot find expected directory tree project root.";
+        return 1;
+    }
+
+    for(size_t i=0;i<sizeof(_commands)/sizeof(Command);++i)
+        if(arguments.value(1)==_commands[i].name)
+            return _commands[i].fn(rootPath,arguments.mid(2));
+    return usage();
+}
+//------------------------------------------------------------------------------
+// Commands
+//------------------------------------------------------------------------------
+int ConsoleCommands::check(const QString& rootPath, const QStringList& args){
+    Q_UNUSED(rootPath)
+
+    ConfigurationCheck configurationCheck;
+    for(int i=0;i<args.size();++i){
+        if(args.at(i)=="--patch"){
+            configurationCheck.enablePatchOutput();
+            continue;
+        }
+        if(args.at(i)=="--images"){
+            configurationCheck.enableImageOutput();
+            continue;
+        }
+        if(args.at(i)=="--all-findings"){
+            configurationCheck.setFindingsDetailed(true);
+            continue;
+        }
+        if(i+1>=args.size())
+            return usage();
+        if(args.at(i)=="--sheet" || args.at(i)=="--csv")
+            configurationCheck.setProbeSheetFilename(args.at(++i));
+        else if(args.at(i)=="--trace")
+            configurationCheck.setTraceFilename(args.at(++i));
+        else if(args.at(i)=="--plugin"){
+            if(!configurationCheck.addPlugin(args.at(++i)))
+                return 1;
+        }else if(args.at(i)=="--profile"){
+            // NAME:RULES[:SHEET], the sheet path may hold a drive letter
+            const QString& profile = args.at(++i);
+            int rulesAt = profile.indexOf(':')+1;
+            int sheetAt = rulesAt>0 ? profile.indexOf(':',rulesAt)+1 : 0;
+            if(!rulesAt)
+                return usage();
+            if(!configurationCheck.addProfile(profile.left(rulesAt-1),
+                    sheetAt ? profile.mid(rulesAt,sheetAt-1-rulesAt)
+                            : profile.mid(rulesAt),
+                    sheetAt ? profile.mid(sheetAt) : QString()))
+                return 1;
+        }else
+            return usage();
+    }
+
+    configurationCheck.start();
+    configurationCheck.wait();
+    return configurationCheck.failed() ? 1 : 0;
+}
+//------------------------------------------------------------------------------
+int ConsoleCommands::generate(const QString& rootPath, const QStringList& args){
+    Q_UNUSED(rootPath)
+
+    ConfigurationCheck configurationCheck;
+    for(int i=0;i<args.size();++i){
+        if(i+1>=args.size())
+            return usage();
+        if(args.at(i)=="--template")
+            configurationCheck.setTemplateFilename(args.at(++i));
+        else if(args.at(i)=="--sheet" || args.at(i)=="--csv")
+            configurationCheck.setProbeSheetFilename(args.at(++i));
+        else if(args.at(i)=="--trace")
+            configurationCheck.setTraceFilename(args.at(++i));
+        else
+            return usage();
+    }
+    if(!args.contains("--template"))
+        return usage();
+
+    configurationCheck.start();
+    configurationCheck.wait();
+    return configurationCheck.failed() ? 1 : 0;
+}
+//------------------------------------------------------------------------------
+int ConsoleCommands::audit(const QString& rootPath, const QStringList& args){
+    Q_UNUSED(rootPath)
+
+    ConfigurationCheck configurationCheck;
+    double confidence = 0.95, margin = 0.05;
+    QString strata = "serial";
+    quint32 seed = quint32(QDateTime::currentMSecsSinceEpoch());
+    bool ok = true;
+    for(int i=0;ok && i<args.size();++i){
+        if(i+1>=args.size())
+            return usage();
+        if(args.at(i)=="--sheet" || args.at(i)=="--csv")
+            configurationCheck.setProbeSheetFilename(args.at(++i));
+        else if(args.at(i)=="--trace")
+            configurationCheck.setTraceFilename(args.at(++i));
+        else if(args.at(i)=="--confidence")
+            confidence = args.at(++i).toDouble(&ok);
+        else if(args.at(i)=="--margin")
+            margin = args.at(++i).toDouble(&ok);
+        else if(args.at(i)=="--strata")
+            strata = args.at(++i);
+        else if(args.at(i)=="--seed")
+            seed = args.at(++i).toUInt(&ok);
+        else
+            return usage();
+    }
+    if(!ok)
+        return usage();
+    if(!configurationCheck.enableSampling(confidence,margin,strata,seed))
+        return 1;
+
+    configurationCheck.start();
+    configurationCheck.wait();
+    return configurationCheck.failed() ? 1 : 0;
+}
+//------------------------------------------------------------------------------
+int ConsoleCommands::apply(const QString& rootPath, const QStringList& args){
+    Q_UNUSED(rootPath)
+    if(args.size()!=3)
+        return usage();
+
+    QByteArray patchData, baseData;
+    if(!readFile(args.at(0),patchData) || !readFile(args.at(1),baseData))
+        return 1;
+    StationPatch patch;
+    std::string result;
+    if(!patch.read(ByteView(patchData.constData(),size_t(patchData.size()))) ||
+       !patch.apply(ByteView(baseData.constData(),size_t(baseData.size())),result))
+    {
+        qCritical() << "Cannot apply" << args.at(0) << "to" << args.at(1) << ":"
+                    << patch.errorString();
+        return 1;
+    }
+    if(!writeFile(args.at(2),ByteView(result)))
+        return 1;
+    qInfo() << quint64(patch.hunks().size()) << "values patched,"
+            << quint64(result.size()) << "bytes written to" << args.at(2);
+    return 0;
+}
+//------------------------------------------------------------------------------
+int ConsoleCommands::compile(const QString& rootPath, const QStringList& args){
+    Q_UNUSED(rootPath)
+    if(args.size()!=2)
+        return usage();
+
+    QByteArray stationData;
+    if(!readFile(args.at(0),stationData))
+        return 1;
+    StationImage image;
+    std::string imageData;
+    if(!image.compile(ByteView(stationData.constData(),size_t(stationData.size())),
+                      imageData))
+    {
+        qCritical() << "Cannot compile" << args.at(0) << ":" << image.errorString();
+        return 1;
+    }
+    if(!writeFile(args.at(1),ByteView(imageData)))
+        return 1;
+    qInfo() << quint64(stationData.size()) << "bytes compiled into"
+            << quint64(imageData.size()) << QString::asprintf(
+               "(layout %08x)",image.layoutCrc());
+    return 0;
+}
+//------------------------------------------------------------------------------
+int ConsoleCommands::decode(const QString& rootPath, const QStringList& args){
+    Q_UNUSED(rootPath)
+    if(args.size()<2 || args.size()>3)
+        return usage();
+
+    QByteArray imageData, layoutData;
+    uint32_t layoutCrc;
+    if(!readFile(args.at(0),imageData))
+        return 1;
+    if(!StationImage::imageLayoutCrc(
+            ByteView(imageData.constData(),size_t(imageData.size())),layoutCrc))
+    {
+        qCritical() << args.at(0) << "is not a station image.";
+        return 1;
+    }
+    QString layoutFilename = args.size()>2
+        ? args.at(2)
+        : QFileInfo(args.at(0)).absolutePath()+"/layouts/"+
+          QString::asprintf("%08x.xml",layoutCrc);
+    if(!readFile(layoutFilename,layoutData))
+        return 1;
+
+    StationImage image;
+    std::string stationData;
+    if(!image.decode(ByteView(imageData.constData(),size_t(imageData.size())),
+                     ByteView(layoutData.constData(),size_t(layoutData.size())),
+                     stationData))
+    {
+        qCritical() << "Cannot decode" << args.at(0) << "with layout"
+                    << layoutFilename << ":" << image.errorString();
+        return 1;
+    }
+    return writeFile(args.at(1),ByteView(stationData)) ? 0 : 1;
+}
+//------------------------------------------------------------------------------
+int ConsoleCommands::index(const QString& rootPath, const QStringList& args){
+    if(!args.isEmpty())
+        return usage();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    FleetIndex fleetIndex;
+    FleetIndex::BuildStats stats;
+    if(!fleetIndex.build(rootPath+"stations",ConfigurationCheck::inputXmlFilename(),
+                         rootPath+_fleetIndexFilename,stats))
+    {
+        qCritical() << "Cannot write fleet index" << rootPath+_fleetIndexFilename;
+        return 1;
+    }
+
+    qInfo() << "Fleet index:" << stats.stationCount << "stations ("
+            << stats.parsedCount << "parsed," << stats.reusedCount << "unchanged,"
+            << stats.failedCount << "failed)," << fleetIndex.pathCount() << "paths,"
+            << fleetIndex.valueCount() << "distinct values,"
+            << fleetIndex.rowCount() << "rows in" << timer.elapsed() << "ms.";
+    return 0;
+}
+//------------------------------------------------------------------------------
+int ConsoleCommands::query(const QString& rootPath, const QStringList& args){
+    QElapsedTimer timer;
+    timer.start();
+
+    FleetIndex fleetIndex;
+    if(!fleetIndex.open(rootPath+_fleetIndexFilename)){
+        qCritical() << "Cannot open fleet index, please run the 'index' command.";
+        return 1;
+    }
+
+    QTextStream out(stdout);
+    QVector<FleetIndex::Condition> conditions;
+    int countByPath = -1, histogramPath = -1, buckets = 10;
+    for(int i=0;i<args.size();++i){
+        const QString& arg = args.at(i);
+        if(arg=="--paths"){
+            QString pattern = args.value(i+1);
+            for(int p=0;p<int(fleetIndex.pathCount());++p){
+                QString path = fleetIndex.path(p);
+                if(pattern.isEmpty() || path.contains(pattern))
+                    out << path << (fleetIndex.isIPv4Path(p) ? "  [ipv4]" : "")
+                        << '\n';
+            }
+            return 0;
+        }
+        if(i+1>=args.size())
+            return usage();
+
+        QString param = args.at(++i);
+        QString pathName = param;
+        FleetIndex::Condition condition;
+        if(arg=="--where"){
+            int opPos = param.lastIndexOf(')')+1;
+            if(opPos<=0 || opPos>=param.length())
+                return usage();
+            pathName = param.left(opPos);
+            if(param.midRef(opPos).startsWith("!=")){
+                condition.op = FleetIndex::coNotEqual;
+                condition.value = param.mid(opPos+2);
+            }else if(param.at(opPos)=='='){
+                condition.op = FleetIndex::coEqual;
+                condition.value = param.mid(opPos+1);
+            }else if(param.at(opPos)=='~'){
+                condition.op = FleetIndex::coPrefix;
+                condition.value = param.mid(opPos+1);
+            }else
+                return usage();
+        }else if(arg=="--buckets"){
+            bool ok;
+            buckets = param.toInt(&ok);
+            if(!ok || buckets<=0)
+                return usage();
+            continue;
+        }else if(arg!="--count-by" && arg!="--histogram")
+            return usage();
+
+        QVector<int> paths = fleetIndex.findPaths(pathName);
+        if(paths.size()!=1){
+            qCritical() << (paths.isEmpty() ? "Unknown path" : "Ambiguous path")
+                        << pathName;
+            for(int p=0;p<paths.size();++p)
+                qCritical() << "    " << fleetIndex.path(paths.at(p));
+            return 1;
+        }
+
+        if(arg=="--where"){
+            condition.pathId = paths.first();
+            conditions.append(condition);
+        }else if(arg=="--count-by")
+            countByPath = paths.first();
+        else
+            histogramPath = paths.first();
+    }
+
+    QBitArray stations = fleetIndex.select(conditions);
+    if(countByPath>=0 || histogramPath>=0){
+        QVector<FleetIndex::ValueCount_t> counts =
+            countByPath>=0 ? fleetIndex.countBy(countByPath,stations)
+                           : fleetIndex.histogram(histogramPath,stations,buckets);
+        for(int i=0;i<counts.size();++i)
+            out << QString("%1  %2\n").arg(counts.at(i).second,8)
+                                      .arg(counts.at(i).first);
+    }else{
+        for(int s=0;s<stations.size();++s)
+            if(stations.testBit(s))
+                out << fleetIndex.stationSerial(uint(s)) << '\n';
+    }
+    out << QString("%1 of %2 stations matched.\n").arg(stations.count(true))
+                                                  .arg(stations.size());
+    out.flush();
+
+    qInfo() << "Query done in" << timer.elapsed() << "ms.";
+    return 0;
+}
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+bool ConsoleCommands::readFile(const QString& filename, QByteArray& data){
+    QFile file(filename);
+    if(!file.open(QIODevice::ReadOnly)){
+        qCritical() << "Cannot open" << filename;
+        return false;
+    }
+    data = file.readAll();
+    return true;
+}
+//------------------------------------------------------------------------------
+bool ConsoleCommands::writeFile(const QString& filename, ByteView bytes){
+    QSaveFile file(filename);
+    if(!file.open(QIODevice::WriteOnly) ||
+       file.write(bytes.data(),qint64(bytes.size()))!=qint64(bytes.size()) ||
+       !file.commit())
+    {
+        qCritical() << "Cannot write" << filename;
+        return false;
+    }
+    return true;
+}
+//------------------------------------------------------------------------------
+int ConsoleCommands::usage(){
+    QTextStream err(stderr);
+    err << "Usage: qMiraProbeXMLCheck [COMMAND [ARGS]]\n"
+           "Without COMMAND the configurations check GUI is started.\n"
+           "Commands:\n";
+    for(size_t i=0;i<sizeof(_commands)/sizeof(Command);++i)
+        err << "  " << _commands[i].usage << '\n';
+    return 2;
+}
+//------------------------------------------------------------------------------
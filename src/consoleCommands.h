@@ -0,0 +1,49 @@
+#ifndef CONSOLECOMMANDS_H
+#define CONSOLECOMMANDS_H
+
+#include <QStringList>
+#include "byteView.h"
+
+
+//------------------------------------------------------------------------------
+// class ConsoleCommands
+//------------------------------------------------------------------------------
+// Headless commands, selected by the first command line argument
+// (e.g. "qMiraProbeXMLCheck query --count-by ..."); without one the GUI runs.
+//------------------------------------------------------------------------------
+class ConsoleCommands
+{
+    public:
+        // Methods
+        static bool isCommand(const char *name);
+        static int exec(const QStringList& arguments);
+    private:
+        // Types
+        typedef int (*CommandFnPtr_t)(const QString& rootPath,
+                                      const QStringList& args);
+        struct Command {
+            const char *name;
+            CommandFnPtr_t fn;
+            const char *usage;
+        };
+        // Data
+        static const Command _commands[];
+        static const QString _fleetIndexFilename;
+        // Private constructor (unimplemented!)
+        ConsoleCommands();
+        // Commands
+        static int check(const QString& rootPath, const QStringList& args);
+        static int generate(const QString& rootPath, const QStringList& args);
+        static int audit(const QString& rootPath, const QStringList& args);
+        static int apply(const QString& rootPath, const QStringList& args);
+        static int compile(const QString& rootPath, const QStringList& args);
+        static int decode(const QString& rootPath, const QStringList& args);
+        static int index(const QString& rootPath, const QStringList& args);
+        static int query(const QString& rootPath, const QStringList& args);
+        // Helpers
+        static bool readFile(const QString& filename, QByteArray& data);
+        static bool writeFile(const QString& filename, ByteView bytes);
+        static int usage();
+};
+
+#endif // CONSOLECOMMANDS_H
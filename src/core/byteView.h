@@ -0,0 +1,53 @@
+#ifndef BYTEVIEW_H
+#define BYTEVIEW_H
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+
+//------------------------------------------------------------------------------
+// class ByteView
+//------------------------------------------------------------------------------
+// Non owning [data,data+size) view of bytes in the document's own encoding,
+// the C++14 stand-in for std::string_view used by the core engine.
+//------------------------------------------------------------------------------
+class ByteView
+{
+    public:
+        // Constructors
+        inline ByteView() : _data(nullptr), _size(0) {}
+        inline ByteView(const char *data, size_t size) : _data(data), _size(size) {}
+        inline ByteView(const char *begin, const char *end) :
+            _data(begin), _size(size_t(end-begin)) {}
+        inline ByteView(const std::string& s) : _data(s.data()), _size(s.size()) {}
+        static inline ByteView fromCString(const char *s) {
+            return ByteView(s,strlen(s));
+        }
+        // Accessors
+        inline const char *data()const { return _data; }
+        inline size_t size()const { return _size; }
+        inline bool isEmpty()const { return !_size; }
+        inline bool isNull()const { return !_data; }
+        inline const char *begin()const { return _data; }
+        inline const char *end()const { return _data+_size; }
+        inline char operator[](size_t i)const { return _data[i]; }
+        inline ByteView mid(size_t pos, size_t size)const {
+            return ByteView(_data+pos,size);
+        }
+        inline bool contains(char c)const {
+            return _size && memchr(_data,c,_size);
+        }
+        inline std::string toString()const { return std::string(_data,_size); }
+        // Operators
+        inline bool operator==(const ByteView& rhs)const {
+            return _size==rhs._size && (!_size || !memcmp(_data,rhs._data,_size));
+        }
+        inline bool operator!=(const ByteView& rhs)const { return !(*this==rhs); }
+    private:
+        // Data
+        const char *_data;
+        size_t _size;
+};
+
+#endif // BYTEVIEW_H
@@ -0,0 +1,311 @@
+#include "checkEngine.h"
+
+#include <algorithm>
+#include "ipCodec.h"
+
+
+//------------------------------------------------------------------------------
+// class CheckEngine implementation
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+CheckEngine::CheckEngine() : _checkCount(0), _unplannedDepth(0),
+    _subtreeSkipping(false), _skippedByteCount(0), _pendingCheck(-1),
+    _performedCheckCount(0), _wrongValueCount(0)
+{
+    clear();
+    _path.reserve(32);
+}
+//------------------------------------------------------------------------------
+// Methods
+//------------------------------------------------------------------------------
+void CheckEngine::clear(){
+    Node root;
+    root.checkIndex = -1;
+    _nodes.assign(1,root);
+    _checkCount = 0;
+}
+//------------------------------------------------------------------------------
+void CheckEngine::setSubtreeSkipping(bool on){
+    _subtreeSkipping = on;
+}
+//------------------------------------------------------------------------------
+bool CheckEngine::addCheck(ByteView path, int checkIndex){
+    // "Tag(name)/Tag(name)/...": names may contain '/', not ')'
+    int node = 0;
+    const char *p = path.begin(), *end = path.end();
+    while(p<end){
+        const char *open = static_cast<const char *>(memchr(p,'(',size_t(end-p)));
+        const char *close = open ? static_cast<const char *>(
+                                       memchr(open,')',size_t(end-open)))
+                                 : nullptr;
+        if(!close || open==p || (close+1<end && close[1]!='/'))
+            return false;
+        Node segment;
+        segment.tag.assign(p,open);
+        segment.name.assign(open+1,close);
+        segment.checkIndex = -1;
+        p = close+2;
+
+        int child = -1;
+        const std::vector<int>& children = _nodes[size_t(node)].children;
+        for(size_t i=0;i<children.size() && child<0;++i){
+            const Node& candidate = _nodes[size_t(children[i])];
+            if(candidate.tag==segment.tag && candidate.name==segment.name)
+                child = children[i];
+        }
+        if(child<0){
+            child = int(_nodes.size());
+            _nodes.push_back(segment);
+            _nodes[size_t(node)].children.push_back(child);
+        }
+        node = child;
+    }
+    if(!node || _nodes[size_t(node)].checkIndex>=0 || checkIndex<0)
+        return false;
+    _nodes[size_t(node)].checkIndex = checkIndex;
+    _checkCount = std::max(_checkCount,checkIndex+1);
+    return true;
+}
+//------------------------------------------------------------------------------
+bool CheckEngine::check(ByteView document, const Expectation *expectations,
+    FindingSink& findings, ElementSink *elements)
+{
+    Location unlocated = { -1, 0, 0, 0, ByteView(), false, false };
+    _locations.assign(size_t(_checkCount),unlocated);
+    _wrong.assign(size_t(_checkCount),0);
+    _performedCheckCount = _wrongValueCount = 0;
+    _path.assign(1,0);
+    _unplannedDepth = 0;
+    _skippedByteCount = 0;
+    _pendingCheck = -1;
+    _scanner.reset(document);
+    // Nothing to skip for an element sink: it wants them all
+    bool skipping = _subtreeSkipping && !elements;
+
+    for(;;){
+        switch(_scanner.next()){
+            case XmlScanner::tStartElement:{
+                // A checked element has a value, not child elements
+                if(_pendingCheck>=0){
+                    findings.parseError("checked element with child elements",
+                                        _scanner.tokenOffset());
+                    return false;
+                }
+                if(elements)
+                    elements->startElement(_scanner);
+                if(_unplannedDepth){
+                    ++_unplannedDepth;
+                    break;
+                }
+                int child = findChild(_path.back(),_scanner.name(),
+                                      _scanner.attribute("name"));
+                if(child<0){
+                    if(skipping && !_scanner.isSelfClosing()){
+                        // No planned element below: on to the end tag
+                        size_t from = _scanner.position();
+                        if(_scanner.skipElement()!=XmlScanner::tEndElement){
+                            findings.parseError(_scanner.errorString(),
+                                                _scanner.tokenOffset());
+                            return false;
+                        }
+                        _skippedByteCount += _scanner.tokenOffset()-from;
+                        break;
+                    }
+                    ++_unplannedDepth;
+                    break;
+                }
+                _path.push_back(child);
+                _pendingCheck = _nodes[size_t(child)].checkIndex;
+                if(_pendingCheck>=0){
+                    _pending.tagOffset = _scanner.tokenOffset();
+                    _pending.tag = _scanner.name();
+                    _pending.selfClosing = _scanner.isSelfClosing();
+                    _pending.offset = _scanner.position()-
+                                      (_pending.selfClosing ? 2 : 0);
+                }
+                break;
+            }
+            case XmlScanner::tText:
+                if(elements)
+                    elements->text(_scanner.text());
+                break;
+            case XmlScanner::tEndElement:
+                // The value is all that lies between the tags: texts, CDATA
+                // sections, comments
+                if(_pendingCheck>=0){
+                    size_t end = _pending.selfClosing ? _pending.offset
+                                                      : _scanner.tokenOffset();
+                    if(!checkValue(expectations,findings,
+                                   document.mid(_pending.offset,end-_pending.offset)))
+                        return false;
+                }
+                if(elements)
+                    elements->endElement(_scanner);
+                if(_unplannedDepth)
+                    --_unplannedDepth;
+                else if(_path.size()>1)
+                    _path.pop_back();
+                break;
+            case XmlScanner::tProcessingInstruction:
+                findings.parseError("unimplemented 'ProcessingInstruction' handling",
+                                    _scanner.tokenOffset());
+                return false;
+            case XmlScanner::tDoctype:
+                findings.parseError("unimplemented 'DTD' handling",
+                                    _scanner.tokenOffset());
+                return false;
+            case XmlScanner::tError:
+                findings.parseError(_scanner.errorString(),_scanner.tokenOffset());
+                return false;
+            case XmlScanner::tEndDocument:
+                return true;
+            default: // declaration, comments, CDATA
+                break;
+        }
+    }
+}
+//------------------------------------------------------------------------------
+void CheckEngine::checkLocated(ByteView document,
+    const std::vector<Location>& locations, const Expectation *expectations,
+    FindingSink& findings)
+{
+    // Values already located (e.g. by StationClasses): no scan, the same
+    // comparisons and the same state for writeFixed()
+    Location unlocated = { -1, 0, 0, 0, ByteView(), false, false };
+    _locations.assign(size_t(_checkCount),unlocated);
+    _wrong.assign(size_t(_checkCount),0);
+    _performedCheckCount = _wrongValueCount = 0;
+    _scanner.reset(document);
+    _scanner.next(); // the XML declaration, for documentEncoding()
+    // In file order, as a scan reports them
+    _order.clear();
+    for(size_t i=0;i<locations.size() && i<size_t(_checkCount);++i)
+        if(locations[i].checkIndex==int(i))
+            _order.push_back(int(i));
+    std::sort(_order.begin(),_order.end(),[&locations](int a, int b){
+        return locations[size_t(a)].offset<locations[size_t(b)].offset;
+    });
+    for(size_t i=0;i<_order.size();++i){
+        const Location& location = locations[size_t(_order[i])];
+        _pending = location;
+        _pendingCheck = location.checkIndex;
+        checkValue(expectations,findings,
+                   document.mid(location.offset,location.length));
+    }
+}
+//------------------------------------------------------------------------------
+void CheckEngine::fixes(const Expectation *expectations,
+    std::vector<Fix>& fixes)
+{
+    // The wrong values of the last check, in file order
+    _order.clear();
+    for(int i=0;i<_checkCount;++i)
+        if(_wrong[size_t(i)] && _locations[size_t(i)].checkIndex==i)
+            _order.push_back(i);
+    std::sort(_order.begin(),_order.end(),[this](int a, int b){
+        return _locations[size_t(a)].offset<_locations[size_t(b)].offset;
+    });
+
+    fixes.resize(_order.size());
+    for(size_t i=0;i<_order.size();++i){
+        const Location& location = _locations[size_t(_order[i])];
+        const Expectation& expected = expectations[_order[i]];
+        Fix& fix = fixes[i];
+        fix.checkIndex = _order[i];
+        fix.offset = location.offset;
+        if(location.selfClosing){
+            // "<tag/>" -> "<tag>value</tag>"
+            fix.length = 2;
+            fix.text.assign(1,'>');
+            fix.text.append(expected.text.data(),expected.text.size());
+            fix.text.append("</",2);
+            fix.text.append(location.tag.data(),location.tag.size());
+            fix.text += '>';
+        }else{
+            fix.length = location.length;
+            fix.text.assign(expected.text.data(),expected.text.size());
+        }
+    }
+}
+//------------------------------------------------------------------------------
+bool CheckEngine::writeFixed(ByteView document, const Expectation *expectations,
+    OutputSink& output)
+{
+    // Verbatim copy, wrong values replaced in file order
+    fixes(expectations,_fixes);
+    size_t pos = 0;
+    for(size_t i=0;i<_fixes.size();++i){
+        const Fix& fix = _fixes[i];
+        if(!output.write(document.mid(pos,fix.offset-pos)) ||
+           !output.write(ByteView(fix.text)))
+            return false;
+        pos = fix.offset+fix.length;
+    }
+    return output.write(document.mid(pos,document.size()-pos));
+}
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+int CheckEngine::findChild(int node, ByteView tag, ByteView name){
+    if(name.contains('&') && XmlScanner::decode(name,_decoded))
+        name = ByteView(_decoded);
+    const std::vector<int>& children = _nodes[size_t(node)].children;
+    for(size_t i=0;i<children.size();++i){
+        const Node& child = _nodes[size_t(children[i])];
+        if(ByteView(child.tag)!=tag)
+            continue;
+        if(name.isEmpty() ? child.name=="*" : ByteView(child.name)==name)
+            return children[i];
+    }
+    return -1;
+}
+//------------------------------------------------------------------------------
+bool CheckEngine::checkValue(const Expectation *expectations,
+    FindingSink& findings, ByteView content)
+{
+    // content: the element's bytes between its tags, all of it replaced by
+    // a fix. One location per check: a second occurrence could not be fixed
+    int checkIndex = _pendingCheck;
+    _pendingCheck = -1;
+    Location& location = _locations[size_t(checkIndex)];
+    if(location.checkIndex>=0){
+        findings.parseError("checked element repeated",_pending.tagOffset);
+        return false;
+    }
+    location = _pending;
+    location.checkIndex = checkIndex;
+    location.length = content.size();
+    location.verbatim = !location.selfClosing;
+
+    ByteView value = content;
+    if(content.contains('&') || content.contains('<')){
+        location.verbatim = false;
+        if(XmlScanner::decodeContent(content,_decoded))
+            value = ByteView(_decoded);
+    }
+
+    // Addresses: an unreadable value is 0.0.0.0
+    const Expectation& expected = expectations[checkIndex];
+    _wrong[size_t(checkIndex)] = 0;
+    if(!expected.active)
+        return true;
+    bool right;
+    if(expected.isIPv4){
+        uint32_t addr = 0;
+        if(!IPCodec::parseXmlIPv4(value.begin(),value.end(),addr))
+            addr = 0;
+        right = addr==expected.ipv4;
+    }else
+        right = value==expected.text;
+
+    ++_performedCheckCount;
+    _wrong[size_t(checkIndex)] = !right;
+    if(!right){
+        ++_wrongValueCount;
+        Finding finding = { checkIndex, value, &expected, location.offset };
+        findings.wrongValue(finding);
+    }
+    return true;
+}
+//------------------------------------------------------------------------------
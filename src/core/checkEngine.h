@@ -0,0 +1,141 @@
+#ifndef CHECKENGINE_H
+#define CHECKENGINE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "byteView.h"
+#include "xmlScanner.h"
+
+
+//------------------------------------------------------------------------------
+// class CheckEngine
+//------------------------------------------------------------------------------
+// Qt free station file check: a check plan (element paths in the
+// "Tag(name)/Tag(*)/..." notation, '*' for elements without a name
+// attribute) compiled into a trie walked along with the document, the values
+// of the planned elements compared with the expected ones and, for a station
+// needing fixes, the document copied with the wrong values replaced (or only
+// the replacements listed, see StationPatch). The document is never
+// transcoded: values are compared, and written, as bytes of its own encoding
+// (addresses as signed int32 numbers).
+//
+// A checked element's value is its whole content, texts and CDATA sections
+// joined (comments left out), and a fix replaces that content as a whole. A
+// checked element with child elements, or met twice, is a parse error: the
+// station could not be fixed in place.
+//
+// Front ends plug in sinks: findings (wrong values, parse errors), every
+// element (e.g. for further validation) and the fixed document output. One
+// engine per thread: the per station state is kept from one to the next.
+//
+// With subtree skipping on and no element sink, an element the plan has no
+// path through is not tokenized: the scanner goes straight to its end tag
+// (XmlScanner::skipElement()). Its content is then delimited, not verified.
+//------------------------------------------------------------------------------
+class CheckEngine
+{
+    public:
+        // Types
+        struct Expectation {
+            ByteView text;      // as written in the file (valid XML text): the fix
+            bool isIPv4;        // compared as address: text is the int32
+            uint32_t ipv4;
+            bool active;        // false: located, not compared (another policy)
+        };
+        struct Location {
+            int checkIndex;     // -1: not met
+            size_t tagOffset;   // '<' of the element
+            size_t offset;      // content bytes, between the tags
+            size_t length;
+            ByteView tag;
+            bool selfClosing;   // "<tag/>": offset is that of "/>"
+            bool verbatim;      // content == value: no references, no CDATA or
+                                // comments, not "<tag/>"
+        };
+        struct Finding {
+            int checkIndex;
+            ByteView got;       // decoded value
+            const Expectation *expected;
+            size_t offset;
+        };
+        struct Fix {
+            int checkIndex;
+            size_t offset;      // document bytes replaced
+            size_t length;
+            std::string text;
+        };
+        class FindingSink {
+        public:
+            virtual ~FindingSink() {}
+            virtual void wrongValue(const Finding& finding) = 0;
+            virtual void parseError(const char *reason, size_t offset) = 0;
+        };
+        class ElementSink {
+        public:
+            virtual ~ElementSink() {}
+            virtual void startElement(const XmlScanner& scanner) = 0;
+            virtual void text(ByteView raw) = 0;
+            virtual void endElement(const XmlScanner& scanner) = 0;
+        };
+        class OutputSink {
+        public:
+            virtual ~OutputSink() {}
+            virtual bool write(ByteView bytes) = 0;
+        };
+        // Constructor
+        CheckEngine();
+        // Accessors
+        inline int checkCount()const { return _checkCount; }
+        inline int performedCheckCount()const { return _performedCheckCount; }
+        inline int wrongValueCount()const { return _wrongValueCount; }
+        inline const std::vector<Location>& locations()const { return _locations; }
+        inline ByteView documentEncoding()const { return _scanner.encoding(); }
+        inline bool isSubtreeSkipping()const { return _subtreeSkipping; }
+        inline size_t skippedByteCount()const { return _skippedByteCount; } // last check
+        // Methods
+        void clear();
+        void setSubtreeSkipping(bool on);
+        bool addCheck(ByteView path, int checkIndex);
+        bool check(ByteView document, const Expectation *expectations,
+                   FindingSink& findings, ElementSink *elements = nullptr);
+        void checkLocated(ByteView document, const std::vector<Location>& locations,
+                          const Expectation *expectations, FindingSink& findings);
+        void fixes(const Expectation *expectations, std::vector<Fix>& fixes);
+        bool writeFixed(ByteView document, const Expectation *expectations,
+                        OutputSink& output);
+    private:
+        // Types
+        struct Node {
+            std::string tag;
+            std::string name;   // "*": no name attribute
+            int checkIndex;     // -1: inner node
+            std::vector<int> children;
+        };
+        // Data
+        std::vector<Node> _nodes;   // [0]: above the document element
+        int _checkCount;
+        XmlScanner _scanner;
+        std::vector<int> _path;     // trie nodes of the open planned elements
+        int _unplannedDepth;        // open elements below the last planned one
+        bool _subtreeSkipping;
+        size_t _skippedByteCount;
+        int _pendingCheck;          // value to be read, -1: none
+        Location _pending;
+        std::vector<Location> _locations;   // by check index
+        std::vector<char> _wrong;           // by check index
+        std::vector<int> _order;
+        std::vector<Fix> _fixes;
+        std::string _decoded;
+        int _performedCheckCount;
+        int _wrongValueCount;
+        // Private copy constructor and assignment (unimplemented!)
+        CheckEngine(const CheckEngine&);
+        CheckEngine& operator=(const CheckEngine&);
+        // Helpers
+        int findChild(int node, ByteView tag, ByteView name);
+        bool checkValue(const Expectation *expectations, FindingSink& findings,
+                        ByteView content);
+};
+
+#endif // CHECKENGINE_H
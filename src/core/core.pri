@@ -0,0 +1,12 @@
+# The core library (core.pro) for a project linking it: its headers and the
+# library as built by ../qMiraProbeXMLCheckAll.pro, ahead of its users
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+CORE_LIB_DIR = $$top_builddir/core
+win32:CONFIG(release, debug|release): CORE_LIB_DIR = $$CORE_LIB_DIR/release
+else:win32:CONFIG(debug, debug|release): CORE_LIB_DIR = $$CORE_LIB_DIR/debug
+
+LIBS += -L$$CORE_LIB_DIR -lmiraCore
+win32:!win32-g++: PRE_TARGETDEPS += $$CORE_LIB_DIR/miraCore.lib
+else: PRE_TARGETDEPS += $$CORE_LIB_DIR/libmiraCore.a
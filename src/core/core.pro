@@ -0,0 +1,33 @@
+# Qt free check engine (plain C++14, no Qt module needed): XML byte scanner
+# and check plan walker, see checkEngine.h. A static library, linked through
+# core.pri by the application, the benchmarks and the tests.
+
+TEMPLATE = lib
+CONFIG += staticlib c++14
+CONFIG -= qt
+
+TARGET = miraCore
+
+SOURCES += \
+        checkEngine.cpp \
+        crc32c.cpp \
+        sha256.cpp \
+        stationClasses.cpp \
+        stationImage.cpp \
+        stationPatch.cpp \
+        stationVisitor.cpp \
+        symbolPool.cpp \
+        xmlScanner.cpp
+
+HEADERS += \
+        byteView.h \
+        checkEngine.h \
+        crc32c.h \
+        ipCodec.h \
+        sha256.h \
+        stationClasses.h \
+        stationImage.h \
+        stationPatch.h \
+        stationVisitor.h \
+        symbolPool.h \
+        xmlScanner.h
@@ -0,0 +1,104 @@
+#include "crc32c.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CRC32C_SSE42
+#include <cpuid.h>
+#include <nmmintrin.h>
+#endif
+
+
+//------------------------------------------------------------------------------
+// Tables (reflected 0x82F63B78, sliced by 8) and the SSE4.2 kernel
+//------------------------------------------------------------------------------
+namespace {
+
+struct Crc32cTables {
+    uint32_t slices[8][256];
+    Crc32cTables(){
+        for(uint32_t i=0;i<256;++i){
+            uint32_t crc = i;
+            for(int bit=0;bit<8;++bit)
+                crc = crc & 1 ? 0x82F63B78u ^ (crc>>1) : crc>>1;
+            slices[0][i] = crc;
+        }
+        for(int i=0;i<256;++i)
+            for(int slice=1;slice<8;++slice)
+                slices[slice][i] = (slices[slice-1][i]>>8) ^
+                                   slices[0][slices[slice-1][i] & 0xFF];
+    }
+};
+
+uint32_t updateTables(const unsigned char *p, size_t n, uint32_t crc){
+    static const Crc32cTables tables;
+    const uint32_t (&t)[8][256] = tables.slices;
+    for(;n>=8;p+=8,n-=8){
+        uint32_t low, high;
+        memcpy(&low,p,sizeof(low));
+        memcpy(&high,p+4,sizeof(high));
+        low ^= crc;
+        crc = t[7][low & 0xFF] ^ t[6][(low>>8) & 0xFF] ^
+              t[5][(low>>16) & 0xFF] ^ t[4][low>>24] ^
+              t[3][high & 0xFF] ^ t[2][(high>>8) & 0xFF] ^
+              t[1][(high>>16) & 0xFF] ^ t[0][high>>24];
+    }
+    while(n--)
+        crc = t[0][(crc ^ *p++) & 0xFF] ^ (crc>>8);
+    return crc;
+}
+
+#ifdef CRC32C_SSE42
+__attribute__((target("sse4.2")))
+uint32_t updateSse42(const unsigned char *p, size_t n, uint32_t crc){
+#ifdef __x86_64__
+    uint64_t crc64 = crc;
+    for(;n>=8;p+=8,n-=8){
+        uint64_t word;
+        memcpy(&word,p,sizeof(word));
+        crc64 = _mm_crc32_u64(crc64,word);
+    }
+    crc = uint32_t(crc64);
+#endif
+    for(;n>=4;p+=4,n-=4){
+        uint32_t word;
+        memcpy(&word,p,sizeof(word));
+        crc = _mm_crc32_u32(crc,word);
+    }
+    while(n--)
+        crc = _mm_crc32_u8(crc,*p++);
+    return crc;
+}
+
+bool hasSse42(){
+    unsigned a, b, c, d;
+    return __get_cpuid(1,&a,&b,&c,&d) && (c & bit_SSE4_2);
+}
+#endif
+
+} // namespace
+
+
+//------------------------------------------------------------------------------
+// class Crc32c implementation
+//------------------------------------------------------------------------------
+// Accessors
+//------------------------------------------------------------------------------
+bool Crc32c::isHardwareAccelerated(){
+#ifdef CRC32C_SSE42
+    static const bool sse42 = hasSse42();
+    return sse42;
+#else
+    return false;
+#endif
+}
+//------------------------------------------------------------------------------
+// Methods
+//------------------------------------------------------------------------------
+uint32_t Crc32c::update(ByteView bytes, uint32_t crc){
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(bytes.data());
+#ifdef CRC32C_SSE42
+    if(isHardwareAccelerated())
+        return ~updateSse42(p,bytes.size(),~crc);
+#endif
+    return ~updateTables(p,bytes.size(),~crc);
+}
+//------------------------------------------------------------------------------
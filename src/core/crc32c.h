@@ -0,0 +1,28 @@
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include <cstdint>
+#include "byteView.h"
+
+
+//------------------------------------------------------------------------------
+// class Crc32c
+//------------------------------------------------------------------------------
+// CRC-32C (Castagnoli, reflected 0x82F63B78, as in iSCSI, ext4 or
+// "crc32c" tools): the SSE4.2 crc32 instruction, 8 bytes a step, where the
+// CPU has it (checked once), slice-by-8 tables otherwise. Streaming: each
+// update() takes the value returned by the previous one.
+//------------------------------------------------------------------------------
+class Crc32c
+{
+    public:
+        // Accessors
+        static bool isHardwareAccelerated();
+        // Methods
+        static uint32_t update(ByteView bytes, uint32_t crc = 0);
+    private:
+        // Private constructor (unimplemented!)
+        Crc32c();
+};
+
+#endif // CRC32C_H
@@ -0,0 +1,303 @@
+#ifndef IPCODEC_H
+#define IPCODEC_H
+
+#include <cstddef>
+#include <cstdint>
+
+
+//------------------------------------------------------------------------------
+// class IPCodec
+//------------------------------------------------------------------------------
+// Allocation free conversions between IPv4 addresses/ports and their textual
+// forms, usable in constant expressions. Every parser works on a [begin,end)
+// view of any character type: char for raw file bytes, ushort for
+// QString::utf16(). Addresses are host order uint32_t values taken apart with
+// shifts, so the result does not depend on the machine byte order and no run
+// time endianness detection is needed.
+//
+// Text forms:
+//   dotted quad  "10.123.14.1"            (CSV cells)
+//   XML ipv4     "-1062731184", "-512"    (signed int32 of the address)
+//   XML port     "2031681537"             ((port<<16)+1, unsigned)
+//------------------------------------------------------------------------------
+class IPCodec
+{
+    public:
+        // Constants
+        enum {
+            cMaxDottedQuadLength = 15,  // "255.255.255.255"
+            cMaxInt32Length = 11,       // "-2147483648"
+            cMaxUInt32Length = 10,      // "4294967295"
+        };
+        //----------------------------------------------------------------------
+        // Dotted quad
+        //----------------------------------------------------------------------
+        template<typename Char>
+        static constexpr bool parseDottedQuad(const Char *begin, const Char *end,
+                                              uint32_t& addr) noexcept
+        {
+            // Same acceptance as the former split(".") + toUInt() path: four
+            // decimal fields <= 255, blanks around a field are tolerated.
+            uint32_t result = 0;
+            int field = 0;
+            const Char *p = begin;
+            while(field<4){
+                while(p<end && isBlank(*p))
+                    ++p;
+                uint32_t value = 0;
+                int digits = 0;
+                while(p<end && isDigit(*p)){
+                    value = value*10 + uint32_t(*p-'0');
+                    if(value>255)
+                        return false;
+                    ++p;
+                    ++digits;
+                }
+                while(p<end && isBlank(*p))
+                    ++p;
+                if(!digits)
+                    return false;
+                result = (result<<8) | value;
+                if(++field<4){
+                    if(p>=end || *p!='.')
+                        return false;
+                    ++p;
+                }
+            }
+            if(p!=end)
+                return false;
+            addr = result;
+            return true;
+        }
+        //----------------------------------------------------------------------
+        template<typename Char>
+        static constexpr size_t formatDottedQuad(uint32_t addr, Char *out) noexcept
+        {
+            size_t length = 0;
+            for(int shift=24;shift>=0;shift-=8){
+                uint32_t value = (addr>>shift) & 0xFF;
+                if(value>=100)
+                    out[length++] = Char('0'+value/100);
+                if(value>=10)
+                    out[length++] = Char('0'+value/10%10);
+                out[length++] = Char('0'+value%10);
+                if(shift)
+                    out[length++] = Char('.');
+            }
+            return length;
+        }
+        //----------------------------------------------------------------------
+        // Decimal integers (XML values)
+        //----------------------------------------------------------------------
+        template<typename Char>
+        static constexpr bool parseInt32(const Char *begin, const Char *end,
+                                         int32_t& value) noexcept
+        {
+            const Char *p = skipBlanks(begin,end);
+            end = skipTrailingBlanks(p,end);
+            bool negative = false;
+            if(p<end && (*p=='-' || *p=='+'))
+                negative = *p++=='-';
+            uint64_t magnitude = 0;
+            if(!parseDigits(p,end,magnitude) ||
+               magnitude>(negative ? uint64_t(2147483648u) : uint64_t(2147483647u)))
+                return false;
+            value = negative ? int32_t(-int64_t(magnitude)) : int32_t(magnitude);
+            return true;
+        }
+        //----------------------------------------------------------------------
+        template<typename Char>
+        static constexpr bool parseUInt32(const Char *begin, const Char *end,
+                                          uint32_t& value) noexcept
+        {
+            const Char *p = skipBlanks(begin,end);
+            end = skipTrailingBlanks(p,end);
+            if(p<end && *p=='+')
+                ++p;
+            uint64_t magnitude = 0;
+            if(!parseDigits(p,end,magnitude) || magnitude>uint64_t(4294967295u))
+                return false;
+            value = uint32_t(magnitude);
+            return true;
+        }
+        //----------------------------------------------------------------------
+        template<typename Char>
+        static constexpr size_t formatUInt32(uint32_t value, Char *out) noexcept
+        {
+            Char digits[cMaxUInt32Length] = {};
+            size_t count = 0;
+            do{
+                digits[count++] = Char('0'+value%10);
+                value /= 10;
+            }while(value);
+            for(size_t i=0;i<count;++i)
+                out[i] = digits[count-1-i];
+            return count;
+        }
+        //----------------------------------------------------------------------
+        template<typename Char>
+        static constexpr size_t formatInt32(int32_t value, Char *out) noexcept
+        {
+            if(value>=0)
+                return formatUInt32(uint32_t(value),out);
+            out[0] = Char('-');
+            return 1+formatUInt32(uint32_t(-int64_t(value)),out+1);
+        }
+        //----------------------------------------------------------------------
+        // XML ipv4 values: the address as a signed 32 bit integer
+        //----------------------------------------------------------------------
+        template<typename Char>
+        static constexpr bool parseXmlIPv4(const Char *begin, const Char *end,
+                                           uint32_t& addr) noexcept
+        {
+            int32_t value = 0;
+            if(!parseInt32(begin,end,value))
+                return false;
+            addr = uint32_t(value);
+            return true;
+        }
+        //----------------------------------------------------------------------
+        template<typename Char>
+        static constexpr size_t formatXmlIPv4(uint32_t addr, Char *out) noexcept
+        {
+            return formatInt32(toInt32(addr),out);
+        }
+        //----------------------------------------------------------------------
+        // XML ports: (port<<16)+1
+        //----------------------------------------------------------------------
+        static constexpr uint32_t encodePort(uint32_t port) noexcept
+        {
+            return (port<<16)+1;
+        }
+        //----------------------------------------------------------------------
+        static constexpr uint32_t decodePort(uint32_t xmlCodedPort) noexcept
+        {
+            return (xmlCodedPort & 0xFFFF0000u)>>16;
+        }
+        //----------------------------------------------------------------------
+        template<typename Char>
+        static constexpr bool parseXmlPort(const Char *begin, const Char *end,
+                                           uint32_t& port) noexcept
+        {
+            uint32_t coded = 0;
+            if(!parseUInt32(begin,end,coded))
+                return false;
+            port = decodePort(coded);
+            return true;
+        }
+        //----------------------------------------------------------------------
+        template<typename Char>
+        static constexpr size_t formatXmlPort(uint32_t port, Char *out) noexcept
+        {
+            return formatUInt32(encodePort(port),out);
+        }
+        //----------------------------------------------------------------------
+        // Batch conversion
+        //----------------------------------------------------------------------
+        // Converts the dotted quads found in column 'column' of every CSV row
+        // in [begin,end) into out[0..maxRows). Cells that are not a valid
+        // dotted quad give 0, like an invalid IPValue. Quoted cells are
+        // honored, quotes are not part of the value. Returns the row count.
+        template<typename Char>
+        static constexpr size_t parseCSVColumn(const Char *begin, const Char *end,
+                                               unsigned column, uint32_t *out,
+                                               size_t maxRows) noexcept
+        {
+            size_t rows = 0;
+            const Char *p = begin;
+            while(p<end && rows<maxRows){
+                unsigned col = 0;
+                const Char *cellBegin = p;
+                const Char *valueBegin = nullptr, *valueEnd = nullptr;
+                bool quoted = false;
+                for(;;++p){
+                    if(p<end && *p=='"'){
+                        quoted = !quoted;
+                        continue;
+                    }
+                    if(p>=end || (!quoted && (*p==',' || *p=='\n' || *p=='\r'))){
+                        if(col==column){
+                            valueBegin = cellBegin;
+                            valueEnd = p;
+                        }
+                        if(p>=end || *p!=',')
+                            break;
+                        ++col;
+                        cellBegin = p+1;
+                    }
+                }
+                if(valueBegin && valueEnd-valueBegin>=2 && *valueBegin=='"' &&
+                   valueEnd[-1]=='"')
+                {
+                    ++valueBegin;
+                    --valueEnd;
+                }
+                uint32_t addr = 0;
+                if(!valueBegin || !parseDottedQuad(valueBegin,valueEnd,addr))
+                    addr = 0;
+                out[rows++] = addr;
+
+                if(p<end && *p=='\r')
+                    ++p;
+                if(p<end && *p=='\n')
+                    ++p;
+            }
+            return rows;
+        }
+        //----------------------------------------------------------------------
+        // Helpers
+        //----------------------------------------------------------------------
+        static constexpr int32_t toInt32(uint32_t addr) noexcept
+        {
+            return addr<=2147483647u ? int32_t(addr)
+                                     : int32_t(int64_t(addr)-4294967296ll);
+        }
+    private:
+        // Private constructor (unimplemented!)
+        IPCodec();
+        // Helpers
+        template<typename Char>
+        static constexpr bool isDigit(Char c) noexcept
+        {
+            return c>='0' && c<='9';
+        }
+        template<typename Char>
+        static constexpr bool isBlank(Char c) noexcept
+        {
+            return c==' ' || c=='\t';
+        }
+        template<typename Char>
+        static constexpr const Char* skipBlanks(const Char *p, const Char *end) noexcept
+        {
+            while(p<end && isBlank(*p))
+                ++p;
+            return p;
+        }
+        template<typename Char>
+        static constexpr const Char* skipTrailingBlanks(const Char *begin,
+                                                        const Char *end) noexcept
+        {
+            while(end>begin && isBlank(end[-1]))
+                --end;
+            return end;
+        }
+        template<typename Char>
+        static constexpr bool parseDigits(const Char *p, const Char *end,
+                                          uint64_t& value) noexcept
+        {
+            if(p>=end)
+                return false;
+            uint64_t result = 0;
+            for(;p<end;++p){
+                if(!isDigit(*p))
+                    return false;
+                result = result*10 + uint64_t(*p-'0');
+                if(result>uint64_t(4294967295u))
+                    return false;
+            }
+            value = result;
+            return true;
+        }
+};
+
+#endif // IPCODEC_H
@@ -0,0 +1,221 @@
+#include "sha256.h"
+
+#include <algorithm>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SHA256_SHANI
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+
+//------------------------------------------------------------------------------
+// Constants and the block kernels
+//------------------------------------------------------------------------------
+namespace {
+
+const uint32_t roundConstants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+inline uint32_t rotr(uint32_t x, int n) {
+    return (x>>n) | (x<<(32-n));
+}
+
+void compressPortable(uint32_t state[8], const unsigned char *p, size_t count){
+    uint32_t w[64];
+    for(;count--;p+=64){
+        for(int i=0;i<16;++i)
+            w[i] = uint32_t(p[4*i])<<24 | uint32_t(p[4*i+1])<<16 |
+                   uint32_t(p[4*i+2])<<8 | uint32_t(p[4*i+3]);
+        for(int i=16;i<64;++i){
+            uint32_t s0 = rotr(w[i-15],7) ^ rotr(w[i-15],18) ^ (w[i-15]>>3);
+            uint32_t s1 = rotr(w[i-2],17) ^ rotr(w[i-2],19) ^ (w[i-2]>>10);
+            w[i] = w[i-16]+s0+w[i-7]+s1;
+        }
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3],
+                 e = state[4], f = state[5], g = state[6], h = state[7];
+        for(int i=0;i<64;++i){
+            uint32_t t1 = h+(rotr(e,6) ^ rotr(e,11) ^ rotr(e,25))+
+                          ((e & f) ^ (~e & g))+roundConstants[i]+w[i];
+            uint32_t t2 = (rotr(a,2) ^ rotr(a,13) ^ rotr(a,22))+
+                          ((a & b) ^ (a & c) ^ (b & c));
+            h = g; g = f; f = e; e = d+t1;
+            d = c; c = b; b = a; a = t1+t2;
+        }
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    }
+}
+
+#ifdef SHA256_SHANI
+__attribute__((target("sha,sse4.1,ssse3")))
+void compressShaNi(uint32_t state[8], const unsigned char *p, size_t count){
+    // Four rounds a step: sha256rnds2 twice on W+K, the schedule of the
+    // next words interleaved (msg1 three groups ahead, msg2 one ahead)
+    const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bLL,
+                                            0x0405060700010203LL);
+    __m128i tmp = _mm_loadu_si128(reinterpret_cast<const __m128i *>(state));
+    __m128i state1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(state+4));
+    tmp = _mm_shuffle_epi32(tmp,0xB1);              // CDAB
+    state1 = _mm_shuffle_epi32(state1,0x1B);        // EFGH
+    __m128i state0 = _mm_alignr_epi8(tmp,state1,8); // ABEF
+    state1 = _mm_blend_epi16(state1,tmp,0xF0);      // CDGH
+
+    for(;count--;p+=64){
+        __m128i abef = state0, cdgh = state1;
+        __m128i w[4];
+        for(int i=0;i<16;++i){
+            __m128i& words = w[i & 3];
+            if(i<4)
+                words = _mm_shuffle_epi8(_mm_loadu_si128(
+                    reinterpret_cast<const __m128i *>(p+16*i)),byteSwap);
+            __m128i message = _mm_add_epi32(words,_mm_loadu_si128(
+                reinterpret_cast<const __m128i *>(roundConstants+4*i)));
+            state1 = _mm_sha256rnds2_epu32(state1,state0,message);
+            if(i>=3 && i<=14){
+                __m128i& next = w[(i+1) & 3];
+                next = _mm_add_epi32(next,_mm_alignr_epi8(words,w[(i+3) & 3],4));
+                next = _mm_sha256msg2_epu32(next,words);
+            }
+            message = _mm_shuffle_epi32(message,0x0E);
+            state0 = _mm_sha256rnds2_epu32(state0,state1,message);
+            if(i>=1 && i<=12)
+                w[(i+3) & 3] = _mm_sha256msg1_epu32(w[(i+3) & 3],words);
+        }
+        state0 = _mm_add_epi32(state0,abef);
+        state1 = _mm_add_epi32(state1,cdgh);
+    }
+
+    tmp = _mm_shuffle_epi32(state0,0x1B);           // FEBA
+    state1 = _mm_shuffle_epi32(state1,0xB1);        // DCHG
+    state0 = _mm_blend_epi16(tmp,state1,0xF0);      // DCBA
+    state1 = _mm_alignr_epi8(state1,tmp,8);         // HGFE
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(state),state0);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(state+4),state1);
+}
+
+bool hasShaNi(){
+    // SHA extensions, and the SSSE3/SSE4.1 shuffles the kernel uses
+    unsigned a, b, c, d;
+    if(!__get_cpuid(1,&a,&b,&c,&d) || !(c & bit_SSSE3) || !(c & bit_SSE4_1))
+        return false;
+    return __get_cpuid_count(7,0,&a,&b,&c,&d) && (b & (1u<<29));
+}
+#endif
+
+} // namespace
+
+
+//------------------------------------------------------------------------------
+// class Sha256 implementation
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+Sha256::Sha256(){
+    reset();
+}
+//------------------------------------------------------------------------------
+// Accessors
+//------------------------------------------------------------------------------
+bool Sha256::isHardwareAccelerated(){
+#ifdef SHA256_SHANI
+    static const bool shaNi = hasShaNi();
+    return shaNi;
+#else
+    return false;
+#endif
+}
+//------------------------------------------------------------------------------
+// Methods
+//------------------------------------------------------------------------------
+void Sha256::reset(){
+    static const uint32_t initialState[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+        0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+    memcpy(_state,initialState,sizeof(_state));
+    _blockSize = 0;
+    _length = 0;
+}
+//------------------------------------------------------------------------------
+void Sha256::update(ByteView bytes){
+    // Whole blocks straight from the input, the rest kept for later
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(bytes.data());
+    size_t n = bytes.size();
+    _length += n;
+    if(_blockSize){
+        size_t take = std::min(n,size_t(cBlockSize)-_blockSize);
+        memcpy(_block+_blockSize,p,take);
+        _blockSize += take;
+        p += take;
+        n -= take;
+        if(_blockSize<size_t(cBlockSize))
+            return;
+        compress(_state,_block,1);
+        _blockSize = 0;
+    }
+    if(n>=size_t(cBlockSize)){
+        compress(_state,p,n/cBlockSize);
+        p += n/cBlockSize*cBlockSize;
+        n %= cBlockSize;
+    }
+    memcpy(_block,p,n);
+    _blockSize = n;
+}
+//------------------------------------------------------------------------------
+void Sha256::final(unsigned char digest[cDigestSize]){
+    // 0x80, zeros up to 56 mod 64, the bit length big endian
+    uint64_t bitLength = _length*8;
+    _block[_blockSize++] = 0x80;
+    if(_blockSize>size_t(cBlockSize)-8){
+        memset(_block+_blockSize,0,size_t(cBlockSize)-_blockSize);
+        compress(_state,_block,1);
+        _blockSize = 0;
+    }
+    memset(_block+_blockSize,0,size_t(cBlockSize)-8-_blockSize);
+    for(int i=0;i<8;++i)
+        _block[cBlockSize-1-i] = static_cast<unsigned char>(bitLength>>(8*i));
+    compress(_state,_block,1);
+    for(int i=0;i<8;++i)
+        for(int j=0;j<4;++j)
+            digest[4*i+j] = static_cast<unsigned char>(_state[i]>>(24-8*j));
+    reset();
+}
+//------------------------------------------------------------------------------
+std::string Sha256::hexDigest(){
+    static const char hexDigits[] = "0123456789abcdef";
+    unsigned char digest[cDigestSize];
+    final(digest);
+    std::string hex(2*cDigestSize,'0');
+    for(int i=0;i<cDigestSize;++i){
+        hex[size_t(2*i)] = hexDigits[digest[i]>>4];
+        hex[size_t(2*i+1)] = hexDigits[digest[i] & 0xF];
+    }
+    return hex;
+}
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+void Sha256::compress(uint32_t state[8], const unsigned char *blocks,
+    size_t count)
+{
+#ifdef SHA256_SHANI
+    if(isHardwareAccelerated()){
+        compressShaNi(state,blocks,count);
+        return;
+    }
+#endif
+    compressPortable(state,blocks,count);
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,44 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <cstdint>
+#include <string>
+#include "byteView.h"
+
+
+//------------------------------------------------------------------------------
+// class Sha256
+//------------------------------------------------------------------------------
+// Incremental SHA-256 (FIPS 180-4): update() with the bytes as they go by,
+// then final(). Blocks are compressed with the x86 SHA extensions where the
+// CPU has them (checked once), in portable C++ otherwise.
+//------------------------------------------------------------------------------
+class Sha256
+{
+    public:
+        // Constants
+        enum {
+            cDigestSize = 32,
+            cBlockSize = 64,
+        };
+        // Constructor
+        Sha256();
+        // Accessors
+        static bool isHardwareAccelerated();
+        // Methods
+        void reset();
+        void update(ByteView bytes);
+        void final(unsigned char digest[cDigestSize]);
+        std::string hexDigest(); // final(), lower case hex
+    private:
+        // Data
+        uint32_t _state[8];
+        unsigned char _block[cBlockSize];
+        size_t _blockSize;      // bytes waiting in _block
+        uint64_t _length;       // bytes
+        // Helpers
+        static void compress(uint32_t state[8], const unsigned char *blocks,
+                             size_t count);
+};
+
+#endif // SHA256_H
@@ -0,0 +1,160 @@
+#include "stationClasses.h"
+
+#include <algorithm>
+
+
+//------------------------------------------------------------------------------
+// class StationClasses implementation
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+StationClasses::StationClasses() : _memberCount(0), _refusedCount(0)
+{
+}
+//------------------------------------------------------------------------------
+// Accessors
+//------------------------------------------------------------------------------
+std::vector<unsigned> StationClasses::outliers()const{
+    std::vector<unsigned> serials;
+    for(size_t i=0;i<_classes.size();++i)
+        if(_classes[i].memberCount==1)
+            serials.push_back(_classes[i].representative);
+    std::sort(serials.begin(),serials.end());
+    return serials;
+}
+//------------------------------------------------------------------------------
+// Methods
+//------------------------------------------------------------------------------
+bool StationClasses::match(ByteView document,
+    std::vector<CheckEngine::Location>& locations)
+{
+    size_t tried = std::min(_classes.size(),size_t(cMaxTriedClasses));
+    for(size_t i=0;i<tried;++i){
+        if(!matchClass(_classes[i],document,locations))
+            continue;
+        ++_classes[i].memberCount;
+        ++_memberCount;
+        // Keeps the most populated first, one step at a time
+        if(i && _classes[i].memberCount>_classes[i-1].memberCount)
+            std::swap(_classes[i],_classes[i-1]);
+        return true;
+    }
+    return false;
+}
+//------------------------------------------------------------------------------
+bool StationClasses::insert(unsigned serial, ByteView document,
+    const std::vector<CheckEngine::Location>& locations)
+{
+    // Only layouts with every value located, as plain bytes
+    if(locations.empty())
+        return false;
+    for(size_t i=0;i<locations.size();++i)
+        if(locations[i].checkIndex!=int(i) || !locations[i].verbatim)
+            return false;
+    if(_classes.size()>=size_t(cMaxClasses)){
+        ++_refusedCount;
+        return false;
+    }
+
+    Class stationClass;
+    stationClass.representative = serial;
+    stationClass.memberCount = 1;
+    stationClass.document.assign(document.data(),document.size());
+    for(size_t i=0;i<locations.size();++i){
+        const CheckEngine::Location& location = locations[i];
+        Slot slot = { location.checkIndex, location.tagOffset, location.offset,
+                      location.length, location.tag.size() };
+        stationClass.valueSlots.push_back(slot);
+    }
+    std::sort(stationClass.valueSlots.begin(),stationClass.valueSlots.end(),
+              [](const Slot& a, const Slot& b){ return a.offset<b.offset; });
+    _classes.push_back(stationClass);
+    return true;
+}
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+bool StationClasses::matchClass(const Class& stationClass, ByteView document,
+    std::vector<CheckEngine::Location>& locations)
+{
+    // Up to each checked value, then past it: a value runs up to the next
+    // '<', references send the station to the full parse
+    const std::string& representative = stationClass.document;
+    const std::vector<Slot>& valueSlots = stationClass.valueSlots;
+    CheckEngine::Location unlocated = { -1, 0, 0, 0, ByteView(), false, false };
+    locations.assign(valueSlots.size(),unlocated);
+
+    size_t pos = 0, from = 0;
+    for(size_t i=0;i<valueSlots.size();++i){
+        const Slot& slot = valueSlots[i];
+        if(!matchMasked(representative,from,slot.offset,document,pos))
+            return false;
+        const char *end = static_cast<const char *>(
+            memchr(document.data()+pos,'<',document.size()-pos));
+        if(!end)
+            return false;
+        size_t length = size_t(end-document.data())-pos;
+        if(memchr(document.data()+pos,'&',length))
+            return false;
+
+        CheckEngine::Location& location = locations[size_t(slot.checkIndex)];
+        location.checkIndex = slot.checkIndex;
+        location.tagOffset = pos-(slot.offset-slot.tagOffset);
+        location.offset = pos;
+        location.length = length;
+        location.tag = document.mid(location.tagOffset+1,slot.tagLength);
+        location.verbatim = true;
+        pos += length;
+        from = slot.offset+slot.length;
+    }
+    return matchMasked(representative,from,representative.size(),document,pos) &&
+           pos==document.size();
+}
+//------------------------------------------------------------------------------
+bool StationClasses::matchMasked(const std::string& representative, size_t from,
+    size_t to, ByteView document, size_t& pos)
+{
+    // representative[from,to) against document[pos,...): markup must be the
+    // same, texts may differ. pos ends right after the matched bytes.
+    const char *r = representative.data();
+    const char *d = document.data();
+    while(from<to){
+        size_t same = commonPrefixLength(r+from,d+pos,
+                                         std::min(to-from,document.size()-pos));
+        from += same;
+        pos += same;
+        if(from==to)
+            break;
+
+        // Different bytes: only in the text after a tag
+        size_t textStart = from;
+        while(textStart && r[textStart-1]!='>' && r[textStart-1]!='<')
+            --textStart;
+        if(!textStart || r[textStart-1]!='>')
+            return false;
+        const char *representativeEnd = static_cast<const char *>(
+            memchr(r+from,'<',to-from));
+        const char *documentEnd = static_cast<const char *>(
+            memchr(d+pos,'<',document.size()-pos));
+        if(!representativeEnd || !documentEnd)
+            return false;
+        from = size_t(representativeEnd-r);
+        pos = size_t(documentEnd-d);
+    }
+    return true;
+}
+//------------------------------------------------------------------------------
+size_t StationClasses::commonPrefixLength(const char *a, const char *b, size_t n){
+    size_t i = 0;
+    for(;i+sizeof(uint64_t)<=n;i+=sizeof(uint64_t)){
+        uint64_t wordA, wordB;
+        memcpy(&wordA,a+i,sizeof(wordA));
+        memcpy(&wordB,b+i,sizeof(wordB));
+        if(wordA!=wordB)
+            break;
+    }
+    while(i<n && a[i]==b[i])
+        ++i;
+    return i;
+}
+//------------------------------------------------------------------------------
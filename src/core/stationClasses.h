@@ -0,0 +1,73 @@
+#ifndef STATIONCLASSES_H
+#define STATIONCLASSES_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "byteView.h"
+#include "checkEngine.h"
+
+
+//------------------------------------------------------------------------------
+// class StationClasses
+//------------------------------------------------------------------------------
+// Equivalence classes of station files: two files are in the same class when
+// they are byte for byte identical once their texts are masked out, i.e. the
+// markup is the same and only values differ: the checked ones and the per
+// probe ones nobody checks (calibration coefficients, serial echoes...).
+// A class keeps the bytes of its representative, the first station fully
+// parsed and checked with that markup; a later station matching it gets its
+// checked values located while compared with the representative, no parse.
+// Files are compared, not hashed: no collisions to care about. The most
+// populated classes are tried first, a few of them at most.
+//------------------------------------------------------------------------------
+class StationClasses
+{
+    public:
+        // Constants
+        enum {
+            cMaxClasses = 64,       // representatives kept (72 KB each)
+            cMaxTriedClasses = 8,   // per station not belonging to any
+        };
+        // Constructor
+        StationClasses();
+        // Accessors
+        inline int classCount()const { return int(_classes.size()); }
+        inline unsigned memberCount()const { return _memberCount; } // matched
+        inline unsigned refusedCount()const { return _refusedCount; } // table full
+        std::vector<unsigned> outliers()const; // representatives of no other
+        // Methods
+        bool match(ByteView document, std::vector<CheckEngine::Location>& locations);
+        bool insert(unsigned serial, ByteView document,
+                    const std::vector<CheckEngine::Location>& locations);
+    private:
+        // Types
+        struct Slot {
+            int checkIndex;
+            size_t tagOffset;
+            size_t offset;
+            size_t length;
+            size_t tagLength;
+        };
+        struct Class {
+            unsigned representative;
+            unsigned memberCount;   // representative included
+            std::string document;
+            std::vector<Slot> valueSlots; // by offset
+        };
+        // Data
+        std::vector<Class> _classes; // most populated first
+        unsigned _memberCount;
+        unsigned _refusedCount;
+        // Private copy constructor and assignment (unimplemented!)
+        StationClasses(const StationClasses&);
+        StationClasses& operator=(const StationClasses&);
+        // Helpers
+        static bool matchClass(const Class& stationClass, ByteView document,
+                               std::vector<CheckEngine::Location>& locations);
+        static bool matchMasked(const std::string& representative, size_t from,
+                                size_t to, ByteView document, size_t& pos);
+        static size_t commonPrefixLength(const char *a, const char *b, size_t n);
+};
+
+#endif // STATIONCLASSES_H
@@ -0,0 +1,330 @@
+#include "stationImage.h"
+
+#include <algorithm>
+#include <cstdio>
+#include "stationPatch.h"
+
+
+namespace {
+
+const char imageMagic[4] = { 'M', 'S', 'T', 'I' };
+const char imageVersion = 1;
+
+} // namespace
+
+
+//------------------------------------------------------------------------------
+// class StationImage implementation
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+StationImage::StationImage() : _skeletonFrom(0), _layoutCrc(0), _depth(0),
+    _entryDepth(0), _entryId(0), _entryEndPending(false), _leafOpen(false),
+    _leafNumeric(false), _valuePending(false), _valueOffset(0),
+    _valueLength(0), _error(nullptr)
+{
+}
+//------------------------------------------------------------------------------
+// Accessors
+//------------------------------------------------------------------------------
+bool StationImage::imageLayoutCrc(ByteView image, uint32_t& layoutCrc){
+    if(image.size()<size_t(cHeaderSize) || memcmp(image.data(),imageMagic,4) ||
+       image[4]!=imageVersion)
+        return false;
+    layoutCrc = getUInt32(image.data()+13);
+    return true;
+}
+//------------------------------------------------------------------------------
+// Methods
+//------------------------------------------------------------------------------
+bool StationImage::compile(ByteView document, std::string& image){
+    _error = nullptr;
+    image.assign(imageMagic,4);
+    image += imageVersion;
+    putUInt32(image,uint32_t(document.size()));
+    putUInt32(image,StationPatch::crc32(document));
+    putUInt32(image,0); // layout CRC, known at the end
+
+    startDocument(document);
+    bool recordOpen = false;
+    uint64_t recordId = 0;
+    for(;;){
+        switch(next()){
+            case evValue:{
+                hashSkeleton(_valueOffset,_valueLength);
+                if(!recordOpen){
+                    recordOpen = true;
+                    recordId = _entryId;
+                    _record.clear();
+                }
+                ByteView text = document.mid(_valueOffset,_valueLength);
+                int64_t number;
+                if(_leafNumeric && parseCanonical(text,number)){
+                    uint64_t zigzag = (uint64_t(number)<<1) ^ uint64_t(number>>63);
+                    putVarint(_record,zigzag<<1);
+                }else{
+                    putVarint(_record,(uint64_t(text.size())<<1) | 1);
+                    _record.append(text.data(),text.size());
+                }
+                break;
+            }
+            case evEntryEnd:
+                if(recordOpen){
+                    putVarint(image,recordId);
+                    putVarint(image,_record.size());
+                    image += _record;
+                    recordOpen = false;
+                }
+                break;
+            case evError:
+                return fail(_scanner.errorString());
+            case evEnd:{
+                _layoutCrc = StationPatch::crc32(
+                    document.mid(_skeletonFrom,document.size()-_skeletonFrom),
+                    _layoutCrc);
+                std::string layoutCrc;
+                putUInt32(layoutCrc,_layoutCrc);
+                image.replace(13,4,layoutCrc);
+                return true;
+            }
+        }
+    }
+}
+//------------------------------------------------------------------------------
+bool StationImage::decode(ByteView image, ByteView layout,
+    std::string& document)
+{
+    // The layout walked as by compile(), its values taken from the image
+    _error = nullptr;
+    document.clear();
+    uint32_t layoutCrc;
+    if(!imageLayoutCrc(image,layoutCrc))
+        return fail("Not a station image.");
+    size_t size = getUInt32(image.data()+5);
+    uint32_t crc = getUInt32(image.data()+9);
+
+    startDocument(layout);
+    // The size of the header is only checked at the end: what gets reserved
+    // for it is bounded by the layout and the image (a number decodes to no
+    // more than 3 bytes per varint byte)
+    document.reserve(std::min(size,layout.size()+3*image.size()));
+    size_t pos = cHeaderSize, recordEnd = 0, from = 0;
+    bool recordOpen = false;
+    char number[24];
+    for(;;){
+        switch(next()){
+            case evValue:{
+                hashSkeleton(_valueOffset,_valueLength);
+                document.append(layout.data()+from,_valueOffset-from);
+                from = _valueOffset+_valueLength;
+                if(!recordOpen){
+                    uint64_t id, length;
+                    if(!getVarint(image,pos,id) || !getVarint(image,pos,length) ||
+                       length>image.size()-pos)
+                        return fail("Truncated station image.");
+                    if(id!=_entryId)
+                        return fail("The layout does not match the image.");
+                    recordEnd = pos+size_t(length);
+                    recordOpen = true;
+                }
+                uint64_t header;
+                if(!getVarint(ByteView(image.data(),recordEnd),pos,header))
+                    return fail("The layout does not match the image.");
+                if(header & 1){
+                    size_t length = size_t(header>>1);
+                    if(length>recordEnd-pos)
+                        return fail("Truncated station image.");
+                    document.append(image.data()+pos,length);
+                    pos += length;
+                }else{
+                    uint64_t zigzag = header>>1;
+                    long long value = (long long)(zigzag>>1) ^ -(long long)(zigzag & 1);
+                    document.append(number,size_t(snprintf(number,sizeof(number),
+                                                           "%lld",value)));
+                }
+                break;
+            }
+            case evEntryEnd:
+                if(recordOpen && pos!=recordEnd)
+                    return fail("The layout does not match the image.");
+                recordOpen = false;
+                break;
+            case evError:
+                return fail(_scanner.errorString());
+            case evEnd:
+                document.append(layout.data()+from,layout.size()-from);
+                _layoutCrc = StationPatch::crc32(
+                    layout.mid(_skeletonFrom,layout.size()-_skeletonFrom),
+                    _layoutCrc);
+                if(_layoutCrc!=layoutCrc || pos!=image.size())
+                    return fail("The layout does not match the image.");
+                if(document.size()!=size ||
+                   StationPatch::crc32(ByteView(document))!=crc)
+                    return fail("The decoded file is not the compiled one.");
+                return true;
+        }
+    }
+}
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+bool StationImage::fail(const char *error){
+    _error = error;
+    return false;
+}
+//------------------------------------------------------------------------------
+void StationImage::startDocument(ByteView document){
+    _scanner.reset(document);
+    _document = document;
+    _skeletonFrom = 0;
+    _layoutCrc = 0;
+    _depth = _entryDepth = 0;
+    _entryId = 0;
+    _entryEndPending = _leafOpen = _leafNumeric = _valuePending = false;
+}
+//------------------------------------------------------------------------------
+StationImage::Event StationImage::next(){
+    // Values: texts between the start and end tags of an element in an Entry
+    if(_entryEndPending){
+        _entryEndPending = false;
+        _entryDepth = 0;
+        return evEntryEnd;
+    }
+    for(;;){
+        switch(_scanner.next()){
+            case XmlScanner::tStartElement:
+                ++_depth;
+                if(!_entryDepth && _scanner.name()==ByteView("Entry",5)){
+                    _entryDepth = _depth;
+                    _entryId = parseEntryId(_scanner.attribute("id"));
+                }
+                _leafOpen = _entryDepth>0;
+                _leafNumeric = _leafOpen && isIntegerType(_scanner.attribute("type"));
+                _valuePending = false;
+                break;
+            case XmlScanner::tText:
+                _valuePending = _leafOpen;
+                _valueOffset = _scanner.tokenOffset();
+                _valueLength = _scanner.text().size();
+                _leafOpen = false;
+                break;
+            case XmlScanner::tEndElement:{
+                bool value = _valuePending;
+                bool entryEnd = _depth--==_entryDepth;
+                _leafOpen = _valuePending = false;
+                if(value){
+                    _entryEndPending = entryEnd;
+                    return evValue;
+                }
+                if(entryEnd){
+                    _entryDepth = 0;
+                    return evEntryEnd;
+                }
+                break;
+            }
+            case XmlScanner::tError:
+                return evError;
+            case XmlScanner::tEndDocument:
+                return evEnd;
+            default: // declaration, comments, CDATA, PIs, DTD: layout
+                _leafOpen = _valuePending = false;
+                break;
+        }
+    }
+}
+//------------------------------------------------------------------------------
+void StationImage::hashSkeleton(size_t valueOffset, size_t valueLength){
+    // Up to the value, then a 0 byte in its place: an element losing or
+    // gaining a value is another layout
+    static const char valueMark = 0;
+    _layoutCrc = StationPatch::crc32(
+        _document.mid(_skeletonFrom,valueOffset-_skeletonFrom),_layoutCrc);
+    _layoutCrc = StationPatch::crc32(ByteView(&valueMark,1),_layoutCrc);
+    _skeletonFrom = valueOffset+valueLength;
+}
+//------------------------------------------------------------------------------
+bool StationImage::isIntegerType(ByteView type){
+    // bool, ipv4, int8...int64, uint8...uint64
+    if(type==ByteView("bool",4) || type==ByteView("ipv4",4))
+        return true;
+    size_t digits = type.size()>=4 && !memcmp(type.data(),"uint",4) ? 4
+                  : type.size()>=3 && !memcmp(type.data(),"int",3) ? 3
+                  : 0;
+    if(!digits || digits==type.size())
+        return false;
+    for(;digits<type.size();++digits)
+        if(type[digits]<'0' || type[digits]>'9')
+            return false;
+    return true;
+}
+//------------------------------------------------------------------------------
+bool StationImage::parseCanonical(ByteView text, int64_t& number){
+    // The way the number would be written back: no sign but '-', no
+    // leading zero, no "-0", up to 18 digits
+    const char *p = text.begin(), *end = text.end();
+    bool negative = p<end && *p=='-';
+    if(negative)
+        ++p;
+    if(p==end || end-p>18 || (*p=='0' && (end-p>1 || negative)))
+        return false;
+    number = 0;
+    for(;p<end;++p){
+        if(*p<'0' || *p>'9')
+            return false;
+        number = number*10+(*p-'0');
+    }
+    if(negative)
+        number = -number;
+    return true;
+}
+//------------------------------------------------------------------------------
+uint64_t StationImage::parseEntryId(ByteView id){
+    // "0x2f0c"
+    if(id.size()<3 || id.size()>18 || id[0]!='0' || (id[1]!='x' && id[1]!='X'))
+        return 0;
+    uint64_t value = 0;
+    for(size_t i=2;i<id.size();++i){
+        char c = id[i];
+        int digit = c>='0' && c<='9' ? c-'0'
+                  : c>='a' && c<='f' ? c-'a'+10
+                  : c>='A' && c<='F' ? c-'A'+10
+                  : -1;
+        if(digit<0)
+            return 0;
+        value = (value<<4) | uint64_t(digit);
+    }
+    return value;
+}
+//------------------------------------------------------------------------------
+void StationImage::putVarint(std::string& out, uint64_t value){
+    // LEB128: 7 bits a byte, low first
+    while(value>=0x80){
+        out += char(0x80 | (value & 0x7F));
+        value >>= 7;
+    }
+    out += char(value);
+}
+//------------------------------------------------------------------------------
+bool StationImage::getVarint(ByteView in, size_t& pos, uint64_t& value){
+    value = 0;
+    for(int shift=0;shift<64 && pos<in.size();shift+=7){
+        unsigned char byte = static_cast<unsigned char>(in[pos++]);
+        value |= uint64_t(byte & 0x7F)<<shift;
+        if(!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+//------------------------------------------------------------------------------
+void StationImage::putUInt32(std::string& out, uint32_t value){
+    // Little endian
+    for(int i=0;i<4;++i)
+        out += char((value>>(8*i)) & 0xFF);
+}
+//------------------------------------------------------------------------------
+uint32_t StationImage::getUInt32(const char *in){
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(in);
+    return uint32_t(bytes[0]) | uint32_t(bytes[1])<<8 | uint32_t(bytes[2])<<16 |
+           uint32_t(bytes[3])<<24;
+}
+//------------------------------------------------------------------------------
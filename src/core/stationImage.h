@@ -0,0 +1,85 @@
+#ifndef STATIONIMAGE_H
+#define STATIONIMAGE_H
+
+#include <cstdint>
+#include <string>
+#include "byteView.h"
+#include "xmlScanner.h"
+
+
+//------------------------------------------------------------------------------
+// class StationImage
+//------------------------------------------------------------------------------
+// Binary image of a station file: its values as TLV records keyed by entry id,
+// the rest (markup, names, lookup lists, blanks) left to a layout, i.e. any
+// station file with the same markup: the fleet shares a handful of them.
+//
+// A value is the text of an element without children inside an Entry (the
+// Entry itself or one of its Elements); texts elsewhere belong to the layout.
+// Every Entry with values gives one record, in file order:
+//
+//     varint id  varint length  values
+//
+// the id being that of the "id" attribute ("0x2f0c"), 0 when missing. A
+// value is a varint header: (zigzag(n)<<1) for the integer types (bool,
+// int*, uint*, ipv4) written the canonical way, (length<<1)|1 followed by
+// the text bytes otherwise (strings, floats, anything unusual).
+//
+// The image starts with "MSTI", a version byte, the size and CRC-32 of the
+// file and the CRC-32 of its layout (the file without its values, a 0 byte
+// in place of each): decoding only succeeds with a matching layout and into
+// the very same bytes.
+//------------------------------------------------------------------------------
+class StationImage
+{
+    public:
+        // Constants
+        enum {
+            cHeaderSize = 17,   // magic, version, size (u32), CRCs (u32)
+        };
+        // Constructor
+        StationImage();
+        // Accessors
+        inline const char *errorString()const { return _error; }
+        inline uint32_t layoutCrc()const { return _layoutCrc; } // last one
+        static bool imageLayoutCrc(ByteView image, uint32_t& layoutCrc);
+        // Methods
+        bool compile(ByteView document, std::string& image);
+        bool decode(ByteView image, ByteView layout, std::string& document);
+    private:
+        // Types
+        enum Event { evEnd, evError, evValue, evEntryEnd };
+        // Data
+        XmlScanner _scanner;
+        ByteView _document;
+        size_t _skeletonFrom;   // layout bytes not yet hashed
+        uint32_t _layoutCrc;
+        int _depth;
+        int _entryDepth;        // of the open Entry, 0: none
+        uint64_t _entryId;
+        bool _entryEndPending;  // Entry closed right after its value
+        bool _leafOpen;         // start tag just read, in an Entry
+        bool _leafNumeric;
+        bool _valuePending;     // text right after the start tag
+        size_t _valueOffset;
+        size_t _valueLength;
+        std::string _record;
+        const char *_error;
+        // Private copy constructor and assignment (unimplemented!)
+        StationImage(const StationImage&);
+        StationImage& operator=(const StationImage&);
+        // Helpers
+        bool fail(const char *error);
+        void startDocument(ByteView document);
+        Event next();
+        void hashSkeleton(size_t valueOffset, size_t valueLength);
+        static bool isIntegerType(ByteView type);
+        static bool parseCanonical(ByteView text, int64_t& number);
+        static uint64_t parseEntryId(ByteView id);
+        static void putVarint(std::string& out, uint64_t value);
+        static bool getVarint(ByteView in, size_t& pos, uint64_t& value);
+        static void putUInt32(std::string& out, uint32_t value);
+        static uint32_t getUInt32(const char *in);
+};
+
+#endif // STATIONIMAGE_H
@@ -0,0 +1,292 @@
+#include "stationPatch.h"
+
+#include <algorithm>
+#include <cstdio>
+
+
+//------------------------------------------------------------------------------
+// Tables (CRC-32 as in zlib, reflected 0xEDB88320, sliced by 8)
+//------------------------------------------------------------------------------
+namespace {
+
+struct Crc32Tables {
+    uint32_t slices[8][256];
+    Crc32Tables(){
+        for(uint32_t i=0;i<256;++i){
+            uint32_t crc = i;
+            for(int bit=0;bit<8;++bit)
+                crc = crc & 1 ? 0xEDB88320u ^ (crc>>1) : crc>>1;
+            slices[0][i] = crc;
+        }
+        for(int i=0;i<256;++i)
+            for(int slice=1;slice<8;++slice)
+                slices[slice][i] = (slices[slice-1][i]>>8) ^
+                                   slices[0][slices[slice-1][i] & 0xFF];
+    }
+};
+
+const char patchMagic[] = "MiraStationPatch 1";
+
+} // namespace
+
+
+//------------------------------------------------------------------------------
+// class StationPatch implementation
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+StationPatch::StationPatch() : _baseSize(0), _baseCrc(0), _resultSize(0),
+    _resultCrc(0), _error(nullptr)
+{
+}
+//------------------------------------------------------------------------------
+// Methods
+//------------------------------------------------------------------------------
+void StationPatch::begin(ByteView base){
+    _base = base;
+    _baseSize = base.size();
+    _baseCrc = crc32(base);
+    _hunks.clear();
+    _error = nullptr;
+}
+//------------------------------------------------------------------------------
+void StationPatch::add(size_t offset, size_t length, ByteView newBytes,
+    ByteView path)
+{
+    // In file order, as CheckEngine::fixes() gives them
+    Hunk hunk;
+    hunk.offset = offset;
+    hunk.oldBytes = _base.mid(offset,length).toString();
+    hunk.newBytes = newBytes.toString();
+    ByteView id = entryId(_base,offset);
+    hunk.entryId = id.isEmpty() ? std::string("-") : id.toString();
+    hunk.path = path.toString();
+    _hunks.push_back(hunk);
+}
+//------------------------------------------------------------------------------
+void StationPatch::end(){
+    // The result is not built: its CRC follows the base one piece by piece
+    size_t pos = 0;
+    _resultSize = _baseSize;
+    _resultCrc = 0;
+    for(size_t i=0;i<_hunks.size();++i){
+        const Hunk& hunk = _hunks[i];
+        _resultCrc = crc32(_base.mid(pos,hunk.offset-pos),_resultCrc);
+        _resultCrc = crc32(ByteView(hunk.newBytes),_resultCrc);
+        _resultSize += hunk.newBytes.size();
+        _resultSize -= hunk.oldBytes.size();
+        pos = hunk.offset+hunk.oldBytes.size();
+    }
+    _resultCrc = crc32(_base.mid(pos,_baseSize-pos),_resultCrc);
+    _base = ByteView();
+}
+//------------------------------------------------------------------------------
+void StationPatch::write(std::string& text)const{
+    char line[96];
+    text.assign(patchMagic);
+    snprintf(line,sizeof(line),"\nbase %llu %08x\nresult %llu %08x\n",
+             static_cast<unsigned long long>(_baseSize),unsigned(_baseCrc),
+             static_cast<unsigned long long>(_resultSize),unsigned(_resultCrc));
+    text += line;
+    for(size_t i=0;i<_hunks.size();++i){
+        const Hunk& hunk = _hunks[i];
+        snprintf(line,sizeof(line),"hunk %llu %llu %llu ",
+                 static_cast<unsigned long long>(hunk.offset),
+                 static_cast<unsigned long long>(hunk.oldBytes.size()),
+                 static_cast<unsigned long long>(hunk.newBytes.size()));
+        text += line;
+        text += hunk.entryId;
+        text += ' ';
+        text += hunk.path;
+        text += '\n';
+        text += hunk.oldBytes;
+        text += '\n';
+        text += hunk.newBytes;
+        text += '\n';
+    }
+}
+//------------------------------------------------------------------------------
+bool StationPatch::read(ByteView text){
+    _base = ByteView();
+    _hunks.clear();
+    _error = nullptr;
+    size_t pos = 0;
+    ByteView line, field;
+    uint64_t number;
+    if(!readLine(text,pos,line) || line!=ByteView::fromCString(patchMagic))
+        return fail("Not a station patch.");
+
+    if(!readLine(text,pos,line) || !readField(line,field) ||
+       field!=ByteView("base",4) || !readNumber(line,10,number))
+        return fail("Malformed base line.");
+    _baseSize = size_t(number);
+    if(!readNumber(line,16,number) || !line.isEmpty())
+        return fail("Malformed base line.");
+    _baseCrc = uint32_t(number);
+    if(!readLine(text,pos,line) || !readField(line,field) ||
+       field!=ByteView("result",6) || !readNumber(line,10,number))
+        return fail("Malformed result line.");
+    _resultSize = size_t(number);
+    if(!readNumber(line,16,number) || !line.isEmpty())
+        return fail("Malformed result line.");
+    _resultCrc = uint32_t(number);
+
+    size_t end = 0; // of the last hunk in the base file
+    while(pos<text.size()){
+        uint64_t offset, oldLength, newLength;
+        if(!readLine(text,pos,line) || !readField(line,field) ||
+           field!=ByteView("hunk",4) || !readNumber(line,10,offset) ||
+           !readNumber(line,10,oldLength) || !readNumber(line,10,newLength) ||
+           !readField(line,field) || field.isEmpty())
+            return fail("Malformed hunk line.");
+        if(offset<end || offset+oldLength>_baseSize)
+            return fail("Hunks out of order or out of the base file.");
+        if(text.size()-pos<oldLength+newLength+2 ||
+           text[pos+oldLength]!='\n' || text[pos+oldLength+1+newLength]!='\n')
+            return fail("Truncated hunk.");
+
+        Hunk hunk;
+        hunk.offset = size_t(offset);
+        hunk.entryId = field.toString();
+        hunk.path = line.toString();
+        hunk.oldBytes = text.mid(pos,size_t(oldLength)).toString();
+        pos += size_t(oldLength)+1;
+        hunk.newBytes = text.mid(pos,size_t(newLength)).toString();
+        pos += size_t(newLength)+1;
+        _hunks.push_back(hunk);
+        end = size_t(offset+oldLength);
+    }
+    return true;
+}
+//------------------------------------------------------------------------------
+bool StationPatch::apply(ByteView base, std::string& result){
+    // Verified on both ends: nothing but the exact fixed file comes out
+    _error = nullptr;
+    result.clear();
+    if(base.size()!=_baseSize || crc32(base)!=_baseCrc)
+        return fail("The base file is not the one the patch was made for.");
+
+    // The result line checked against the hunks before it sizes anything
+    size_t resultSize = base.size();
+    for(size_t i=0;i<_hunks.size();++i)
+        resultSize += _hunks[i].newBytes.size()-_hunks[i].oldBytes.size();
+    if(resultSize!=_resultSize)
+        return fail("The patched file is not the expected one.");
+
+    result.reserve(_resultSize);
+    size_t pos = 0;
+    for(size_t i=0;i<_hunks.size();++i){
+        const Hunk& hunk = _hunks[i];
+        if(base.mid(hunk.offset,hunk.oldBytes.size())!=ByteView(hunk.oldBytes))
+            return fail("Old value not found in the base file.");
+        result.append(base.data()+pos,hunk.offset-pos);
+        result += hunk.newBytes;
+        pos = hunk.offset+hunk.oldBytes.size();
+    }
+    result.append(base.data()+pos,base.size()-pos);
+    if(result.size()!=_resultSize || crc32(ByteView(result))!=_resultCrc)
+        return fail("The patched file is not the expected one.");
+    return true;
+}
+//------------------------------------------------------------------------------
+uint32_t StationPatch::crc32(ByteView bytes, uint32_t crc){
+    // Eight bytes a step, read as little endian words (x86, ARM)
+    static const Crc32Tables tables;
+    const uint32_t (&t)[8][256] = tables.slices;
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(bytes.data());
+    size_t n = bytes.size();
+    crc = ~crc;
+    for(;n>=8;p+=8,n-=8){
+        uint32_t low, high;
+        memcpy(&low,p,sizeof(low));
+        memcpy(&high,p+4,sizeof(high));
+        low ^= crc;
+        crc = t[7][low & 0xFF] ^ t[6][(low>>8) & 0xFF] ^
+              t[5][(low>>16) & 0xFF] ^ t[4][low>>24] ^
+              t[3][high & 0xFF] ^ t[2][(high>>8) & 0xFF] ^
+              t[1][(high>>16) & 0xFF] ^ t[0][high>>24];
+    }
+    while(n--)
+        crc = t[0][(crc ^ *p++) & 0xFF] ^ (crc>>8);
+    return ~crc;
+}
+//------------------------------------------------------------------------------
+ByteView StationPatch::entryId(ByteView document, size_t tagOffset){
+    // The nearest Entry start tag at or before the element, unless closed in
+    // between: Entries hold Elements, they do not nest
+    static const char entryStart[] = "<Entry", entryEnd[] = "</Entry>",
+                      idAttribute[] = " id=\"";
+    for(size_t p=std::min(tagOffset,document.size())+1;p-->0;){
+        if(p>=document.size() || document[p]!='<')
+            continue;
+        size_t left = document.size()-p;
+        const char *tag = document.data()+p;
+        if(left>=sizeof(entryEnd)-1 && !memcmp(tag,entryEnd,sizeof(entryEnd)-1))
+            return ByteView();
+        if(left<sizeof(entryStart) || memcmp(tag,entryStart,sizeof(entryStart)-1) ||
+           (tag[sizeof(entryStart)-1]!=' ' && tag[sizeof(entryStart)-1]!='>'))
+            continue;
+
+        const char *tagEnd = static_cast<const char *>(memchr(tag,'>',left));
+        if(!tagEnd)
+            return ByteView();
+        const char *id = std::search(tag,tagEnd,idAttribute,
+                                     idAttribute+sizeof(idAttribute)-1);
+        if(id==tagEnd)
+            return ByteView();
+        id += sizeof(idAttribute)-1;
+        const char *quote = static_cast<const char *>(
+            memchr(id,'"',size_t(tagEnd-id)));
+        return quote ? ByteView(id,quote) : ByteView();
+    }
+    return ByteView();
+}
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+bool StationPatch::fail(const char *error){
+    _error = error;
+    return false;
+}
+//------------------------------------------------------------------------------
+bool StationPatch::readLine(ByteView text, size_t& pos, ByteView& line){
+    const char *newline = static_cast<const char *>(
+        memchr(text.data()+pos,'\n',text.size()-pos));
+    if(!newline)
+        return false;
+    line = ByteView(text.data()+pos,newline);
+    pos = size_t(newline-text.data())+1;
+    return true;
+}
+//------------------------------------------------------------------------------
+bool StationPatch::readField(ByteView& line, ByteView& field){
+    // Up to the next blank, which is consumed
+    const char *blank = static_cast<const char *>(memchr(line.data(),' ',line.size()));
+    if(!blank){
+        field = line;
+        line = ByteView(line.end(),size_t(0));
+    }else{
+        field = ByteView(line.begin(),blank);
+        line = ByteView(blank+1,line.end());
+    }
+    return true;
+}
+//------------------------------------------------------------------------------
+bool StationPatch::readNumber(ByteView& line, int base, uint64_t& number){
+    ByteView field;
+    readField(line,field);
+    if(field.isEmpty() || field.size()>16)
+        return false;
+    number = 0;
+    for(size_t i=0;i<field.size();++i){
+        char c = field[i];
+        int digit = c>='0' && c<='9' ? c-'0'
+                  : c>='a' && c<='f' ? c-'a'+10
+                  : -1;
+        if(digit<0 || digit>=base)
+            return false;
+        number = number*uint64_t(base)+uint64_t(digit);
+    }
+    return true;
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,77 @@
+#ifndef STATIONPATCH_H
+#define STATIONPATCH_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "byteView.h"
+
+
+//------------------------------------------------------------------------------
+// class StationPatch
+//------------------------------------------------------------------------------
+// The fixes of a station file as a compact patch: per fixed value its offset
+// in the base file, the old and new bytes, the id of the enclosing Entry and
+// the check path, e.g.
+//
+//     MiraStationPatch 1
+//     base 72311 9f1c03aa
+//     result 72313 51d2e6b0
+//     hunk 11042 9 11 0x2f0c ConfigurationEntries(*)/.../Element(Gateway)
+//     167772161
+//     -1062731519
+//
+// Old and new bytes come with their lengths: they are read as they are, no
+// escaping. Both files are identified by size and CRC-32: a patch applies
+// to its own base file only and rebuilds the fixed file byte for byte, or
+// not at all.
+//------------------------------------------------------------------------------
+class StationPatch
+{
+    public:
+        // Types
+        struct Hunk {
+            size_t offset;          // in the base file
+            std::string oldBytes;
+            std::string newBytes;
+            std::string entryId;    // "-": not in an Entry
+            std::string path;       // check path, for people
+        };
+        // Constructor
+        StationPatch();
+        // Accessors
+        inline size_t baseSize()const { return _baseSize; }
+        inline uint32_t baseCrc()const { return _baseCrc; }
+        inline size_t resultSize()const { return _resultSize; }
+        inline uint32_t resultCrc()const { return _resultCrc; }
+        inline const std::vector<Hunk>& hunks()const { return _hunks; }
+        inline const char *errorString()const { return _error; }
+        // Methods
+        void begin(ByteView base);
+        void add(size_t offset, size_t length, ByteView newBytes, ByteView path);
+        void end();
+        void write(std::string& text)const;
+        bool read(ByteView text);
+        bool apply(ByteView base, std::string& result);
+        static uint32_t crc32(ByteView bytes, uint32_t crc = 0);
+        static ByteView entryId(ByteView document, size_t tagOffset);
+    private:
+        // Data
+        ByteView _base;     // between begin() and end()
+        size_t _baseSize;
+        uint32_t _baseCrc;
+        size_t _resultSize;
+        uint32_t _resultCrc;
+        std::vector<Hunk> _hunks;   // by offset, not overlapping
+        const char *_error;
+        // Private copy constructor and assignment (unimplemented!)
+        StationPatch(const StationPatch&);
+        StationPatch& operator=(const StationPatch&);
+        // Helpers
+        bool fail(const char *error);
+        static bool readLine(ByteView text, size_t& pos, ByteView& line);
+        static bool readField(ByteView& line, ByteView& field);
+        static bool readNumber(ByteView& line, int base, uint64_t& number);
+};
+
+#endif // STATIONPATCH_H
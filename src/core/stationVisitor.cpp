@@ -0,0 +1,123 @@
+#include "stationVisitor.h"
+
+
+//------------------------------------------------------------------------------
+// class StationVisitors implementation
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+StationVisitors::StationVisitors() : _next(nullptr), _probe(){
+}
+//------------------------------------------------------------------------------
+// Methods
+//------------------------------------------------------------------------------
+void StationVisitors::add(StationVisitor *visitor){
+    _visitors.push_back(visitor);
+}
+//------------------------------------------------------------------------------
+void StationVisitors::clear(){
+    _visitors.clear();
+}
+//------------------------------------------------------------------------------
+void StationVisitors::beginRun(const char *rootPath){
+    for(size_t i=0;i<_visitors.size();++i)
+        _visitors[i]->beginRun(rootPath);
+}
+//------------------------------------------------------------------------------
+void StationVisitors::startDocument(const StationVisitor::Probe& probe,
+    CheckEngine::ElementSink *next)
+{
+    _probe = probe;
+    _next = next;
+    _open.clear();
+    for(size_t i=0;i<_visitors.size();++i)
+        _visitors[i]->startDocument(_probe);
+}
+//------------------------------------------------------------------------------
+void StationVisitors::endDocument(int wrongValueCount){
+    _probe.wrongValueCount = wrongValueCount;
+    for(size_t i=0;i<_visitors.size();++i)
+        _visitors[i]->endDocument(_probe);
+    _next = nullptr;
+}
+//------------------------------------------------------------------------------
+void StationVisitors::endRun(){
+    for(size_t i=0;i<_visitors.size();++i)
+        _visitors[i]->endRun();
+}
+//------------------------------------------------------------------------------
+void StationVisitors::startElement(const XmlScanner& scanner){
+    if(_next)
+        _next->startElement(scanner);
+    if(!_open.empty())
+        _open.back().hasChildren = true;
+    OpenElement open;
+    open.element.tag = scanner.name();
+    open.element.name = scanner.attribute("name");
+    open.element.type = scanner.attribute("type");
+    open.element.offset = scanner.tokenOffset();
+    open.element.depth = int(_open.size())+1;
+    open.selfClosing = scanner.isSelfClosing();
+    open.contentOffset = scanner.position()-(open.selfClosing ? 2 : 0);
+    open.hasChildren = false;
+    _open.push_back(open);
+    for(size_t i=0;i<_visitors.size();++i)
+        _visitors[i]->startElement(open.element);
+}
+//------------------------------------------------------------------------------
+void StationVisitors::text(ByteView raw){
+    if(_next)
+        _next->text(raw);
+}
+//------------------------------------------------------------------------------
+void StationVisitors::endElement(const XmlScanner& scanner){
+    if(_next)
+        _next->endElement(scanner);
+    if(_open.empty())
+        return;
+    const OpenElement& open = _open.back();
+    if(!open.hasChildren){
+        // All between the tags, as the engine takes a checked value
+        StationVisitor::Value value;
+        value.tag = open.element.tag;
+        value.name = open.element.name;
+        value.type = open.element.type;
+        value.offset = open.contentOffset;
+        if(!open.selfClosing)
+            value.raw = _probe.document.mid(open.contentOffset,
+                                            scanner.tokenOffset()-open.contentOffset);
+        if(!value.raw.contains('&') && !value.raw.contains('<'))
+            value.text = value.raw;
+        else{
+            XmlScanner::decodeContent(value.raw,_decoded);
+            value.text = ByteView(_decoded);
+        }
+        value.integer = 0;
+        value.isInteger = parseInteger(value.text,value.integer);
+        value.depth = open.element.depth;
+        for(size_t i=0;i<_visitors.size();++i)
+            _visitors[i]->value(value);
+    }
+    for(size_t i=0;i<_visitors.size();++i)
+        _visitors[i]->endElement();
+    _open.pop_back();
+}
+//------------------------------------------------------------------------------
+bool StationVisitors::parseInteger(ByteView text, int64_t& value){
+    // [+-]digits, 18 of them at most: no overflow
+    const char *p = text.begin(), *end = text.end();
+    bool negative = p!=end && *p=='-';
+    if(p!=end && (*p=='-' || *p=='+'))
+        ++p;
+    if(p==end || end-p>18)
+        return false;
+    int64_t result = 0;
+    for(;p!=end;++p){
+        if(*p<'0' || *p>'9')
+            return false;
+        result = result*10+(*p-'0');
+    }
+    value = negative ? -result : result;
+    return true;
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,131 @@
+#ifndef STATIONVISITOR_H
+#define STATIONVISITOR_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "byteView.h"
+#include "checkEngine.h"
+
+
+//------------------------------------------------------------------------------
+// class StationVisitor
+//------------------------------------------------------------------------------
+// Analyses beyond the check plan, run in the check pass of every station:
+// the same tokens as the engine, no further parse. Typically implemented by
+// a plugin, a shared object exporting
+//
+//     extern "C" int stationVisitorApiVersion();  // cApiVersion, as built
+//     extern "C" StationVisitor *createStationVisitor(int apiVersion);
+//
+// the latter returning null for an API version it was not built for. It
+// must be built with the compiler of the application, which deletes the
+// visitors it got. A plugin only sees the types below: views and offsets
+// into Probe::document, none of the engine's classes. cApiVersion goes up
+// with any change to them.
+//
+// The hooks of a document come in this order: startDocument(), then
+// startElement() / value() / endElement() in document order, value() being
+// the content of a leaf element right before its endElement(), then
+// endDocument(). Views are only valid during the call.
+//------------------------------------------------------------------------------
+class StationVisitor
+{
+    public:
+        // Constants
+        enum {
+            cApiVersion = 2,
+        };
+        // Types
+        struct Probe {      // the probe sheet row of the station
+            unsigned serial;
+            uint32_t ip;        // host order
+            uint32_t netmask;
+            uint32_t gateway;
+            const char *stationFilename; // UTF-8
+            ByteView document;
+            int wrongValueCount; // in endDocument(), -1: parse error
+        };
+        struct Element {
+            ByteView tag;
+            ByteView name;      // name="..." (raw), null: none
+            ByteView type;      // type="..." (raw), null: none
+            size_t offset;      // '<' of the start tag in Probe::document
+            int depth;          // 1: document element
+        };
+        struct Value {      // content of a leaf element, as the engine takes it
+            ByteView tag;
+            ByteView name;
+            ByteView type;
+            size_t offset;      // raw in Probe::document
+            ByteView raw;       // between the tags, null: "<tag/>"
+            ByteView text;      // references decoded, CDATA joined, no comments
+            bool isInteger;     // text is a decimal integer
+            int64_t integer;
+            int depth;
+        };
+        // Destructor
+        virtual ~StationVisitor() {}
+        // Methods
+        virtual const char *name()const = 0;
+        virtual void beginRun(const char * /*rootPath*/) {}
+        virtual void startDocument(const Probe& /*probe*/) {}
+        virtual void startElement(const Element& /*element*/) {}
+        virtual void value(const Value& /*value*/) {}
+        virtual void endElement() {}
+        virtual void endDocument(const Probe& /*probe*/) {}
+        virtual void endRun() {} // reports, files
+};
+
+typedef int (*StationVisitorApiVersion_t)();
+typedef StationVisitor *(*CreateStationVisitor_t)(int apiVersion);
+
+
+//------------------------------------------------------------------------------
+// class StationVisitors
+//------------------------------------------------------------------------------
+// The element sink handing one check pass to every visitor: elements and
+// leaf values assembled out of the scanner's tokens, the tokens passed on as
+// they are to the sink the front end would have given the engine (if any).
+//------------------------------------------------------------------------------
+class StationVisitors : public CheckEngine::ElementSink
+{
+    public:
+        // Constructor
+        StationVisitors();
+        // Accessors
+        inline bool isEmpty()const { return _visitors.empty(); }
+        inline size_t size()const { return _visitors.size(); }
+        inline StationVisitor *at(size_t i)const { return _visitors[i]; }
+        // Methods
+        void add(StationVisitor *visitor); // not owned
+        void clear();
+        void beginRun(const char *rootPath);
+        void startDocument(const StationVisitor::Probe& probe,
+                           CheckEngine::ElementSink *next);
+        void endDocument(int wrongValueCount);
+        void endRun();
+        virtual void startElement(const XmlScanner& scanner);
+        virtual void text(ByteView raw);
+        virtual void endElement(const XmlScanner& scanner);
+        static bool parseInteger(ByteView text, int64_t& value);
+    private:
+        // Types
+        struct OpenElement {
+            StationVisitor::Element element;
+            size_t contentOffset;   // right after the start tag
+            bool selfClosing;
+            bool hasChildren;
+        };
+        // Data
+        std::vector<StationVisitor *> _visitors;
+        CheckEngine::ElementSink *_next;
+        StationVisitor::Probe _probe;
+        std::vector<OpenElement> _open;
+        std::string _decoded;
+        // Private copy constructor and assignment (unimplemented!)
+        StationVisitors(const StationVisitors&);
+        StationVisitors& operator=(const StationVisitors&);
+};
+
+#endif // STATIONVISITOR_H
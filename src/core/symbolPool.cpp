@@ -0,0 +1,181 @@
+#include "symbolPool.h"
+
+#include <algorithm>
+
+
+//------------------------------------------------------------------------------
+// class SymbolPool implementation
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+SymbolPool::SymbolPool() : _symbolCount(0)
+{
+    for(int i=0;i<cShardCount;++i){
+        Shard& shard = _shards[i];
+        shard.usedCount = 0;
+        shard.chunkPos = nullptr;
+        shard.chunkLeft = shard.chunkBytes = 0;
+    }
+    for(int i=0;i<cMaxPages;++i)
+        _pages[i].store(nullptr);
+}
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+SymbolPool::~SymbolPool(){
+    for(int i=0;i<cShardCount;++i)
+        for(size_t c=0;c<_shards[i].chunks.size();++c)
+            delete[] _shards[i].chunks[c];
+    for(int i=0;i<cMaxPages;++i)
+        delete[] _pages[i].load();
+}
+//------------------------------------------------------------------------------
+// Accessors
+//------------------------------------------------------------------------------
+SymbolPool& SymbolPool::instance(){
+    static SymbolPool pool;
+    return pool;
+}
+//------------------------------------------------------------------------------
+size_t SymbolPool::memoryUsage()const{
+    // Texts, hash tables and symbol pages: what the pool holds
+    size_t bytes = 0;
+    for(int i=0;i<cShardCount;++i){
+        const Shard& shard = _shards[i];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        bytes += shard.chunkBytes+shard.table.capacity()*sizeof(Slot);
+    }
+    for(int i=0;i<cMaxPages;++i)
+        if(_pages[i].load(std::memory_order_acquire))
+            bytes += cPageSize*sizeof(Entry);
+    return bytes;
+}
+//------------------------------------------------------------------------------
+ByteView SymbolPool::text(uint32_t symbol)const{
+    // The symbol was handed out after its entry had been written
+    const Entry *entries = _pages[symbol/cPageSize].load(std::memory_order_acquire);
+    const Entry& entry = entries[symbol%cPageSize];
+    return ByteView(entry.data,size_t(entry.size));
+}
+//------------------------------------------------------------------------------
+// Methods
+//------------------------------------------------------------------------------
+uint32_t SymbolPool::intern(ByteView text){
+    return intern(text,hash(text));
+}
+//------------------------------------------------------------------------------
+uint32_t SymbolPool::hash(ByteView text){
+    // FNV-1a
+    uint32_t value = 2166136261u;
+    for(size_t i=0;i<text.size();++i)
+        value = (value ^ static_cast<unsigned char>(text[i]))*16777619u;
+    return value;
+}
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+uint32_t SymbolPool::intern(ByteView text, uint32_t textHash){
+    // Shard by the low hash bits, slot by the next ones
+    Shard& shard = _shards[textHash%cShardCount];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if((shard.usedCount+1)*4>shard.table.size()*3)
+        grow(shard);
+    size_t mask = shard.table.size()-1;
+    size_t i = (textHash/cShardCount) & mask;
+    for(;shard.table[i].symbol;i=(i+1) & mask){
+        const Slot& slot = shard.table[i];
+        if(slot.hash==textHash && this->text(slot.symbol-1)==text)
+            return slot.symbol-1;
+    }
+
+    uint32_t symbol = _symbolCount.fetch_add(1);
+    if(symbol>=uint32_t(cMaxPages)*cPageSize){
+        _symbolCount.fetch_sub(1);
+        return cNoSymbol;
+    }
+    Entry *entries = _pages[symbol/cPageSize].load(std::memory_order_acquire);
+    if(!entries){
+        std::lock_guard<std::mutex> pagesLock(_pagesMutex);
+        entries = _pages[symbol/cPageSize].load(std::memory_order_relaxed);
+        if(!entries){
+            entries = new Entry[cPageSize];
+            _pages[symbol/cPageSize].store(entries,std::memory_order_release);
+        }
+    }
+    Entry& entry = entries[symbol%cPageSize];
+    entry.data = store(shard,text);
+    entry.size = uint32_t(text.size());
+    Slot slot = { textHash, symbol+1 };
+    shard.table[i] = slot;
+    ++shard.usedCount;
+    return symbol;
+}
+//------------------------------------------------------------------------------
+const char *SymbolPool::store(Shard& shard, ByteView text){
+    // Chunks are never moved nor freed: texts stay put for the lock free
+    // readers. Long texts get a chunk of their own.
+    if(text.isEmpty())
+        return "";
+    if(text.size()>cChunkSize/4){
+        char *own = new char[text.size()];
+        memcpy(own,text.data(),text.size());
+        shard.chunks.push_back(own);
+        shard.chunkBytes += text.size();
+        return own;
+    }
+    if(shard.chunkLeft<text.size()){
+        shard.chunkPos = new char[cChunkSize];
+        shard.chunkLeft = cChunkSize;
+        shard.chunks.push_back(shard.chunkPos);
+        shard.chunkBytes += cChunkSize;
+    }
+    char *stored = shard.chunkPos;
+    memcpy(stored,text.data(),text.size());
+    shard.chunkPos += text.size();
+    shard.chunkLeft -= text.size();
+    return stored;
+}
+//------------------------------------------------------------------------------
+void SymbolPool::grow(Shard& shard){
+    std::vector<Slot> table(std::max(size_t(64),shard.table.size()*2));
+    size_t mask = table.size()-1;
+    for(size_t s=0;s<shard.table.size();++s){
+        const Slot& slot = shard.table[s];
+        if(!slot.symbol)
+            continue;
+        size_t i = (slot.hash/cShardCount) & mask;
+        while(table[i].symbol)
+            i = (i+1) & mask;
+        table[i] = slot;
+    }
+    shard.table.swap(table);
+}
+//------------------------------------------------------------------------------
+// class SymbolPool::LocalCache implementation
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+SymbolPool::LocalCache::LocalCache(SymbolPool& pool) : _pool(pool)
+{
+    for(int i=0;i<cLineCount;++i){
+        _lines[i].hash = 0;
+        _lines[i].symbol = cNoSymbol;
+    }
+}
+//------------------------------------------------------------------------------
+// Methods
+//------------------------------------------------------------------------------
+uint32_t SymbolPool::LocalCache::intern(ByteView text){
+    uint32_t textHash = SymbolPool::hash(text);
+    Line& line = _lines[(textHash/cShardCount)%cLineCount];
+    if(line.symbol!=cNoSymbol && line.hash==textHash &&
+       _pool.text(line.symbol)==text)
+        return line.symbol;
+    uint32_t symbol = _pool.intern(text,textHash);
+    if(symbol!=cNoSymbol){
+        line.hash = textHash;
+        line.symbol = symbol;
+    }
+    return symbol;
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,118 @@
+#ifndef SYMBOLPOOL_H
+#define SYMBOLPOOL_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "byteView.h"
+
+
+//------------------------------------------------------------------------------
+// class SymbolPool
+//------------------------------------------------------------------------------
+// Process wide pool of interned byte strings: tag names, attribute names and
+// attribute values repeated by every station file get a small integer symbol
+// once, then compare by symbol and are stored once. Symbols are never
+// released: the pool holds the vocabulary of the fleet, not its values.
+//
+// Thread safe: interning locks one of cShardCount shards (by hash), reading
+// the text of a symbol does not lock. A LocalCache in front of the pool, one
+// per thread, answers the symbols it has already met without locking.
+//------------------------------------------------------------------------------
+class SymbolPool
+{
+    public:
+        // Constants
+        enum : uint32_t {
+            cNoSymbol = 0xFFFFFFFF, // the pool is full
+        };
+        // Types
+        class LocalCache;
+        // Constructor
+        SymbolPool();
+        // Destructor
+        ~SymbolPool();
+        // Accessors
+        static SymbolPool& instance();
+        inline uint32_t symbolCount()const { return _symbolCount.load(); }
+        size_t memoryUsage()const;
+        ByteView text(uint32_t symbol)const;
+        // Methods
+        uint32_t intern(ByteView text);
+        static uint32_t hash(ByteView text);
+    private:
+        // Constants
+        enum {
+            cShardCount = 16,
+            cPageSize = 1024,       // symbols
+            cMaxPages = 4096,       // 4M symbols
+            cChunkSize = 4096,      // text bytes
+        };
+        // Types
+        struct Entry {
+            const char *data;
+            uint32_t size;
+        };
+        struct Slot {
+            uint32_t hash;
+            uint32_t symbol;        // +1, 0: free
+        };
+        struct Shard {
+            mutable std::mutex mutex;
+            std::vector<Slot> table;    // open addressing, power of 2
+            size_t usedCount;
+            std::vector<char *> chunks;
+            char *chunkPos;
+            size_t chunkLeft;
+            size_t chunkBytes;
+        };
+        // Data
+        Shard _shards[cShardCount];
+        std::atomic<Entry *> _pages[cMaxPages];
+        std::mutex _pagesMutex;
+        std::atomic<uint32_t> _symbolCount;
+        // Private copy constructor and assignment (unimplemented!)
+        SymbolPool(const SymbolPool&);
+        SymbolPool& operator=(const SymbolPool&);
+        // Helpers
+        uint32_t intern(ByteView text, uint32_t textHash);
+        const char *store(Shard& shard, ByteView text);
+        static void grow(Shard& shard);
+};
+
+//------------------------------------------------------------------------------
+// class SymbolPool::LocalCache
+//------------------------------------------------------------------------------
+// Direct mapped cache of the symbols last interned by one thread: a hit
+// costs a hash and a compare with the pooled text, no lock.
+//------------------------------------------------------------------------------
+class SymbolPool::LocalCache
+{
+    public:
+        // Constructor
+        explicit LocalCache(SymbolPool& pool = SymbolPool::instance());
+        // Accessors
+        inline SymbolPool& pool()const { return _pool; }
+        inline ByteView text(uint32_t symbol)const { return _pool.text(symbol); }
+        // Methods
+        uint32_t intern(ByteView text);
+    private:
+        // Constants
+        enum {
+            cLineCount = 1024,
+        };
+        // Types
+        struct Line {
+            uint32_t hash;
+            uint32_t symbol;
+        };
+        // Data
+        SymbolPool& _pool;
+        Line _lines[cLineCount];
+        // Private copy constructor and assignment (unimplemented!)
+        LocalCache(const LocalCache&);
+        LocalCache& operator=(const LocalCache&);
+};
+
+#endif // SYMBOLPOOL_H
@@ -0,0 +1,394 @@
+#include "xmlScanner.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+
+//------------------------------------------------------------------------------
+// class XmlScanner implementation
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+XmlScanner::XmlScanner() : _data(nullptr), _size(0), _pos(0), _token(tNone),
+    _tokenOffset(0), _selfClosing(false), _pendingEnd(false), _error(nullptr)
+{
+    _attributes.reserve(8);
+    _openElements.reserve(32);
+}
+//------------------------------------------------------------------------------
+// Accessors
+//------------------------------------------------------------------------------
+ByteView XmlScanner::attribute(const char *name)const{
+    ByteView wanted = ByteView::fromCString(name);
+    for(size_t i=0;i<_attributes.size();++i)
+        if(_attributes[i].name==wanted)
+            return _attributes[i].value;
+    return ByteView();
+}
+//------------------------------------------------------------------------------
+// Methods
+//------------------------------------------------------------------------------
+void XmlScanner::reset(ByteView document){
+    _data = document.data();
+    _size = document.size();
+    _pos = 0;
+    _token = tNone;
+    _tokenOffset = 0;
+    _name = _text = _encoding = ByteView();
+    _selfClosing = _pendingEnd = false;
+    _attributes.clear();
+    _openElements.clear();
+    _error = nullptr;
+}
+//------------------------------------------------------------------------------
+XmlScanner::Token XmlScanner::next(){
+    if(_token==tError || _token==tEndDocument)
+        return _token;
+    _selfClosing = false;
+    _attributes.clear();
+    _text = ByteView();
+
+    if(_pendingEnd){
+        // Second half of "<tag/>": same offsets, no bytes of its own
+        _pendingEnd = false;
+        _openElements.pop_back();
+        return _token = tEndElement;
+    }
+
+    _tokenOffset = _pos;
+    if(_pos>=_size){
+        if(!_openElements.empty())
+            return fail("Premature end of document.");
+        return _token = tEndDocument;
+    }
+    if(_data[_pos]!='<'){
+        const char *lt = static_cast<const char *>(memchr(_data+_pos,'<',_size-_pos));
+        size_t end = lt ? size_t(lt-_data) : _size;
+        _text = ByteView(_data+_pos,end-_pos);
+        _pos = end;
+        return _token = tText;
+    }
+    return scanMarkup();
+}
+//------------------------------------------------------------------------------
+XmlScanner::Token XmlScanner::skipElement(){
+    // Right after a start tag: on to its end tag (the token returned) at
+    // memchr speed. The markup in between is only delimited, not checked:
+    // start tags up to their '>' (quoted values honoured) for the depth,
+    // comments and CDATA sections stepped over, processing instructions
+    // refused (CheckEngine does not handle them either).
+    if(_token!=tStartElement || _pendingEnd)
+        return next();
+    _selfClosing = false;
+    _attributes.clear();
+    _text = ByteView();
+
+    int depth = 1;
+    size_t p = _pos;
+    for(;;){
+        const char *lt = static_cast<const char *>(memchr(_data+p,'<',_size-p));
+        if(!lt || size_t(lt-_data)+1>=_size){
+            _tokenOffset = _size;
+            return fail("Premature end of document.");
+        }
+        p = size_t(lt-_data);
+        _tokenOffset = p;
+        char c = _data[p+1];
+        if(c=='/'){
+            if(!--depth){
+                _pos = p;
+                return scanEndElement();
+            }
+            p += 2;
+        }else if(c=='!'){
+            _pos = p;
+            size_t end = startsWith("<!--") ? find("-->",p+4)
+                       : startsWith("<![CDATA[") ? find("]]>",p+9)
+                       : std::string::npos;
+            if(end==std::string::npos)
+                return fail(startsWith("<!--") || startsWith("<![CDATA[")
+                            ? "Premature end of document."
+                            : "Unsupported markup declaration.");
+            p = end+3;
+        }else if(c=='?'){
+            return fail("Processing instruction in a skipped element.");
+        }else{
+            char quote = 0;
+            size_t q = p+1;
+            for(;q<_size;++q){
+                char d = _data[q];
+                if(quote){
+                    if(d==quote)
+                        quote = 0;
+                }else if(d=='"' || d=='\'')
+                    quote = d;
+                else if(d=='>')
+                    break;
+            }
+            if(q>=_size)
+                return fail("Malformed start tag.");
+            if(_data[q-1]!='/')
+                ++depth;
+            p = q+1;
+        }
+    }
+}
+//------------------------------------------------------------------------------
+bool XmlScanner::decode(ByteView raw, std::string& out){
+    // The five predefined entities and character references; characters
+    // above 0xFF are written as UTF-8
+    out.clear();
+    out.reserve(raw.size());
+    const char *p = raw.begin(), *end = raw.end();
+    while(p<end){
+        if(*p!='&'){
+            out += *p++;
+            continue;
+        }
+        const char *semicolon = static_cast<const char *>(memchr(p,';',size_t(end-p)));
+        if(!semicolon)
+            return false;
+        ByteView entity(p+1,semicolon);
+        p = semicolon+1;
+        if(entity==ByteView("lt",2))
+            out += '<';
+        else if(entity==ByteView("gt",2))
+            out += '>';
+        else if(entity==ByteView("amp",3))
+            out += '&';
+        else if(entity==ByteView("quot",4))
+            out += '"';
+        else if(entity==ByteView("apos",4))
+            out += '\'';
+        else if(entity.size()>1 && entity[0]=='#'){
+            std::string digits(entity.begin()+1,entity.end());
+            bool hex = digits[0]=='x';
+            char *digitsEnd;
+            unsigned long code = strtoul(digits.c_str()+(hex ? 1 : 0),&digitsEnd,
+                                         hex ? 16 : 10);
+            if(*digitsEnd || code>0x10FFFF)
+                return false;
+            if(code<0x100)
+                out += char(code);
+            else if(code<0x800){
+                out += char(0xC0 | (code>>6));
+                out += char(0x80 | (code & 0x3F));
+            }else if(code<0x10000){
+                out += char(0xE0 | (code>>12));
+                out += char(0x80 | ((code>>6) & 0x3F));
+                out += char(0x80 | (code & 0x3F));
+            }else{
+                out += char(0xF0 | (code>>18));
+                out += char(0x80 | ((code>>12) & 0x3F));
+                out += char(0x80 | ((code>>6) & 0x3F));
+                out += char(0x80 | (code & 0x3F));
+            }
+        }else
+            return false;
+    }
+    return true;
+}
+//------------------------------------------------------------------------------
+bool XmlScanner::decodeContent(ByteView content, std::string& out){
+    // The value of an element without child elements, as a DOM reader gives
+    // it: texts (references decoded) and CDATA sections joined, comments
+    // left out. False on any other markup.
+    static const char commentEnd[] = "-->", cdataEnd[] = "]]>";
+    out.clear();
+    std::string text;
+    const char *p = content.begin(), *end = content.end();
+    while(p<end){
+        const char *lt = static_cast<const char *>(memchr(p,'<',size_t(end-p)));
+        if(!lt)
+            lt = end;
+        if(!decode(ByteView(p,lt),text))
+            return false;
+        out += text;
+        if(lt==end)
+            break;
+        ByteView markup(lt,end);
+        if(markup.size()>=4 && !memcmp(lt,"<!--",4)){
+            const char *close = std::search(lt+4,end,commentEnd,commentEnd+3);
+            if(close==end)
+                return false;
+            p = close+3;
+        }else if(markup.size()>=9 && !memcmp(lt,"<![CDATA[",9)){
+            const char *close = std::search(lt+9,end,cdataEnd,cdataEnd+3);
+            if(close==end)
+                return false;
+            out.append(lt+9,close);
+            p = close+3;
+        }else
+            return false;
+    }
+    return true;
+}
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+XmlScanner::Token XmlScanner::fail(const char *error){
+    _error = error;
+    return _token = tError;
+}
+//------------------------------------------------------------------------------
+bool XmlScanner::startsWith(const char *s)const{
+    size_t length = strlen(s);
+    return _size-_pos>=length && !memcmp(_data+_pos,s,length);
+}
+//------------------------------------------------------------------------------
+size_t XmlScanner::find(const char *s, size_t from)const{
+    size_t length = strlen(s);
+    while(from+length<=_size){
+        const char *first = static_cast<const char *>(
+            memchr(_data+from,s[0],_size-from-length+1));
+        if(!first)
+            break;
+        from = size_t(first-_data);
+        if(!memcmp(first,s,length))
+            return from;
+        ++from;
+    }
+    return std::string::npos;
+}
+//------------------------------------------------------------------------------
+ByteView XmlScanner::scanName(){
+    size_t begin = _pos;
+    while(_pos<_size){
+        char c = _data[_pos];
+        if(isBlank(c) || c=='/' || c=='>' || c=='=' || c=='<' || c=='?' ||
+           c=='"' || c=='\'')
+            break;
+        ++_pos;
+    }
+    return ByteView(_data+begin,_pos-begin);
+}
+//------------------------------------------------------------------------------
+void XmlScanner::skipBlanks(){
+    while(_pos<_size && isBlank(_data[_pos]))
+        ++_pos;
+}
+//------------------------------------------------------------------------------
+bool XmlScanner::scanAttributes(bool declaration){
+    // Up to (not including) '>', "/>" or "?>"
+    for(;;){
+        size_t before = _pos;
+        skipBlanks();
+        if(_pos>=_size)
+            return false;
+        char c = _data[_pos];
+        if(c=='>' || c=='/' || (declaration && c=='?'))
+            return true;
+        if(_pos==before)
+            return false; // attributes must be blank separated
+
+        Attribute attribute;
+        attribute.name = scanName();
+        skipBlanks();
+        if(attribute.name.isEmpty() || _pos>=_size || _data[_pos]!='=')
+            return false;
+        ++_pos;
+        skipBlanks();
+        if(_pos>=_size || (_data[_pos]!='"' && _data[_pos]!='\''))
+            return false;
+        char quote = _data[_pos++];
+        const char *close = static_cast<const char *>(
+            memchr(_data+_pos,quote,_size-_pos));
+        if(!close)
+            return false;
+        attribute.value = ByteView(_data+_pos,close);
+        if(attribute.value.contains('<'))
+            return false;
+        _pos = size_t(close-_data)+1;
+        _attributes.push_back(attribute);
+    }
+}
+//------------------------------------------------------------------------------
+XmlScanner::Token XmlScanner::scanMarkup(){
+    if(startsWith("</"))
+        return scanEndElement();
+    if(startsWith("<!--")){
+        size_t end = find("-->",_pos+4);
+        if(end==std::string::npos)
+            return fail("Unterminated comment.");
+        _text = ByteView(_data+_pos+4,_data+end);
+        _pos = end+3;
+        return _token = tComment;
+    }
+    if(startsWith("<![CDATA[")){
+        size_t end = find("]]>",_pos+9);
+        if(end==std::string::npos)
+            return fail("Unterminated CDATA section.");
+        _text = ByteView(_data+_pos+9,_data+end);
+        _pos = end+3;
+        return _token = tCData;
+    }
+    if(startsWith("<!DOCTYPE")){
+        // Internal subset included
+        int brackets = 0;
+        for(size_t p=_pos+9;p<_size;++p){
+            if(_data[p]=='[')
+                ++brackets;
+            else if(_data[p]==']')
+                --brackets;
+            else if(_data[p]=='>' && brackets<=0){
+                _text = ByteView(_data+_pos,_data+p+1);
+                _pos = p+1;
+                return _token = tDoctype;
+            }
+        }
+        return fail("Unterminated DOCTYPE.");
+    }
+    if(startsWith("<?")){
+        _pos += 2;
+        _name = scanName();
+        bool declaration = _tokenOffset==0 && _name==ByteView("xml",3);
+        if(declaration){
+            if(!scanAttributes(true) || !startsWith("?>"))
+                return fail("Malformed XML declaration.");
+            _encoding = attribute("encoding");
+            _pos += 2;
+            return _token = tDeclaration;
+        }
+        size_t end = find("?>",_pos);
+        if(_name.isEmpty() || end==std::string::npos)
+            return fail("Malformed processing instruction.");
+        _text = ByteView(_data+_pos,_data+end);
+        _pos = end+2;
+        return _token = tProcessingInstruction;
+    }
+    if(startsWith("<!"))
+        return fail("Unsupported markup declaration.");
+    return scanStartElement();
+}
+//------------------------------------------------------------------------------
+XmlScanner::Token XmlScanner::scanStartElement(){
+    ++_pos;
+    _name = scanName();
+    if(_name.isEmpty())
+        return fail("Invalid element name.");
+    if(!scanAttributes(false))
+        return fail("Malformed start tag.");
+    if(_data[_pos]=='/'){
+        if(!startsWith("/>"))
+            return fail("Malformed start tag.");
+        _selfClosing = _pendingEnd = true;
+        _pos += 2;
+    }else
+        ++_pos;
+    _openElements.push_back(_name);
+    return _token = tStartElement;
+}
+//------------------------------------------------------------------------------
+XmlScanner::Token XmlScanner::scanEndElement(){
+    _pos += 2;
+    _name = scanName();
+    skipBlanks();
+    if(_pos>=_size || _data[_pos]!='>')
+        return fail("Malformed end tag.");
+    ++_pos;
+    if(_openElements.empty() || _openElements.back()!=_name)
+        return fail("Opening and ending tag mismatch.");
+    _openElements.pop_back();
+    return _token = tEndElement;
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,93 @@
+#ifndef XMLSCANNER_H
+#define XMLSCANNER_H
+
+#include <string>
+#include <vector>
+#include "byteView.h"
+
+
+//------------------------------------------------------------------------------
+// class XmlScanner
+//------------------------------------------------------------------------------
+// Pull tokenizer over an XML document held in memory, working on the raw
+// bytes: any ASCII compatible encoding (ISO-8859-1, UTF-8...) goes through
+// untouched, names, attribute values and texts are views into the document.
+// Entity and character references are left in place (see decode() and,
+// for the whole content of an element, decodeContent()), tag nesting is
+// verified. DTDs are reported, not interpreted.
+//------------------------------------------------------------------------------
+class XmlScanner
+{
+    public:
+        // Types
+        enum Token {
+            tNone,
+            tStartElement,
+            tEndElement,        // also right after a "<tag/>" start element
+            tText,
+            tCData,
+            tComment,
+            tDeclaration,       // <?xml ...?> at the very beginning
+            tProcessingInstruction,
+            tDoctype,
+            tEndDocument,
+            tError,
+        };
+        struct Attribute {
+            ByteView name;
+            ByteView value;     // raw: references not decoded
+        };
+        // Constructor
+        XmlScanner();
+        // Accessors
+        inline Token token()const { return _token; }
+        inline size_t tokenOffset()const { return _tokenOffset; }
+        inline size_t position()const { return _pos; } // right after the token
+        inline int depth()const { return int(_openElements.size()); }
+        inline ByteView name()const { return _name; }
+        inline ByteView text()const { return _text; }
+        inline bool isSelfClosing()const { return _selfClosing; }
+        inline const std::vector<Attribute>& attributes()const { return _attributes; }
+        ByteView attribute(const char *name)const; // null view: none
+        inline ByteView encoding()const { return _encoding; }
+        inline const char *errorString()const { return _error; }
+        // Methods
+        void reset(ByteView document);
+        Token next();
+        Token skipElement();
+        static bool decode(ByteView raw, std::string& out);
+        static bool decodeContent(ByteView content, std::string& out);
+    private:
+        // Data
+        const char *_data;
+        size_t _size;
+        size_t _pos;
+        Token _token;
+        size_t _tokenOffset;
+        ByteView _name;
+        ByteView _text;
+        bool _selfClosing;
+        bool _pendingEnd;
+        std::vector<Attribute> _attributes;
+        std::vector<ByteView> _openElements;
+        ByteView _encoding;
+        const char *_error;
+        // Private copy constructor and assignment (unimplemented!)
+        XmlScanner(const XmlScanner&);
+        XmlScanner& operator=(const XmlScanner&);
+        // Helpers
+        Token fail(const char *error);
+        bool startsWith(const char *s)const;
+        size_t find(const char *s, size_t from)const;
+        ByteView scanName();
+        void skipBlanks();
+        bool scanAttributes(bool declaration);
+        Token scanMarkup();
+        Token scanStartElement();
+        Token scanEndElement();
+        static inline bool isBlank(char c) {
+            return c==' ' || c=='\t' || c=='\n' || c=='\r';
+        }
+};
+
+#endif // XMLSCANNER_H
@@ -0,0 +1,123 @@
+#include "findingSummary.h"
+
+#include <QDebug>
+#include <algorithm>
+
+
+//------------------------------------------------------------------------------
+// class FindingSummary implementation
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+FindingSummary::FindingSummary() : _detailed(false), _findingCount(0){
+}
+//------------------------------------------------------------------------------
+// Accessors
+//------------------------------------------------------------------------------
+QStringList FindingSummary::report()const{
+    // Ranges over the checked probes, those with findings included in case
+    // their check did not get to the end
+    QVector<uint> population = _checked;
+    for(int i=0;i<_patterns.size();++i)
+        population += _patterns.at(i).serials;
+    std::sort(population.begin(),population.end());
+    population.erase(std::unique(population.begin(),population.end()),
+                     population.end());
+
+    QVector<int> order(_patterns.size());
+    for(int i=0;i<order.size();++i)
+        order[i] = i;
+    std::stable_sort(order.begin(),order.end(),[this](int a, int b){
+        return _patterns.at(a).serials.size()>_patterns.at(b).serials.size();
+    });
+
+    QStringList lines;
+    for(int i=0;i<order.size();++i){
+        const Pattern& pattern = _patterns.at(order.at(i));
+        if(!_detailed && pattern.serials.size()<=cRareCount){
+            for(int j=0;j<pattern.serials.size();++j)
+                lines << findingLine(pattern.serials.at(j),pattern.parameter,
+                                     pattern.expected,pattern.got);
+            continue;
+        }
+        QString line;
+        QDebug(&line) << "Wrong" << pattern.parameter << ", expected: "
+                      << pattern.expected << " got:" << pattern.got << " -"
+                      << pattern.serials.size() << "of" << population.size()
+                      << "checked probes:";
+        lines << line+' '+serialRanges(pattern.serials,population);
+    }
+    return lines;
+}
+//------------------------------------------------------------------------------
+// Methods
+//------------------------------------------------------------------------------
+void FindingSummary::setDetailed(bool detailed){
+    _detailed = detailed;
+}
+//------------------------------------------------------------------------------
+void FindingSummary::addChecked(uint serial){
+    _checked.append(serial);
+}
+//------------------------------------------------------------------------------
+void FindingSummary::add(uint serial, const QString& parameter,
+    const QString& expected, const QString& got)
+{
+    // Deep copies: the values may be views into the station
+    QString key = parameter+QChar(0)+expected+QChar(0)+got;
+    QHash<QString,int>::const_iterator it = _patternIndex.constFind(key);
+    int index;
+    if(it==_patternIndex.constEnd()){
+        Pattern pattern;
+        pattern.parameter = parameter;
+        pattern.expected = QString(expected.unicode(),expected.size());
+        pattern.got = QString(got.unicode(),got.size());
+        index = _patterns.size();
+        _patterns.append(pattern);
+        _patternIndex.insert(key,index);
+    }else
+        index = it.value();
+    _patterns[index].serials.append(serial);
+    ++_findingCount;
+}
+//------------------------------------------------------------------------------
+QString FindingSummary::findingLine(uint serial, const QString& parameter,
+    const QString& expected, const QString& got)
+{
+    // The line of the per probe log
+    QString line;
+    QDebug(&line) << "probe " << serial << " - Wrong" << parameter
+                  << ", expected: " << expected << " got:" << got
+                  << " (FIXING!)";
+    return line;
+}
+//------------------------------------------------------------------------------
+QString FindingSummary::serialRanges(const QVector<uint>& serials,
+    const QVector<uint>& population)
+{
+    // "first-last" for runs of consecutive population members, both sorted
+    QVector<uint> sorted = serials;
+    std::sort(sorted.begin(),sorted.end());
+    QStringList ranges;
+    int s = 0, runStart = -1;
+    for(int p=0;p<=population.size();++p){
+        bool member = p<population.size() && s<sorted.size() &&
+                      population.at(p)==sorted.at(s);
+        if(member){
+            if(runStart<0)
+                runStart = p;
+            while(s<sorted.size() && sorted.at(s)==population.at(p))
+                ++s;
+            continue;
+        }
+        if(runStart<0)
+            continue;
+        ranges << (p-1==runStart
+                   ? QString::number(population.at(runStart))
+                   : QString("%1-%2").arg(population.at(runStart))
+                                     .arg(population.at(p-1)));
+        runStart = -1;
+    }
+    return ranges.join(',');
+}
+//------------------------------------------------------------------------------
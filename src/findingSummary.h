@@ -0,0 +1,61 @@
+#ifndef FINDINGSUMMARY_H
+#define FINDINGSUMMARY_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+
+//------------------------------------------------------------------------------
+// class FindingSummary
+//------------------------------------------------------------------------------
+// The wrong values of a run counted by pattern (parameter, expected, got)
+// instead of a log line each: a fleet wide misconfiguration makes one row,
+// with the serials of the probes concerned compressed into ranges. A range
+// runs over the probes checked, "30304-30998" meaning every checked probe in
+// between: the probes with no finding break it. Patterns met at most
+// cRareCount times keep the per probe lines, as do all of them when
+// isDetailed() (the caller then logs each finding as it comes, the report
+// only holding the rows).
+//------------------------------------------------------------------------------
+class FindingSummary
+{
+    public:
+        // Constants
+        enum {
+            cRareCount = 5, // findings of a pattern still reported one by one
+        };
+        // Constructor
+        FindingSummary();
+        // Accessors
+        inline bool isDetailed()const { return _detailed; }
+        inline int patternCount()const { return _patterns.size(); }
+        inline uint findingCount()const { return _findingCount; }
+        QStringList report()const; // the most frequent pattern first
+        // Methods
+        void setDetailed(bool detailed);
+        void addChecked(uint serial);
+        void add(uint serial, const QString& parameter, const QString& expected,
+                 const QString& got);
+        static QString findingLine(uint serial, const QString& parameter,
+                                   const QString& expected, const QString& got);
+        static QString serialRanges(const QVector<uint>& serials,
+                                    const QVector<uint>& population);
+    private:
+        // Types
+        struct Pattern {
+            QString parameter;
+            QString expected;
+            QString got;
+            QVector<uint> serials; // in check order
+        };
+        // Data
+        bool _detailed;
+        uint _findingCount;
+        QVector<Pattern> _patterns; // in order of appearance
+        QHash<QString,int> _patternIndex; // "parameter\0expected\0got"
+        QVector<uint> _checked;
+};
+
+#endif // FINDINGSUMMARY_H
@@ -0,0 +1,607 @@
+#include "fleetIndex.h"
+
+#include "ipCodec.h"
+#include <algorithm>
+#include <QDir>
+#include <QDirIterator>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QXmlStreamReader>
+
+
+//------------------------------------------------------------------------------
+// class FleetIndex::Builder
+//------------------------------------------------------------------------------
+class FleetIndex::Builder
+{
+    public:
+        // Methods
+        quint32 pathId(const QString& path, quint8 flags);
+        quint32 valueId(const QString& value);
+        bool serialize(QIODevice& device);
+        // Data
+        QVector<StationRecord> stations;
+        QVector<QString> paths;
+        QVector<quint8> pathFlags;
+        QVector<QString> values;
+        QVector<Row> rows;
+    private:
+        // Constants
+        enum {
+            cMaxBlobSize = 0x40000000,  // quint32 offsets, far from int sizes
+            cRowChunk = 16384,
+        };
+        // Data
+        QHash<QString,quint32> _pathIds;
+        QHash<QString,quint32> _valueIds;
+        // Helpers
+        static quint64 align(quint64 offset) { return (offset+7) & ~quint64(7); }
+        static bool appendStrings(const QVector<QString>& strings,
+                                  QVector<quint32>& offsets, QByteArray& blob);
+        static bool writeSection(QIODevice& device, quint64& pos, quint64 offset,
+                                 const void *data, quint64 size);
+};
+//------------------------------------------------------------------------------
+// Methods
+//------------------------------------------------------------------------------
+quint32 FleetIndex::Builder::pathId(const QString& path, quint8 flags){
+    QHash<QString,quint32>::const_iterator it = _pathIds.constFind(path);
+    if(it!=_pathIds.constEnd()){
+        pathFlags[int(*it)] |= flags;
+        return *it;
+    }
+    quint32 id = quint32(paths.size());
+    _pathIds.insert(path,id);
+    paths.append(path);
+    pathFlags.append(flags);
+    return id;
+}
+//------------------------------------------------------------------------------
+quint32 FleetIndex::Builder::valueId(const QString& value){
+    QHash<QString,quint32>::const_iterator it = _valueIds.constFind(value);
+    if(it!=_valueIds.constEnd())
+        return *it;
+    quint32 id = quint32(values.size());
+    _valueIds.insert(value,id);
+    values.append(value);
+    return id;
+}
+//------------------------------------------------------------------------------
+bool FleetIndex::Builder::serialize(QIODevice& device){
+    std::sort(rows.begin(),rows.end(),[](const Row& lhs, const Row& rhs){
+        return lhs.path!=rhs.path ? lhs.path<rhs.path : lhs.station<rhs.station;
+    });
+
+    QVector<quint32> pathFirstRow(paths.size()+1);
+    int row = 0;
+    for(int p=0;p<paths.size();++p){
+        pathFirstRow[p] = quint32(row);
+        while(row<rows.size() && rows.at(row).path==quint32(p))
+            ++row;
+    }
+    pathFirstRow[paths.size()] = quint32(rows.size());
+
+    QVector<quint32> pathString, valueString;
+    QByteArray pathBlob, valueBlob;
+    if(!appendStrings(paths,pathString,pathBlob) ||
+       !appendStrings(values,valueString,valueBlob))
+        return false;
+
+    Header header;
+    memset(&header,0,sizeof(header));
+    header.magic = cMagic;
+    header.version = cVersion;
+    header.byteOrderMark = cByteOrderMark;
+    header.stationCount = quint32(stations.size());
+    header.pathCount = quint32(paths.size());
+    header.valueCount = quint32(values.size());
+    header.rowCount = quint32(rows.size());
+    header.stationsOffset = align(sizeof(Header));
+    header.pathFirstRowOffset = align(header.stationsOffset +
+                                      quint64(stations.size())*sizeof(StationRecord));
+    header.pathStringOffset = align(header.pathFirstRowOffset +
+                                    quint64(pathFirstRow.size())*sizeof(quint32));
+    header.pathFlagsOffset = align(header.pathStringOffset +
+                                   quint64(pathString.size())*sizeof(quint32));
+    header.valueStringOffset = align(header.pathFlagsOffset +
+                                     quint64(pathFlags.size()));
+    header.rowStationOffset = align(header.valueStringOffset +
+                                    quint64(valueString.size())*sizeof(quint32));
+    header.rowValueOffset = align(header.rowStationOffset +
+                                  quint64(rows.size())*sizeof(quint32));
+    header.pathBlobOffset = align(header.rowValueOffset +
+                                  quint64(rows.size())*sizeof(quint32));
+    header.valueBlobOffset = align(header.pathBlobOffset+quint64(pathBlob.size()));
+    header.fileSize = header.valueBlobOffset+quint64(valueBlob.size());
+
+    // Section by section, straight to the device: the file is never held
+    // whole in memory, its size is 64 bit
+    quint64 pos = 0;
+    if(!writeSection(device,pos,0,&header,sizeof(header)) ||
+       !writeSection(device,pos,header.stationsOffset,stations.constData(),
+                     quint64(stations.size())*sizeof(StationRecord)) ||
+       !writeSection(device,pos,header.pathFirstRowOffset,pathFirstRow.constData(),
+                     quint64(pathFirstRow.size())*sizeof(quint32)) ||
+       !writeSection(device,pos,header.pathStringOffset,pathString.constData(),
+                     quint64(pathString.size())*sizeof(quint32)) ||
+       !writeSection(device,pos,header.pathFlagsOffset,pathFlags.constData(),
+                     quint64(pathFlags.size())) ||
+       !writeSection(device,pos,header.valueStringOffset,valueString.constData(),
+                     quint64(valueString.size())*sizeof(quint32)))
+        return false;
+    // The row columns through a buffer of cRowChunk rows
+    QVector<quint32> column;
+    for(int c=0;c<2;++c){
+        quint64 offset = c ? header.rowValueOffset : header.rowStationOffset;
+        for(int first=0;first<rows.size();first+=cRowChunk){
+            int count = qMin(int(cRowChunk),rows.size()-first);
+            column.resize(count);
+            for(int i=0;i<count;++i)
+                column[i] = c ? rows.at(first+i).value : rows.at(first+i).station;
+            if(!writeSection(device,pos,offset+quint64(first)*sizeof(quint32),
+                             column.constData(),quint64(count)*sizeof(quint32)))
+                return false;
+        }
+    }
+    return writeSection(device,pos,header.pathBlobOffset,pathBlob.constData(),
+                        quint64(pathBlob.size())) &&
+           writeSection(device,pos,header.valueBlobOffset,valueBlob.constData(),
+                        quint64(valueBlob.size())) &&
+           pos==header.fileSize;
+}
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+bool FleetIndex::Builder::appendStrings(const QVector<QString>& strings,
+    QVector<quint32>& offsets, QByteArray& blob)
+{
+    offsets.resize(strings.size()+1);
+    for(int i=0;i<strings.size();++i){
+        offsets[i] = quint32(blob.size());
+        QByteArray utf8 = strings.at(i).toUtf8();
+        if(utf8.size()>cMaxBlobSize-blob.size())
+            return false;
+        blob += utf8;
+    }
+    offsets[strings.size()] = quint32(blob.size());
+    return true;
+}
+//------------------------------------------------------------------------------
+bool FleetIndex::Builder::writeSection(QIODevice& device, quint64& pos,
+    quint64 offset, const void *data, quint64 size)
+{
+    // Zeros up to the section's aligned offset, then its bytes
+    static const char zeros[8] = {};
+    if(offset<pos || offset-pos>sizeof(zeros) ||
+       device.write(zeros,qint64(offset-pos))!=qint64(offset-pos) ||
+       device.write(static_cast<const char *>(data),qint64(size))!=qint64(size))
+        return false;
+    pos = offset+size;
+    return true;
+}
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+// class FleetIndex implementation
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+FleetIndex::FleetIndex() : _file(nullptr),_data(nullptr),_header(nullptr)
+{
+}
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+FleetIndex::~FleetIndex(){
+    close();
+}
+//------------------------------------------------------------------------------
+// Accessors
+//------------------------------------------------------------------------------
+uint FleetIndex::stationSerial(uint stationIndex)const{
+    return _stations[stationIndex].serial;
+}
+//------------------------------------------------------------------------------
+QString FleetIndex::path(int pathId)const{
+    return QString::fromUtf8(_pathBlob+_pathString[pathId],
+                             int(_pathString[pathId+1]-_pathString[pathId]));
+}
+//------------------------------------------------------------------------------
+bool FleetIndex::isIPv4Path(int pathId)const{
+    return _pathFlags[pathId] & pfIPv4;
+}
+//------------------------------------------------------------------------------
+QVector<int> FleetIndex::findPaths(const QString& pathOrSuffix)const{
+    QVector<int> found;
+    QString suffix = '/' + pathOrSuffix;
+    for(int p=0;p<int(pathCount());++p){
+        QString candidate = path(p);
+        if(candidate==pathOrSuffix){
+            found.clear();
+            found.append(p);
+            break;
+        }
+        if(candidate.endsWith(suffix))
+            found.append(p);
+    }
+    return found;
+}
+//------------------------------------------------------------------------------
+QString FleetIndex::displayValue(int pathId, quint32 valueId)const{
+    QString raw = value(valueId);
+    if(!isIPv4Path(pathId))
+        return raw;
+    quint32 addr;
+    const ushort *begin = raw.utf16();
+    return IPCodec::parseXmlIPv4(begin,begin+raw.size(),addr)
+           ? ipv4ToString(IPCodec::toInt32(addr)) : raw;
+}
+//------------------------------------------------------------------------------
+// Methods
+//------------------------------------------------------------------------------
+bool FleetIndex::open(const QString& filename){
+    close();
+
+    _file = new QFile(filename);
+    if(!_file->open(QIODevice::ReadOnly) || _file->size()<qint64(sizeof(Header))){
+        close();
+        return false;
+    }
+    _data = _file->map(0,_file->size());
+    if(!_data){
+        close();
+        return false;
+    }
+
+    // Every section within the file, and every offset or id kept in one
+    // within its target, before any of them is used
+    _header = reinterpret_cast<const Header *>(_data);
+    const Header& header = *_header;
+    const quint64 fileSize = quint64(_file->size());
+    if(header.magic!=cMagic || header.version!=cVersion ||
+       header.byteOrderMark!=cByteOrderMark || header.fileSize!=fileSize ||
+       !fits(header.stationsOffset,header.stationCount,sizeof(StationRecord),fileSize) ||
+       !fits(header.pathFirstRowOffset,quint64(header.pathCount)+1,sizeof(quint32),
+             fileSize) ||
+       !fits(header.pathStringOffset,quint64(header.pathCount)+1,sizeof(quint32),
+             fileSize) ||
+       !fits(header.pathFlagsOffset,header.pathCount,sizeof(quint8),fileSize) ||
+       !fits(header.valueStringOffset,quint64(header.valueCount)+1,sizeof(quint32),
+             fileSize) ||
+       !fits(header.rowStationOffset,header.rowCount,sizeof(quint32),fileSize) ||
+       !fits(header.rowValueOffset,header.rowCount,sizeof(quint32),fileSize) ||
+       header.pathBlobOffset>header.valueBlobOffset ||
+       header.valueBlobOffset>fileSize)
+    {
+        close();
+        return false;
+    }
+
+    _stations = reinterpret_cast<const StationRecord *>(_data+_header->stationsOffset);
+    _pathFirstRow = reinterpret_cast<const quint32 *>(_data+_header->pathFirstRowOffset);
+    _pathString = reinterpret_cast<const quint32 *>(_data+_header->pathStringOffset);
+    _pathFlags = _data+_header->pathFlagsOffset;
+    _valueString = reinterpret_cast<const quint32 *>(_data+_header->valueStringOffset);
+    _rowStation = reinterpret_cast<const quint32 *>(_data+_header->rowStationOffset);
+    _rowValue = reinterpret_cast<const quint32 *>(_data+_header->rowValueOffset);
+    _pathBlob = reinterpret_cast<const char *>(_data+_header->pathBlobOffset);
+    _valueBlob = reinterpret_cast<const char *>(_data+_header->valueBlobOffset);
+    if(!isConsistent()){
+        close();
+        return false;
+    }
+    return true;
+}
+//------------------------------------------------------------------------------
+void FleetIndex::close(){
+    if(_file){
+        if(_data)
+            _file->unmap(const_cast<uchar *>(_data));
+        delete _file;
+    }
+    _file = nullptr;
+    _data = nullptr;
+    _header = nullptr;
+}
+//------------------------------------------------------------------------------
+bool FleetIndex::build(const QString& stationsPath, const QString& xmlFilename,
+    const QString& filename, BuildStats& stats)
+{
+    if(!isOpen())
+        open(filename);
+
+    QHash<uint,uint> oldStationBySerial;
+    for(uint i=0;i<stationCount();++i)
+        oldStationBySerial.insert(_stations[i].serial,i);
+    QVector<int> reusedAs(int(stationCount()),-1);
+
+    QVector<uint> serials;
+    {
+        QDirIterator it(stationsPath, QDir::Dirs | QDir::NoDotAndDotDot);
+        bool ok;
+        while(it.hasNext()){
+            it.next();
+            uint serial = it.fileName().toUInt(&ok);
+            if(ok)
+                serials.append(serial);
+        }
+        std::sort(serials.begin(),serials.end());
+    }
+
+    Builder builder;
+    for(int i=0;i<serials.size();++i){
+        uint serial = serials.at(i);
+        QFileInfo fileInfo(stationsPath+'/'+QString::number(serial)+'/'+xmlFilename);
+        if(!fileInfo.isFile())
+            continue;
+
+        StationRecord record;
+        record.serial = serial;
+        record.reserved = 0;
+        record.size = fileInfo.size();
+        record.lastModified = fileInfo.lastModified().toMSecsSinceEpoch();
+        quint32 station = quint32(builder.stations.size());
+        builder.stations.append(record);
+        ++stats.stationCount;
+
+        QHash<uint,uint>::const_iterator old = oldStationBySerial.constFind(serial);
+        if(old!=oldStationBySerial.constEnd() &&
+           _stations[*old].size==record.size &&
+           _stations[*old].lastModified==record.lastModified)
+        {
+            reusedAs[int(*old)] = int(station);
+            ++stats.reusedCount;
+            continue;
+        }
+
+        int firstRow = builder.rows.size();
+        if(parseStation(fileInfo.filePath(),station,builder))
+            ++stats.parsedCount;
+        else{
+            builder.rows.resize(firstRow);
+            builder.stations.removeLast();
+            --stats.stationCount;
+            ++stats.failedCount;
+        }
+    }
+
+    // Carry over the rows of unchanged stations without parsing them again
+    if(stats.reusedCount){
+        QVector<qint64> valueRemap(int(valueCount()),-1);
+        for(uint p=0;p<pathCount();++p){
+            qint64 newPath = -1;
+            for(quint32 r=_pathFirstRow[p];r<_pathFirstRow[p+1];++r){
+                int station = reusedAs.at(int(_rowStation[r]));
+                if(station<0)
+                    continue;
+                if(newPath<0)
+                    newPath = builder.pathId(path(int(p)),_pathFlags[p]);
+                qint64& newValue = valueRemap[int(_rowValue[r])];
+                if(newValue<0)
+                    newValue = builder.valueId(value(_rowValue[r]));
+                Row row = { quint32(station), quint32(newPath), quint32(newValue) };
+                builder.rows.append(row);
+            }
+        }
+    }
+
+    close(); // the mapping must go before the file gets replaced
+
+    QSaveFile file(filename);
+    if(!file.open(QIODevice::WriteOnly) || !builder.serialize(file) ||
+       !file.commit())
+        return false;
+    return open(filename);
+}
+//------------------------------------------------------------------------------
+QBitArray FleetIndex::select(const QVector<Condition>& conditions)const{
+    QBitArray selected(int(stationCount()),true);
+    for(int c=0;c<conditions.size();++c){
+        const Condition& condition = conditions.at(c);
+        // Each distinct value is tested at most once: 1 = match, 0 = no match
+        QVector<qint8> matches(int(valueCount()),-1);
+        QBitArray hit(selected.size());
+        for(quint32 r=_pathFirstRow[condition.pathId];
+            r<_pathFirstRow[condition.pathId+1];
+            ++r)
+        {
+            qint8& match = matches[int(_rowValue[r])];
+            if(match<0){
+                QString display = displayValue(condition.pathId,_rowValue[r]);
+                bool equal = display==condition.value ||
+                             value(_rowValue[r])==condition.value;
+                switch(condition.op){
+                    case coEqual:
+                        match = equal;
+                        break;
+                    case coNotEqual:
+                        match = !equal;
+                        break;
+                    case coPrefix:
+                        match = display.startsWith(condition.value);
+                        break;
+                }
+            }
+            if(match)
+                hit.setBit(int(_rowStation[r]));
+        }
+        selected &= hit;
+    }
+    return selected;
+}
+//------------------------------------------------------------------------------
+QVector<FleetIndex::ValueCount_t> FleetIndex::countBy(int pathId,
+    const QBitArray& stations)const
+{
+    QHash<quint32,uint> counts;
+    for(quint32 r=_pathFirstRow[pathId];r<_pathFirstRow[pathId+1];++r)
+        if(stations.testBit(int(_rowStation[r])))
+            ++counts[_rowValue[r]];
+
+    QVector<ValueCount_t> result;
+    result.reserve(counts.size());
+    for(QHash<quint32,uint>::const_iterator it=counts.constBegin();
+        it!=counts.constEnd();
+        ++it)
+        result.append(ValueCount_t(displayValue(pathId,it.key()),it.value()));
+    std::sort(result.begin(),result.end(),
+              [](const ValueCount_t& lhs, const ValueCount_t& rhs){
+        return lhs.second!=rhs.second ? lhs.second>rhs.second
+                                      : lhs.first<rhs.first;
+    });
+    return result;
+}
+//------------------------------------------------------------------------------
+QVector<FleetIndex::ValueCount_t> FleetIndex::histogram(int pathId,
+    const QBitArray& stations, int bucketCount)const
+{
+    QHash<quint32,uint> counts;
+    for(quint32 r=_pathFirstRow[pathId];r<_pathFirstRow[pathId+1];++r)
+        if(stations.testBit(int(_rowStation[r])))
+            ++counts[_rowValue[r]];
+
+    // Bucket the distinct values, not the rows
+    QVector<QPair<qint64,uint> > numbers;
+    uint nonNumeric = 0;
+    qint64 minimum = 0, maximum = 0;
+    for(QHash<quint32,uint>::const_iterator it=counts.constBegin();
+        it!=counts.constEnd();
+        ++it)
+    {
+        bool ok;
+        qint64 number = value(it.key()).toLongLong(&ok);
+        if(!ok){
+            nonNumeric += it.value();
+            continue;
+        }
+        if(numbers.isEmpty() || number<minimum)
+            minimum = number;
+        if(numbers.isEmpty() || number>maximum)
+            maximum = number;
+        numbers.append(QPair<qint64,uint>(number,it.value()));
+    }
+
+    QVector<ValueCount_t> result;
+    if(!numbers.isEmpty()){
+        bucketCount = qMax(1,bucketCount);
+        qint64 width = (maximum-minimum)/bucketCount+1;
+        QVector<uint> buckets(bucketCount,0);
+        for(int i=0;i<numbers.size();++i)
+            buckets[int((numbers.at(i).first-minimum)/width)] += numbers.at(i).second;
+        for(int b=0;b<bucketCount;++b){
+            qint64 low = minimum+b*width;
+            if(low>maximum)
+                break;
+            qint64 high = qMin(low+width-1,maximum);
+            result.append(ValueCount_t(QString("[%1..%2]").arg(low).arg(high),
+                                       buckets.at(b)));
+        }
+    }
+    if(nonNumeric)
+        result.append(ValueCount_t("(non numeric)",nonNumeric));
+    return result;
+}
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+QString FleetIndex::ipv4ToString(qint32 value){
+    char buffer[IPCodec::cMaxDottedQuadLength];
+    return QString::fromLatin1(buffer,
+                               int(IPCodec::formatDottedQuad(quint32(value),buffer)));
+}
+//------------------------------------------------------------------------------
+bool FleetIndex::fits(quint64 offset, quint64 count, quint64 elementSize,
+    quint64 fileSize)
+{
+    // Aligned as built, offset+count*elementSize<=fileSize without overflowing
+    return offset%sizeof(quint64)==0 && offset<=fileSize &&
+           count<=(fileSize-offset)/elementSize;
+}
+//------------------------------------------------------------------------------
+bool FleetIndex::isConsistent()const{
+    // One pass over the rows, cheap next to parsing a single station file
+    const Header& header = *_header;
+    if(_pathFirstRow[0] || _pathFirstRow[header.pathCount]!=header.rowCount ||
+       _pathString[0] || _valueString[0] ||
+       _pathString[header.pathCount]>header.valueBlobOffset-header.pathBlobOffset ||
+       _valueString[header.valueCount]>header.fileSize-header.valueBlobOffset)
+        return false;
+    for(quint32 p=0;p<header.pathCount;++p)
+        if(_pathFirstRow[p]>_pathFirstRow[p+1] || _pathString[p]>_pathString[p+1])
+            return false;
+    for(quint32 v=0;v<header.valueCount;++v)
+        if(_valueString[v]>_valueString[v+1])
+            return false;
+    for(quint32 r=0;r<header.rowCount;++r)
+        if(_rowStation[r]>=header.stationCount || _rowValue[r]>=header.valueCount)
+            return false;
+    return true;
+}
+//------------------------------------------------------------------------------
+QString FleetIndex::value(quint32 valueId)const{
+    return QString::fromUtf8(_valueBlob+_valueString[valueId],
+                             int(_valueString[valueId+1]-_valueString[valueId]));
+}
+//------------------------------------------------------------------------------
+bool FleetIndex::parseStation(const QString& filename, quint32 station,
+    Builder& builder)const
+{
+    QFile file(filename);
+    if(!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QXmlStreamReader xmlReader(&file);
+    QString elementPath;
+    QVector<int> elementPathLengths;
+    QVector<quint8> valueElementFlags; // 0: not an Element/Entry
+    while(!xmlReader.atEnd()){
+        switch(xmlReader.readNext()){
+            case QXmlStreamReader::StartElement:
+            {
+                QStringRef tag = xmlReader.name();
+                QXmlStreamAttributes attributes = xmlReader.attributes();
+                QStringRef name = attributes.value("name");
+                elementPathLengths.append(elementPath.length());
+                if(!elementPath.isEmpty())
+                    elementPath += '/';
+                elementPath += tag;
+                elementPath += '(';
+                if(name.isEmpty())
+                    elementPath += '*';
+                else
+                    elementPath += name;
+                elementPath += ')';
+
+                quint8 flags = 0;
+                if(tag=="Element" || tag=="Entry")
+                    flags = 0x80 | (attributes.value("type")=="ipv4" ? pfIPv4 : 0);
+                valueElementFlags.append(flags);
+                break;
+            }
+            case QXmlStreamReader::EndElement:
+                elementPath.truncate(elementPathLengths.last());
+                elementPathLengths.removeLast();
+                valueElementFlags.removeLast();
+                break;
+            case QXmlStreamReader::Characters:
+                if(!valueElementFlags.isEmpty() && valueElementFlags.last() &&
+                   !xmlReader.isWhitespace())
+                {
+                    Row row;
+                    row.station = station;
+                    row.path = builder.pathId(elementPath,
+                                              valueElementFlags.last() & pfIPv4);
+                    row.value = builder.valueId(xmlReader.text().toString());
+                    builder.rows.append(row);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    return !xmlReader.hasError();
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,142 @@
+#ifndef FLEETINDEX_H
+#define FLEETINDEX_H
+
+#include <QBitArray>
+#include <QHash>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+//------------------------------------------------------------------------------
+// Forwards
+//------------------------------------------------------------------------------
+class QFile;
+
+
+//------------------------------------------------------------------------------
+// class FleetIndex
+//------------------------------------------------------------------------------
+// Columnar, dictionary encoded store of every Element/Entry value of every
+// station file, keyed by (serial, element path). Element paths use the same
+// notation as ConfigurationCheck::_checks. Rows are sorted by path, so a
+// filter or a group-by only scans the rows of the paths it names, and value
+// predicates are evaluated once per distinct value instead of once per row.
+// The store file is memory mapped; rebuilding it only re-parses the station
+// files whose size or modification time changed.
+//------------------------------------------------------------------------------
+class FleetIndex
+{
+    public:
+        // Types
+        enum ConditionOp {
+            coEqual,
+            coNotEqual,
+            coPrefix,
+        };
+        struct Condition {
+            int pathId;
+            ConditionOp op;
+            QString value;
+        };
+        struct BuildStats {
+            inline BuildStats() : stationCount(0), parsedCount(0),
+                                  reusedCount(0), failedCount(0) {}
+
+            uint stationCount;
+            uint parsedCount;
+            uint reusedCount;
+            uint failedCount;
+        };
+        typedef QPair<QString,uint> ValueCount_t;
+        // Constructor
+        FleetIndex();
+        // Destructor
+        ~FleetIndex();
+        // Accessors
+        inline bool isOpen()const { return _data!=nullptr; }
+        inline uint stationCount()const { return _header ? _header->stationCount : 0; }
+        inline uint pathCount()const { return _header ? _header->pathCount : 0; }
+        inline uint valueCount()const { return _header ? _header->valueCount : 0; }
+        inline uint rowCount()const { return _header ? _header->rowCount : 0; }
+        uint stationSerial(uint stationIndex)const;
+        QString path(int pathId)const;
+        bool isIPv4Path(int pathId)const;
+        QVector<int> findPaths(const QString& pathOrSuffix)const;
+        QString displayValue(int pathId, quint32 valueId)const;
+        // Methods
+        bool open(const QString& filename);
+        void close();
+        bool build(const QString& stationsPath, const QString& xmlFilename,
+                   const QString& filename, BuildStats& stats);
+        QBitArray select(const QVector<Condition>& conditions)const;
+        QVector<ValueCount_t> countBy(int pathId, const QBitArray& stations)const;
+        QVector<ValueCount_t> histogram(int pathId, const QBitArray& stations,
+                                        int bucketCount)const;
+        // Helpers
+        static QString ipv4ToString(qint32 value);
+    private:
+        // Constants
+        enum {
+            cMagic = 0x5849464D, // "MFIX"
+            cVersion = 1,
+            cByteOrderMark = 0x01020304,
+        };
+        enum PathFlag {
+            pfIPv4 = 0x01,
+        };
+        // Types
+        struct Header {
+            quint32 magic;
+            quint32 version;
+            quint32 byteOrderMark;
+            quint32 stationCount;
+            quint32 pathCount;
+            quint32 valueCount;
+            quint32 rowCount;
+            quint32 reserved;
+            quint64 stationsOffset;     // StationRecord[stationCount]
+            quint64 pathFirstRowOffset; // quint32[pathCount+1]
+            quint64 pathStringOffset;   // quint32[pathCount+1]
+            quint64 pathFlagsOffset;    // quint8[pathCount]
+            quint64 valueStringOffset;  // quint32[valueCount+1]
+            quint64 rowStationOffset;   // quint32[rowCount]
+            quint64 rowValueOffset;     // quint32[rowCount]
+            quint64 pathBlobOffset;     // UTF-8 path strings
+            quint64 valueBlobOffset;    // UTF-8 value strings
+            quint64 fileSize;
+        };
+        struct StationRecord {
+            quint32 serial;
+            quint32 reserved;
+            qint64 size;
+            qint64 lastModified;
+        };
+        struct Row {
+            quint32 station;
+            quint32 path;
+            quint32 value;
+        };
+        class Builder;
+        // Data
+        QFile *_file;
+        const uchar *_data;
+        const Header *_header;
+        const StationRecord *_stations;
+        const quint32 *_pathFirstRow;
+        const quint32 *_pathString;
+        const quint8 *_pathFlags;
+        const quint32 *_valueString;
+        const quint32 *_rowStation;
+        const quint32 *_rowValue;
+        const char *_pathBlob;
+        const char *_valueBlob;
+        // Helpers
+        static bool fits(quint64 offset, quint64 count, quint64 elementSize,
+                         quint64 fileSize);
+        bool isConsistent()const;
+        QString value(quint32 valueId)const;
+        bool parseStation(const QString& filename, quint32 station,
+                          Builder& builder)const;
+};
+
+#endif // FLEETINDEX_H
@@ -0,0 +1,322 @@
+#include "inflater.h"
+
+
+//------------------------------------------------------------------------------
+// Tables (RFC 1951, 3.2.5)
+//------------------------------------------------------------------------------
+namespace {
+
+const short lengthBase[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+const short lengthExtra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+const short distanceBase[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+    8193, 12289, 16385, 24577 };
+const short distanceExtra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+const short codeLengthOrder[19] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+} // namespace
+
+
+//------------------------------------------------------------------------------
+// class Inflater implementation
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+Inflater::Inflater() : _readFn(nullptr), _opaque(nullptr)
+{
+    short lengths[cFixedLengthCodes];
+    int symbol = 0;
+    for(;symbol<144;++symbol)
+        lengths[symbol] = 8;
+    for(;symbol<256;++symbol)
+        lengths[symbol] = 9;
+    for(;symbol<280;++symbol)
+        lengths[symbol] = 7;
+    for(;symbol<cFixedLengthCodes;++symbol)
+        lengths[symbol] = 8;
+    buildHuffman(_fixedLengthCode,lengths,cFixedLengthCodes);
+
+    for(symbol=0;symbol<cMaxDistanceCodes;++symbol)
+        lengths[symbol] = 5;
+    buildHuffman(_fixedDistanceCode,lengths,cMaxDistanceCodes);
+
+    reset(nullptr,nullptr);
+}
+//------------------------------------------------------------------------------
+// Methods
+//------------------------------------------------------------------------------
+void Inflater::reset(ReadFnPtr_t readFn, void *opaque){
+    _readFn = readFn;
+    _opaque = opaque;
+    _inputPos = _inputSize = 0;
+    _bitBuffer = 0;
+    _bitCount = 0;
+    _state = sBlockHeader;
+    _lastBlock = false;
+    _storedRemaining = 0;
+    _copyLength = _copyDistance = 0;
+    _windowPos = 0;
+    _totalOut = 0;
+    _currentLengthCode = &_fixedLengthCode;
+    _currentDistanceCode = &_fixedDistanceCode;
+}
+//------------------------------------------------------------------------------
+long Inflater::read(uint8_t *out, size_t size){
+    size_t produced = 0;
+    while(produced<size){
+        if(_copyLength){
+            output(_window[(_windowPos-_copyDistance) & (cWindowSize-1)],out,
+                   produced);
+            --_copyLength;
+            continue;
+        }
+
+        switch(_state){
+            case sBlockHeader:
+                if(!readBlockHeader())
+                    return -1;
+                break;
+            case sStored:
+                if(!_storedRemaining)
+                    _state = sBlockHeader;
+                else{
+                    uint8_t byte = uint8_t(bits(8));
+                    if(failed())
+                        return -1;
+                    output(byte,out,produced);
+                    --_storedRemaining;
+                }
+                break;
+            case sHuffman:{
+                int symbol = decode(*_currentLengthCode);
+                if(symbol<0)
+                    return -1;
+                if(symbol<256){
+                    output(uint8_t(symbol),out,produced);
+                    break;
+                }
+                if(symbol==256){
+                    _state = sBlockHeader;
+                    break;
+                }
+                symbol -= 257;
+                if(symbol>=29){
+                    _state = sFailed;
+                    return -1;
+                }
+                uint32_t length = uint32_t(lengthBase[symbol])+
+                                  bits(lengthExtra[symbol]);
+                symbol = decode(*_currentDistanceCode);
+                if(symbol<0 || symbol>=cMaxDistanceCodes){
+                    _state = sFailed;
+                    return -1;
+                }
+                uint32_t distance = uint32_t(distanceBase[symbol])+
+                                    bits(distanceExtra[symbol]);
+                if(failed() || distance>_totalOut){
+                    _state = sFailed;
+                    return -1;
+                }
+                _copyLength = length;
+                _copyDistance = distance;
+                break;
+            }
+            case sDone:
+                return long(produced);
+            case sFailed:
+                return -1;
+        }
+    }
+    return long(produced);
+}
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+bool Inflater::needBits(int count){
+    while(_bitCount<count){
+        if(_inputPos==_inputSize){
+            _inputSize = _readFn ? _readFn(_opaque,_input,sizeof(_input)) : 0;
+            _inputPos = 0;
+            if(!_inputSize){
+                _state = sFailed; // truncated stream
+                return false;
+            }
+        }
+        _bitBuffer |= uint64_t(_input[_inputPos++])<<_bitCount;
+        _bitCount += 8;
+    }
+    return true;
+}
+//------------------------------------------------------------------------------
+uint32_t Inflater::bits(int count){
+    if(!needBits(count))
+        return 0;
+    uint32_t value = uint32_t(_bitBuffer & ((uint64_t(1)<<count)-1));
+    _bitBuffer >>= count;
+    _bitCount -= count;
+    return value;
+}
+//------------------------------------------------------------------------------
+int Inflater::decode(const Huffman& huffman){
+    // Codes are stored most significant bit first: walk them one bit at a
+    // time, first code of each length being 'first'
+    int code = 0, first = 0, index = 0;
+    for(int length=1;length<=cMaxBits;++length){
+        code |= int(bits(1));
+        if(failed())
+            return -1;
+        int count = huffman.count[length];
+        if(code-count<first)
+            return huffman.symbol[index+(code-first)];
+        index += count;
+        first += count;
+        first <<= 1;
+        code <<= 1;
+    }
+    _state = sFailed;
+    return -1;
+}
+//------------------------------------------------------------------------------
+int Inflater::buildHuffman(Huffman& huffman, const short *lengths, int count){
+    // Returns 0 for a complete code, >0 for an incomplete one and <0 for an
+    // over-subscribed (invalid) one
+    for(int length=0;length<=cMaxBits;++length)
+        huffman.count[length] = 0;
+    for(int symbol=0;symbol<count;++symbol)
+        ++huffman.count[lengths[symbol]];
+    if(huffman.count[0]==count)
+        return 0;
+
+    int left = 1;
+    for(int length=1;length<=cMaxBits;++length){
+        left <<= 1;
+        left -= huffman.count[length];
+        if(left<0)
+            return left;
+    }
+
+    short offsets[cMaxBits+1];
+    offsets[1] = 0;
+    for(int length=1;length<cMaxBits;++length)
+        offsets[length+1] = short(offsets[length]+huffman.count[length]);
+    for(int symbol=0;symbol<count;++symbol)
+        if(lengths[symbol])
+            huffman.symbol[offsets[lengths[symbol]]++] = short(symbol);
+    return left;
+}
+//------------------------------------------------------------------------------
+bool Inflater::readBlockHeader(){
+    if(_lastBlock){
+        _state = sDone;
+        return true;
+    }
+    _lastBlock = bits(1);
+    uint32_t type = bits(2);
+    if(failed())
+        return false;
+
+    switch(type){
+        case 0:{
+            // Stored: skip to the byte boundary, LEN and its complement follow
+            _bitBuffer >>= _bitCount%8;
+            _bitCount -= _bitCount%8;
+            uint32_t length = bits(16);
+            uint32_t complement = bits(16);
+            if(failed() || length!=(~complement & 0xFFFF)){
+                _state = sFailed;
+                return false;
+            }
+            _storedRemaining = length;
+            _state = sStored;
+            return true;
+        }
+        case 1:
+            _currentLengthCode = &_fixedLengthCode;
+            _currentDistanceCode = &_fixedDistanceCode;
+            _state = sHuffman;
+            return true;
+        case 2:
+            if(!readDynamicTables()){
+                _state = sFailed;
+                return false;
+            }
+            _currentLengthCode = &_lengthCode;
+            _currentDistanceCode = &_distanceCode;
+            _state = sHuffman;
+            return true;
+        default:
+            _state = sFailed;
+            return false;
+    }
+}
+//------------------------------------------------------------------------------
+bool Inflater::readDynamicTables(){
+    int lengthCount = int(bits(5))+257;
+    int distanceCount = int(bits(5))+1;
+    int codeLengthCount = int(bits(4))+4;
+    if(failed() || lengthCount>cMaxLengthCodes || distanceCount>cMaxDistanceCodes)
+        return false;
+
+    // Code length code, used for the literal/length and distance code lengths
+    short lengths[cMaxLengthCodes+cMaxDistanceCodes];
+    int index = 0;
+    for(;index<codeLengthCount;++index)
+        lengths[codeLengthOrder[index]] = short(bits(3));
+    for(;index<19;++index)
+        lengths[codeLengthOrder[index]] = 0;
+    if(failed() || buildHuffman(_lengthCode,lengths,19))
+        return false;
+
+    index = 0;
+    while(index<lengthCount+distanceCount){
+        int symbol = decode(_lengthCode);
+        if(symbol<0)
+            return false;
+        if(symbol<16){
+            lengths[index++] = short(symbol);
+            continue;
+        }
+        short length = 0;
+        int repeat;
+        if(symbol==16){
+            if(!index)
+                return false;
+            length = lengths[index-1];
+            repeat = 3+int(bits(2));
+        }else if(symbol==17)
+            repeat = 3+int(bits(3));
+        else
+            repeat = 11+int(bits(7));
+        if(failed() || index+repeat>lengthCount+distanceCount)
+            return false;
+        while(repeat--)
+            lengths[index++] = length;
+    }
+    if(!lengths[256]) // no end of block code
+        return false;
+
+    // Incomplete codes are only allowed for a single code
+    int left = buildHuffman(_lengthCode,lengths,lengthCount);
+    if(left<0 || (left>0 && lengthCount-_lengthCode.count[0]!=1))
+        return false;
+    left = buildHuffman(_distanceCode,lengths+lengthCount,distanceCount);
+    if(left<0 || (left>0 && distanceCount-_distanceCode.count[0]!=1))
+        return false;
+    return true;
+}
+//------------------------------------------------------------------------------
+inline void Inflater::output(uint8_t byte, uint8_t *out, size_t& produced){
+    out[produced++] = byte;
+    _window[_windowPos++ & (cWindowSize-1)] = byte;
+    if(_totalOut<cWindowSize)
+        ++_totalOut;
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,89 @@
+#ifndef INFLATER_H
+#define INFLATER_H
+
+#include <cstddef>
+#include <cstdint>
+
+
+//------------------------------------------------------------------------------
+// class Inflater
+//------------------------------------------------------------------------------
+// Streaming decoder of raw DEFLATE data (RFC 1951), as found in zip entries.
+// Compressed input is pulled through a callback, decompressed output is
+// handed out in caller sized pieces: memory use is fixed (32 KiB history
+// window, 16 KiB input buffer) whatever the entry size. Huffman decoding is
+// canonical code walking, after zlib's "puff" reference decoder.
+//------------------------------------------------------------------------------
+class Inflater
+{
+    public:
+        // Types
+        typedef size_t (*ReadFnPtr_t)(void *opaque, uint8_t *buffer, size_t size);
+        // Constructor
+        Inflater();
+        // Accessors
+        inline bool failed()const { return _state==sFailed; }
+        inline bool atEnd()const { return _state==sDone && !_copyLength; }
+        // Methods
+        void reset(ReadFnPtr_t readFn, void *opaque);
+        // Returns the bytes stored in out (less than size only at the end of
+        // the stream) or -1 on corrupted/truncated input.
+        long read(uint8_t *out, size_t size);
+    private:
+        // Constants
+        enum {
+            cMaxBits = 15,
+            cMaxLengthCodes = 286,
+            cMaxDistanceCodes = 30,
+            cFixedLengthCodes = 288,
+            cWindowSize = 32768,
+            cInputBufferSize = 16384,
+        };
+        // Types
+        enum State {
+            sBlockHeader,
+            sStored,
+            sHuffman,
+            sDone,
+            sFailed,
+        };
+        struct Huffman {
+            short count[cMaxBits+1];    // codes per length
+            short symbol[cFixedLengthCodes];
+        };
+        // Data
+        ReadFnPtr_t _readFn;
+        void *_opaque;
+        uint8_t _input[cInputBufferSize];
+        size_t _inputPos;
+        size_t _inputSize;
+        uint64_t _bitBuffer;
+        int _bitCount;
+        State _state;
+        bool _lastBlock;
+        uint32_t _storedRemaining;
+        uint32_t _copyLength;
+        uint32_t _copyDistance;
+        uint8_t _window[cWindowSize];
+        uint32_t _windowPos;
+        uint32_t _totalOut;       // saturates at cWindowSize
+        Huffman _lengthCode;
+        Huffman _distanceCode;
+        Huffman _fixedLengthCode;
+        Huffman _fixedDistanceCode;
+        const Huffman *_currentLengthCode;
+        const Huffman *_currentDistanceCode;
+        // Private copy constructor and assignment (unimplemented!)
+        Inflater(const Inflater&);
+        Inflater& operator=(const Inflater&);
+        // Helpers
+        bool needBits(int count);
+        uint32_t bits(int count);
+        int decode(const Huffman& huffman);
+        static int buildHuffman(Huffman& huffman, const short *lengths, int count);
+        bool readBlockHeader();
+        bool readDynamicTables();
+        inline void output(uint8_t byte, uint8_t *out, size_t& produced);
+};
+
+#endif // INFLATER_H
@@ -0,0 +1,298 @@
+#include "ioRing.h"
+
+#if defined(EXPRIVIA_IO_URING) && defined(__linux__)
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <linux/stat.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+
+//------------------------------------------------------------------------------
+// Syscalls
+//------------------------------------------------------------------------------
+namespace {
+
+int ioUringSetup(unsigned entries, io_uring_params *params){
+    return int(syscall(__NR_io_uring_setup,entries,params));
+}
+
+int ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete,
+                 unsigned flags)
+{
+    return int(syscall(__NR_io_uring_enter,fd,toSubmit,minComplete,flags,
+                       nullptr,0));
+}
+
+int ioUringRegister(int fd, unsigned opcode, void *arg, unsigned count){
+    return int(syscall(__NR_io_uring_register,fd,opcode,arg,count));
+}
+
+const uint8_t requiredOps[] = {
+    IORING_OP_OPENAT,
+    IORING_OP_STATX,
+    IORING_OP_READ,
+    IORING_OP_WRITE,
+    IORING_OP_CLOSE,
+    IORING_OP_MKDIRAT,
+    IORING_OP_RENAMEAT,
+};
+
+} // namespace
+
+
+//------------------------------------------------------------------------------
+// class IoRing implementation
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+IoRing::IoRing() : _fd(-1), _entries(0), _sqRing(MAP_FAILED), _sqRingSize(0),
+    _cqRing(MAP_FAILED), _cqRingSize(0), _sqes(MAP_FAILED), _sqesSize(0),
+    _sqHead(nullptr), _sqTail(nullptr), _sqMask(0), _sqArray(nullptr),
+    _cqHead(nullptr), _cqTail(nullptr), _cqMask(0), _cqes(nullptr),
+    _sqLocalTail(0), _toSubmit(0)
+{
+}
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+IoRing::~IoRing(){
+    close();
+}
+//------------------------------------------------------------------------------
+// Accessors
+//------------------------------------------------------------------------------
+int64_t IoRing::statxSize(const StatxBuffer& statx){
+    static_assert(sizeof(struct statx)<=sizeof(StatxBuffer),
+                  "StatxBuffer too small");
+    return int64_t(reinterpret_cast<const struct statx *>(statx.raw)->stx_size);
+}
+//------------------------------------------------------------------------------
+int64_t IoRing::statxLastModified(const StatxBuffer& statx){
+    const struct statx_timestamp& mtime =
+        reinterpret_cast<const struct statx *>(statx.raw)->stx_mtime;
+    return int64_t(mtime.tv_sec)*1000+mtime.tv_nsec/1000000;
+}
+//------------------------------------------------------------------------------
+// Methods
+//------------------------------------------------------------------------------
+bool IoRing::init(unsigned entries){
+    close();
+
+    io_uring_params params;
+    memset(&params,0,sizeof(params));
+    _fd = ioUringSetup(entries,&params);
+    if(_fd<0){
+        _fd = -1;
+        return false;
+    }
+    _entries = params.sq_entries;
+
+    // Every operation used must be there (mkdirat: 5.15)
+    size_t probeSize = sizeof(io_uring_probe)+256*sizeof(io_uring_probe_op);
+    io_uring_probe *probe = static_cast<io_uring_probe *>(std::calloc(1,probeSize));
+    bool supported = probe &&
+                     !ioUringRegister(_fd,IORING_REGISTER_PROBE,probe,256);
+    for(size_t i=0;supported && i<sizeof(requiredOps);++i)
+        supported = requiredOps[i]<=probe->last_op &&
+                    (probe->ops[requiredOps[i]].flags & IO_URING_OP_SUPPORTED);
+    std::free(probe);
+    if(!supported){
+        close();
+        return false;
+    }
+
+    _sqRingSize = params.sq_off.array+params.sq_entries*sizeof(unsigned);
+    _cqRingSize = params.cq_off.cqes+params.cq_entries*sizeof(io_uring_cqe);
+    bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if(singleMmap && _cqRingSize>_sqRingSize)
+        _sqRingSize = _cqRingSize;
+    _sqRing = mmap(nullptr,_sqRingSize,PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE,_fd,IORING_OFF_SQ_RING);
+    if(singleMmap){
+        _cqRing = _sqRing;
+        _cqRingSize = 0;
+    }else
+        _cqRing = mmap(nullptr,_cqRingSize,PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE,_fd,IORING_OFF_CQ_RING);
+    _sqesSize = params.sq_entries*sizeof(io_uring_sqe);
+    _sqes = mmap(nullptr,_sqesSize,PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE,_fd,IORING_OFF_SQES);
+    if(_sqRing==MAP_FAILED || _cqRing==MAP_FAILED || _sqes==MAP_FAILED){
+        close();
+        return false;
+    }
+
+    char *sq = static_cast<char *>(_sqRing);
+    _sqHead = reinterpret_cast<unsigned *>(sq+params.sq_off.head);
+    _sqTail = reinterpret_cast<unsigned *>(sq+params.sq_off.tail);
+    _sqMask = *reinterpret_cast<unsigned *>(sq+params.sq_off.ring_mask);
+    _sqArray = reinterpret_cast<unsigned *>(sq+params.sq_off.array);
+    char *cq = static_cast<char *>(_cqRing);
+    _cqHead = reinterpret_cast<unsigned *>(cq+params.cq_off.head);
+    _cqTail = reinterpret_cast<unsigned *>(cq+params.cq_off.tail);
+    _cqMask = *reinterpret_cast<unsigned *>(cq+params.cq_off.ring_mask);
+    _cqes = cq+params.cq_off.cqes;
+    _sqLocalTail = *_sqTail;
+    _toSubmit = 0;
+    return true;
+}
+//------------------------------------------------------------------------------
+void IoRing::close(){
+    if(_sqes!=MAP_FAILED)
+        munmap(_sqes,_sqesSize);
+    if(_cqRing!=MAP_FAILED && _cqRing!=_sqRing)
+        munmap(_cqRing,_cqRingSize);
+    if(_sqRing!=MAP_FAILED)
+        munmap(_sqRing,_sqRingSize);
+    _sqes = _cqRing = _sqRing = MAP_FAILED;
+    if(_fd>=0)
+        ::close(_fd);
+    _fd = -1;
+    _entries = 0;
+    _toSubmit = 0;
+}
+//------------------------------------------------------------------------------
+bool IoRing::prepOpenAt(const char *path, int flags, unsigned mode,
+    uint64_t userData)
+{
+    io_uring_sqe *sqe = static_cast<io_uring_sqe *>(
+        nextSqe(IORING_OP_OPENAT,AT_FDCWD,path,mode,0,userData));
+    if(sqe)
+        sqe->open_flags = uint32_t(flags | O_CLOEXEC);
+    return sqe;
+}
+//------------------------------------------------------------------------------
+bool IoRing::prepStatx(const char *path, StatxBuffer *statx, uint64_t userData){
+    io_uring_sqe *sqe = static_cast<io_uring_sqe *>(
+        nextSqe(IORING_OP_STATX,AT_FDCWD,path,STATX_SIZE | STATX_MTIME,
+                reinterpret_cast<uintptr_t>(statx->raw),userData));
+    if(sqe)
+        sqe->statx_flags = 0;
+    return sqe;
+}
+//------------------------------------------------------------------------------
+bool IoRing::prepRead(int fd, void *buffer, unsigned size, uint64_t offset,
+    uint64_t userData)
+{
+    return nextSqe(IORING_OP_READ,fd,buffer,size,offset,userData);
+}
+//------------------------------------------------------------------------------
+bool IoRing::prepWrite(int fd, const void *buffer, unsigned size,
+    uint64_t offset, uint64_t userData)
+{
+    return nextSqe(IORING_OP_WRITE,fd,buffer,size,offset,userData);
+}
+//------------------------------------------------------------------------------
+bool IoRing::prepClose(int fd, uint64_t userData){
+    return nextSqe(IORING_OP_CLOSE,fd,nullptr,0,0,userData);
+}
+//------------------------------------------------------------------------------
+bool IoRing::prepMkdirAt(const char *path, unsigned mode, uint64_t userData){
+    return nextSqe(IORING_OP_MKDIRAT,AT_FDCWD,path,mode,0,userData);
+}
+//------------------------------------------------------------------------------
+bool IoRing::prepRenameAt(const char *oldPath, const char *newPath,
+    uint64_t userData)
+{
+    // len carries the new directory fd, off the new path
+    return nextSqe(IORING_OP_RENAMEAT,AT_FDCWD,oldPath,unsigned(AT_FDCWD),
+                   reinterpret_cast<uintptr_t>(newPath),userData);
+}
+//------------------------------------------------------------------------------
+bool IoRing::submit(unsigned waitFor){
+    if(_fd<0)
+        return false;
+    if(!_toSubmit && !waitFor)
+        return true;
+    // Publish the queued entries before the kernel looks at the tail
+    __atomic_store_n(_sqTail,_sqLocalTail,__ATOMIC_RELEASE);
+    for(;;){
+        int result = ioUringEnter(_fd,_toSubmit,waitFor,
+                                  waitFor ? IORING_ENTER_GETEVENTS : 0);
+        if(result>=0){
+            _toSubmit -= unsigned(result)<_toSubmit ? unsigned(result) : _toSubmit;
+            return true;
+        }
+        // EBUSY (completion queue overflow) cannot happen while callers keep
+        // at most entries() operations in flight
+        if(errno!=EINTR)
+            return false;
+    }
+}
+//------------------------------------------------------------------------------
+bool IoRing::peek(Completion& completion){
+    if(_fd<0)
+        return false;
+    unsigned head = *_cqHead;
+    if(head==__atomic_load_n(_cqTail,__ATOMIC_ACQUIRE))
+        return false;
+    const io_uring_cqe& cqe =
+        static_cast<const io_uring_cqe *>(_cqes)[head & _cqMask];
+    completion.userData = cqe.user_data;
+    completion.result = cqe.res;
+    __atomic_store_n(_cqHead,head+1,__ATOMIC_RELEASE);
+    return true;
+}
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+void *IoRing::nextSqe(uint8_t opcode, int fd, const void *addr, unsigned len,
+    uint64_t offset, uint64_t userData)
+{
+    if(_fd<0 ||
+       _sqLocalTail-__atomic_load_n(_sqHead,__ATOMIC_ACQUIRE)>=_entries)
+        return nullptr;
+    unsigned index = _sqLocalTail & _sqMask;
+    io_uring_sqe *sqe = static_cast<io_uring_sqe *>(_sqes)+index;
+    memset(sqe,0,sizeof(*sqe));
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uintptr_t>(addr);
+    sqe->len = len;
+    sqe->off = offset;
+    sqe->user_data = userData;
+    _sqArray[index] = index;
+    ++_sqLocalTail;
+    ++_toSubmit;
+    return sqe;
+}
+//------------------------------------------------------------------------------
+
+#else // !EXPRIVIA_IO_URING || !__linux__
+
+//------------------------------------------------------------------------------
+// class IoRing implementation (unavailable: init() always fails)
+//------------------------------------------------------------------------------
+IoRing::IoRing() : _fd(-1), _entries(0), _sqRing(nullptr), _sqRingSize(0),
+    _cqRing(nullptr), _cqRingSize(0), _sqes(nullptr), _sqesSize(0),
+    _sqHead(nullptr), _sqTail(nullptr), _sqMask(0), _sqArray(nullptr),
+    _cqHead(nullptr), _cqTail(nullptr), _cqMask(0), _cqes(nullptr),
+    _sqLocalTail(0), _toSubmit(0)
+{
+}
+IoRing::~IoRing(){}
+int64_t IoRing::statxSize(const StatxBuffer&){ return 0; }
+int64_t IoRing::statxLastModified(const StatxBuffer&){ return 0; }
+bool IoRing::init(unsigned){ return false; }
+void IoRing::close(){}
+bool IoRing::prepOpenAt(const char *, int, unsigned, uint64_t){ return false; }
+bool IoRing::prepStatx(const char *, StatxBuffer *, uint64_t){ return false; }
+bool IoRing::prepRead(int, void *, unsigned, uint64_t, uint64_t){ return false; }
+bool IoRing::prepWrite(int, const void *, unsigned, uint64_t, uint64_t){ return false; }
+bool IoRing::prepClose(int, uint64_t){ return false; }
+bool IoRing::prepMkdirAt(const char *, unsigned, uint64_t){ return false; }
+bool IoRing::prepRenameAt(const char *, const char *, uint64_t){ return false; }
+bool IoRing::submit(unsigned){ return false; }
+bool IoRing::peek(Completion&){ return false; }
+void *IoRing::nextSqe(uint8_t, int, const void *, unsigned, uint64_t, uint64_t){
+    return nullptr;
+}
+//------------------------------------------------------------------------------
+
+#endif // EXPRIVIA_IO_URING && __linux__
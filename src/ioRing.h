@@ -0,0 +1,86 @@
+#ifndef IORING_H
+#define IORING_H
+
+#include <cstddef>
+#include <cstdint>
+
+
+//------------------------------------------------------------------------------
+// class IoRing
+//------------------------------------------------------------------------------
+// Thin Linux io_uring wrapper (raw syscalls, no liburing), limited to the file
+// operations station I/O needs. Operations are queued with the prep*()
+// methods, tagged with a caller's 64 bit value, handed to the kernel in one
+// go by submit() and come back as completions in any order. init() fails,
+// and the caller is expected to fall back to blocking I/O, when the build
+// lacks EXPRIVIA_IO_URING, on other systems, on kernels without io_uring (or
+// one of the operations) and where it is denied (e.g. seccomp).
+//------------------------------------------------------------------------------
+class IoRing
+{
+    public:
+        // Types
+        struct Completion {
+            uint64_t userData;
+            int32_t result; // >= 0 success, -errno failure
+        };
+        struct StatxBuffer { // opaque struct statx
+            alignas(8) unsigned char raw[256];
+        };
+        // Constructor
+        IoRing();
+        // Destructor
+        ~IoRing();
+        // Accessors
+        inline bool isOpen()const { return _fd>=0; }
+        inline unsigned entries()const { return _entries; }
+        static int64_t statxSize(const StatxBuffer& statx);
+        static int64_t statxLastModified(const StatxBuffer& statx); // msecs
+        // Methods
+        bool init(unsigned entries);
+        void close();
+        // Operations: false when the submission queue is full
+        bool prepOpenAt(const char *path, int flags, unsigned mode,
+                        uint64_t userData);
+        bool prepStatx(const char *path, StatxBuffer *statx, uint64_t userData);
+        bool prepRead(int fd, void *buffer, unsigned size, uint64_t offset,
+                      uint64_t userData);
+        bool prepWrite(int fd, const void *buffer, unsigned size,
+                       uint64_t offset, uint64_t userData);
+        bool prepClose(int fd, uint64_t userData);
+        bool prepMkdirAt(const char *path, unsigned mode, uint64_t userData);
+        bool prepRenameAt(const char *oldPath, const char *newPath,
+                          uint64_t userData);
+        // Hands the queued operations over, optionally waiting for at least
+        // waitFor completions; returns false on a ring failure
+        bool submit(unsigned waitFor = 0);
+        bool peek(Completion& completion);
+    private:
+        // Data
+        int _fd;
+        unsigned _entries;
+        void *_sqRing;
+        size_t _sqRingSize;
+        void *_cqRing;
+        size_t _cqRingSize;
+        void *_sqes;
+        size_t _sqesSize;
+        unsigned *_sqHead;
+        unsigned *_sqTail;
+        unsigned _sqMask;
+        unsigned *_sqArray;
+        unsigned *_cqHead;
+        unsigned *_cqTail;
+        unsigned _cqMask;
+        void *_cqes;
+        unsigned _sqLocalTail;  // queued, not yet published
+        unsigned _toSubmit;
+        // Private copy constructor and assignment (unimplemented!)
+        IoRing(const IoRing&);
+        IoRing& operator=(const IoRing&);
+        // Helpers
+        void *nextSqe(uint8_t opcode, int fd, const void *addr, unsigned len,
+                      uint64_t offset, uint64_t userData);
+};
+
+#endif // IORING_H
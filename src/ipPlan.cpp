@@ -0,0 +1,372 @@
+#include "ipPlan.h"
+
+#include "ipCodec.h"
+#include <QFile>
+#include <QtAlgorithms>
+
+
+//------------------------------------------------------------------------------
+// class IPPlan::Trie
+//------------------------------------------------------------------------------
+class IPPlan::Trie
+{
+    public:
+        // Constructor
+        Trie(const IPPlan& plan);
+        // Methods
+        int insert(quint32 key, int length);
+        void addOwner(int node, OwnerKind kind, int item);
+        void walk(int node, int enclosingSubnet, bool allowed,
+                  QVector<Finding>& findings)const;
+    private:
+        // Data
+        const IPPlan& _plan;
+        QVector<Node> _nodes;   // 0: root, the empty prefix
+        QVector<Owner> _owners;
+        // Helpers
+        int newNode(quint32 key, int length);
+        int firstSubnetProbe(int node)const;
+        static inline int bit(quint32 key, int position) {
+            return int(key>>(31-position)) & 1;
+        }
+        static inline Finding finding(Issue issue, int probe, int otherProbe,
+                                      int endpoint)
+        {
+            Finding result = { issue, probe, otherProbe, endpoint };
+            return result;
+        }
+};
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+IPPlan::Trie::Trie(const IPPlan& plan) : _plan(plan)
+{
+    _nodes.reserve(2*(2*plan._probes.size()+plan._endpoints.size()+
+                      plan._allowed.size())+1);
+    _owners.reserve(2*plan._probes.size()+plan._endpoints.size()+
+                    plan._allowed.size());
+    newNode(0,0);
+}
+//------------------------------------------------------------------------------
+// Methods
+//------------------------------------------------------------------------------
+int IPPlan::Trie::insert(quint32 key, int length){
+    // Path compressed: a node exists only where a prefix ends or where two
+    // prefixes part, so there are at most two nodes per prefix
+    key &= mask(length);
+    int n = 0;
+    for(;;){
+        if(_nodes.at(n).length==length)
+            return n;
+        int side = bit(key,_nodes.at(n).length);
+        int c = _nodes.at(n).child[side];
+        if(c<0){
+            int leaf = newNode(key,length);
+            _nodes[n].child[side] = leaf;
+            return leaf;
+        }
+
+        const Node& child = _nodes.at(c);
+        quint32 diff = key ^ child.key;
+        int common = diff ? qMin(length,qMin(child.length,
+                                             int(qCountLeadingZeroBits(diff))))
+                          : qMin(length,child.length);
+        if(common==child.length){
+            n = c;
+            continue;
+        }
+        if(common==length){
+            // The new prefix sits between n and its child
+            int middle = newNode(key,length);
+            _nodes[middle].child[bit(_nodes.at(c).key,length)] = c;
+            _nodes[n].child[side] = middle;
+            return middle;
+        }
+        // They part below both: split node, then the new leaf beside c
+        int split = newNode(key & mask(common),common);
+        int leaf = newNode(key,length);
+        int childSide = bit(_nodes.at(c).key,common);
+        _nodes[split].child[childSide] = c;
+        _nodes[split].child[1-childSide] = leaf;
+        _nodes[n].child[side] = split;
+        return leaf;
+    }
+}
+//------------------------------------------------------------------------------
+void IPPlan::Trie::addOwner(int node, OwnerKind kind, int item){
+    Owner owner = { kind, item, -1 };
+    int o = _owners.size();
+    _owners.append(owner);
+    Node& n = _nodes[node];
+    if(n.lastOwner>=0)
+        _owners[n.lastOwner].next = o;
+    else
+        n.firstOwner = o;
+    n.lastOwner = o;
+}
+//------------------------------------------------------------------------------
+void IPPlan::Trie::walk(int node, int enclosingSubnet, bool allowed,
+    QVector<Finding>& findings)const
+{
+    // Depth first, 0 before 1: findings come in address order. The depth is
+    // at most 33, so recursing is fine.
+    const Node& n = _nodes.at(node);
+    for(int o=n.firstOwner;o>=0;o=_owners.at(o).next)
+        allowed |= _owners.at(o).kind==okAllowed;
+
+    // Subnets: nested in the enclosing one, gateways of the probes sharing it
+    // (those with a gateway outside the subnet have been reported already)
+    int firstSubnet = -1, firstGateway = -1;
+    for(int o=n.firstOwner;o>=0;o=_owners.at(o).next){
+        const Owner& owner = _owners.at(o);
+        if(owner.kind!=okSubnet)
+            continue;
+        if(firstSubnet<0){
+            firstSubnet = owner.item;
+            if(enclosingSubnet>=0 && !allowed)
+                findings.append(finding(piSubnetOverlap,owner.item,
+                                        firstSubnetProbe(enclosingSubnet),-1));
+        }
+        const Probe& probe = _plan._probes.at(owner.item);
+        if((probe.gateway ^ n.key) & mask(n.length))
+            continue;
+        if(firstGateway<0)
+            firstGateway = owner.item;
+        else if(probe.gateway!=_plan._probes.at(firstGateway).gateway && !allowed)
+            findings.append(finding(piGatewayConflict,owner.item,firstGateway,-1));
+    }
+    if(firstSubnet>=0)
+        enclosingSubnet = node;
+
+    // Addresses: probes sharing one, endpoints on a probe or in its subnet
+    int firstHost = -1;
+    for(int o=n.firstOwner;o>=0;o=_owners.at(o).next){
+        const Owner& owner = _owners.at(o);
+        if(owner.kind!=okHost)
+            continue;
+        if(firstHost<0)
+            firstHost = owner.item;
+        else if(!allowed)
+            findings.append(finding(piDuplicateAddress,owner.item,firstHost,-1));
+    }
+    for(int o=n.firstOwner;o>=0;o=_owners.at(o).next){
+        const Owner& owner = _owners.at(o);
+        if(owner.kind!=okEndpoint || allowed)
+            continue;
+        if(firstHost>=0)
+            findings.append(finding(piEndpointAddress,firstHost,-1,owner.item));
+        else if(enclosingSubnet>=0)
+            findings.append(finding(piEndpointInSubnet,
+                                    firstSubnetProbe(enclosingSubnet),-1,
+                                    owner.item));
+    }
+
+    for(int side=0;side<2;++side)
+        if(n.child[side]>=0)
+            walk(n.child[side],enclosingSubnet,allowed,findings);
+}
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+int IPPlan::Trie::newNode(quint32 key, int length){
+    Node node = { key, length, { -1, -1 }, -1, -1 };
+    _nodes.append(node);
+    return _nodes.size()-1;
+}
+//------------------------------------------------------------------------------
+int IPPlan::Trie::firstSubnetProbe(int node)const{
+    for(int o=_nodes.at(node).firstOwner;o>=0;o=_owners.at(o).next)
+        if(_owners.at(o).kind==okSubnet)
+            return _owners.at(o).item;
+    return -1;
+}
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+// class IPPlan implementation
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+IPPlan::IPPlan()
+{
+}
+//------------------------------------------------------------------------------
+// Accessors
+//------------------------------------------------------------------------------
+QString IPPlan::describe(const Finding& finding)const{
+    const Probe *probe = finding.probe>=0 ? &_probes.at(finding.probe) : nullptr;
+    const Probe *other = finding.otherProbe>=0 ? &_probes.at(finding.otherProbe)
+                                               : nullptr;
+    const Endpoint *endpoint = finding.endpoint>=0
+                               ? &_endpoints.at(finding.endpoint) : nullptr;
+    QString subnet, otherSubnet;
+    if(probe){
+        int length = prefixLength(probe->netmask);
+        subnet = formatAddress(probe->address & mask(length))+'/'+
+                 QString::number(length);
+    }
+    if(other){
+        int length = prefixLength(other->netmask);
+        otherSubnet = formatAddress(other->address & mask(length))+'/'+
+                      QString::number(length);
+    }
+
+    switch(finding.issue){
+        case piNetmaskNotContiguous:
+            return QString("probe %1: netmask %2 is not contiguous")
+                   .arg(probe->serial).arg(formatAddress(probe->netmask));
+        case piGatewayOutsideSubnet:
+            return QString("probe %1: gateway %2 is outside the probe subnet %3")
+                   .arg(probe->serial).arg(formatAddress(probe->gateway))
+                   .arg(subnet);
+        case piGatewayIsProbe:
+            return QString("probe %1: gateway %2 is the probe address itself")
+                   .arg(probe->serial).arg(formatAddress(probe->gateway));
+        case piNetworkOrBroadcast:
+            return QString("probe %1: address %2 is the network or broadcast "
+                           "address of %3")
+                   .arg(probe->serial).arg(formatAddress(probe->address))
+                   .arg(subnet);
+        case piDuplicateAddress:
+            return QString("probe %1: address %2 is already used by probe %3")
+                   .arg(probe->serial).arg(formatAddress(probe->address))
+                   .arg(other->serial);
+        case piEndpointAddress:
+            return QString("probe %1: address %2 is the %3 address")
+                   .arg(probe->serial).arg(formatAddress(probe->address))
+                   .arg(endpoint->name);
+        case piEndpointInSubnet:
+            return QString("%1 %2 lies inside the subnet %3 of probe %4")
+                   .arg(endpoint->name).arg(formatAddress(endpoint->address))
+                   .arg(subnet).arg(probe->serial);
+        case piGatewayConflict:
+            return QString("probe %1: gateway %2 differs from %3 of probe %4, "
+                           "same subnet %5")
+                   .arg(probe->serial).arg(formatAddress(probe->gateway))
+                   .arg(formatAddress(other->gateway)).arg(other->serial)
+                   .arg(subnet);
+        case piSubnetOverlap:
+            return QString("probe %1: subnet %2 overlaps the subnet %3 of probe %4")
+                   .arg(probe->serial).arg(subnet).arg(otherSubnet)
+                   .arg(other->serial);
+    }
+    return QString();
+}
+//------------------------------------------------------------------------------
+// Methods
+//------------------------------------------------------------------------------
+void IPPlan::clear(){
+    _probes.clear();
+    _endpoints.clear();
+    _allowed.clear();
+}
+//------------------------------------------------------------------------------
+void IPPlan::addProbe(uint serial, quint32 address, quint32 netmask,
+    quint32 gateway)
+{
+    Probe probe = { serial, address, netmask, gateway };
+    _probes.append(probe);
+}
+//------------------------------------------------------------------------------
+void IPPlan::addEndpoint(const QString& name, quint32 address){
+    Endpoint endpoint = { name, address };
+    _endpoints.append(endpoint);
+}
+//------------------------------------------------------------------------------
+void IPPlan::allow(quint32 prefix, int prefixLength){
+    Prefix allowed = { prefix & mask(prefixLength), prefixLength };
+    _allowed.append(allowed);
+}
+//------------------------------------------------------------------------------
+bool IPPlan::loadAllowlist(const QString& filename, int& badLine){
+    // One address or prefix per line ("192.168.2.80", "192.168.2.0/24"),
+    // '#' starts a comment
+    badLine = 0;
+    QFile file(filename);
+    if(!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return false;
+    int lineNum = 0;
+    while(!file.atEnd()){
+        ++lineNum;
+        QByteArray line = file.readLine();
+        int comment = line.indexOf('#');
+        if(comment>=0)
+            line.truncate(comment);
+        line = line.trimmed();
+        if(line.isEmpty())
+            continue;
+
+        int slash = line.indexOf('/');
+        const char *begin = line.constData();
+        const char *end = slash>=0 ? begin+slash : begin+line.size();
+        uint32_t prefix;
+        uint32_t length = 32;
+        if(!IPCodec::parseDottedQuad(begin,end,prefix) ||
+           (slash>=0 && (!IPCodec::parseUInt32(end+1,begin+line.size(),length) ||
+                         length>32)))
+        {
+            badLine = lineNum;
+            return false;
+        }
+        allow(prefix,int(length));
+    }
+    return true;
+}
+//------------------------------------------------------------------------------
+QVector<IPPlan::Finding> IPPlan::analyze()const{
+    QVector<Finding> findings;
+
+    // Each probe on its own
+    for(int i=0;i<_probes.size();++i){
+        const Probe& probe = _probes.at(i);
+        quint32 hostBits = ~probe.netmask;
+        int length = prefixLength(probe.netmask);
+        Finding finding = { piNetmaskNotContiguous, i, -1, -1 };
+        if(hostBits & (hostBits+1))
+            findings.append(finding);
+        if((probe.gateway ^ probe.address) & mask(length)){
+            finding.issue = piGatewayOutsideSubnet;
+            findings.append(finding);
+        }
+        if(probe.gateway==probe.address){
+            finding.issue = piGatewayIsProbe;
+            findings.append(finding);
+        }
+        quint32 host = probe.address & ~mask(length);
+        if(length<=30 && (!host || host==~mask(length))){
+            finding.issue = piNetworkOrBroadcast;
+            findings.append(finding);
+        }
+    }
+
+    // The fleet as a whole
+    Trie trie(*this);
+    for(int i=0;i<_allowed.size();++i)
+        trie.addOwner(trie.insert(_allowed.at(i).prefix,_allowed.at(i).length),
+                      okAllowed,i);
+    for(int i=0;i<_probes.size();++i){
+        const Probe& probe = _probes.at(i);
+        trie.addOwner(trie.insert(probe.address,prefixLength(probe.netmask)),
+                      okSubnet,i);
+        trie.addOwner(trie.insert(probe.address,32),okHost,i);
+    }
+    for(int i=0;i<_endpoints.size();++i)
+        if(_endpoints.at(i).address)
+            trie.addOwner(trie.insert(_endpoints.at(i).address,32),okEndpoint,i);
+    trie.walk(0,-1,false,findings);
+    return findings;
+}
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+int IPPlan::prefixLength(quint32 netmask){
+    // Leading ones: a non contiguous mask counts up to its first hole
+    return ~netmask ? int(qCountLeadingZeroBits(~netmask)) : 32;
+}
+//------------------------------------------------------------------------------
+QString IPPlan::formatAddress(quint32 address){
+    char buffer[IPCodec::cMaxDottedQuadLength];
+    return QString::fromLatin1(buffer,int(IPCodec::formatDottedQuad(address,buffer)));
+}
+//------------------------------------------------------------------------------
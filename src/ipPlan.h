@@ -0,0 +1,106 @@
+#ifndef IPPLAN_H
+#define IPPLAN_H
+
+#include <QString>
+#include <QVector>
+
+
+//------------------------------------------------------------------------------
+// class IPPlan
+//------------------------------------------------------------------------------
+// Fleet wide IPv4 address plan analyzer. Every probe (address, subnet,
+// gateway), the global endpoints (Central 0, SNTP, updater) and the
+// allowlisted prefixes go into one path compressed binary radix trie; a
+// single depth first walk then finds, in address order, the addresses used
+// twice, endpoints clashing with or lying inside a probe subnet, subnets
+// nested in other ones and equal subnets with different gateways. Probes
+// under an allowlisted prefix (e.g. the NATed 192.168.2.80 ones, sharing the
+// same private address behind different routers) are left out of the fleet
+// wide checks, not of the per probe ones (contiguous netmask, gateway inside
+// the subnet, address not the network/broadcast one). Building is O(32 n),
+// the walk O(n), memory a few dozen bytes per probe.
+//------------------------------------------------------------------------------
+class IPPlan
+{
+    public:
+        // Types
+        enum Issue {
+            piNetmaskNotContiguous,
+            piGatewayOutsideSubnet,
+            piGatewayIsProbe,       // gateway == probe address
+            piNetworkOrBroadcast,   // probe address
+            piDuplicateAddress,     // two probes, same address
+            piEndpointAddress,      // probe address == endpoint address
+            piEndpointInSubnet,     // endpoint inside a probe subnet
+            piGatewayConflict,      // same subnet, different gateways
+            piSubnetOverlap,        // subnet nested in another probe's one
+        };
+        struct Finding {
+            Issue issue;
+            int probe;              // index of the probe, -1: none
+            int otherProbe;         // the one it clashes with, -1: none
+            int endpoint;           // -1: none
+        };
+        // Constructor
+        IPPlan();
+        // Accessors
+        inline int probeCount()const { return _probes.size(); }
+        inline int allowedCount()const { return _allowed.size(); }
+        inline uint serial(int probe)const { return _probes.at(probe).serial; }
+        QString describe(const Finding& finding)const;
+        // Methods
+        void clear();
+        void addProbe(uint serial, quint32 address, quint32 netmask,
+                      quint32 gateway);
+        void addEndpoint(const QString& name, quint32 address);
+        void allow(quint32 prefix, int prefixLength);
+        bool loadAllowlist(const QString& filename, int& badLine);
+        QVector<Finding> analyze()const;
+    private:
+        // Types
+        enum OwnerKind {
+            okHost,     // probe address
+            okSubnet,   // probe subnet
+            okEndpoint,
+            okAllowed,
+        };
+        struct Probe {
+            uint serial;
+            quint32 address;
+            quint32 netmask;
+            quint32 gateway;
+        };
+        struct Prefix {
+            quint32 prefix;
+            int length;
+        };
+        struct Endpoint {
+            QString name;
+            quint32 address;
+        };
+        struct Node {
+            quint32 key;        // prefix bits, left aligned
+            int length;
+            int child[2];       // -1: none
+            int firstOwner;     // -1: none (internal split node)
+            int lastOwner;
+        };
+        struct Owner {
+            OwnerKind kind;
+            int item;           // index in _probes, _endpoints or _allowed
+            int next;           // -1: last
+        };
+        class Trie;
+        // Data
+        QVector<Probe> _probes;
+        QVector<Endpoint> _endpoints;
+        QVector<Prefix> _allowed;
+        // Helpers
+        static int prefixLength(quint32 netmask);
+        static inline quint32 mask(int length) {
+            return length ? ~quint32(0)<<(32-length) : 0;
+        }
+        static QString formatAddress(quint32 address);
+};
+
+#endif // IPPLAN_H
@@ -1,8 +1,14 @@
 #include "mainwindow.h"
+#include "consoleCommands.h"
 #include <QApplication>
 
 int main(int argc, char *argv[])
 {
+    if(argc>1 && ConsoleCommands::isCommand(argv[1])){
+        QCoreApplication a(argc, argv);
+        return ConsoleCommands::exec(a.arguments());
+    }
+
     QApplication a(argc, argv);
     MainWindow w;
     w.show();
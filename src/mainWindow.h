@@ -11,15 +11,15 @@
 namespace Ui {
     class MainWindow;
 }
-class QTextEdit;
 class QProgressBar;
-class QFile;
-class QTextStream;
+class CheckLog;
 
 
 //------------------------------------------------------------------------------
 // class MainWindow
 //------------------------------------------------------------------------------
+// The GUI front end: starts the check thread, shows its log and progress.
+//------------------------------------------------------------------------------
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
@@ -28,22 +28,14 @@ class MainWindow : public QMainWindow
         explicit MainWindow(QWidget *parent = nullptr);
         // Destructor
         ~MainWindow();
-    signals:
-        void addLogLine(const QString& msg);
+    private slots:
+        void appendLogLine(const QString& msg);
     private:
         // Data
-        static MainWindow  *_mainWindow;
-        static QTextStream *_logStream;
-
         Ui::MainWindow *_ui;
         ConfigurationCheck *_configurationCheck;
-        QFile *_logFile;
+        CheckLog *_log;
         QProgressBar *_progressBar;
-        // Helpers
-        static void messageOutputHandler(QtMsgType type,
-                                         const QMessageLogContext &context,
-                                         const QString &msg);
-        void logLine(const QString& msg);
 };
 
 #endif // MAINWINDOW_H
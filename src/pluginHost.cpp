@@ -0,0 +1,86 @@
+#include "pluginHost.h"
+
+#include <QLibrary>
+#include <QtDebug>
+
+
+//------------------------------------------------------------------------------
+// class PluginHost implementation
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+PluginHost::PluginHost(){
+}
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+PluginHost::~PluginHost(){
+    unloadAll();
+}
+//------------------------------------------------------------------------------
+// Accessors
+//------------------------------------------------------------------------------
+QStringList PluginHost::names()const{
+    QStringList names;
+    for(int i=0;i<_plugins.size();++i)
+        names << QString("%1 (%2)").arg(QString::fromUtf8(_plugins.at(i).visitor->name()),
+                                         _plugins.at(i).library->fileName());
+    return names;
+}
+//------------------------------------------------------------------------------
+// Methods
+//------------------------------------------------------------------------------
+bool PluginHost::load(const QString& filename){
+    QLibrary *library = new QLibrary(filename);
+    StationVisitorApiVersion_t apiVersion = nullptr;
+    CreateStationVisitor_t create = nullptr;
+    if(library->load()){
+        apiVersion = reinterpret_cast<StationVisitorApiVersion_t>(
+                         library->resolve("stationVisitorApiVersion"));
+        create = reinterpret_cast<CreateStationVisitor_t>(
+                     library->resolve("createStationVisitor"));
+    }
+    if(!apiVersion || !create){
+        qCritical() << "Cannot load plugin" << filename << ":"
+                    << library->errorString();
+        library->unload();
+        delete library;
+        return false;
+    }
+    // Built against other visitor types: not a single call into it
+    int pluginApiVersion = apiVersion();
+    if(pluginApiVersion!=StationVisitor::cApiVersion){
+        qCritical() << "Plugin" << filename << "was built for API version"
+                    << pluginApiVersion << "instead of"
+                    << int(StationVisitor::cApiVersion);
+        library->unload();
+        delete library;
+        return false;
+    }
+    StationVisitor *visitor = create(StationVisitor::cApiVersion);
+    if(!visitor){
+        qCritical() << "Plugin" << filename << "does not support API version"
+                    << int(StationVisitor::cApiVersion);
+        library->unload();
+        delete library;
+        return false;
+    }
+
+    Plugin plugin = { library, visitor };
+    _plugins.append(plugin);
+    _visitors.add(visitor);
+    qInfo() << "Plugin" << QString::fromUtf8(visitor->name()) << "loaded from"
+            << library->fileName();
+    return true;
+}
+//------------------------------------------------------------------------------
+void PluginHost::unloadAll(){
+    _visitors.clear();
+    for(int i=_plugins.size()-1;i>=0;--i){
+        delete _plugins.at(i).visitor;
+        _plugins.at(i).library->unload();
+        delete _plugins.at(i).library;
+    }
+    _plugins.clear();
+}
+//------------------------------------------------------------------------------
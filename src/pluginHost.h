@@ -0,0 +1,51 @@
+#ifndef PLUGINHOST_H
+#define PLUGINHOST_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "stationVisitor.h"
+
+//------------------------------------------------------------------------------
+// Forwards
+//------------------------------------------------------------------------------
+class QLibrary;
+
+
+//------------------------------------------------------------------------------
+// class PluginHost
+//------------------------------------------------------------------------------
+// Station visitors loaded from shared objects (see StationVisitor), all of
+// them run by the one check pass through visitors(). A plugin is loaded
+// once and kept until the host goes: its visitor is deleted first, then the
+// library unloaded.
+//------------------------------------------------------------------------------
+class PluginHost
+{
+    public:
+        // Constructor
+        PluginHost();
+        // Destructor
+        ~PluginHost();
+        // Accessors
+        inline bool isEmpty()const { return _plugins.isEmpty(); }
+        inline StationVisitors& visitors() { return _visitors; }
+        QStringList names()const; // "visitor (file)"
+        // Methods
+        bool load(const QString& filename);
+        void unloadAll();
+    private:
+        // Types
+        struct Plugin {
+            QLibrary *library;
+            StationVisitor *visitor;
+        };
+        // Data
+        QVector<Plugin> _plugins;
+        StationVisitors _visitors;
+        // Private copy constructor and assignment (unimplemented!)
+        PluginHost(const PluginHost&);
+        PluginHost& operator=(const PluginHost&);
+};
+
+#endif // PLUGINHOST_H
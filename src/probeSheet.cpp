@@ -0,0 +1,226 @@
+#include "probeSheet.h"
+
+#include "ipCodec.h"
+#include <QVector>
+#include <QtDebug>
+
+
+//------------------------------------------------------------------------------
+// class IPValue implementation
+//------------------------------------------------------------------------------
+// Constructors
+//------------------------------------------------------------------------------
+IPValue IPValue::fromXmlString(const QString& xmlValue){
+    uint32_t addr;
+    const ushort *begin = xmlValue.utf16();
+    return IPCodec::parseXmlIPv4(begin,begin+xmlValue.size(),addr)
+           ? IPValue(IPCodec::toInt32(addr)) : IPValue();
+}
+//------------------------------------------------------------------------------
+// Accessors
+//------------------------------------------------------------------------------
+QString IPValue::toString()const{
+    char buffer[IPCodec::cMaxDottedQuadLength];
+    return QString::fromLatin1(buffer,
+                               int(IPCodec::formatDottedQuad(uint32_t(_addr),buffer)));
+}
+//------------------------------------------------------------------------------
+QString IPValue::toXmlString()const{
+    char buffer[IPCodec::cMaxInt32Length];
+    return QString::fromLatin1(buffer,int(IPCodec::formatInt32(_addr,buffer)));
+}
+//------------------------------------------------------------------------------
+// Operators
+//------------------------------------------------------------------------------
+IPValue& IPValue::operator=(int32_t rhs)
+{
+    _addr=rhs;
+    return *this;
+}
+//------------------------------------------------------------------------------
+IPValue& IPValue::operator=(const QString& ipLikeString)
+{
+    assign(ipLikeString);
+    return *this;
+}
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+void IPValue::assign(const QString& ipLikeString){
+    uint32_t addr;
+    const ushort *begin = ipLikeString.utf16();
+    _addr = IPCodec::parseDottedQuad(begin,begin+ipLikeString.size(),addr)
+            ? IPCodec::toInt32(addr) : 0;
+}
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+// class IPPort implementation
+//------------------------------------------------------------------------------
+// Accessors
+//------------------------------------------------------------------------------
+QString IPPort::toXmlCodedString()const {
+    char buffer[IPCodec::cMaxUInt32Length];
+    return QString::fromLatin1(buffer,int(IPCodec::formatXmlPort(_port,buffer)));
+}
+//------------------------------------------------------------------------------
+uint32_t IPPort::toXmlCoded()const {
+    return IPCodec::encodePort(_port);
+}
+//------------------------------------------------------------------------------
+// Operators
+//------------------------------------------------------------------------------
+IPPort& IPPort::operator=(uint32_t value)
+{
+    _port = value;
+    if(_port>65535)
+        _port = 0;
+    return *this;
+}
+//------------------------------------------------------------------------------
+IPPort& IPPort::operator=(const QString& xmlCodedValue)
+{
+    assign(xmlCodedValue);
+    return *this;
+}
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+void IPPort::assign(const QString& xmlCodedValue){
+    const ushort *begin = xmlCodedValue.utf16();
+    if(!IPCodec::parseXmlPort(begin,begin+xmlCodedValue.size(),_port))
+        _port = 0;
+}
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+// class ProbeSheet implementation
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+ProbeSheet::ProbeSheet() : _snapshotPending(false)
+{
+}
+//------------------------------------------------------------------------------
+// Methods
+//------------------------------------------------------------------------------
+void ProbeSheet::clear(){
+    central0IP = 0;
+    central0Port = 0;
+    central0SNTP = 0;
+    globalSNTP = 0;
+    newUpdaterIP = 0;
+    newUpdaterPort = 0;
+    probes.clear();
+    diagnostics.clear();
+}
+//------------------------------------------------------------------------------
+ProbeConfig *ProbeSheet::addProbe(uint lineNum, const ProbeConfig& probeConfig){
+    // Messages kept for the startup snapshot to repeat them
+    if(!probeConfig.serial || probeConfig.serial<cMinProbeSerial ||
+       probeConfig.serial>cMaxProbeSerial)
+    {
+        diagnostics << QString::asprintf("Probe at CSV line %d has no "
+                                         "serial, skipped", lineNum);
+        qCritical() << diagnostics.last();
+        return nullptr;
+    }
+
+    int diagnosticCount = diagnostics.size();
+    bool skip = false;
+    if(!probeConfig.ip && (skip=true))
+        diagnostics << QString::asprintf("Probe %u (CSV line %d) has invalid IP, skipped",
+                                         probeConfig.serial, lineNum);
+    if(!probeConfig.netmask && (skip=true))
+        diagnostics << QString::asprintf("Probe %u (CSV line %d) has invalid Netmask, skipped",
+                                         probeConfig.serial, lineNum);
+    if(!probeConfig.gateway && (skip=true))
+        diagnostics << QString::asprintf("Probe %u (CSV line %d) has invalid Gateway, skipped",
+                                         probeConfig.serial, lineNum);
+
+    for(int i=diagnosticCount;i<diagnostics.size();++i)
+        qCritical() << diagnostics.at(i);
+
+    if(skip)
+        return nullptr;
+
+    // Streaming: the station may have been checked against an earlier row
+    QMap<uint,ProbeConfig>::iterator it = probes.find(probeConfig.serial);
+    if(it!=probes.end() && it->checked){
+        diagnostics << QString::asprintf("Probe %u (CSV line %d) is duplicated and "
+                                         "was already checked, skipped",
+                                         probeConfig.serial, lineNum);
+        qCritical() << diagnostics.last();
+        return nullptr;
+    }
+    return &*probes.insert(probeConfig.serial,probeConfig);
+}
+//------------------------------------------------------------------------------
+bool ProbeSheet::loadSnapshot(const QString& snapshotFilename,
+    const QString& sheetFilename)
+{
+    // Warm start: the sheet as a previous run loaded it, as long as the file
+    // is the same. Otherwise the file gets fingerprinted before it is read,
+    // the snapshot to be saved describing what was actually read
+    clear();
+    _snapshotPending = false;
+    StartupSnapshot snapshot;
+    if(!snapshot.open(snapshotFilename,sheetFilename)){
+        _snapshotPending = StartupSnapshot::fingerprint(sheetFilename,
+                                                        _snapshotSheet);
+        return false;
+    }
+
+    const StartupSnapshot::Globals& globals = snapshot.globals();
+    central0IP = globals.central0IP;
+    central0Port = IPPort(globals.central0Port);
+    central0SNTP = globals.central0SNTP;
+    globalSNTP = globals.globalSNTP;
+    newUpdaterIP = globals.newUpdaterIP;
+    newUpdaterPort = IPPort(globals.newUpdaterPort);
+
+    // By serial already: each one appended at the end of the map
+    const StartupSnapshot::Probe *snapshotProbes = snapshot.probes();
+    for(int i=0;i<snapshot.probeCount();++i){
+        ProbeConfig probeConfig;
+        probeConfig.serial = snapshotProbes[i].serial;
+        probeConfig.ip = snapshotProbes[i].ip;
+        probeConfig.netmask = snapshotProbes[i].netmask;
+        probeConfig.gateway = snapshotProbes[i].gateway;
+        probes.insert(probes.constEnd(),probeConfig.serial,probeConfig);
+    }
+    diagnostics = snapshot.diagnostics();
+    for(int i=0;i<diagnostics.size();++i)
+        qCritical() << diagnostics.at(i);
+    return true;
+}
+//------------------------------------------------------------------------------
+bool ProbeSheet::saveSnapshot(const QString& snapshotFilename,
+    const QString& sheetFilename)
+{
+    // Only for a sheet read to the end, with the fingerprint of loadSnapshot()
+    if(!_snapshotPending)
+        return false;
+    _snapshotPending = false;
+    StartupSnapshot::Globals globals = {
+        central0IP.toInt32(), central0Port.toUInt32(), central0SNTP.toInt32(),
+        globalSNTP.toInt32(), newUpdaterIP.toInt32(), newUpdaterPort.toUInt32()
+    };
+    QVector<StartupSnapshot::Probe> snapshotProbes;
+    snapshotProbes.reserve(probes.size());
+    for(QMap<uint,ProbeConfig>::const_iterator it=probes.constBegin();
+        it!=probes.constEnd();
+        ++it)
+    {
+        StartupSnapshot::Probe probe = {
+            it->serial, it->ip.toInt32(), it->netmask.toInt32(),
+            it->gateway.toInt32()
+        };
+        snapshotProbes.append(probe);
+    }
+    return StartupSnapshot::save(snapshotFilename,sheetFilename,_snapshotSheet,
+                                 globals,snapshotProbes,diagnostics);
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,125 @@
+#ifndef PROBESHEET_H
+#define PROBESHEET_H
+
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <cstdint>
+#include "startupSnapshot.h"
+
+
+//------------------------------------------------------------------------------
+// class IPValue
+//------------------------------------------------------------------------------
+// IPv4 address as the station files hold it: a signed int32, 0 for none.
+//------------------------------------------------------------------------------
+class IPValue {
+    public:
+        // Constructors
+        inline IPValue() : _addr(0) {}
+        inline IPValue(int32_t addr) : _addr(addr) {}
+        inline IPValue(const QString& ipLikeString) { assign(ipLikeString); }
+        static IPValue fromXmlString(const QString& xmlValue);
+        // Accessors
+        QString toString()const;
+        QString toXmlString()const;
+        inline int32_t toInt32()const { return _addr; }
+        // Operators
+        IPValue& operator=(int32_t rhs);
+        IPValue& operator=(const QString& ipLikeString);
+        inline operator bool()const { return _addr; }
+        inline bool operator !()const { return !_addr; }
+    private:
+        // Data
+        int32_t _addr;
+        // Helpers
+        void assign(const QString& ipLikeString);
+};
+
+
+//------------------------------------------------------------------------------
+// class IPPort
+//------------------------------------------------------------------------------
+// TCP port, 0 for none; coded as the station files hold it on request.
+//------------------------------------------------------------------------------
+class IPPort {
+    public:
+        // Constructors
+        inline IPPort() : _port(0) {}
+        inline IPPort(uint32_t port) : _port(port) {}
+        inline IPPort(const QString& xmlCodedValue) { assign(xmlCodedValue); }
+        // Accessors
+        QString toXmlCodedString()const;
+        uint32_t toXmlCoded()const;
+        inline uint32_t toUInt32()const { return _port; }
+        // Operators
+        IPPort& operator=(uint32_t value);
+        IPPort& operator=(const QString& xmlCodedValue);
+        inline operator bool()const { return _port; }
+        inline bool operator !()const { return !_port; }
+    private:
+        uint32_t _port;
+        // Helpers
+        void assign(const QString& xmlCodedValue);
+};
+
+
+//------------------------------------------------------------------------------
+// struct ProbeConfig
+//------------------------------------------------------------------------------
+struct ProbeConfig {
+    inline ProbeConfig() : serial(0), checked(false) {}
+
+    uint serial;
+    IPValue ip;
+    IPValue netmask;
+    IPValue gateway;
+    bool checked;
+};
+
+
+//------------------------------------------------------------------------------
+// class ProbeSheet
+//------------------------------------------------------------------------------
+// The probe configurations sheet as loaded: the global endpoints of its
+// second line, the valid probe rows by serial and the messages about the
+// rejected ones (see ProbeSheetReader). The startup snapshot keeps all three
+// for a warm start: loadSnapshot() replaces reading the sheet when the
+// snapshot holds for it, otherwise the sheet gets fingerprinted for
+// saveSnapshot() to describe what is then read.
+//------------------------------------------------------------------------------
+class ProbeSheet
+{
+    public:
+        // Constants
+        enum {
+            cMinProbeSerial = 30000,
+            cMaxProbeSerial = 30999,
+        };
+        // Constructor
+        ProbeSheet();
+        // Accessors
+        inline bool isSnapshotPending()const { return _snapshotPending; }
+        // Methods
+        void clear();
+        ProbeConfig *addProbe(uint lineNum, const ProbeConfig& probeConfig);
+        bool loadSnapshot(const QString& snapshotFilename,
+                          const QString& sheetFilename);
+        bool saveSnapshot(const QString& snapshotFilename,
+                          const QString& sheetFilename);
+        // Public data
+        IPValue central0IP;
+        IPPort central0Port;
+        IPValue central0SNTP;
+        IPValue globalSNTP;
+        IPValue newUpdaterIP;
+        IPPort newUpdaterPort;
+        QMap<uint,ProbeConfig> probes;
+        QStringList diagnostics;
+    private:
+        // Data
+        StartupSnapshot::Sheet _snapshotSheet; // as it was before reading it
+        bool _snapshotPending; // cold start: to be saved once read in full
+};
+
+#endif // PROBESHEET_H
@@ -0,0 +1,235 @@
+#include "probeSheetReader.h"
+
+#include "ipCodec.h"
+#include <algorithm>
+#include <cstdio>
+#include <QtDebug>
+
+
+//------------------------------------------------------------------------------
+// class ProbeSheetReader implementation
+//------------------------------------------------------------------------------
+// Static data
+//------------------------------------------------------------------------------
+const char *const ProbeSheetReader::_fieldNames[fFieldCount] = {
+    "MIRA SN",
+    "PROBE IP",
+    "SUBNET MASK",
+    "GATEWAY",
+    "Central 0 IP",
+    "Central 0 SNTP",
+    "Global NTP List",
+    "New Updater IP",
+};
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+ProbeSheetReader::ProbeSheetReader(ProbeSheet& sheet) : _sheet(sheet),
+    _isXlsx(false), _lineNum(0)
+{
+    std::fill(_colNums,_colNums+fFieldCount,-1);
+}
+//------------------------------------------------------------------------------
+// Methods
+//------------------------------------------------------------------------------
+bool ProbeSheetReader::open(const QString& filename){
+    _isXlsx = filename.endsWith(".xlsx",Qt::CaseInsensitive);
+    qInfo() << "Probe sheet:" << filename;
+    if(_isXlsx){
+        if(!_xlsx.open(filename))
+            return fail("Cannot open probe configuration workbook: "+
+                        _xlsx.errorString());
+        return true;
+    }
+
+    bool opened;
+    if(filename=="-"){
+        // Unbuffered: each line is handed over as soon as it has been written
+        // to the pipe, instead of waiting for a full read buffer
+        opened = _csv.open(stdin, QIODevice::ReadOnly | QIODevice::Unbuffered);
+    }else{
+        _csv.setFileName(filename);
+        opened = _csv.open(QFile::ReadOnly | QFile::Text);
+    }
+    if(!opened)
+        return fail("Cannot open probe configuration CSV file");
+    return true;
+}
+//------------------------------------------------------------------------------
+bool ProbeSheetReader::readHeader(ProbeConfig& probeConfig){
+    if(!readRow() || !parseHeaderLine() || !readRow())
+        return false;
+
+    // Line 2: the global endpoints, then a probe as any other line
+    parseIPandPort(_row.value(_colNums[fCentral0IP]),_sheet.central0IP,
+                   _sheet.central0Port);
+    _sheet.central0SNTP = _row.value(_colNums[fCentral0SNTP]);
+    _sheet.globalSNTP = _row.value(_colNums[fGlobalSNTP]);
+    parseIPandPort(_row.value(_colNums[fNewUpdaterIP]),_sheet.newUpdaterIP,
+                   _sheet.newUpdaterPort);
+    parseProbe(probeConfig);
+
+    if(!_sheet.central0IP)
+        return fail("Central0 IP not found or invalid");
+    if(!_sheet.central0Port)
+        return fail("Central0 port not found or invalid");
+    if(!_sheet.central0SNTP)
+        return fail("Central0 SNTP not found or invalid");
+    if(!_sheet.globalSNTP)
+        return fail("Global SNTP not found or invalid");
+    if(!_sheet.newUpdaterIP)
+        return fail("New updater server IP not found or invalid");
+    if(!_sheet.newUpdaterPort)
+        return fail("New updater server port not found or invalid");
+    return true;
+}
+//------------------------------------------------------------------------------
+bool ProbeSheetReader::readProbe(ProbeConfig& probeConfig){
+    if(!readRow())
+        return false;
+    parseProbe(probeConfig);
+    return true;
+}
+//------------------------------------------------------------------------------
+bool ProbeSheetReader::readCSVRow(uint lineNum, QIODevice &in,
+    QStringList& row)
+{
+    // vik: adapted from https://stackoverflow.com/questions/27318631/parsing-through-a-csv-file-in-qt
+    // Input is consumed a line at a time (no seeking, so pipes work too);
+    // quoted cells spanning lines pull in the following ones.
+
+    static const int delta[][5] = {
+        //  ,    "   \n    ?  eof
+        {   1,   2,  -1,   0,  -1  }, // 0: parsing (store char)
+        {   1,   2,  -1,   0,  -1  }, // 1: parsing (store column)
+        {   3,   4,   3,   3,  -2  }, // 2: quote entered (no-op)
+        {   3,   4,   3,   3,  -2  }, // 3: parsing inside quotes (store char)
+        {   1,   3,  -1,   0,  -1  }, // 4: quote exited (no-op)
+        // -1: end of row, store column, success
+        // -2: eof inside quotes
+    };
+
+    row.clear();
+
+    QString line = QString::fromLocal8Bit(in.readLine());
+    if (line.isEmpty())
+        return false;
+
+    int state = 0, t = 0, pos = 0;
+    QChar ch;
+    QString cell;
+
+    while (state >= 0) {
+
+        if (pos >= line.size()) {
+            line = QString::fromLocal8Bit(in.readLine());
+            pos = 0;
+        }
+        if (pos >= line.size())
+            t = 4;
+        else {
+            ch = line.at(pos++);
+            if (ch == ',') t = 0;
+            else if (ch == '\"') t = 1;
+            else if (ch == '\n') t = 2;
+            else if (ch == '\r' && pos < line.size() && line.at(pos) == '\n') {
+                ch = line.at(pos++);
+                t = 2;
+            }
+            else t = 3;
+        }
+
+        state = delta[state][t];
+
+        switch (state) {
+        case 0:
+        case 3:
+            cell += ch;
+            break;
+        case -1:
+        case 1:
+            row.append(cell);
+            cell = "";
+            break;
+        }
+
+    }
+
+    if (state == -2)
+        return fail(QString::asprintf("CSV line %d: End-of-file found while inside quotes.",
+                                      lineNum));
+
+    return true;
+}
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+bool ProbeSheetReader::readRow(){
+    if(!_isXlsx)
+        return readCSVRow(++_lineNum, _csv, _row);
+
+    // Sheet rows keep their own numbers (empty ones are not stored), so that
+    // messages point to the same line as in the CSV export
+    if(_xlsx.readRow(_row)){
+        _lineNum = uint(_xlsx.rowNumber());
+        return true;
+    }
+    if(!_xlsx.errorString().isEmpty())
+        return fail("Probe configuration workbook: "+_xlsx.errorString());
+    return false;
+}
+//------------------------------------------------------------------------------
+bool ProbeSheetReader::parseHeaderLine(){
+    int fieldCount = 0;
+    for(int i=0;i<_row.size();++i){
+        const QString& fieldName = _row.at(i);
+        for(int j=0;j<fFieldCount;++j){
+            if(fieldName.simplified()==QLatin1String(_fieldNames[j])){
+                if(_colNums[j]==-1){
+                    _colNums[j] = i;
+                    fieldCount++;
+                    break;
+                }else
+                    return fail(QString::asprintf("CSV header: duplicated column '%s'.",
+                                                  fieldName.toUtf8().constData()));
+            }
+        }
+    }
+
+    if(fieldCount!=fFieldCount){
+        qCritical() << "CSV header missing expected colums:";
+        for(int j=0;j<fFieldCount;++j)
+            if(_colNums[j]==-1)
+                qCritical() << QString::asprintf("    %s",_fieldNames[j]);
+        return fail("Bailing out");
+    }
+    return true;
+}
+//------------------------------------------------------------------------------
+void ProbeSheetReader::parseIPandPort(const QString& inIPAndPort,
+    IPValue& outIPValue, IPPort& outPort)
+{
+    const ushort *begin = inIPAndPort.utf16();
+    const ushort *end = begin+inIPAndPort.size();
+    const ushort *colon = std::find(begin,end,ushort(':'));
+    if(colon!=end && std::find(colon+1,end,ushort(':'))==end){
+        uint32_t addr, port;
+        outIPValue = IPCodec::parseDottedQuad(begin,colon,addr)
+                     ? IPCodec::toInt32(addr) : 0;
+        outPort = IPCodec::parseUInt32(colon+1,end,port) ? port : 0;
+    }
+}
+//------------------------------------------------------------------------------
+void ProbeSheetReader::parseProbe(ProbeConfig& probeConfig)const{
+    probeConfig.serial = _row.value(_colNums[fProbeSN]).toUInt();
+
+    probeConfig.ip = _row.value(_colNums[fProbeIP]);
+    probeConfig.netmask = _row.value(_colNums[fProbeNetMask]);
+    probeConfig.gateway= _row.value(_colNums[fProbeGateway]);
+}
+//------------------------------------------------------------------------------
+bool ProbeSheetReader::fail(const QString& message){
+    _errorString = message;
+    return false;
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,74 @@
+#ifndef PROBESHEETREADER_H
+#define PROBESHEETREADER_H
+
+#include <QFile>
+#include <QIODevice>
+#include <QString>
+#include <QStringList>
+#include "probeSheet.h"
+#include "xlsxReader.h"
+
+
+//------------------------------------------------------------------------------
+// class ProbeSheetReader
+//------------------------------------------------------------------------------
+// Reads a probe configurations sheet into a ProbeSheet a row at a time: an
+// .xlsx workbook (first worksheet) or a CSV export, "-" being CSV on stdin.
+// readHeader() takes the header line and the second line (global endpoints
+// and first probe), readProbe() each further row: the caller decides what
+// happens in between, e.g. check the probe's station right away while the
+// sheet is still being written (streaming). The rows are parsed only, the
+// caller passes them to ProbeSheet::addProbe(). All failures are fatal to
+// the run: false with errorString() set (false with no error is the end of
+// the sheet).
+//------------------------------------------------------------------------------
+class ProbeSheetReader
+{
+    public:
+        // Constructor
+        explicit ProbeSheetReader(ProbeSheet& sheet);
+        // Accessors
+        inline const QString& errorString()const { return _errorString; }
+        inline uint lineNumber()const { return _lineNum; } // of the last row
+        // Methods
+        bool open(const QString& filename);
+        bool readHeader(ProbeConfig& probeConfig);
+        bool readProbe(ProbeConfig& probeConfig);
+        bool readCSVRow(uint lineNum, QIODevice& in, QStringList& row);
+    private:
+        // Types
+        enum Field {
+            fProbeSN,
+            fProbeIP,
+            fProbeNetMask,
+            fProbeGateway,
+            fCentral0IP,
+            fCentral0SNTP,
+            fGlobalSNTP,
+            fNewUpdaterIP,
+            fFieldCount
+        };
+        // Data
+        static const char *const _fieldNames[fFieldCount]; // header columns
+
+        ProbeSheet& _sheet;
+        QFile _csv;
+        XlsxReader _xlsx;
+        bool _isXlsx;
+        uint _lineNum;
+        int _colNums[fFieldCount];
+        QStringList _row;
+        QString _errorString;
+        // Helpers
+        bool readRow();
+        bool parseHeaderLine();
+        static void parseIPandPort(const QString& inIPAndPort,
+                                   IPValue& outIPValue, IPPort& outPort);
+        void parseProbe(ProbeConfig& probeConfig)const;
+        bool fail(const QString& message);
+        // Private copy constructor and assignment (unimplemented!)
+        ProbeSheetReader(const ProbeSheetReader&);
+        ProbeSheetReader& operator=(const ProbeSheetReader&);
+};
+
+#endif // PROBESHEETREADER_H
@@ -18,24 +18,93 @@ TEMPLATE = app
 DEFINES += QT_DEPRECATED_WARNINGS
 DEFINES += EXPRIVIA_CHECK_TIME_INTERVALS
 #DEFINES += EXPRIVIA_CHECK_SERVICE_MODE
+# Off by default, one at a time or in the combinations built together:
+#  - EXPRIVIA_TYPED_VALIDATION with EXPRIVIA_STATION_OFFSET_INDEX,
+#    EXPRIVIA_STREAMING_CSV, EXPRIVIA_STARTUP_SNAPSHOT
+#  - EXPRIVIA_STATION_CLASSES with EXPRIVIA_SUBTREE_SKIP,
+#    EXPRIVIA_STATION_OFFSET_INDEX, EXPRIVIA_STREAMING_CSV,
+#    EXPRIVIA_STARTUP_SNAPSHOT
+# EXPRIVIA_XLSX_INPUT, EXPRIVIA_IP_PLAN_CHECK, EXPRIVIA_TRACE and
+# EXPRIVIA_IO_URING go with either.
+#DEFINES += EXPRIVIA_STATION_OFFSET_INDEX
+#DEFINES += EXPRIVIA_STREAMING_CSV
+#DEFINES += EXPRIVIA_XLSX_INPUT
+#DEFINES += EXPRIVIA_STARTUP_SNAPSHOT # probe sheet kept in 'startup.snap' for warm starts
+#DEFINES += EXPRIVIA_TYPED_VALIDATION
+#DEFINES += EXPRIVIA_IP_PLAN_CHECK
+#DEFINES += EXPRIVIA_STATION_CLASSES # not with EXPRIVIA_TYPED_VALIDATION
+#DEFINES += EXPRIVIA_SUBTREE_SKIP    # not with EXPRIVIA_TYPED_VALIDATION
+#DEFINES += EXPRIVIA_TRACE         # recording enabled by --trace FILE
+#linux: DEFINES += EXPRIVIA_IO_URING   # falls back to QFile where unavailable
+#DEFINES += EXPRIVIA_ALLOC_STATS
 
 # You can also make your code fail to compile if you use deprecated APIs.
 # In order to do so, uncomment the following line.
 # You can also select to disable deprecated APIs only up to a certain version of Qt.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
-CONFIG += c++11
+CONFIG += c++14
 
 SOURCES += \
         main.cpp \
         mainWindow.cpp \
+        allocStats.cpp \
+        bumpArena.cpp \
+        checkContext.cpp \
+        checkLog.cpp \
+        checkProfile.cpp \
         configurationCheck.cpp \
-        systemEndianess.cpp
+        consoleCommands.cpp \
+        findingSummary.cpp \
+        fleetIndex.cpp \
+        inflater.cpp \
+        ioRing.cpp \
+        ipPlan.cpp \
+        pluginHost.cpp \
+        probeSheet.cpp \
+        probeSheetReader.cpp \
+        sampleAudit.cpp \
+        startupSnapshot.cpp \
+        stationIO.cpp \
+        stationManifest.cpp \
+        stationOffsetIndex.cpp \
+        stationTemplate.cpp \
+        traceRecorder.cpp \
+        typedValidator.cpp \
+        xlsxReader.cpp
 
 HEADERS += \
         mainWindow.h \
+        allocStats.h \
+        bumpArena.h \
+        checkContext.h \
+        checkLog.h \
+        checkProfile.h \
         configurationCheck.h \
-        systemEndianess.h
+        consoleCommands.h \
+        findingSummary.h \
+        fleetIndex.h \
+        inflater.h \
+        ioRing.h \
+        ipPlan.h \
+        pluginHost.h \
+        probeSheet.h \
+        probeSheetReader.h \
+        sampleAudit.h \
+        startupSnapshot.h \
+        stationIO.h \
+        stationManifest.h \
+        stationOffsetIndex.h \
+        stationTemplate.h \
+        traceRecorder.h \
+        typedValidator.h \
+        xlsxReader.h
+
+contains(DEFINES, EXPRIVIA_ALLOC_STATS) {
+    win32: LIBS += -lpsapi
+}
+
+include(core/core.pri)
 
 FORMS += \
         mainWindow.ui
@@ -0,0 +1,46 @@
+#-------------------------------------------------
+#
+# Everything, in build order: the core library, then the application, the
+# benchmarks and the tests linking it. Build this project rather than its
+# parts; 'make check' runs the tests.
+#
+#-------------------------------------------------
+
+TEMPLATE = subdirs
+
+SUBDIRS += \
+        core \
+        app \
+        checkKernelsBench \
+        ipCodecBench \
+        offsetIndexTest \
+        fleetIndexTest \
+        probeSheetTest \
+        stationPatchTest \
+        stationImageTest \
+        startupSnapshotTest \
+        inflaterTest \
+        checkEngineTest \
+        checksumTest
+
+app.file = qMiraProbeXMLCheck.pro
+app.depends = core
+checkKernelsBench.file = bench/checkKernelsBench.pro
+checkKernelsBench.depends = core
+ipCodecBench.file = bench/ipCodecBench.pro
+offsetIndexTest.file = tests/offsetIndexTest.pro
+fleetIndexTest.file = tests/fleetIndexTest.pro
+fleetIndexTest.depends = core
+probeSheetTest.file = tests/probeSheetTest.pro
+probeSheetTest.depends = core
+stationPatchTest.file = tests/stationPatchTest.pro
+stationPatchTest.depends = core
+stationImageTest.file = tests/stationImageTest.pro
+stationImageTest.depends = core
+startupSnapshotTest.file = tests/startupSnapshotTest.pro
+startupSnapshotTest.depends = core
+inflaterTest.file = tests/inflaterTest.pro
+checkEngineTest.file = tests/checkEngineTest.pro
+checkEngineTest.depends = core
+checksumTest.file = tests/checksumTest.pro
+checksumTest.depends = core
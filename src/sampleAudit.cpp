@@ -0,0 +1,220 @@
+#include "sampleAudit.h"
+
+#include <QMap>
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+
+//------------------------------------------------------------------------------
+// class SampleAudit implementation
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+SampleAudit::SampleAudit() : _enabled(false), _confidence(0.95), _margin(0.05),
+    _z(zScore(0.95)), _strata(stSerialRange), _serialRange(100), _seed(0),
+    _sampleSize(0)
+{
+}
+//------------------------------------------------------------------------------
+// Accessors
+//------------------------------------------------------------------------------
+int SampleAudit::plannedSize()const{
+    // Worst case (p = 0.5) sample for the margin, finite population
+    // corrected
+    int population = _candidates.size();
+    double n0 = _z*_z*0.25/(_margin*_margin);
+    double n = population ? n0/(1+(n0-1)/population) : 0;
+    return qBound(qMin(int(cMinSampleSize),population),int(std::ceil(n)),
+                  population);
+}
+//------------------------------------------------------------------------------
+bool SampleAudit::isPrecise()const{
+    if(_sampleSize<qMin(int(cMinSampleSize),_candidates.size()))
+        return false;
+    for(int i=0;i<_parameters.size();++i){
+        Estimate e = estimate(i);
+        if(e.high-e.low>2*_margin)
+            return false;
+    }
+    return true;
+}
+//------------------------------------------------------------------------------
+SampleAudit::Estimate SampleAudit::estimate(int parameter)const{
+    // Stratum rates weighted by the sizes of the strata sampled so far
+    Estimate result = { 0, 0, 0, 1 };
+    int parameterCount = _parameters.size();
+    double weight = 0, rate = 0;
+    for(int s=0;s<_strataSizes.size();++s){
+        int samples = _strataSamples.at(s);
+        if(!samples)
+            continue;
+        int mismatches = _mismatches.at(s*parameterCount+parameter);
+        result.mismatchCount += mismatches;
+        weight += _strataSizes.at(s);
+        rate += _strataSizes.at(s)*double(mismatches)/samples;
+    }
+    if(weight>0){
+        result.rate = rate/weight;
+        interval(result.rate,result);
+    }
+    return result;
+}
+//------------------------------------------------------------------------------
+quint32 SampleAudit::stratumKey(uint serial, qint32 ip, qint32 netmask)const{
+    if(_strata==stSubnet)
+        return quint32(ip) & quint32(netmask);
+    return serial/_serialRange;
+}
+//------------------------------------------------------------------------------
+QStringList SampleAudit::report()const{
+    // A line per parameter: in the sample, rate [interval], fleet estimate,
+    // the worst rate first
+    QVector<Estimate> estimates;
+    QVector<int> parameters;
+    for(int i=0;i<_parameters.size();++i){
+        estimates.append(estimate(i));
+        parameters.append(i);
+    }
+    std::stable_sort(parameters.begin(),parameters.end(),
+                     [&estimates](int a, int b){
+                         return estimates.at(a).rate>estimates.at(b).rate;
+                     });
+
+    QStringList lines;
+    for(int i=0;i<parameters.size();++i){
+        const Estimate& e = estimates.at(parameters.at(i));
+        lines << QString::asprintf(
+            "    %-40s %4d  %5.1f%% [%5.1f%% .. %5.1f%%]  ~%.0f stations",
+            _parameters.at(parameters.at(i)).toUtf8().constData(),
+            e.mismatchCount,e.rate*100,e.low*100,e.high*100,
+            e.rate*_candidates.size());
+    }
+    return lines;
+}
+//------------------------------------------------------------------------------
+// Methods
+//------------------------------------------------------------------------------
+bool SampleAudit::configure(double confidence, double margin, Strata strata,
+    uint serialRange, quint32 seed)
+{
+    if(!(confidence>=0.5 && confidence<1) || !(margin>0 && margin<=0.5) ||
+       !serialRange)
+        return false;
+    _enabled = true;
+    _confidence = confidence;
+    _margin = margin;
+    _z = zScore(confidence);
+    _strata = strata;
+    _serialRange = serialRange;
+    _seed = seed;
+    return true;
+}
+//------------------------------------------------------------------------------
+void SampleAudit::setParameters(const QStringList& names){
+    _parameters = names;
+}
+//------------------------------------------------------------------------------
+void SampleAudit::addCandidate(uint serial, quint32 stratumKey){
+    Candidate candidate = { serial, stratumKey, -1 };
+    _candidates.append(candidate);
+}
+//------------------------------------------------------------------------------
+void SampleAudit::plan(){
+    // Strata numbered by key, each one shuffled, then drawn from in turn:
+    // the k-th station comes from the stratum furthest below its share of
+    // k, so that every prefix of the order is proportionally stratified
+    std::sort(_candidates.begin(),_candidates.end(),
+              [](const Candidate& a, const Candidate& b){
+                  return a.serial<b.serial;
+              });
+    QMap<quint32,int> strata;
+    for(int i=0;i<_candidates.size();++i)
+        strata.insert(_candidates.at(i).stratumKey,0);
+    int stratum = 0;
+    for(QMap<quint32,int>::iterator it=strata.begin();it!=strata.end();++it)
+        it.value() = stratum++;
+
+    QVector<QVector<uint> > members(strata.size());
+    for(int i=0;i<_candidates.size();++i){
+        Candidate& candidate = _candidates[i];
+        candidate.stratum = strata.value(candidate.stratumKey);
+        members[candidate.stratum].append(candidate.serial);
+    }
+    std::mt19937 random(_seed);
+    _strataSizes.resize(members.size());
+    for(int s=0;s<members.size();++s){
+        std::shuffle(members[s].begin(),members[s].end(),random);
+        _strataSizes[s] = members.at(s).size();
+    }
+
+    int population = _candidates.size();
+    QVector<int> drawn(members.size(),0);
+    _order.clear();
+    _order.reserve(population);
+    for(int k=1;k<=population;++k){
+        int best = -1;
+        double bestDeficit = 0;
+        for(int s=0;s<members.size();++s){
+            if(drawn.at(s)==_strataSizes.at(s))
+                continue;
+            double deficit = double(k)*_strataSizes.at(s)/population-drawn.at(s);
+            if(best<0 || deficit>bestDeficit){
+                best = s;
+                bestDeficit = deficit;
+            }
+        }
+        _order.append(members.at(best).at(drawn[best]++));
+    }
+
+    _strataSamples.fill(0,members.size());
+    _mismatches.fill(0,members.size()*_parameters.size());
+    _sampleSize = 0;
+}
+//------------------------------------------------------------------------------
+void SampleAudit::addStation(uint serial, const QVector<bool>& mismatches){
+    const Candidate *candidate = findCandidate(serial);
+    if(!candidate)
+        return;
+    int parameterCount = _parameters.size();
+    int *counts = _mismatches.data()+candidate->stratum*parameterCount;
+    for(int i=0;i<parameterCount && i<mismatches.size();++i)
+        if(mismatches.at(i))
+            ++counts[i];
+    ++_strataSamples[candidate->stratum];
+    ++_sampleSize;
+}
+//------------------------------------------------------------------------------
+double SampleAudit::zScore(double confidence){
+    // Two sided: the normal quantile of 1-(1-confidence)/2, rational
+    // approximation of Abramowitz and Stegun 26.2.23 (error < 4.5e-4)
+    double p = (1-confidence)/2;
+    if(p<=0)
+        return 0;
+    double t = std::sqrt(-2*std::log(p));
+    return t-(2.515517+0.802853*t+0.010328*t*t)/
+             (1+1.432788*t+0.189269*t*t+0.001308*t*t*t);
+}
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+const SampleAudit::Candidate *SampleAudit::findCandidate(uint serial)const{
+    const Candidate *begin = _candidates.constData(),
+                    *end = begin+_candidates.size();
+    const Candidate *candidate = std::lower_bound(begin,end,serial,
+        [](const Candidate& c, uint s){ return c.serial<s; });
+    return candidate!=end && candidate->serial==serial ? candidate : nullptr;
+}
+//------------------------------------------------------------------------------
+void SampleAudit::interval(double rate, Estimate& estimate)const{
+    // Wilson score interval, z^2 scaled by the finite population correction
+    double n = _sampleSize;
+    int population = _candidates.size();
+    double correction = population>1 ? (population-n)/(population-1) : 0;
+    double z2 = _z*_z*qMax(correction,0.0);
+    double center = (rate+z2/(2*n))/(1+z2/n);
+    double half = std::sqrt(z2)/(1+z2/n)*std::sqrt(rate*(1-rate)/n+z2/(4*n*n));
+    estimate.low = qMax(0.0,center-half);
+    estimate.high = qMin(1.0,center+half);
+}
+//------------------------------------------------------------------------------
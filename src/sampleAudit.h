@@ -0,0 +1,97 @@
+#ifndef SAMPLEAUDIT_H
+#define SAMPLEAUDIT_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+
+//------------------------------------------------------------------------------
+// class SampleAudit
+//------------------------------------------------------------------------------
+// Estimate of the fleet mismatch rates out of a random sample of stations.
+// The stations are split into strata (serial ranges or sheet subnets) and
+// visited in an order whose every prefix is a proportionally stratified
+// random sample: the audit can stop at any point, typically as soon as
+// isPrecise(), i.e. the confidence interval of every parameter is within
+// the margin. plannedSize() is the sample giving the margin whatever the
+// rates (p = 0.5); rates near 0 or 1 get there much sooner.
+//
+// A rate is the stratified estimate (stratum rates weighted by the stratum
+// sizes) with a Wilson score interval, the finite population correction
+// applied: the interval narrows to the exact rate as the sample reaches the
+// whole fleet.
+//------------------------------------------------------------------------------
+class SampleAudit
+{
+    public:
+        // Types
+        enum Strata {
+            stSerialRange,  // serial / serialRange
+            stSubnet,       // network address of the sheet row
+        };
+        struct Estimate {
+            int mismatchCount;  // in the sample
+            double rate;
+            double low;
+            double high;
+        };
+        // Constructor
+        SampleAudit();
+        // Accessors
+        inline bool isEnabled()const { return _enabled; }
+        inline double confidence()const { return _confidence; }
+        inline double margin()const { return _margin; }
+        inline Strata strata()const { return _strata; }
+        inline uint serialRange()const { return _serialRange; }
+        inline quint32 seed()const { return _seed; }
+        inline int populationSize()const { return _candidates.size(); }
+        inline int strataCount()const { return _strataSizes.size(); }
+        inline int sampleSize()const { return _sampleSize; }
+        inline const QVector<uint>& order()const { return _order; }
+        inline const QStringList& parameters()const { return _parameters; }
+        int plannedSize()const;
+        bool isPrecise()const;
+        Estimate estimate(int parameter)const;
+        quint32 stratumKey(uint serial, qint32 ip, qint32 netmask)const;
+        QStringList report()const;
+        // Methods
+        bool configure(double confidence, double margin, Strata strata,
+                       uint serialRange, quint32 seed);
+        void setParameters(const QStringList& names);
+        void addCandidate(uint serial, quint32 stratumKey);
+        void plan();
+        void addStation(uint serial, const QVector<bool>& mismatches);
+        static double zScore(double confidence);
+    private:
+        // Constants
+        enum {
+            cMinSampleSize = 30,    // before isPrecise() may hold
+        };
+        // Types
+        struct Candidate {
+            uint serial;
+            quint32 stratumKey;
+            int stratum;
+        };
+        // Data
+        bool _enabled;
+        double _confidence;
+        double _margin;
+        double _z;
+        Strata _strata;
+        uint _serialRange;
+        quint32 _seed;
+        QStringList _parameters;
+        QVector<Candidate> _candidates;     // by serial once planned
+        QVector<uint> _order;
+        QVector<int> _strataSizes;
+        QVector<int> _strataSamples;
+        QVector<int> _mismatches;           // [stratum*parameters+parameter]
+        int _sampleSize;
+        // Helpers
+        const Candidate *findCandidate(uint serial)const;
+        void interval(double rate, Estimate& estimate)const;
+};
+
+#endif // SAMPLEAUDIT_H
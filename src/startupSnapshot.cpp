@@ -0,0 +1,188 @@
+#include "startupSnapshot.h"
+
+#include "sha256.h"
+#include <cstring>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+
+//------------------------------------------------------------------------------
+// class StartupSnapshot implementation
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+StartupSnapshot::StartupSnapshot() : _file(nullptr), _data(nullptr),
+    _header(nullptr)
+{
+}
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+StartupSnapshot::~StartupSnapshot(){
+    close();
+}
+//------------------------------------------------------------------------------
+// Accessors
+//------------------------------------------------------------------------------
+const StartupSnapshot::Globals& StartupSnapshot::globals()const{
+    return _header->globals;
+}
+//------------------------------------------------------------------------------
+int StartupSnapshot::probeCount()const{
+    return _header ? int(_header->probeCount) : 0;
+}
+//------------------------------------------------------------------------------
+const StartupSnapshot::Probe *StartupSnapshot::probes()const{
+    return reinterpret_cast<const Probe *>(_data+_header->probesOffset);
+}
+//------------------------------------------------------------------------------
+QStringList StartupSnapshot::diagnostics()const{
+    if(!_header || !_header->diagnosticsSize)
+        return QStringList();
+    return QString::fromUtf8(reinterpret_cast<const char *>(
+                                 _data+_header->diagnosticsOffset),
+                             int(_header->diagnosticsSize)).split('\n');
+}
+//------------------------------------------------------------------------------
+// Methods
+//------------------------------------------------------------------------------
+bool StartupSnapshot::open(const QString& filename, const QString& sheetFilename){
+    // The sheet is hashed only once everything cheaper matches
+    close();
+
+    Sheet sheet;
+    if(!stat(sheetFilename,sheet))
+        return false;
+    _file = new QFile(filename);
+    if(!_file->open(QIODevice::ReadOnly) || _file->size()<qint64(sizeof(Header))){
+        close();
+        return false;
+    }
+    _data = _file->map(0,_file->size());
+    if(!_data){
+        close();
+        return false;
+    }
+
+    // Every section within the file before anything in it is read
+    _header = reinterpret_cast<const Header *>(_data);
+    const quint64 fileSize = quint64(_file->size());
+    if(_header->magic!=cMagic || _header->version!=cVersion ||
+       _header->byteOrderMark!=cByteOrderMark || _header->fileSize!=fileSize ||
+       _header->probesOffset%alignof(Probe) ||
+       !fits(_header->probesOffset,_header->probeCount,sizeof(Probe),fileSize) ||
+       !fits(_header->sheetNameOffset,_header->sheetNameSize,1,fileSize) ||
+       !fits(_header->diagnosticsOffset,_header->diagnosticsSize,1,fileSize))
+    {
+        close();
+        return false;
+    }
+
+    QByteArray sheetName = QFileInfo(sheetFilename).absoluteFilePath().toUtf8();
+    if(_header->sheet.size!=sheet.size ||
+       _header->sheet.lastModified!=sheet.lastModified ||
+       _header->sheetNameSize!=quint32(sheetName.size()) ||
+       memcmp(_data+_header->sheetNameOffset,sheetName.constData(),
+              size_t(sheetName.size())) ||
+       !hash(sheetFilename,sheet) ||
+       memcmp(_header->sheet.sha256,sheet.sha256,sizeof(sheet.sha256)))
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+//------------------------------------------------------------------------------
+void StartupSnapshot::close(){
+    if(_file){
+        if(_data)
+            _file->unmap(const_cast<uchar *>(_data));
+        delete _file;
+    }
+    _file = nullptr;
+    _data = nullptr;
+    _header = nullptr;
+}
+//------------------------------------------------------------------------------
+bool StartupSnapshot::fingerprint(const QString& sheetFilename, Sheet& sheet){
+    return stat(sheetFilename,sheet) && hash(sheetFilename,sheet);
+}
+//------------------------------------------------------------------------------
+bool StartupSnapshot::save(const QString& filename, const QString& sheetFilename,
+    const Sheet& sheet, const Globals& globals, const QVector<Probe>& probes,
+    const QStringList& diagnostics)
+{
+    QByteArray sheetName = QFileInfo(sheetFilename).absoluteFilePath().toUtf8();
+    QByteArray diagnosticText = diagnostics.join('\n').toUtf8();
+
+    Header header;
+    memset(&header,0,sizeof(header));
+    header.magic = cMagic;
+    header.version = cVersion;
+    header.byteOrderMark = cByteOrderMark;
+    header.probeCount = quint32(probes.size());
+    header.sheet = sheet;
+    header.globals = globals;
+    header.sheetNameSize = quint32(sheetName.size());
+    header.diagnosticsSize = quint32(diagnosticText.size());
+    header.probesOffset = align(sizeof(Header));
+    header.sheetNameOffset = header.probesOffset+
+                             quint64(probes.size())*sizeof(Probe);
+    header.diagnosticsOffset = header.sheetNameOffset+quint64(sheetName.size());
+    header.fileSize = header.diagnosticsOffset+quint64(diagnosticText.size());
+
+    QByteArray data(int(header.fileSize),'\0');
+    char *base = data.data();
+    memcpy(base,&header,sizeof(header));
+    memcpy(base+header.probesOffset,probes.constData(),
+           size_t(probes.size())*sizeof(Probe));
+    memcpy(base+header.sheetNameOffset,sheetName.constData(),
+           size_t(sheetName.size()));
+    memcpy(base+header.diagnosticsOffset,diagnosticText.constData(),
+           size_t(diagnosticText.size()));
+
+    QSaveFile file(filename);
+    return file.open(QIODevice::WriteOnly) && file.write(data)==data.size() &&
+           file.commit();
+}
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+bool StartupSnapshot::fits(quint64 offset, quint64 count, quint64 elementSize,
+    quint64 fileSize)
+{
+    // offset+count*elementSize<=fileSize, without overflowing
+    return offset<=fileSize && count<=(fileSize-offset)/elementSize;
+}
+//------------------------------------------------------------------------------
+bool StartupSnapshot::stat(const QString& sheetFilename, Sheet& sheet){
+    // Standard input has no identity to check against
+    if(sheetFilename=="-")
+        return false;
+    QFileInfo info(sheetFilename);
+    if(!info.isFile())
+        return false;
+    sheet.size = info.size();
+    sheet.lastModified = info.lastModified().toMSecsSinceEpoch();
+    return true;
+}
+//------------------------------------------------------------------------------
+bool StartupSnapshot::hash(const QString& sheetFilename, Sheet& sheet){
+    QFile file(sheetFilename);
+    if(!file.open(QIODevice::ReadOnly) || file.size()!=sheet.size)
+        return false;
+    Sha256 sha256;
+    if(sheet.size){
+        const uchar *data = file.map(0,sheet.size);
+        if(!data)
+            return false;
+        sha256.update(ByteView(reinterpret_cast<const char *>(data),
+                               size_t(sheet.size)));
+        file.unmap(const_cast<uchar *>(data));
+    }
+    sha256.final(sheet.sha256);
+    return true;
+}
+//------------------------------------------------------------------------------
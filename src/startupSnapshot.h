@@ -0,0 +1,107 @@
+#ifndef STARTUPSNAPSHOT_H
+#define STARTUPSNAPSHOT_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+//------------------------------------------------------------------------------
+// Forwards
+//------------------------------------------------------------------------------
+class QFile;
+
+
+//------------------------------------------------------------------------------
+// class StartupSnapshot
+//------------------------------------------------------------------------------
+// The probe sheet as loaded by a run: the global endpoints of its second
+// line, the valid probe rows and the messages about the rejected ones. The
+// file is memory mapped and used as is, so a warm start skips reading,
+// tokenizing and validating the sheet. It holds for the sheet file it was
+// made from only: same path, size and modification time, and the same
+// SHA-256 (the sheet is hashed on open, a fraction of the cost of parsing
+// it, the more so for a workbook).
+//
+// The check plan is not part of it: ConfigurationCheck::addChecks() compiles
+// it from its 33 built-in path literals (and the rule groups') in
+// microseconds, less than validating a mapped copy of it would take.
+//------------------------------------------------------------------------------
+class StartupSnapshot
+{
+    public:
+        // Types
+        struct Sheet {
+            qint64 size;
+            qint64 lastModified; // msecs since epoch
+            unsigned char sha256[32];
+        };
+        struct Globals {
+            qint32 central0IP;
+            quint32 central0Port;
+            qint32 central0SNTP;
+            qint32 globalSNTP;
+            qint32 newUpdaterIP;
+            quint32 newUpdaterPort;
+        };
+        struct Probe {
+            quint32 serial;
+            qint32 ip;
+            qint32 netmask;
+            qint32 gateway;
+        };
+        // Constructor
+        StartupSnapshot();
+        // Destructor
+        ~StartupSnapshot();
+        // Accessors
+        inline bool isOpen()const { return _data!=nullptr; }
+        const Globals& globals()const;
+        int probeCount()const;
+        const Probe *probes()const; // by serial
+        QStringList diagnostics()const;
+        // Methods
+        bool open(const QString& filename, const QString& sheetFilename);
+        void close();
+        static bool fingerprint(const QString& sheetFilename, Sheet& sheet);
+        static bool save(const QString& filename, const QString& sheetFilename,
+                         const Sheet& sheet, const Globals& globals,
+                         const QVector<Probe>& probes,
+                         const QStringList& diagnostics);
+    private:
+        // Constants
+        enum {
+            cMagic = 0x4E53534D, // "MSSN"
+            cVersion = 1,
+            cByteOrderMark = 0x01020304,
+        };
+        // Types
+        struct Header {
+            quint32 magic;
+            quint32 version;
+            quint32 byteOrderMark;
+            quint32 probeCount;
+            Sheet sheet;
+            Globals globals;
+            quint32 sheetNameSize;      // UTF-8 bytes
+            quint32 diagnosticsSize;    // UTF-8 bytes, lines joined by '\n'
+            quint64 probesOffset;       // Probe[probeCount]
+            quint64 sheetNameOffset;
+            quint64 diagnosticsOffset;
+            quint64 fileSize;
+        };
+        // Data
+        QFile *_file;
+        const uchar *_data;
+        const Header *_header;
+        // Private copy constructor and assignment (unimplemented!)
+        StartupSnapshot(const StartupSnapshot& src);
+        StartupSnapshot& operator=(const StartupSnapshot& rhs);
+        // Helpers
+        static quint64 align(quint64 offset) { return (offset+7) & ~quint64(7); }
+        static bool fits(quint64 offset, quint64 count, quint64 elementSize,
+                         quint64 fileSize);
+        static bool stat(const QString& sheetFilename, Sheet& sheet);
+        static bool hash(const QString& sheetFilename, Sheet& sheet);
+};
+
+#endif // STARTUPSNAPSHOT_H
@@ -0,0 +1,250 @@
+#include "stationIO.h"
+
+#include <cerrno>
+#include <fcntl.h>
+
+
+//------------------------------------------------------------------------------
+// class StationIO implementation
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+StationIO::StationIO() : _depth(1), _pending(0), _failed(false)
+{
+}
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+StationIO::~StationIO(){
+    // Buffers must outlive the operations the kernel still holds
+    while(_pending && !_failed){
+        Request *request = next(true);
+        if(request)
+            release(request);
+    }
+    _ring.close();
+    qDeleteAll(_requests);
+}
+//------------------------------------------------------------------------------
+// Methods
+//------------------------------------------------------------------------------
+bool StationIO::init(int depth){
+    // Up to two operations per request in flight (open and stat)
+    _depth = depth>0 ? depth : 1;
+    _failed = false;
+    return _ring.init(unsigned(2*_depth));
+}
+//------------------------------------------------------------------------------
+StationIO::Request *StationIO::acquire(Kind kind){
+    Request *request;
+    if(_free.isEmpty()){
+        request = new Request;
+        _requests.append(request);
+    }else{
+        request = _free.takeLast();
+    }
+    request->kind = kind;
+    request->cookie = nullptr;
+    return request;
+}
+//------------------------------------------------------------------------------
+void StationIO::submit(Request *request){
+    // Queued only: the kernel gets them in batches, from next()
+    request->size = request->kind==kWrite ? request->data.size() : 0;
+    request->lastModified = 0;
+    request->failedStep = stNone;
+    request->error = 0;
+    request->fd = -1;
+    request->inFlight = 0;
+    request->done = 0;
+    ++_pending;
+    if(request->kind==kRead){
+        prep(request,stOpen);
+        prep(request,stStat);
+    }else
+        prep(request,stMkdir);
+}
+//------------------------------------------------------------------------------
+StationIO::Request *StationIO::next(bool wait){
+    for(;;){
+        IoRing::Completion completion;
+        while(_finished.isEmpty() && _ring.peek(completion))
+            dispatch(completion);
+
+        // Whatever finishing requests queued goes out before handing one back
+        if(!_finished.isEmpty() || !_pending || !wait){
+            if(!_ring.submit())
+                _failed = true;
+            if(_finished.isEmpty())
+                return nullptr;
+            Request *request = _finished.takeFirst();
+            --_pending;
+            return request;
+        }
+
+        if(!_ring.submit(1)){
+            _failed = true;
+            return nullptr;
+        }
+    }
+}
+//------------------------------------------------------------------------------
+void StationIO::release(Request *request){
+    // Buffers are kept for the next request
+    _free.append(request);
+}
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+void StationIO::prep(Request *request, Step step){
+    // Requests are 8 byte aligned: bit 0 of the tag tells the stat of a read
+    // request from its open, both being in flight together
+    uint64_t userData = reinterpret_cast<uintptr_t>(request) |
+                        (step==stStat ? 1 : 0);
+    if(step!=stStat)
+        request->step = step;
+    ++request->inFlight;
+
+    for(;;){
+        bool queued = false;
+        switch(step){
+            case stOpen:
+                queued = request->kind==kRead
+                    ? _ring.prepOpenAt(request->path.constData(),O_RDONLY,0,
+                                       userData)
+                    : _ring.prepOpenAt(request->tmpPath.constData(),
+                                       O_WRONLY | O_CREAT | O_TRUNC,0644,
+                                       userData);
+                break;
+            case stStat:
+                queued = _ring.prepStatx(request->path.constData(),
+                                         &request->statx,userData);
+                break;
+            case stRead:
+                queued = _ring.prepRead(request->fd,
+                                        request->data.data()+request->done,
+                                        unsigned(request->size-request->done),
+                                        uint64_t(request->done),userData);
+                break;
+            case stMkdir:
+                queued = _ring.prepMkdirAt(request->done ?
+                                           request->dirPath.constData() :
+                                           request->parentDirPath.constData(),
+                                           0777,userData);
+                break;
+            case stWrite:
+                queued = _ring.prepWrite(request->fd,
+                                         request->data.constData()+request->done,
+                                         unsigned(request->size-request->done),
+                                         uint64_t(request->done),userData);
+                break;
+            case stClose:
+                queued = _ring.prepClose(request->fd,userData);
+                break;
+            case stRename:
+                queued = _ring.prepRenameAt(request->tmpPath.constData(),
+                                            request->path.constData(),userData);
+                break;
+            case stNone:
+                break;
+        }
+        if(queued || !_ring.submit()){
+            if(!queued)
+                _failed = true;
+            return;
+        }
+        // Submission queue was full: retry now that it has been handed over
+    }
+}
+//------------------------------------------------------------------------------
+void StationIO::dispatch(const IoRing::Completion& completion){
+    Request *request = reinterpret_cast<Request *>(
+        uintptr_t(completion.userData & ~uint64_t(1)));
+    complete(request,(completion.userData & 1) ? stStat : request->step,
+             completion.result);
+}
+//------------------------------------------------------------------------------
+void StationIO::complete(Request *request, Step step, int result){
+    --request->inFlight;
+    switch(step){
+        case stOpen:
+        case stStat:
+            if(result<0)
+                fail(request,step,-result);
+            else if(step==stOpen)
+                request->fd = result;
+            else{
+                request->size = IoRing::statxSize(request->statx);
+                request->lastModified = IoRing::statxLastModified(request->statx);
+            }
+            if(request->inFlight)
+                return; // read: waiting for the other one
+            if(request->failedStep!=stNone)
+                break;
+            request->done = 0;
+            if(request->kind==kRead){
+                request->data.resize(int(request->size));
+                prep(request,request->size ? stRead : stClose);
+            }else
+                prep(request,request->size ? stWrite : stClose);
+            return;
+        case stRead:
+        case stWrite:
+            if(result<=0){
+                if(result<0 || step==stWrite){
+                    fail(request,step,result<0 ? -result : EIO);
+                    break;
+                }
+                // The file shrank since it was stat'ed
+                request->size = request->done;
+                request->data.resize(int(request->done));
+            }
+            request->done += result;
+            prep(request,request->done<request->size ? step : stClose);
+            return;
+        case stMkdir:
+            if(result<0 && result!=-EEXIST){
+                fail(request,step,-result);
+                break;
+            }
+            if(!request->done++){
+                prep(request,stMkdir); // the station directory now
+                return;
+            }
+            prep(request,stOpen);
+            return;
+        case stClose:
+            request->fd = -1;
+            if(result<0 && request->kind==kWrite)
+                fail(request,step,-result);
+            if(request->kind==kWrite && request->failedStep==stNone){
+                prep(request,stRename);
+                return;
+            }
+            break;
+        case stRename:
+            if(result<0)
+                fail(request,step,-result);
+            break;
+        case stNone:
+            break;
+    }
+
+    // Failed or done: a file left open is closed first
+    if(request->fd>=0)
+        prep(request,stClose);
+    else
+        finish(request);
+}
+//------------------------------------------------------------------------------
+void StationIO::fail(Request *request, Step step, int error){
+    if(request->failedStep==stNone){
+        request->failedStep = step;
+        request->error = error;
+    }
+}
+//------------------------------------------------------------------------------
+void StationIO::finish(Request *request){
+    _finished.append(request);
+}
+//------------------------------------------------------------------------------
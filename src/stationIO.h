@@ -0,0 +1,95 @@
+#ifndef STATIONIO_H
+#define STATIONIO_H
+
+#include <QByteArray>
+#include <QtAlgorithms>
+#include <QVector>
+#include "ioRing.h"
+
+
+//------------------------------------------------------------------------------
+// class StationIO
+//------------------------------------------------------------------------------
+// Batched asynchronous station file I/O over io_uring. A read request opens,
+// stats, reads and closes a station file; a write request creates the
+// station's output directory, writes a temporary file next to the final one,
+// closes and renames it. Many requests are in flight at once, each one
+// advancing as its operations complete; finished requests are handed back in
+// completion order by next(). init() fails when io_uring cannot be used: the
+// caller then goes on with blocking QFile I/O.
+//------------------------------------------------------------------------------
+class StationIO
+{
+    public:
+        // Types
+        enum Kind {
+            kRead,
+            kWrite,
+        };
+        enum Step {
+            stNone,
+            stOpen,
+            stStat,
+            stRead,
+            stMkdir,
+            stWrite,
+            stClose,
+            stRename,
+        };
+        struct Request {
+            // Caller's
+            Kind kind;
+            const void *cookie;
+            QByteArray path;    // local 8 bit: file read, or final file written
+            QByteArray tmpPath; // write: temporary file in dirPath
+            QByteArray parentDirPath; // write: dirPath's parent
+            QByteArray dirPath; // write: directory of path
+            QByteArray data;    // read result, or data to write
+            // Results
+            qint64 size;
+            qint64 lastModified; // msecs since epoch
+            Step failedStep;
+            int error;          // errno of failedStep
+            // Private
+            int fd;
+            int inFlight;
+            Step step;
+            qint64 done;        // bytes, or directories while creating them
+            IoRing::StatxBuffer statx;
+        };
+        // Constructor
+        StationIO();
+        // Destructor
+        ~StationIO();
+        // Accessors
+        inline bool isAsync()const { return _ring.isOpen(); }
+        inline int depth()const { return _depth; }
+        inline int pending()const { return _pending; }
+        inline bool failed()const { return _failed; }
+        // Methods
+        bool init(int depth);
+        Request *acquire(Kind kind);
+        void submit(Request *request);
+        Request *next(bool wait); // null: none finished (or none pending)
+        void release(Request *request);
+    private:
+        // Data
+        IoRing _ring;
+        int _depth;
+        int _pending;   // submitted, not handed back yet
+        bool _failed;   // the ring itself failed, nothing more completes
+        QVector<Request *> _requests;
+        QVector<Request *> _free;
+        QVector<Request *> _finished;
+        // Private copy constructor and assignment (unimplemented!)
+        StationIO(const StationIO&);
+        StationIO& operator=(const StationIO&);
+        // Helpers
+        void prep(Request *request, Step step);
+        void dispatch(const IoRing::Completion& completion);
+        void complete(Request *request, Step step, int result);
+        void fail(Request *request, Step step, int error);
+        void finish(Request *request);
+};
+
+#endif // STATIONIO_H
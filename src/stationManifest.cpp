@@ -0,0 +1,51 @@
+#include "stationManifest.h"
+
+#include <QFile>
+#include <QSaveFile>
+
+
+//------------------------------------------------------------------------------
+// class StationManifest implementation
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+StationManifest::StationManifest(){
+}
+//------------------------------------------------------------------------------
+// Methods
+//------------------------------------------------------------------------------
+void StationManifest::add(uint serial, const QString& filename,
+    DigestDevice& digest, ByteView input)
+{
+    Entry entry;
+    entry.size = digest.writtenSize();
+    entry.crc32c = digest.crc32c();
+    entry.sha256 = digest.sha256Hex();
+    Sha256 inputSha256;
+    inputSha256.update(input);
+    entry.inputSha256 = QByteArray::fromStdString(inputSha256.hexDigest());
+    entry.filename = filename;
+    _entries.insert(serial,entry);
+}
+//------------------------------------------------------------------------------
+void StationManifest::remove(uint serial){
+    _entries.remove(serial);
+}
+//------------------------------------------------------------------------------
+bool StationManifest::write(const QString& filename)const{
+    QByteArray text = "# MiraStationManifest 1\n"
+                      "# serial size crc32c sha256 input_sha256 file\n";
+    for(QMap<uint,Entry>::const_iterator it=_entries.constBegin();
+        it!=_entries.constEnd();
+        ++it)
+    {
+        text += QByteArray::number(it.key())+' '+QByteArray::number(it->size)+' '+
+                QByteArray::number(it->crc32c,16).rightJustified(8,'0')+' '+
+                it->sha256+' '+it->inputSha256+' '+
+                QByteArray::number(it.key())+'/'+QFile::encodeName(it->filename)+'\n';
+    }
+    QSaveFile file(filename);
+    return file.open(QIODevice::WriteOnly) && file.write(text)==text.size() &&
+           file.commit();
+}
+//------------------------------------------------------------------------------
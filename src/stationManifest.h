@@ -0,0 +1,95 @@
+#ifndef STATIONMANIFEST_H
+#define STATIONMANIFEST_H
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QMap>
+#include <QString>
+#include "byteView.h"
+#include "crc32c.h"
+#include "sha256.h"
+
+
+//------------------------------------------------------------------------------
+// class DigestDevice
+//------------------------------------------------------------------------------
+// Write only pass-through to another device: the CRC-32C and SHA-256 of the
+// output computed while it streams out, no second read. Newline translation
+// (Text mode), if any, is done here, ahead of the digests.
+//------------------------------------------------------------------------------
+class DigestDevice : public QIODevice
+{
+    public:
+        // Constructor
+        inline DigestDevice(QIODevice& device, QIODevice::OpenMode textMode) :
+            _device(device), _crc32c(0), _size(0)
+        {
+            open(QIODevice::WriteOnly | textMode);
+        }
+        // Accessors
+        inline quint32 crc32c()const { return _crc32c; }
+        inline qint64 writtenSize()const { return _size; }
+        virtual bool isSequential()const { return true; }
+        // Methods
+        inline QByteArray sha256Hex() {
+            return QByteArray::fromStdString(_sha256.hexDigest());
+        }
+    protected:
+        virtual qint64 readData(char *data, qint64 maxSize){
+            Q_UNUSED(data) Q_UNUSED(maxSize)
+            return -1;
+        }
+        virtual qint64 writeData(const char *data, qint64 size){
+            qint64 written = _device.write(data,size);
+            if(written>0){
+                ByteView bytes(data,size_t(written));
+                _crc32c = Crc32c::update(bytes,_crc32c);
+                _sha256.update(bytes);
+                _size += written;
+            }
+            return written;
+        }
+    private:
+        // Data
+        QIODevice& _device;
+        quint32 _crc32c;
+        Sha256 _sha256;
+        qint64 _size;
+};
+
+
+//------------------------------------------------------------------------------
+// class StationManifest
+//------------------------------------------------------------------------------
+// The files of one output tree (modified_stations, modified_stations_<name>)
+// one line each, by serial: what a transfer or a probe gets verified
+// against, without reading the files again. Written to the root of the tree
+// once the run is over, and only if the tree has files.
+//------------------------------------------------------------------------------
+class StationManifest
+{
+    public:
+        // Constructor
+        StationManifest();
+        // Accessors
+        inline bool isEmpty()const { return _entries.isEmpty(); }
+        inline int size()const { return _entries.size(); }
+        // Methods
+        void add(uint serial, const QString& filename, DigestDevice& digest,
+                 ByteView input);
+        void remove(uint serial);
+        bool write(const QString& filename)const;
+    private:
+        // Types
+        struct Entry {
+            qint64 size;
+            quint32 crc32c;
+            QByteArray sha256;      // hex, of the output file
+            QByteArray inputSha256; // hex, of the station file checked
+            QString filename;       // in <serial>/
+        };
+        // Data
+        QMap<uint,Entry> _entries;
+};
+
+#endif // STATIONMANIFEST_H
@@ -0,0 +1,129 @@
+#include "stationOffsetIndex.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+
+
+//------------------------------------------------------------------------------
+// class StationOffsetIndex implementation
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+StationOffsetIndex::StationOffsetIndex() : _planSignature(0), _dirty(false)
+{
+}
+//------------------------------------------------------------------------------
+// Accessors
+//------------------------------------------------------------------------------
+const StationOffsetIndex::Entry* StationOffsetIndex::find(uint serial,
+    qint64 size, qint64 lastModified)const
+{
+    QMap<uint,Entry>::const_iterator it = _entries.find(serial);
+    if(it==_entries.end() || it->size!=size || it->lastModified!=lastModified)
+        return nullptr;
+    return &*it;
+}
+//------------------------------------------------------------------------------
+// Methods
+//------------------------------------------------------------------------------
+void StationOffsetIndex::clear(quint32 planSignature){
+    _planSignature = planSignature;
+    _dirty = !_entries.isEmpty();
+    _entries.clear();
+}
+//------------------------------------------------------------------------------
+bool StationOffsetIndex::load(const QString& filename, quint32 planSignature,
+    int checkCount)
+{
+    clear(planSignature);
+
+    QFile file(filename);
+    if(!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_0);
+    quint32 magic, version, signature, count;
+    in >> magic >> version >> signature >> count;
+    if(in.status()!=QDataStream::Ok || magic!=cMagic || version!=cVersion ||
+       signature!=planSignature)
+        return false; // stale or foreign: start over with an empty index
+
+    // Counts are bounded by what is left of the file before anything gets
+    // allocated for them, slot counts by the check plan as well
+    bool valid = count<=quint64(file.size()-file.pos())/cEntrySize;
+    for(quint32 i=0;valid && i<count && in.status()==QDataStream::Ok;++i){
+        quint32 serial, slotCount;
+        Entry entry;
+        in >> serial >> entry.size >> entry.lastModified >> slotCount;
+        if(slotCount>quint32(checkCount) ||
+           slotCount>quint64(file.size()-file.pos())/cSlotSize)
+        {
+            valid = false;
+            break;
+        }
+        entry.valueSlots.resize(int(slotCount));
+        for(quint32 j=0;j<slotCount;++j){
+            Slot& slot = entry.valueSlots[int(j)];
+            qint32 checkIndex, length;
+            in >> checkIndex >> slot.tagOffset >> slot.offset >> length;
+            slot.checkIndex = checkIndex;
+            slot.length = length;
+            if(checkIndex<0 || checkIndex>=checkCount || slot.tagOffset<0 ||
+               slot.offset<slot.tagOffset || length<0)
+                valid = false;
+        }
+        _entries.insert(serial,entry);
+    }
+
+    if(!valid || in.status()!=QDataStream::Ok){
+        clear(planSignature);
+        return false;
+    }
+    return true;
+}
+//------------------------------------------------------------------------------
+bool StationOffsetIndex::save(const QString& filename){
+    QSaveFile file(filename);
+    if(!file.open(QIODevice::WriteOnly))
+        return false;
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << quint32(cMagic) << quint32(cVersion) << _planSignature
+        << quint32(_entries.size());
+    for(QMap<uint,Entry>::const_iterator it=_entries.begin();
+        it!=_entries.end();
+        ++it)
+    {
+        out << quint32(it.key()) << it->size << it->lastModified
+            << quint32(it->valueSlots.size());
+        for(int j=0;j<it->valueSlots.size();++j){
+            const Slot& slot = it->valueSlots.at(j);
+            out << qint32(slot.checkIndex) << slot.tagOffset << slot.offset
+                << qint32(slot.length);
+        }
+    }
+
+    if(!file.commit())
+        return false;
+    _dirty = false;
+    return true;
+}
+//------------------------------------------------------------------------------
+void StationOffsetIndex::insert(uint serial, qint64 size, qint64 lastModified,
+    const QVector<Slot>& valueSlots)
+{
+    Entry& entry = _entries[serial];
+    entry.size = size;
+    entry.lastModified = lastModified;
+    entry.valueSlots = valueSlots;
+    _dirty = true;
+}
+//------------------------------------------------------------------------------
+void StationOffsetIndex::remove(uint serial){
+    if(_entries.remove(serial))
+        _dirty = true;
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,60 @@
+#ifndef STATIONOFFSETINDEX_H
+#define STATIONOFFSETINDEX_H
+
+#include <QMap>
+#include <QString>
+#include <QVector>
+
+//------------------------------------------------------------------------------
+// class StationOffsetIndex
+//------------------------------------------------------------------------------
+// Persistent map: station serial -> (input file fingerprint, byte ranges of
+// every checked value). It lets a run validate an unchanged station file by
+// looking at the recorded ranges only, instead of parsing it from the top.
+//------------------------------------------------------------------------------
+class StationOffsetIndex
+{
+    public:
+        // Types
+        struct Slot {
+            int checkIndex;     // position of the check in the check plan
+            qint64 tagOffset;   // byte offset of the enclosing start tag '<'
+            qint64 offset;      // byte offset of the value text
+            int length;         // byte length of the value text
+        };
+        struct Entry {
+            inline Entry() : size(0), lastModified(0) {}
+
+            qint64 size;
+            qint64 lastModified; // msecs since epoch
+            QVector<Slot> valueSlots; // sorted by checkIndex, one per check
+        };
+        // Constructor
+        StationOffsetIndex();
+        // Accessors
+        inline int size()const { return _entries.size(); }
+        inline bool isDirty()const { return _dirty; }
+        const Entry* find(uint serial, qint64 size, qint64 lastModified)const;
+        // Methods
+        void clear(quint32 planSignature);
+        bool load(const QString& filename, quint32 planSignature,
+                  int checkCount);
+        bool save(const QString& filename);
+        void insert(uint serial, qint64 size, qint64 lastModified,
+                    const QVector<Slot>& valueSlots);
+        void remove(uint serial);
+    private:
+        // Constants
+        enum {
+            cMagic = 0x4D534F49, // "MSOI"
+            cVersion = 1,
+            cEntrySize = 24, // serial, size, lastModified, slot count
+            cSlotSize = 24,  // checkIndex, tagOffset, offset, length
+        };
+        // Data
+        quint32 _planSignature;
+        QMap<uint,Entry> _entries;
+        bool _dirty;
+};
+
+#endif // STATIONOFFSETINDEX_H
@@ -0,0 +1,77 @@
+#include "stationTemplate.h"
+
+#include <algorithm>
+#include <cstring>
+
+
+//------------------------------------------------------------------------------
+// class StationTemplate implementation
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+StationTemplate::StationTemplate() : _chunksSize(0)
+{
+}
+//------------------------------------------------------------------------------
+// Methods
+//------------------------------------------------------------------------------
+void StationTemplate::clear(){
+    _data.clear();
+    _slots.clear();
+    _chunksSize = 0;
+}
+//------------------------------------------------------------------------------
+bool StationTemplate::compile(const QByteArray& data,
+    const QVector<StationOffsetIndex::Slot>& valueSlots)
+{
+    clear();
+    _slots.reserve(valueSlots.size());
+    for(int i=0;i<valueSlots.size();++i){
+        const StationOffsetIndex::Slot& valueSlot = valueSlots.at(i);
+        Slot slot;
+        slot.checkIndex = valueSlot.checkIndex;
+        slot.offset = int(valueSlot.offset);
+        slot.length = valueSlot.length;
+        if(slot.checkIndex<0 || slot.offset<0 || slot.length<0 ||
+           qint64(slot.offset)+slot.length>data.size())
+            return false;
+        _slots.append(slot);
+    }
+    std::sort(_slots.begin(),_slots.end(),[](const Slot& a, const Slot& b){
+        return a.offset<b.offset;
+    });
+
+    // Overlapping ranges cannot be told apart while rendering
+    _chunksSize = data.size();
+    for(int i=0;i<_slots.size();++i){
+        if(i && _slots.at(i-1).offset+_slots.at(i-1).length>_slots.at(i).offset){
+            _slots.clear();
+            return false;
+        }
+        _chunksSize -= _slots.at(i).length;
+    }
+    _data = data;
+    return true;
+}
+//------------------------------------------------------------------------------
+void StationTemplate::render(const QVector<Value>& values, QByteArray& out)const{
+    int size = _chunksSize;
+    for(int i=0;i<_slots.size();++i)
+        size += values.at(_slots.at(i).checkIndex).length;
+    out.resize(size);
+
+    const char *in = _data.constData();
+    char *p = out.data();
+    int chunkBegin = 0;
+    for(int i=0;i<_slots.size();++i){
+        const Slot& slot = _slots.at(i);
+        const Value& value = values.at(slot.checkIndex);
+        memcpy(p,in+chunkBegin,size_t(slot.offset-chunkBegin));
+        p += slot.offset-chunkBegin;
+        memcpy(p,value.text,size_t(value.length));
+        p += value.length;
+        chunkBegin = slot.offset+slot.length;
+    }
+    memcpy(p,in+chunkBegin,size_t(_data.size()-chunkBegin));
+}
+//------------------------------------------------------------------------------
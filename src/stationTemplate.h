@@ -0,0 +1,53 @@
+#ifndef STATIONTEMPLATE_H
+#define STATIONTEMPLATE_H
+
+#include <QByteArray>
+#include <QVector>
+#include "stationOffsetIndex.h"
+
+
+//------------------------------------------------------------------------------
+// class StationTemplate
+//------------------------------------------------------------------------------
+// A reference station file compiled into verbatim byte chunks and value
+// slots, one per check (the ranges the offset index records). Rendering a
+// station file is a sequence of copies: chunk, value, chunk, ... with no XML
+// parsing nor writing involved; values are the raw (ASCII) texts to put in
+// the slots, by check index.
+//------------------------------------------------------------------------------
+class StationTemplate
+{
+    public:
+        // Constants
+        enum {
+            cMaxValueLength = 15,   // "255.255.255.255", "-2147483648"
+        };
+        // Types
+        struct Value {
+            char text[cMaxValueLength];
+            int length;
+        };
+        // Constructor
+        StationTemplate();
+        // Accessors
+        inline bool isEmpty()const { return _data.isEmpty(); }
+        inline int slotCount()const { return _slots.size(); }
+        // Methods
+        void clear();
+        bool compile(const QByteArray& data,
+                     const QVector<StationOffsetIndex::Slot>& valueSlots);
+        void render(const QVector<Value>& values, QByteArray& out)const;
+    private:
+        // Types
+        struct Slot {
+            int checkIndex;
+            int offset;
+            int length;
+        };
+        // Data
+        QByteArray _data;
+        QVector<Slot> _slots;   // file order
+        int _chunksSize;        // bytes outside the slots
+};
+
+#endif // STATIONTEMPLATE_H
@@ -0,0 +1,280 @@
+#include "checkEngine.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+//------------------------------------------------------------------------------
+// Check engine tests
+//------------------------------------------------------------------------------
+// CheckEngine on the project's station files, with a part of the built-in
+// check plan (names holding '/' included): every value located where its
+// element is, an unmodified station written back byte for byte, a fixed one
+// checked again without findings. Then one value of a station changed to the
+// forms a station file may hold (references, CDATA sections, comments, an
+// empty element) and to those the engine refuses (child elements, a checked
+// element repeated): the value is the whole content, the fix replaces it all.
+// Exit status is the number of failed checks.
+//------------------------------------------------------------------------------
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition) check((condition),#condition,__LINE__)
+
+//------------------------------------------------------------------------------
+void check(bool condition, const char *text, int line){
+    if(!condition){
+        std::printf("FAIL line %d: %s\n",line,text);
+        ++failures;
+    }
+}
+//------------------------------------------------------------------------------
+// Paths of the built-in plan (ConfigurationCheck::initChecks())
+const char *const plan[] = {
+    "ConfigurationEntries(*)/Category(System)/Entry(SerialNr)",
+    "ConfigurationEntries(*)/Category(Devices)/Category(Ethernet)/Entry(UseDHCP)",
+    "ConfigurationEntries(*)/Category(Devices)/Category(Ethernet)/Entry(StaticIp)/Element(Ip Address)",
+    "ConfigurationEntries(*)/Category(Devices)/Category(Ethernet)/Entry(StaticIp)/Element(Subnet Mask)",
+    "ConfigurationEntries(*)/Category(Devices)/Category(Ethernet)/Entry(StaticIp)/Element(Gateway)",
+    "ConfigurationEntries(*)/Category(Communication)/Entry(Time Servers)/Element(Time Server 0)",
+    "ConfigurationEntries(*)/Category(Communication)/Category(Central Connection Information)/Category(Central 0)/Entry(Enable)",
+    "ConfigurationEntries(*)/Category(Communication)/Category(Central Connection Information)/Category(Central 0)/Entry(Device List)/Category(Device 0)/Element(TCP/IP: Port / Serial: Address High)",
+    "ConfigurationEntries(*)/Category(Communication)/Category(Central Connection Information)/Category(Central 0)/Entry(Device List)/Category(Device 0)/Element(TCP/IP: IP Address / Serial: Address Low)",
+    "ConfigurationEntries(*)/Category(Communication)/Category(Central Connection Information)/Category(Special)/Category(Updater)/Entry(Device List)/Category(Device 0)/Element(TCP/IP: SNTP Server Ip / Serial: Destination Ip)",
+};
+const int cCheckCount = int(sizeof(plan)/sizeof(plan[0]));
+const int cGateway = 4;
+
+// First, middle and last stations of the project's set
+const char *const serials[] = { "30290", "30476", "30530", "30602", "30665" };
+
+//------------------------------------------------------------------------------
+class Findings : public CheckEngine::FindingSink {
+    public:
+        virtual void wrongValue(const CheckEngine::Finding& finding){
+            values[size_t(finding.checkIndex)] = finding.got.toString();
+            ++wrongCount;
+        }
+        virtual void parseError(const char *reason, size_t offset){
+            this->reason = reason;
+            this->offset = offset;
+        }
+        void clear(){
+            values.assign(size_t(cCheckCount),std::string());
+            wrongCount = 0;
+            reason.clear();
+            offset = 0;
+        }
+        std::vector<std::string> values;    // by check index, as found
+        int wrongCount;
+        std::string reason;
+        size_t offset;
+};
+//------------------------------------------------------------------------------
+class Output : public CheckEngine::OutputSink {
+    public:
+        virtual bool write(ByteView bytes){
+            text.append(bytes.data(),bytes.size());
+            return true;
+        }
+        std::string text;
+};
+//------------------------------------------------------------------------------
+std::string readFile(const std::string& filename){
+    std::ifstream file(filename.c_str(),std::ios::binary);
+    std::ostringstream data;
+    data << file.rdbuf();
+    return data.str();
+}
+//------------------------------------------------------------------------------
+std::string stationFile(const char *serial){
+    return std::string(PROJECT_ROOT)+"stations/"+serial+
+           "/ConfigV1.5.6ExpriviaN.xml";
+}
+//------------------------------------------------------------------------------
+void buildPlan(CheckEngine& engine){
+    engine.clear();
+    for(int i=0;i<cCheckCount;++i)
+        CHECK(engine.addCheck(ByteView::fromCString(plan[i]),i));
+}
+//------------------------------------------------------------------------------
+// Every check expecting text: compared as strings, none of them IPv4. The
+// expectations are views into texts
+void setExpectations(std::vector<CheckEngine::Expectation>& expectations,
+                     const std::vector<std::string>& texts){
+    expectations.resize(texts.size());
+    for(size_t i=0;i<texts.size();++i){
+        CheckEngine::Expectation expectation = { ByteView(texts[i]), false, 0, true };
+        expectations[i] = expectation;
+    }
+}
+//------------------------------------------------------------------------------
+// The name attribute of the last path segment, as in the start tag
+std::string nameAttribute(const char *path){
+    std::string segment(path);
+    segment = segment.substr(segment.rfind('(')+1);
+    segment.erase(segment.size()-1);
+    return " name=\""+segment+"\"";
+}
+//------------------------------------------------------------------------------
+void stations(){
+    CheckEngine engine;
+    buildPlan(engine);
+    Findings findings;
+    const std::vector<std::string> unknownTexts(size_t(cCheckCount),"?");
+    std::vector<CheckEngine::Expectation> expectations;
+    setExpectations(expectations,unknownTexts);
+    std::vector<std::string> texts(unknownTexts);
+
+    for(size_t s=0;s<sizeof(serials)/sizeof(serials[0]);++s){
+        const std::string data = readFile(stationFile(serials[s]));
+        CHECK(!data.empty());
+        const ByteView document(data);
+
+        // Located: the plain content of the element of each path
+        findings.clear();
+        CHECK(engine.check(document,expectations.data(),findings));
+        CHECK(findings.reason.empty());
+        CHECK(findings.wrongCount==cCheckCount);
+        const std::vector<CheckEngine::Location> locations = engine.locations();
+        for(int i=0;i<cCheckCount;++i){
+            const CheckEngine::Location& location = locations[size_t(i)];
+            CHECK(location.checkIndex==i && location.verbatim);
+            size_t tagEnd = data.find('>',location.tagOffset);
+            std::string startTag = data.substr(location.tagOffset,
+                                               tagEnd-location.tagOffset);
+            CHECK(startTag.find(nameAttribute(plan[i]))!=std::string::npos);
+            CHECK(location.offset==tagEnd+1);
+            CHECK(data.compare(location.offset+location.length,2,"</")==0);
+            texts[size_t(i)] = findings.values[size_t(i)];
+            CHECK(texts[size_t(i)]==data.substr(location.offset,location.length));
+        }
+
+        // Expected as they are: no finding, written back byte for byte
+        std::vector<CheckEngine::Expectation> same;
+        setExpectations(same,texts);
+        findings.clear();
+        CHECK(engine.check(document,same.data(),findings));
+        CHECK(findings.wrongCount==0);
+        Output output;
+        CHECK(engine.writeFixed(document,same.data(),output));
+        CHECK(output.text==data);
+
+        // Every value wrong: fixed, then right
+        std::vector<std::string> fixedTexts(texts.size());
+        for(int i=0;i<cCheckCount;++i)
+            fixedTexts[size_t(i)] = texts[size_t(i)]+"1";
+        std::vector<CheckEngine::Expectation> fixedExpectations;
+        setExpectations(fixedExpectations,fixedTexts);
+        findings.clear();
+        CHECK(engine.check(document,fixedExpectations.data(),findings));
+        CHECK(findings.wrongCount==cCheckCount);
+        output.text.clear();
+        CHECK(engine.writeFixed(document,fixedExpectations.data(),output));
+        CHECK(output.text.size()==data.size()+size_t(cCheckCount));
+        findings.clear();
+        CHECK(engine.check(ByteView(output.text),fixedExpectations.data(),findings));
+        CHECK(findings.reason.empty() && findings.wrongCount==0);
+    }
+}
+//------------------------------------------------------------------------------
+struct Case {
+    const char *what;
+    const char *element;    // replaces the Gateway element, %s its start tag
+    bool checked;           // false: a parse error
+    const char *value;      // as compared
+};
+//------------------------------------------------------------------------------
+const Case cases[] = {
+    { "plain", "%s>-1062731519</Element>", true, "-1062731519" },
+    { "references", "%s>&#45;106273151&#x39;</Element>", true, "-1062731519" },
+    { "entity", "%s>a&amp;b&lt;</Element>", true, "a&b<" },
+    { "CDATA", "%s><![CDATA[-1062731519]]></Element>", true, "-1062731519" },
+    { "CDATA and text", "%s>-10627<![CDATA[31519]]></Element>", true, "-1062731519" },
+    { "CDATA markup", "%s><![CDATA[<b>&amp;</b>]]></Element>", true, "<b>&amp;</b>" },
+    { "comment", "%s>-106273<!-- c -->1519</Element>", true, "-1062731519" },
+    { "comment only", "%s><!-- -1062731519 --></Element>", true, "" },
+    { "empty", "%s></Element>", true, "" },
+    { "self-closing", "%s/>", true, "" },
+    { "child element", "%s><b>1</b></Element>", false, nullptr },
+    { "empty child", "%s>1<b/></Element>", false, nullptr },
+    { "repeated", "%s>1</Element>%s>2</Element>", false, nullptr },
+};
+//------------------------------------------------------------------------------
+void contents(){
+    const std::string data = readFile(stationFile(serials[0]));
+    const std::string startTag =
+        "<Element name=\"Gateway\" property=\"user\" size=\"1\" type=\"ipv4\"";
+    size_t begin = data.find(startTag);
+    size_t end = data.find("</Element>",begin)+10;
+    CHECK(begin!=std::string::npos);
+    if(begin==std::string::npos)
+        return;
+
+    CheckEngine engine;
+    buildPlan(engine);
+    Findings findings;
+    const std::vector<std::string> unknownTexts(size_t(cCheckCount),"?");
+    std::vector<CheckEngine::Expectation> expectations;
+    setExpectations(expectations,unknownTexts);
+    const std::string fixedText = "167772417";
+    std::vector<std::string> fixedTexts(unknownTexts);
+    fixedTexts[cGateway] = fixedText;
+    std::vector<CheckEngine::Expectation> fixedExpectations;
+    setExpectations(fixedExpectations,fixedTexts);
+    // The Gateway only: the others located, not compared
+    for(int i=0;i<cCheckCount;++i)
+        expectations[size_t(i)].active = fixedExpectations[size_t(i)].active =
+            i==cGateway;
+
+    for(size_t c=0;c<sizeof(cases)/sizeof(cases[0]);++c){
+        const Case& testCase = cases[c];
+        std::string element = testCase.element;
+        for(size_t at;(at=element.find("%s"))!=std::string::npos;)
+            element.replace(at,2,startTag);
+        std::string station = data;
+        station.replace(begin,end-begin,element);
+
+        findings.clear();
+        bool checked = engine.check(ByteView(station),expectations.data(),findings);
+        if(!testCase.checked){
+            if(checked || findings.reason.empty())
+                std::printf("FAIL case %s: not refused\n",testCase.what);
+            CHECK(!checked && !findings.reason.empty());
+            continue;
+        }
+        if(!checked)
+            std::printf("FAIL case %s: %s\n",testCase.what,findings.reason.c_str());
+        CHECK(checked);
+        CHECK(findings.values[cGateway]==testCase.value);
+        const CheckEngine::Location& location = engine.locations()[cGateway];
+        CHECK(location.tagOffset==begin);
+
+        // The fix replaces the whole content: nothing of it is left
+        findings.clear();
+        CHECK(engine.check(ByteView(station),fixedExpectations.data(),findings));
+        Output output;
+        CHECK(engine.writeFixed(ByteView(station),fixedExpectations.data(),output));
+        std::string expected = data;
+        expected.replace(begin,end-begin,startTag+'>'+fixedText+"</Element>");
+        if(output.text!=expected)
+            std::printf("FAIL case %s: fixed differently\n",testCase.what);
+        CHECK(output.text==expected);
+    }
+}
+//------------------------------------------------------------------------------
+
+} // namespace
+
+//------------------------------------------------------------------------------
+int main(){
+    stations();
+    contents();
+    std::printf("%s: %d failed checks\n",failures ? "FAIL" : "PASS",failures);
+    return failures;
+}
+//------------------------------------------------------------------------------
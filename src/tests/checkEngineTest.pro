@@ -0,0 +1,18 @@
+# The core check engine on the project's station files, then on values
+# written as references, CDATA sections and comments, empty, repeated and
+# with child elements (no Qt needed). Built by ../qMiraProbeXMLCheckAll.pro,
+# after the core library it links; run by 'make check' or on its own:
+# ./checkEngineTest (exit status: failed checks).
+
+CONFIG += console c++14 testcase
+CONFIG -= qt app_bundle
+
+TARGET = checkEngineTest
+
+# Where the project's station files are
+DEFINES += PROJECT_ROOT=\\\"$$PWD/../../\\\"
+
+SOURCES += \
+        checkEngineTest.cpp
+
+include(../core/core.pri)
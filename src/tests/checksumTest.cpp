@@ -0,0 +1,131 @@
+#include "crc32c.h"
+#include "sha256.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+
+//------------------------------------------------------------------------------
+// Checksum tests
+//------------------------------------------------------------------------------
+// Known answers of the core checksums: CRC-32C (the check value and the
+// iSCSI vectors of RFC 3720 B.4) and SHA-256 (the FIPS 180-2 examples, the
+// 1,000,000 'a' message included), then the same input given in pieces of
+// every size up to past a block: the same values. Run on the code path the CPU
+// selects (printed). Exit status is the number of failed checks.
+//------------------------------------------------------------------------------
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition) check((condition),#condition,__LINE__)
+
+//------------------------------------------------------------------------------
+void check(bool condition, const char *text, int line){
+    if(!condition){
+        std::printf("FAIL line %d: %s\n",line,text);
+        ++failures;
+    }
+}
+//------------------------------------------------------------------------------
+std::string sha256(const std::string& message){
+    Sha256 hash;
+    hash.update(ByteView(message));
+    return hash.hexDigest();
+}
+//------------------------------------------------------------------------------
+// A test message of size bytes, no period short of 251
+std::string message(size_t size){
+    std::string bytes(size,'\0');
+    for(size_t i=0;i<size;++i)
+        bytes[i] = char((i*7+3)%251);
+    return bytes;
+}
+//------------------------------------------------------------------------------
+void crc32cVectors(){
+    CHECK(Crc32c::update(ByteView())==0);
+    CHECK(Crc32c::update(ByteView::fromCString("123456789"))==0xE3069283u);
+
+    std::string bytes(32,'\0');
+    CHECK(Crc32c::update(ByteView(bytes))==0x8A9136AAu);
+    bytes.assign(32,char(0xFF));
+    CHECK(Crc32c::update(ByteView(bytes))==0x62A8AB43u);
+    for(int i=0;i<32;++i)
+        bytes[size_t(i)] = char(i);
+    CHECK(Crc32c::update(ByteView(bytes))==0x46DD794Eu);
+    for(int i=0;i<32;++i)
+        bytes[size_t(i)] = char(31-i);
+    CHECK(Crc32c::update(ByteView(bytes))==0x113FDB5Cu);
+}
+//------------------------------------------------------------------------------
+void sha256Vectors(){
+    CHECK(sha256("")==
+          "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    CHECK(sha256("abc")==
+          "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    // 56 bytes: the length no longer fits the last block
+    CHECK(sha256("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq")==
+          "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+    CHECK(sha256(std::string(1000000,'a'))==
+          "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+
+    // The hash is reset by final(): the next message starts afresh
+    Sha256 hash;
+    hash.update(ByteView::fromCString("abc"));
+    hash.hexDigest();
+    CHECK(hash.hexDigest()==
+          "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+}
+//------------------------------------------------------------------------------
+void splitUpdates(){
+    // Pieces of 1 to 129 bytes: within, across and over several blocks (and
+    // the 8 byte steps of CRC-32C), the last one what is left
+    const std::string bytes = message(1000);
+    const uint32_t crc = Crc32c::update(ByteView(bytes));
+    const std::string digest = sha256(bytes);
+    for(size_t piece=1;piece<=2*Sha256::cBlockSize+1;++piece){
+        uint32_t pieceCrc = 0;
+        Sha256 hash;
+        for(size_t pos=0;pos<bytes.size();pos+=piece){
+            ByteView part = ByteView(bytes).mid(pos,std::min(piece,bytes.size()-pos));
+            pieceCrc = Crc32c::update(part,pieceCrc);
+            hash.update(part);
+        }
+        std::string pieceDigest = hash.hexDigest();
+        if(pieceCrc!=crc || pieceDigest!=digest)
+            std::printf("FAIL pieces of %u bytes\n",unsigned(piece));
+        CHECK(pieceCrc==crc && pieceDigest==digest);
+    }
+
+    // Uneven pieces, empty ones among them, over the 1,000,000 'a' message
+    const std::string a(1000000,'a');
+    uint32_t pieceCrc = 0;
+    Sha256 hash;
+    size_t pos = 0;
+    for(size_t piece=0;pos<a.size();piece=(piece*13+5)%300){
+        ByteView part = ByteView(a).mid(pos,std::min(piece,a.size()-pos));
+        pieceCrc = Crc32c::update(part,pieceCrc);
+        hash.update(part);
+        pos += part.size();
+    }
+    CHECK(pieceCrc==Crc32c::update(ByteView(a)));
+    CHECK(hash.hexDigest()==
+          "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+}
+//------------------------------------------------------------------------------
+
+} // namespace
+
+//------------------------------------------------------------------------------
+int main(){
+    std::printf("CRC-32C %s, SHA-256 %s\n",
+                Crc32c::isHardwareAccelerated() ? "SSE4.2" : "tables",
+                Sha256::isHardwareAccelerated() ? "SHA extensions" : "portable");
+    crc32cVectors();
+    sha256Vectors();
+    splitUpdates();
+    std::printf("%s: %d failed checks\n",failures ? "FAIL" : "PASS",failures);
+    return failures;
+}
+//------------------------------------------------------------------------------
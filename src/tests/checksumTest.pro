@@ -0,0 +1,14 @@
+# Known answers of the core library's CRC-32C and SHA-256, whole and in
+# pieces (no Qt needed). Built by ../qMiraProbeXMLCheckAll.pro, after the core
+# library it links; run by 'make check' or on its own: ./checksumTest (exit
+# status: failed checks).
+
+CONFIG += console c++14 testcase
+CONFIG -= qt app_bundle
+
+TARGET = checksumTest
+
+SOURCES += \
+        checksumTest.cpp
+
+include(../core/core.pri)
@@ -0,0 +1,245 @@
+#include "fleetIndex.h"
+
+#include <cstring>
+#include <QBitArray>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+
+
+//------------------------------------------------------------------------------
+// class FleetIndexTest
+//------------------------------------------------------------------------------
+// The fleet index over a few stations: built, reopened and rebuilt, then
+// opened truncated at every length and with corrupted fields. A damaged index
+// is refused as a whole (the fleet is indexed again), or consistent enough to
+// be queried within its bounds (run it under a sanitizer build too).
+//------------------------------------------------------------------------------
+class FleetIndexTest : public QObject
+{
+    Q_OBJECT
+    private slots:
+        void initTestCase();
+        void roundTrip();
+        void truncated();
+        void corrupted();
+    private:
+        // Data
+        QTemporaryDir _dir;
+        // Helpers
+        QString path(const QString& name)const;
+        static QByteArray readFile(const QString& filename);
+        static bool writeFile(const QString& filename, const QByteArray& data);
+        static void patch32(QByteArray& data, int offset, quint32 value);
+        static void patch64(QByteArray& data, int offset, quint64 value);
+        static quint64 field64(const QByteArray& data, int offset);
+        void writeStation(uint serial, const QString& ip, const QString& mode);
+        bool buildFleetIndex(FleetIndex& index, FleetIndex::BuildStats& stats);
+        static void queryFleetIndex(const FleetIndex& index);
+        static void compareFleetIndex(const FleetIndex& index);
+};
+//------------------------------------------------------------------------------
+// Test cases
+//------------------------------------------------------------------------------
+void FleetIndexTest::initTestCase(){
+    QVERIFY(_dir.isValid());
+}
+//------------------------------------------------------------------------------
+void FleetIndexTest::roundTrip(){
+    writeStation(30001,"167772161","A");    // 10.0.0.1
+    writeStation(30002,"167772161","B");
+    writeStation(30003,"167772417","A");    // 10.0.1.1
+    QDir(path("stations")).mkpath("30004");
+    QVERIFY(writeFile(path("stations/30004/station.xml"),
+                      "<ConfigurationEntries><Category name=\"Ethernet\">"));
+    QDir(path("stations")).mkpath("notAStation");
+
+    FleetIndex index;
+    FleetIndex::BuildStats stats;
+    QVERIFY(buildFleetIndex(index,stats));
+    QCOMPARE(stats.stationCount,3u);
+    QCOMPARE(stats.parsedCount,3u);
+    QCOMPARE(stats.reusedCount,0u);
+    QCOMPARE(stats.failedCount,1u);   // the unterminated one
+    compareFleetIndex(index);
+
+    // Reopened as is
+    FleetIndex reopened;
+    QVERIFY(reopened.open(path("fleet.idx")));
+    QCOMPARE(reopened.stationCount(),3u);
+    QCOMPARE(reopened.rowCount(),index.rowCount());
+    compareFleetIndex(reopened);
+    reopened.close();
+
+    // Rebuilt: the unchanged stations are carried over, not parsed again
+    FleetIndex::BuildStats rebuildStats;
+    QVERIFY(buildFleetIndex(index,rebuildStats));
+    QCOMPARE(rebuildStats.stationCount,3u);
+    QCOMPARE(rebuildStats.parsedCount,0u);
+    QCOMPARE(rebuildStats.reusedCount,3u);
+    QCOMPARE(rebuildStats.failedCount,1u);
+    compareFleetIndex(index);
+}
+//------------------------------------------------------------------------------
+void FleetIndexTest::truncated(){
+    const QByteArray data = readFile(path("fleet.idx"));
+    QVERIFY(!data.isEmpty());
+    for(int size=0;size<data.size();++size){
+        QVERIFY(writeFile(path("truncated.fidx"),data.left(size)));
+        FleetIndex index;
+        QVERIFY2(!index.open(path("truncated.fidx")),
+                 qPrintable(QString("truncated to %1 bytes").arg(size)));
+        QVERIFY(!index.isOpen());
+    }
+}
+//------------------------------------------------------------------------------
+void FleetIndexTest::corrupted(){
+    // Native order: magic, version, byte order mark, station/path/value/row
+    // counts, reserved, then the section offsets from 32 and the file size
+    const QByteArray data = readFile(path("fleet.idx"));
+    const int cRowCount = 24, cRowValueOffset = 80, cValueBlobOffset = 96;
+    const quint64 rowValue = field64(data,cRowValueOffset);
+
+    QByteArray bad = data;
+    patch32(bad,cRowCount,0xffffffff);
+    QVERIFY(writeFile(path("corrupted.fidx"),bad));
+    FleetIndex index;
+    QVERIFY2(!index.open(path("corrupted.fidx")),"row count");
+
+    bad = data;
+    patch64(bad,cRowValueOffset,quint64(data.size()));
+    QVERIFY(writeFile(path("corrupted.fidx"),bad));
+    QVERIFY2(!index.open(path("corrupted.fidx")),"row value offset");
+
+    bad = data;
+    patch64(bad,cValueBlobOffset,quint64(data.size())+1);
+    QVERIFY(writeFile(path("corrupted.fidx"),bad));
+    QVERIFY2(!index.open(path("corrupted.fidx")),"value blob offset");
+
+    bad = data;
+    quint32 valueId = 0xffffffff;
+    memcpy(bad.data()+rowValue,&valueId,sizeof(valueId));
+    QVERIFY(writeFile(path("corrupted.fidx"),bad));
+    QVERIFY2(!index.open(path("corrupted.fidx")),"value id");
+
+    // Any single byte: refused, or consistent enough to be queried
+    for(int i=0;i<data.size();++i){
+        bad = data;
+        bad[i] = char(~bad.at(i));
+        QVERIFY(writeFile(path("corrupted.fidx"),bad));
+        if(index.open(path("corrupted.fidx")))
+            queryFleetIndex(index);
+        index.close();
+    }
+}
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+QString FleetIndexTest::path(const QString& name)const{
+    return _dir.filePath(name);
+}
+//------------------------------------------------------------------------------
+QByteArray FleetIndexTest::readFile(const QString& filename){
+    QFile file(filename);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+//------------------------------------------------------------------------------
+bool FleetIndexTest::writeFile(const QString& filename,
+    const QByteArray& data)
+{
+    QFile file(filename);
+    return file.open(QIODevice::WriteOnly | QIODevice::Truncate) &&
+           file.write(data)==data.size();
+}
+//------------------------------------------------------------------------------
+void FleetIndexTest::patch32(QByteArray& data, int offset, quint32 value){
+    if(offset+4<=data.size())
+        memcpy(data.data()+offset,&value,sizeof(value));
+}
+//------------------------------------------------------------------------------
+void FleetIndexTest::patch64(QByteArray& data, int offset, quint64 value){
+    if(offset+8<=data.size())
+        memcpy(data.data()+offset,&value,sizeof(value));
+}
+//------------------------------------------------------------------------------
+quint64 FleetIndexTest::field64(const QByteArray& data, int offset){
+    quint64 value = 0;
+    if(offset+8<=data.size())
+        memcpy(&value,data.constData()+offset,sizeof(value));
+    return value;
+}
+//------------------------------------------------------------------------------
+void FleetIndexTest::writeStation(uint serial, const QString& ip,
+    const QString& mode)
+{
+    QDir(path("stations")).mkpath(QString::number(serial));
+    QString xml = QString(
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<ConfigurationEntries version=\"1.5.6\">\n"
+        "  <Category name=\"Ethernet\">\n"
+        "    <Entry name=\"StaticIp\" id=\"0x2f0c\">\n"
+        "      <Element name=\"Ip Address\" type=\"ipv4\">%1</Element>\n"
+        "      <Element name=\"Mode\" type=\"string\">%2</Element>\n"
+        "    </Entry>\n"
+        "  </Category>\n"
+        "</ConfigurationEntries>\n").arg(ip,mode);
+    QVERIFY(writeFile(path(QString("stations/%1/station.xml").arg(serial)),
+                      xml.toUtf8()));
+}
+//------------------------------------------------------------------------------
+bool FleetIndexTest::buildFleetIndex(FleetIndex& index,
+    FleetIndex::BuildStats& stats)
+{
+    return index.build(path("stations"),"station.xml",path("fleet.idx"),stats);
+}
+//------------------------------------------------------------------------------
+void FleetIndexTest::queryFleetIndex(const FleetIndex& index){
+    // Every path and value of every station: the queries do not check ids
+    // against the file, open() does it once for all
+    QBitArray all(int(index.stationCount()),true);
+    for(int p=0;p<int(index.pathCount());++p){
+        index.path(p);
+        index.countBy(p,all);
+        index.histogram(p,all,4);
+    }
+    for(uint s=0;s<index.stationCount();++s)
+        index.stationSerial(s);
+}
+//------------------------------------------------------------------------------
+void FleetIndexTest::compareFleetIndex(const FleetIndex& index){
+    // What the stations of roundTrip() hold
+    queryFleetIndex(index);
+    QCOMPARE(index.stationCount(),3u);
+    QCOMPARE(index.rowCount(),6u);
+    QCOMPARE(index.stationSerial(0),30001u);
+    QCOMPARE(index.stationSerial(2),30003u);
+    QVector<int> ipPaths = index.findPaths("Element(Ip Address)");
+    QVector<int> modePaths = index.findPaths("Element(Mode)");
+    QCOMPARE(ipPaths.size(),1);
+    QCOMPARE(modePaths.size(),1);
+    QCOMPARE(index.path(modePaths.at(0)),
+             QString("ConfigurationEntries(*)/Category(Ethernet)/"
+                     "Entry(StaticIp)/Element(Mode)"));
+    QVERIFY(index.isIPv4Path(ipPaths.at(0)));
+    QVERIFY(!index.isIPv4Path(modePaths.at(0)));
+
+    QBitArray all(int(index.stationCount()),true);
+    QVector<FleetIndex::ValueCount_t> modes = index.countBy(modePaths.at(0),all);
+    QCOMPARE(modes.size(),2);
+    QVERIFY(modes.at(0)==FleetIndex::ValueCount_t("A",2));
+    QVERIFY(modes.at(1)==FleetIndex::ValueCount_t("B",1));
+
+    QVector<FleetIndex::Condition> conditions;
+    FleetIndex::Condition mode = { modePaths.at(0), FleetIndex::coEqual, "A" };
+    FleetIndex::Condition ip = { ipPaths.at(0), FleetIndex::coEqual, "10.0.0.1" };
+    conditions << mode << ip;
+    QBitArray selected = index.select(conditions);
+    QCOMPARE(selected.count(true),1);
+    QVERIFY(selected.testBit(0));
+}
+//------------------------------------------------------------------------------
+
+QTEST_GUILESS_MAIN(FleetIndexTest)
+
+#include "fleetIndexTest.moc"
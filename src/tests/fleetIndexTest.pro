@@ -0,0 +1,22 @@
+# Qt Test of the fleet index: built over a few stations in a temporary
+# directory, reopened and rebuilt, then truncated and corrupted copies. Built
+# by ../qMiraProbeXMLCheckAll.pro, after the core library; run by
+# 'make check'.
+
+QT += core testlib
+QT -= gui
+CONFIG += console c++14 testcase
+CONFIG -= app_bundle
+
+TARGET = fleetIndexTest
+
+INCLUDEPATH += ..
+
+SOURCES += \
+        fleetIndexTest.cpp \
+        ../fleetIndex.cpp
+
+HEADERS += \
+        ../fleetIndex.h
+
+include(../core/core.pri)
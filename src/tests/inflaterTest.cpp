@@ -0,0 +1,216 @@
+#include "inflater.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+
+//------------------------------------------------------------------------------
+// Inflater tests
+//------------------------------------------------------------------------------
+// The three kinds of DEFLATE block (stored, fixed and dynamic Huffman codes),
+// the streams being those zlib writes for the same text: decoded whole, then
+// with the input trickling in a byte at a time and the output taken in odd
+// sized pieces, then truncated at every length and with corrupted bytes. A
+// truncated stream always fails; a corrupted one may decode to something,
+// but ends in bounded time and never reads or writes out of the buffers
+// (run it under a sanitizer build too). Exit status is the number of failed
+// checks.
+//------------------------------------------------------------------------------
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition) check((condition),#condition,__LINE__)
+
+//------------------------------------------------------------------------------
+void check(bool condition, const char *text, int line){
+    if(!condition){
+        std::printf("FAIL line %d: %s\n",line,text);
+        ++failures;
+    }
+}
+//------------------------------------------------------------------------------
+// zlib, raw deflate (wbits -15), level 9 and Z_FIXED, of shortText()
+const uint8_t fixedStream[] = {
+    0x73, 0xad, 0x28, 0x28, 0xca, 0x2c, 0xcb, 0x4c, 0x54, 0xf0, 0xcd, 0x2c,
+    0x4a, 0x54, 0x28, 0x28, 0xca, 0x4f, 0x4a, 0x2d, 0x56, 0x48, 0xce, 0xcf,
+    0x4b, 0xcb, 0x4c, 0x2f, 0x2d, 0x4a, 0x2c, 0xc9, 0xcc, 0xcf, 0x2b, 0xd6,
+    0x51, 0x70, 0x25, 0xac, 0x88, 0x0b, 0x00,
+};
+// zlib, raw deflate (wbits -15), level 9, of sheetText()
+const uint8_t dynamicStream[] = {
+    0x7d, 0xd3, 0x4d, 0x6a, 0x02, 0x41, 0x14, 0x04, 0xe0, 0x7d, 0x4e, 0x31,
+    0x07, 0x18, 0x86, 0xa9, 0xea, 0xd7, 0x7f, 0xcb, 0x11, 0x86, 0x20, 0x41,
+    0x23, 0x6a, 0x08, 0xb9, 0xff, 0x45, 0x12, 0x6d, 0xe7, 0xf5, 0x66, 0x52,
+    0x8a, 0x8b, 0x96, 0x5a, 0xd4, 0xe3, 0xa3, 0x4e, 0xc7, 0xeb, 0x32, 0xdc,
+    0xce, 0xe3, 0xe5, 0xfa, 0x79, 0x58, 0x87, 0xe3, 0x65, 0xbc, 0x7d, 0x1d,
+    0xce, 0xeb, 0x7d, 0x38, 0x2d, 0xb7, 0x8f, 0xf1, 0x7d, 0xb9, 0xaf, 0xdf,
+    0xcb, 0xcf, 0x5b, 0x98, 0xff, 0x3e, 0x23, 0xe6, 0xe9, 0xf9, 0x1d, 0x19,
+    0xe3, 0xb4, 0xfd, 0xfc, 0x6f, 0x3c, 0x53, 0xb9, 0x3d, 0x31, 0x85, 0xbc,
+    0x17, 0x43, 0x8b, 0xc1, 0xda, 0x93, 0x53, 0xb6, 0xbd, 0x18, 0x5b, 0x8c,
+    0x68, 0xcf, 0x30, 0x01, 0xd8, 0xcb, 0x85, 0x57, 0xae, 0xb4, 0xa7, 0x4d,
+    0xb0, 0xb2, 0x97, 0xb3, 0x96, 0x0b, 0xd1, 0xcb, 0x96, 0x28, 0xae, 0x30,
+    0x6e, 0x6d, 0x49, 0x8a, 0x33, 0xac, 0x6e, 0x75, 0xab, 0xb8, 0x22, 0xa6,
+    0xad, 0xac, 0x25, 0x71, 0x44, 0x0a, 0x5b, 0xd7, 0x12, 0xc4, 0x0d, 0xb9,
+    0x57, 0xa5, 0x92, 0xc8, 0x2e, 0x81, 0xa8, 0x28, 0x8a, 0x53, 0xa0, 0x2a,
+    0x8b, 0xea, 0x16, 0x0c, 0xca, 0xa2, 0x76, 0x0b, 0x41, 0x81, 0xd9, 0x29,
+    0xa2, 0x90, 0x00, 0x5c, 0xa2, 0x0a, 0x08, 0xc0, 0x21, 0x40, 0x41, 0x01,
+    0x3a, 0x05, 0x92, 0xb0, 0x40, 0x70, 0x0b, 0xce, 0x02, 0x03, 0xe6, 0x6d,
+    0x69, 0x02, 0x03, 0xe6, 0x18, 0x14, 0x16, 0x88, 0x6e, 0x91, 0x04, 0x05,
+    0x52, 0x9f, 0xc5, 0x2c, 0x28, 0x90, 0x3a, 0x45, 0x50, 0x16, 0xb9, 0xcf,
+    0x22, 0x2b, 0x8c, 0xd2, 0x67, 0x01, 0xa5, 0x51, 0x5c, 0x83, 0xa6, 0x34,
+    0xaa, 0x6b, 0x04, 0x81, 0xf1, 0x10, 0x78, 0xb5, 0xcd, 0xc2, 0x82, 0xe8,
+    0x65, 0x21, 0x2c, 0x88, 0x3e, 0x0c, 0x13, 0x18, 0x64, 0x1f, 0x46, 0x11,
+    0x1a, 0x8f, 0x35, 0x6c, 0xc3, 0xa0, 0xd0, 0x60, 0x70, 0x0d, 0x61, 0x41,
+    0x73, 0x0b, 0x13, 0x14, 0x8c, 0x4e, 0x51, 0x84, 0x04, 0x63, 0xdf, 0x05,
+    0x84, 0x04, 0x53, 0xdf, 0x45, 0x54, 0x14, 0xd9, 0x29, 0x50, 0xff, 0xb5,
+    0xf8, 0x05,
+};
+
+//------------------------------------------------------------------------------
+std::string shortText(){
+    return "Exprivia Mira probes configurations, "
+           "Exprivia Mira probes configurations\n";
+}
+//------------------------------------------------------------------------------
+// A probe sheet like CSV export, 1618 bytes
+std::string sheetText(){
+    std::string text = "MIRA SN,PROBE IP,SUBNET MASK,GATEWAY\n";
+    char line[64];
+    for(int i=0;i<40;++i){
+        std::snprintf(line,sizeof(line),"%d,10.0.%d.%d,255.255.255.0,10.0.%d.1\n",
+                      30000+i*7,i%5,(i*37)%250,i%5);
+        text += line;
+    }
+    return text;
+}
+//------------------------------------------------------------------------------
+// The text as a single, last, stored block
+std::string storedStream(const std::string& text){
+    const size_t size = text.size();
+    std::string stream;
+    stream += char(0x01);
+    stream += char(size&0xff);
+    stream += char(size>>8);
+    stream += char(~size&0xff);
+    stream += char((~size>>8)&0xff);
+    return stream+text;
+}
+//------------------------------------------------------------------------------
+struct Source {
+    const uint8_t *data;
+    size_t size;
+    size_t pos;
+    size_t chunk;   // most bytes handed over per call
+};
+//------------------------------------------------------------------------------
+size_t readSource(void *opaque, uint8_t *buffer, size_t size){
+    Source& source = *static_cast<Source *>(opaque);
+    size_t count = source.size-source.pos;
+    if(count>size)
+        count = size;
+    if(count>source.chunk)
+        count = source.chunk;
+    std::memcpy(buffer,source.data+source.pos,count);
+    source.pos += count;
+    return count;
+}
+//------------------------------------------------------------------------------
+// Decodes the whole stream, out pieces of piece bytes; false if it failed.
+// A stream decoding to more than limit bytes is cut short (corrupted input
+// may legitimately expand to a lot).
+bool inflate(const std::string& stream, size_t chunk, size_t piece,
+             std::string& result, size_t limit = 1<<20){
+    Source source = {
+        reinterpret_cast<const uint8_t *>(stream.data()), stream.size(), 0, chunk
+    };
+    Inflater inflater;
+    inflater.reset(readSource,&source);
+    result.clear();
+    uint8_t out[4096];
+    for(;;){
+        long count = inflater.read(out,piece);
+        if(count<0){
+            CHECK(inflater.failed());
+            return false;
+        }
+        result.append(reinterpret_cast<const char *>(out),size_t(count));
+        if(size_t(count)<piece){
+            CHECK(inflater.atEnd());
+            return true;
+        }
+        if(result.size()>limit)
+            return false;
+    }
+}
+//------------------------------------------------------------------------------
+void roundTrip(const char *name, const std::string& stream,
+               const std::string& text){
+    static const size_t pieces[] = { 1, 7, 258, 4096 };
+    std::string result;
+    for(size_t i=0;i<sizeof(pieces)/sizeof(pieces[0]);++i){
+        bool inflated = inflate(stream,size_t(-1),pieces[i],result) &&
+                        result==text;
+        if(!inflated)
+            std::printf("  %s, %zu byte pieces\n",name,pieces[i]);
+        CHECK(inflated);
+        inflated = inflate(stream,1,pieces[i],result) && result==text;
+        if(!inflated)
+            std::printf("  %s, %zu byte pieces, input a byte at a time\n",
+                        name,pieces[i]);
+        CHECK(inflated);
+    }
+}
+//------------------------------------------------------------------------------
+void truncated(const char *name, const std::string& stream){
+    std::string result;
+    for(size_t size=0;size<stream.size();++size){
+        bool inflated = inflate(stream.substr(0,size),size_t(-1),4096,result);
+        if(inflated)
+            std::printf("  %s, truncated to %zu bytes\n",name,size);
+        CHECK(!inflated);
+    }
+}
+//------------------------------------------------------------------------------
+void corrupted(const std::string& stream, uint32_t seed){
+    std::string result;
+    for(int i=0;i<5000;++i){
+        std::string bad = stream;
+        for(int j=0;j<=i%3;++j){
+            seed = seed*1664525u+1013904223u;
+            size_t pos = (seed>>8)%bad.size();
+            seed = seed*1664525u+1013904223u;
+            bad[pos] = char(seed>>24);
+        }
+        inflate(bad,i%2 ? 3 : size_t(-1),i%2 ? 13 : 4096,result);
+    }
+}
+//------------------------------------------------------------------------------
+
+} // namespace
+
+//------------------------------------------------------------------------------
+int main(){
+    const std::string fixed(reinterpret_cast<const char *>(fixedStream),
+                            sizeof(fixedStream));
+    const std::string dynamic(reinterpret_cast<const char *>(dynamicStream),
+                              sizeof(dynamicStream));
+    const std::string stored = storedStream(sheetText());
+
+    roundTrip("stored",stored,sheetText());
+    roundTrip("fixed",fixed,shortText());
+    roundTrip("dynamic",dynamic,sheetText());
+
+    truncated("stored",stored);
+    truncated("fixed",fixed);
+    truncated("dynamic",dynamic);
+
+    corrupted(stored,1);
+    corrupted(fixed,2);
+    corrupted(dynamic,3);
+
+    std::printf("%s: %d failed checks\n",failures ? "FAIL" : "PASS",failures);
+    return failures;
+}
+//------------------------------------------------------------------------------
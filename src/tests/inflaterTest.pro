@@ -0,0 +1,17 @@
+# Stored, fixed and dynamic Huffman DEFLATE streams through the Inflater of
+# the .xlsx input, whole, cut short and corrupted (no Qt needed). Run by
+# 'make check' or on its own: ./inflaterTest (exit status: failed checks).
+
+CONFIG += console c++14 testcase
+CONFIG -= qt app_bundle
+
+TARGET = inflaterTest
+
+INCLUDEPATH += ..
+
+SOURCES += \
+        inflaterTest.cpp \
+        ../inflater.cpp
+
+HEADERS += \
+        ../inflater.h
@@ -0,0 +1,159 @@
+#include "stationOffsetIndex.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtEndian>
+#include <QtTest>
+
+
+//------------------------------------------------------------------------------
+// class OffsetIndexTest
+//------------------------------------------------------------------------------
+// The station offset index a run keeps for the next one: written, read back,
+// then read back truncated at every length and with corrupted fields. A
+// damaged index is refused as a whole (the stations are parsed again), never
+// half used, and never read out of its bounds (run it under a sanitizer
+// build too).
+//------------------------------------------------------------------------------
+class OffsetIndexTest : public QObject
+{
+    Q_OBJECT
+    private slots:
+        void initTestCase();
+        void roundTrip();
+        void truncated();
+        void corrupted();
+    private:
+        // Constants
+        enum {
+            cPlanSignature = 0x5eed1234,
+            cCheckCount = 3,
+        };
+        // Data
+        QTemporaryDir _dir;
+        // Helpers
+        QString path(const QString& name)const;
+        static QByteArray readFile(const QString& filename);
+        static bool writeFile(const QString& filename, const QByteArray& data);
+        static void patchBigEndian32(QByteArray& data, int offset,
+                                     quint32 value);
+};
+//------------------------------------------------------------------------------
+// Test cases
+//------------------------------------------------------------------------------
+void OffsetIndexTest::initTestCase(){
+    QVERIFY(_dir.isValid());
+}
+//------------------------------------------------------------------------------
+void OffsetIndexTest::roundTrip(){
+    StationOffsetIndex index;
+    index.clear(cPlanSignature);
+    QVector<StationOffsetIndex::Slot> valueSlots;
+    StationOffsetIndex::Slot first = { 0, 100, 130, 9 };
+    StationOffsetIndex::Slot last = { 2, 400, 428, 11 };
+    valueSlots << first << last;
+    index.insert(30001,2048,1600000000000ll,valueSlots);
+    index.insert(30002,4096,1600000001000ll,QVector<StationOffsetIndex::Slot>());
+    QVERIFY(index.isDirty());
+    QVERIFY(index.save(path("offsets.idx")));
+    QVERIFY(!index.isDirty());
+
+    StationOffsetIndex loaded;
+    QVERIFY(loaded.load(path("offsets.idx"),cPlanSignature,cCheckCount));
+    QCOMPARE(loaded.size(),2);
+    const StationOffsetIndex::Entry *entry = loaded.find(30001,2048,1600000000000ll);
+    QVERIFY(entry);
+    QCOMPARE(entry->valueSlots.size(),2);
+    QCOMPARE(entry->valueSlots.at(1).checkIndex,2);
+    QCOMPARE(entry->valueSlots.at(1).tagOffset,qint64(400));
+    QCOMPARE(entry->valueSlots.at(1).offset,qint64(428));
+    QCOMPARE(entry->valueSlots.at(1).length,11);
+    QVERIFY(loaded.find(30002,4096,1600000001000ll));
+
+    // Another file than the one indexed
+    QVERIFY(!loaded.find(30001,2049,1600000000000ll));
+    QVERIFY(!loaded.find(30001,2048,1600000000001ll));
+    QVERIFY(!loaded.find(30003,2048,1600000000000ll));
+
+    // Another check plan
+    QVERIFY(!loaded.load(path("offsets.idx"),cPlanSignature+1,cCheckCount));
+    QCOMPARE(loaded.size(),0);
+    QVERIFY(!loaded.load(path("offsets.idx"),cPlanSignature,cCheckCount-1));
+    QCOMPARE(loaded.size(),0);
+}
+//------------------------------------------------------------------------------
+void OffsetIndexTest::truncated(){
+    const QByteArray data = readFile(path("offsets.idx"));
+    QVERIFY(!data.isEmpty());
+    for(int size=0;size<data.size();++size){
+        QVERIFY(writeFile(path("truncated.idx"),data.left(size)));
+        StationOffsetIndex index;
+        QVERIFY2(!index.load(path("truncated.idx"),cPlanSignature,cCheckCount),
+                 qPrintable(QString("truncated to %1 bytes").arg(size)));
+        QCOMPARE(index.size(),0);
+    }
+}
+//------------------------------------------------------------------------------
+void OffsetIndexTest::corrupted(){
+    // Big endian: magic, version, signature, entry count, then per entry
+    // serial, size, lastModified, slot count and its slots (checkIndex,
+    // tagOffset, offset, length)
+    const QByteArray data = readFile(path("offsets.idx"));
+    struct Corruption {
+        const char *what;
+        int offset;
+        quint32 value;
+    };
+    static const Corruption corruptions[] = {
+        { "magic", 0, 0x4D534F48 },
+        { "version", 4, 2 },
+        { "entry count", 12, 0xffffffff },
+        { "entry count", 12, 3 },
+        { "slot count", 16+20, 0x7fffffff },
+        { "slot count", 16+20, cCheckCount+1 },
+        { "check index", 16+24, cCheckCount },
+        { "check index", 16+24, 0xffffffff },
+        { "length", 16+24+20, 0xffffffff },
+    };
+    for(size_t i=0;i<sizeof(corruptions)/sizeof(corruptions[0]);++i){
+        QByteArray bad = data;
+        patchBigEndian32(bad,corruptions[i].offset,corruptions[i].value);
+        QVERIFY(writeFile(path("corrupted.idx"),bad));
+        StationOffsetIndex index;
+        QVERIFY2(!index.load(path("corrupted.idx"),cPlanSignature,cCheckCount),
+                 corruptions[i].what);
+        QCOMPARE(index.size(),0);
+    }
+}
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+QString OffsetIndexTest::path(const QString& name)const{
+    return _dir.filePath(name);
+}
+//------------------------------------------------------------------------------
+QByteArray OffsetIndexTest::readFile(const QString& filename){
+    QFile file(filename);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+//------------------------------------------------------------------------------
+bool OffsetIndexTest::writeFile(const QString& filename,
+    const QByteArray& data)
+{
+    QFile file(filename);
+    return file.open(QIODevice::WriteOnly | QIODevice::Truncate) &&
+           file.write(data)==data.size();
+}
+//------------------------------------------------------------------------------
+void OffsetIndexTest::patchBigEndian32(QByteArray& data, int offset,
+    quint32 value)
+{
+    // The index is written by a QDataStream
+    if(offset+4<=data.size())
+        qToBigEndian(value,data.data()+offset);
+}
+//------------------------------------------------------------------------------
+
+QTEST_GUILESS_MAIN(OffsetIndexTest)
+
+#include "offsetIndexTest.moc"
@@ -0,0 +1,19 @@
+# Qt Test of the station offset index: a round trip, then truncated and
+# corrupted copies, in a temporary directory. Built by
+# ../qMiraProbeXMLCheckAll.pro; run by 'make check'.
+
+QT += core testlib
+QT -= gui
+CONFIG += console c++14 testcase
+CONFIG -= app_bundle
+
+TARGET = offsetIndexTest
+
+INCLUDEPATH += ..
+
+SOURCES += \
+        offsetIndexTest.cpp \
+        ../stationOffsetIndex.cpp
+
+HEADERS += \
+        ../stationOffsetIndex.h
@@ -0,0 +1,331 @@
+#include "probeSheetReader.h"
+
+#include <QBuffer>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtEndian>
+#include <QtTest>
+#include <QVector>
+
+
+//------------------------------------------------------------------------------
+// class ProbeSheetTest
+//------------------------------------------------------------------------------
+// ProbeSheetReader on both sheet formats: a CSV export read a row at a time,
+// as the streaming check does, the project's workbook read against its own
+// CSV export, then both cut short and corrupted. A CSV has no framing, a
+// shorter one is a sheet too: the probes read from it must be rows of the
+// full one. A workbook cut short is refused, and so is one whose entries no
+// longer inflate to what their size and CRC-32 say; it is never read out of
+// its buffers (run it under a sanitizer build too).
+//------------------------------------------------------------------------------
+class ProbeSheetTest : public QObject
+{
+    Q_OBJECT
+    private slots:
+        void initTestCase();
+        void csv();
+        void csvRow();
+        void csvHeader();
+        void csvTruncated();
+        void xlsx();
+        void xlsxTruncated();
+        void xlsxCorrupted();
+    private:
+        // Data
+        QTemporaryDir _dir;
+        // Helpers
+        QString path(const QString& name)const;
+        static QString projectFile(const QString& suffix);
+        static QByteArray readFile(const QString& filename);
+        static bool writeFile(const QString& filename, const QByteArray& data);
+        static bool readSheet(const QString& filename, ProbeSheet& sheet,
+                              QString& errorString);
+        static void compareProbes(const ProbeSheet& part, const ProbeSheet& sheet);
+        static QVector<int> entryBytes(const QByteArray& zip,
+                                       const QStringList& names);
+        static const char *sheetText();
+};
+//------------------------------------------------------------------------------
+// Test cases
+//------------------------------------------------------------------------------
+void ProbeSheetTest::initTestCase(){
+    QVERIFY(_dir.isValid());
+}
+//------------------------------------------------------------------------------
+void ProbeSheetTest::csv(){
+    QVERIFY(writeFile(path("sheet.csv"),sheetText()));
+    ProbeSheet sheet;
+    QString errorString;
+    QVERIFY2(readSheet(path("sheet.csv"),sheet,errorString),
+             qPrintable(errorString));
+
+    QCOMPARE(sheet.central0IP.toString(),QString("192.168.1.10"));
+    QCOMPARE(sheet.central0Port.toUInt32(),4000u);
+    QCOMPARE(sheet.central0SNTP.toString(),QString("192.168.1.11"));
+    QCOMPARE(sheet.globalSNTP.toString(),QString("192.168.1.12"));
+    QCOMPARE(sheet.newUpdaterIP.toString(),QString("192.168.1.13"));
+    QCOMPARE(sheet.newUpdaterPort.toUInt32(),8080u);
+
+    QCOMPARE(sheet.probes.size(),3);
+    QCOMPARE(sheet.probes.value(30001).ip.toString(),QString("10.0.0.2"));
+    QCOMPARE(sheet.probes.value(30002).gateway.toString(),QString("10.0.1.1"));
+    QCOMPARE(sheet.probes.value(30003).ip.toString(),QString("10.0.2.2"));
+    QCOMPARE(sheet.probes.value(30003).netmask.toString(),QString("255.255.255.0"));
+    QCOMPARE(sheet.diagnostics.size(),1);
+    QVERIFY(sheet.diagnostics.at(0).contains("Probe 30004 (CSV line 5)"));
+}
+//------------------------------------------------------------------------------
+void ProbeSheetTest::csvRow(){
+    ProbeSheet sheet;
+    ProbeSheetReader reader(sheet);
+    QStringList row;
+
+    QByteArray data = "a,\"b,\"\"c\"\"\",,\"d\ne\"\r\nlast";
+    QBuffer buffer(&data);
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+    QVERIFY(reader.readCSVRow(1,buffer,row));
+    QCOMPARE(row,QStringList() << "a" << "b,\"c\"" << "" << "d\ne");
+    QVERIFY(reader.readCSVRow(2,buffer,row));
+    QCOMPARE(row,QStringList() << "last");
+    QVERIFY(!reader.readCSVRow(3,buffer,row));
+    QVERIFY(reader.errorString().isEmpty());
+    buffer.close();
+
+    data = "a,\"b\nc";
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+    QVERIFY(!reader.readCSVRow(7,buffer,row));
+    QCOMPARE(reader.errorString(),
+             QString("CSV line 7: End-of-file found while inside quotes."));
+}
+//------------------------------------------------------------------------------
+void ProbeSheetTest::csvHeader(){
+    ProbeSheet sheet;
+    QString errorString;
+
+    QByteArray data = sheetText();
+    data.replace("GATEWAY,","GATE WAY,");
+    QVERIFY(writeFile(path("missing.csv"),data));
+    QVERIFY(!readSheet(path("missing.csv"),sheet,errorString));
+    QCOMPARE(errorString,QString("Bailing out"));
+
+    data = sheetText();
+    data.replace("NOTES","PROBE IP");
+    QVERIFY(writeFile(path("duplicated.csv"),data));
+    QVERIFY(!readSheet(path("duplicated.csv"),sheet,errorString));
+    QCOMPARE(errorString,QString("CSV header: duplicated column 'PROBE IP'."));
+
+    // Read again with the same columns, as a second profile does
+    QVERIFY(writeFile(path("sheet.csv"),sheetText()));
+    QVERIFY2(readSheet(path("sheet.csv"),sheet,errorString),
+             qPrintable(errorString));
+    QVERIFY2(readSheet(path("sheet.csv"),sheet,errorString),
+             qPrintable(errorString));
+
+    QVERIFY(!readSheet(path("none.csv"),sheet,errorString));
+    QVERIFY(!errorString.isEmpty());
+}
+//------------------------------------------------------------------------------
+void ProbeSheetTest::csvTruncated(){
+    const QByteArray data = sheetText();
+    QVERIFY(writeFile(path("sheet.csv"),data));
+    ProbeSheet sheet;
+    QString errorString;
+    QVERIFY(readSheet(path("sheet.csv"),sheet,errorString));
+
+    const int quoteBegin = data.indexOf("\"two"), quoteEnd = data.indexOf("\"\n");
+    for(int size=0;size<data.size();++size){
+        QVERIFY(writeFile(path("truncated.csv"),data.left(size)));
+        ProbeSheet part;
+        bool read = readSheet(path("truncated.csv"),part,errorString);
+        if(size>quoteBegin && size<=quoteEnd){
+            QVERIFY(!read);
+            QVERIFY(errorString.contains("End-of-file found while inside quotes"));
+        }
+        compareProbes(part,sheet);
+    }
+}
+void ProbeSheetTest::xlsx(){
+    ProbeSheet workbookSheet;
+    QString errorString;
+    QVERIFY2(readSheet(projectFile(".xlsx"),workbookSheet,errorString),
+             qPrintable(errorString));
+    QVERIFY(workbookSheet.probes.size()>100);
+
+    // The CSV export is Windows-1252 (its header has no-break spaces)
+    ProbeSheet csvSheet;
+    if(!readSheet(projectFile(".csv"),csvSheet,errorString) &&
+       errorString=="Bailing out")
+        QSKIP("The CSV export header needs a Windows-1252 local 8-bit codec");
+    QVERIFY2(errorString.isEmpty(),qPrintable(errorString));
+
+    QCOMPARE(workbookSheet.central0IP.toInt32(),csvSheet.central0IP.toInt32());
+    QCOMPARE(workbookSheet.central0Port.toUInt32(),csvSheet.central0Port.toUInt32());
+    QCOMPARE(workbookSheet.central0SNTP.toInt32(),csvSheet.central0SNTP.toInt32());
+    QCOMPARE(workbookSheet.globalSNTP.toInt32(),csvSheet.globalSNTP.toInt32());
+    QCOMPARE(workbookSheet.newUpdaterIP.toInt32(),csvSheet.newUpdaterIP.toInt32());
+    QCOMPARE(workbookSheet.newUpdaterPort.toUInt32(),
+             csvSheet.newUpdaterPort.toUInt32());
+    QCOMPARE(workbookSheet.probes.size(),csvSheet.probes.size());
+    compareProbes(workbookSheet,csvSheet);
+    QCOMPARE(workbookSheet.diagnostics,csvSheet.diagnostics);
+}
+//------------------------------------------------------------------------------
+void ProbeSheetTest::xlsxTruncated(){
+    // The central directory is at the end: any cut loses it. Every size near
+    // the end, a sample of the others
+    const QByteArray data = readFile(projectFile(".xlsx"));
+    QVERIFY(!data.isEmpty());
+    ProbeSheet sheet;
+    QString errorString;
+    for(int size=0;size<data.size();size+=(data.size()-size>256 ? 97 : 1)){
+        QVERIFY(writeFile(path("truncated.xlsx"),data.left(size)));
+        QVERIFY2(!readSheet(path("truncated.xlsx"),sheet,errorString),
+                 qPrintable(QString("truncated to %1 bytes").arg(size)));
+        QVERIFY(!errorString.isEmpty());
+    }
+}
+//------------------------------------------------------------------------------
+void ProbeSheetTest::xlsxCorrupted(){
+    // One byte of the compressed data of an entry the reader goes through
+    // changed at a time (the block flags of the first byte and the empty
+    // closing block Excel ends an entry with left aside). The change is
+    // refused, unless the entry still inflates to the same bytes (a match
+    // distance moved to equal text): then it is the same sheet
+    const QByteArray data = readFile(projectFile(".xlsx"));
+    QVERIFY(!data.isEmpty());
+    QVector<int> bytes = entryBytes(data,QStringList()
+                                    << "xl/workbook.xml"
+                                    << "xl/_rels/workbook.xml.rels"
+                                    << "xl/sharedStrings.xml"
+                                    << "xl/worksheets/sheet1.xml");
+    QVERIFY(bytes.size()>1000);
+    ProbeSheet intactSheet;
+    QString errorString;
+    QVERIFY2(readSheet(projectFile(".xlsx"),intactSheet,errorString),
+             qPrintable(errorString));
+
+    ProbeSheet sheet;
+    quint32 seed = 1;
+    int refusedCount = 0;
+    for(int i=0;i<500;++i){
+        QByteArray bad = data;
+        seed = seed*1664525u+1013904223u;
+        int pos = bytes.at(int((seed>>8)%quint32(bytes.size())));
+        seed = seed*1664525u+1013904223u;
+        bad[pos] = char(bad.at(pos) ^ char(1+(seed>>24)%255));
+        QVERIFY(writeFile(path("corrupted.xlsx"),bad));
+        if(!readSheet(path("corrupted.xlsx"),sheet,errorString)){
+            QVERIFY2(!errorString.isEmpty(),
+                     qPrintable(QString("byte %1 changed").arg(pos)));
+            ++refusedCount;
+            continue;
+        }
+        QCOMPARE(sheet.probes.size(),intactSheet.probes.size());
+        compareProbes(sheet,intactSheet);
+        QCOMPARE(sheet.diagnostics,intactSheet.diagnostics);
+    }
+    QVERIFY2(refusedCount>=490,qPrintable(QString("%1 refused").arg(refusedCount)));
+}
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+QString ProbeSheetTest::path(const QString& name)const{
+    return _dir.filePath(name);
+}
+//------------------------------------------------------------------------------
+QString ProbeSheetTest::projectFile(const QString& suffix){
+    return QString(PROJECT_ROOT)+"Exprivia Mira probes configurations V2.1"+suffix;
+}
+//------------------------------------------------------------------------------
+QByteArray ProbeSheetTest::readFile(const QString& filename){
+    QFile file(filename);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+//------------------------------------------------------------------------------
+bool ProbeSheetTest::writeFile(const QString& filename, const QByteArray& data){
+    QFile file(filename);
+    return file.open(QIODevice::WriteOnly | QIODevice::Truncate) &&
+           file.write(data)==data.size();
+}
+//------------------------------------------------------------------------------
+bool ProbeSheetTest::readSheet(const QString& filename, ProbeSheet& sheet,
+    QString& errorString)
+{
+    // As ConfigurationCheck::readProbeSheet() does, short of failing the run
+    sheet.clear();
+    ProbeSheetReader reader(sheet);
+    if(!reader.open(filename)){
+        errorString = reader.errorString();
+        return false;
+    }
+    ProbeConfig probeConfig;
+    if(reader.readHeader(probeConfig)){
+        sheet.addProbe(reader.lineNumber(),probeConfig);
+        while(reader.readProbe(probeConfig))
+            sheet.addProbe(reader.lineNumber(),probeConfig);
+    }
+    errorString = reader.errorString();
+    return errorString.isEmpty() && !sheet.probes.isEmpty();
+}
+//------------------------------------------------------------------------------
+void ProbeSheetTest::compareProbes(const ProbeSheet& part,
+    const ProbeSheet& sheet)
+{
+    for(QMap<uint,ProbeConfig>::const_iterator it=part.probes.constBegin();
+        it!=part.probes.constEnd();
+        ++it)
+    {
+        QVERIFY2(sheet.probes.contains(it.key()),
+                 qPrintable(QString("probe %1").arg(it.key())));
+        const ProbeConfig& probeConfig = sheet.probes[it.key()];
+        QCOMPARE(it->ip.toInt32(),probeConfig.ip.toInt32());
+        QCOMPARE(it->netmask.toInt32(),probeConfig.netmask.toInt32());
+        QCOMPARE(it->gateway.toInt32(),probeConfig.gateway.toInt32());
+    }
+}
+//------------------------------------------------------------------------------
+QVector<int> ProbeSheetTest::entryBytes(const QByteArray& zip,
+    const QStringList& names)
+{
+    // Offsets of the compressed data of the named entries, found through the
+    // central directory as the reader does, short of their first byte and
+    // last 8 bytes
+    QVector<int> bytes;
+    const uchar *base = reinterpret_cast<const uchar *>(zip.constData());
+    int record = zip.lastIndexOf("PK\x05\x06");
+    if(record<0 || record+22>zip.size())
+        return bytes;
+    int pos = int(qFromLittleEndian<quint32>(base+record+16));
+    int entryCount = qFromLittleEndian<quint16>(base+record+10);
+    for(int i=0;i<entryCount && pos+46<=record;++i){
+        int nameLength = qFromLittleEndian<quint16>(base+pos+28);
+        QString name = QString::fromUtf8(zip.constData()+pos+46,nameLength);
+        int compressedSize = int(qFromLittleEndian<quint32>(base+pos+20));
+        int header = int(qFromLittleEndian<quint32>(base+pos+42));
+        pos += 46+nameLength+qFromLittleEndian<quint16>(base+pos+30)+
+               qFromLittleEndian<quint16>(base+pos+32);
+        if(!names.contains(name) || header+30>zip.size())
+            continue;
+        int begin = header+30+qFromLittleEndian<quint16>(base+header+26)+
+                    qFromLittleEndian<quint16>(base+header+28);
+        for(int b=begin+1;b<begin+compressedSize-8 && b<zip.size();++b)
+            bytes.append(b);
+    }
+    return bytes;
+}
+//------------------------------------------------------------------------------
+const char *ProbeSheetTest::sheetText(){
+    return "MIRA SN,PROBE IP,SUBNET MASK,GATEWAY,Central 0 IP,Central 0 SNTP,"
+               "Global NTP List,New Updater IP,NOTES\n"
+           "30001,10.0.0.2,255.255.255.0,10.0.0.1,192.168.1.10:4000,"
+               "192.168.1.11,192.168.1.12,192.168.1.13:8080,first\n"
+           "30002,10.0.1.2,255.255.255.0,10.0.1.1,,,,,\"two\nlines, quoted\"\n"
+           "\"30003\",\"10.0.2.2\",255.255.255.0,10.0.2.1\n"
+           "30004,10.0.3.2,255.255.255.0,\n";
+}
+//------------------------------------------------------------------------------
+
+QTEST_GUILESS_MAIN(ProbeSheetTest)
+
+#include "probeSheetTest.moc"
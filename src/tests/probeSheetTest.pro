@@ -0,0 +1,33 @@
+# Qt Test of ProbeSheetReader: CSV rows, headers and truncated CSV exports,
+# then the project's workbook against its CSV export, cut short and
+# corrupted. Built by ../qMiraProbeXMLCheckAll.pro, after the core library it
+# links; run by 'make check'.
+
+QT += core testlib
+QT -= gui
+CONFIG += console c++14 testcase
+CONFIG -= app_bundle
+
+TARGET = probeSheetTest
+
+# Where the project's probe sheet files are
+DEFINES += PROJECT_ROOT=\\\"$$PWD/../../\\\"
+
+INCLUDEPATH += ..
+
+SOURCES += \
+        probeSheetTest.cpp \
+        ../inflater.cpp \
+        ../probeSheet.cpp \
+        ../probeSheetReader.cpp \
+        ../startupSnapshot.cpp \
+        ../xlsxReader.cpp
+
+HEADERS += \
+        ../inflater.h \
+        ../probeSheet.h \
+        ../probeSheetReader.h \
+        ../startupSnapshot.h \
+        ../xlsxReader.h
+
+include(../core/core.pri)
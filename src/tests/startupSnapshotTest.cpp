@@ -0,0 +1,234 @@
+#include "probeSheet.h"
+#include "startupSnapshot.h"
+
+#include <cstring>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QtTest>
+
+
+//------------------------------------------------------------------------------
+// class StartupSnapshotTest
+//------------------------------------------------------------------------------
+// The startup snapshot of the probe sheet: saved by a cold start, loaded by
+// the next one, refused once the sheet changes, then opened truncated at
+// every length and with corrupted fields. A damaged snapshot is refused as a
+// whole (the sheet is read again), never half used, and never read out of
+// its bounds (run it under a sanitizer build too).
+//------------------------------------------------------------------------------
+class StartupSnapshotTest : public QObject
+{
+    Q_OBJECT
+    private slots:
+        void initTestCase();
+        void roundTrip();
+        void stale();
+        void truncated();
+        void corrupted();
+    private:
+        // Data
+        QTemporaryDir _dir;
+        // Helpers
+        QString path(const QString& name)const;
+        static QByteArray readFile(const QString& filename);
+        static bool writeFile(const QString& filename, const QByteArray& data);
+        static void patch32(QByteArray& data, int offset, quint32 value);
+        static void patch64(QByteArray& data, int offset, quint64 value);
+        void writeSnapshot();
+};
+//------------------------------------------------------------------------------
+// Test cases
+//------------------------------------------------------------------------------
+void StartupSnapshotTest::initTestCase(){
+    QVERIFY(_dir.isValid());
+}
+//------------------------------------------------------------------------------
+void StartupSnapshotTest::roundTrip(){
+    writeSnapshot();
+
+    ProbeSheet sheet;
+    QVERIFY(sheet.loadSnapshot(path("sheet.snapshot"),path("sheet.csv")));
+    QVERIFY(!sheet.isSnapshotPending());
+    QCOMPARE(sheet.central0IP.toString(),QString("192.168.1.10"));
+    QCOMPARE(sheet.central0Port.toUInt32(),4000u);
+    QCOMPARE(sheet.central0SNTP.toString(),QString("192.168.1.11"));
+    QCOMPARE(sheet.globalSNTP.toString(),QString("192.168.1.12"));
+    QCOMPARE(sheet.newUpdaterIP.toString(),QString("192.168.1.13"));
+    QCOMPARE(sheet.newUpdaterPort.toUInt32(),8080u);
+    QCOMPARE(sheet.probes.size(),2);
+    QCOMPARE(sheet.probes.firstKey(),30001u);
+    QCOMPARE(sheet.probes.value(30002).ip.toString(),QString("10.0.1.2"));
+    QCOMPARE(sheet.probes.value(30002).netmask.toString(),QString("255.255.255.0"));
+    QCOMPARE(sheet.probes.value(30002).gateway.toString(),QString("10.0.1.1"));
+    QCOMPARE(sheet.diagnostics.size(),2);
+    QVERIFY(sheet.diagnostics.at(0).contains("invalid Gateway"));
+    QVERIFY(sheet.diagnostics.at(1).contains("no serial"));
+
+    // Saved once per cold start only
+    QVERIFY(!sheet.saveSnapshot(path("sheet.snapshot"),path("sheet.csv")));
+}
+//------------------------------------------------------------------------------
+void StartupSnapshotTest::stale(){
+    writeSnapshot();
+
+    // Same size and modification time, another content: hashed, refused
+    QFile sheetFile(path("sheet.csv"));
+    QDateTime lastModified = QFileInfo(sheetFile).lastModified();
+    QByteArray data = readFile(path("sheet.csv"));
+    data[data.indexOf("10.0.1.2")+7] = '3';
+    QVERIFY(writeFile(path("sheet.csv"),data));
+    QVERIFY(sheetFile.open(QIODevice::ReadWrite));
+    QVERIFY(sheetFile.setFileTime(lastModified,QFileDevice::FileModificationTime));
+    sheetFile.close();
+    QCOMPARE(QFileInfo(path("sheet.csv")).lastModified(),lastModified);
+
+    ProbeSheet sheet;
+    QVERIFY(!sheet.loadSnapshot(path("sheet.snapshot"),path("sheet.csv")));
+    QVERIFY(sheet.isSnapshotPending());
+    QVERIFY(sheet.probes.isEmpty());
+
+    // Another sheet file of the same content
+    writeSnapshot();
+    QVERIFY(QFile::copy(path("sheet.csv"),path("copy.csv")));
+    QVERIFY(!sheet.loadSnapshot(path("sheet.snapshot"),path("copy.csv")));
+    QVERIFY(!sheet.loadSnapshot(path("sheet.snapshot"),"-"));
+}
+//------------------------------------------------------------------------------
+void StartupSnapshotTest::truncated(){
+    writeSnapshot();
+    const QByteArray data = readFile(path("sheet.snapshot"));
+    QVERIFY(!data.isEmpty());
+    for(int size=0;size<data.size();++size){
+        QVERIFY(writeFile(path("truncated.snapshot"),data.left(size)));
+        StartupSnapshot snapshot;
+        QVERIFY2(!snapshot.open(path("truncated.snapshot"),path("sheet.csv")),
+                 qPrintable(QString("truncated to %1 bytes").arg(size)));
+        QVERIFY(!snapshot.isOpen());
+    }
+}
+//------------------------------------------------------------------------------
+void StartupSnapshotTest::corrupted(){
+    // Native order: magic, version, byte order mark, probe count, the sheet
+    // fingerprint (size, lastModified, SHA-256) from 16, the globals from 64,
+    // sheet name and diagnostics sizes at 88, section offsets from 96 and
+    // the file size
+    writeSnapshot();
+    const QByteArray data = readFile(path("sheet.snapshot"));
+    struct Corruption {
+        const char *what;
+        int offset;
+        quint64 value;
+        bool wide;
+    };
+    static const Corruption corruptions[] = {
+        { "magic", 0, 0x4E53534C, false },
+        { "byte order mark", 8, 0x04030201, false },
+        { "probe count", 12, 0xffffffff, false },
+        { "probe count", 12, 0x10000000, false },
+        { "sheet size", 16, 1, true },
+        { "sha256", 32, 0, true },
+        { "sheet name size", 88, 0xffffffff, false },
+        { "diagnostics size", 92, 0xffffffff, false },
+        { "probes offset", 96, 0xfffffffffffffff0ull, true },
+        { "probes offset", 96, 130, true },
+        { "sheet name offset", 104, 0, true },
+        { "diagnostics offset", 112, 0xffffffffffffffffull, true },
+        { "file size", 120, 0, true },
+    };
+    for(size_t i=0;i<sizeof(corruptions)/sizeof(corruptions[0]);++i){
+        QByteArray bad = data;
+        if(corruptions[i].wide)
+            patch64(bad,corruptions[i].offset,corruptions[i].value);
+        else
+            patch32(bad,corruptions[i].offset,quint32(corruptions[i].value));
+        QVERIFY(writeFile(path("corrupted.snapshot"),bad));
+        StartupSnapshot snapshot;
+        QVERIFY2(!snapshot.open(path("corrupted.snapshot"),path("sheet.csv")),
+                 corruptions[i].what);
+    }
+
+    // Any single byte: refused, or used within the file (the probes and
+    // diagnostics are not checksummed, a change there is taken as is)
+    for(int i=0;i<data.size();++i){
+        QByteArray bad = data;
+        bad[i] = char(~bad.at(i));
+        QVERIFY(writeFile(path("corrupted.snapshot"),bad));
+        ProbeSheet sheet;
+        if(sheet.loadSnapshot(path("corrupted.snapshot"),path("sheet.csv")))
+            QVERIFY(sheet.probes.size()<=2);
+    }
+}
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+QString StartupSnapshotTest::path(const QString& name)const{
+    return _dir.filePath(name);
+}
+//------------------------------------------------------------------------------
+QByteArray StartupSnapshotTest::readFile(const QString& filename){
+    QFile file(filename);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+//------------------------------------------------------------------------------
+bool StartupSnapshotTest::writeFile(const QString& filename,
+    const QByteArray& data)
+{
+    QFile file(filename);
+    return file.open(QIODevice::WriteOnly | QIODevice::Truncate) &&
+           file.write(data)==data.size();
+}
+//------------------------------------------------------------------------------
+void StartupSnapshotTest::patch32(QByteArray& data, int offset, quint32 value){
+    if(offset+4<=data.size())
+        memcpy(data.data()+offset,&value,sizeof(value));
+}
+//------------------------------------------------------------------------------
+void StartupSnapshotTest::patch64(QByteArray& data, int offset, quint64 value){
+    if(offset+8<=data.size())
+        memcpy(data.data()+offset,&value,sizeof(value));
+}
+//------------------------------------------------------------------------------
+void StartupSnapshotTest::writeSnapshot(){
+    // As a cold start does it: fingerprint, read the sheet, save
+    QFile::remove(path("sheet.snapshot"));
+    QVERIFY(writeFile(path("sheet.csv"),
+                      "MIRA SN,PROBE IP,SUBNET MASK,GATEWAY\n"
+                      "30001,10.0.0.2,255.255.255.0,10.0.0.1\n"
+                      "30002,10.0.1.2,255.255.255.0,10.0.1.1\n"
+                      "30003,10.0.2.2,255.255.255.0,\n"));
+    ProbeSheet sheet;
+    QVERIFY(!sheet.loadSnapshot(path("sheet.snapshot"),path("sheet.csv")));
+    QVERIFY(sheet.isSnapshotPending());
+
+    sheet.central0IP = QString("192.168.1.10");
+    sheet.central0Port = 4000u;
+    sheet.central0SNTP = QString("192.168.1.11");
+    sheet.globalSNTP = QString("192.168.1.12");
+    sheet.newUpdaterIP = QString("192.168.1.13");
+    sheet.newUpdaterPort = 8080u;
+    ProbeConfig probeConfig;
+    probeConfig.netmask = QString("255.255.255.0");
+    probeConfig.serial = 30001;
+    probeConfig.ip = QString("10.0.0.2");
+    probeConfig.gateway = QString("10.0.0.1");
+    QVERIFY(sheet.addProbe(2,probeConfig));
+    probeConfig.serial = 30002;
+    probeConfig.ip = QString("10.0.1.2");
+    probeConfig.gateway = QString("10.0.1.1");
+    QVERIFY(sheet.addProbe(3,probeConfig));
+    probeConfig.serial = 30003;
+    probeConfig.ip = QString("10.0.2.2");
+    probeConfig.gateway = 0;
+    QVERIFY(!sheet.addProbe(4,probeConfig));
+    probeConfig.serial = 0;
+    QVERIFY(!sheet.addProbe(5,probeConfig));
+    QCOMPARE(sheet.diagnostics.size(),2);
+    QVERIFY(sheet.saveSnapshot(path("sheet.snapshot"),path("sheet.csv")));
+}
+//------------------------------------------------------------------------------
+
+QTEST_GUILESS_MAIN(StartupSnapshotTest)
+
+#include "startupSnapshotTest.moc"
@@ -0,0 +1,24 @@
+# Qt Test of the startup snapshot of the probe sheet: saved, loaded, made
+# stale, then truncated and corrupted copies, in a temporary directory. Built
+# by ../qMiraProbeXMLCheckAll.pro, after the core library it links; run by
+# 'make check'.
+
+QT += core testlib
+QT -= gui
+CONFIG += console c++14 testcase
+CONFIG -= app_bundle
+
+TARGET = startupSnapshotTest
+
+INCLUDEPATH += ..
+
+SOURCES += \
+        startupSnapshotTest.cpp \
+        ../probeSheet.cpp \
+        ../startupSnapshot.cpp
+
+HEADERS += \
+        ../probeSheet.h \
+        ../startupSnapshot.h
+
+include(../core/core.pri)
@@ -0,0 +1,141 @@
+#include "stationImage.h"
+
+#include <cstdio>
+#include <string>
+
+
+//------------------------------------------------------------------------------
+// Station image tests
+//------------------------------------------------------------------------------
+// A round trip of the core station image format, then every truncation and
+// a series of byte corruptions of the image: decoding either fails or gives
+// back the very same file, never anything else (and never reads out of the
+// buffers: run it under a sanitizer build too). Exit status is the number of
+// failed checks.
+//------------------------------------------------------------------------------
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition) check((condition),#condition,__LINE__)
+
+//------------------------------------------------------------------------------
+void check(bool condition, const char *text, int line){
+    if(!condition){
+        std::printf("FAIL line %d: %s\n",line,text);
+        ++failures;
+    }
+}
+//------------------------------------------------------------------------------
+const char station[] =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<ConfigurationEntries version=\"1.5.6\">\n"
+    "  <Category name=\"System\">\n"
+    "    <Entry name=\"SerialNr\" id=\"0x0101\" type=\"uint32\">30290</Entry>\n"
+    "    <Entry name=\"StationId\" id=\"0x0102\" type=\"uint32\">30290</Entry>\n"
+    "  </Category>\n"
+    "  <Category name=\"Devices\">\n"
+    "    <Category name=\"Ethernet\">\n"
+    "      <Entry name=\"UseDHCP\" id=\"0x2f0b\" type=\"bool\">1</Entry>\n"
+    "      <Entry name=\"StaticIp\" id=\"0x2f0c\">\n"
+    "        <Element name=\"Ip Address\" type=\"ipv4\">167772161</Element>\n"
+    "        <Element name=\"Subnet Mask\" type=\"ipv4\">16777215</Element>\n"
+    "        <Element name=\"Gateway\" type=\"ipv4\">-1062731519</Element>\n"
+    "        <Element name=\"Label\" type=\"string\">Site A &amp; B</Element>\n"
+    "      </Entry>\n"
+    "    </Category>\n"
+    "  </Category>\n"
+    "</ConfigurationEntries>\n";
+
+//------------------------------------------------------------------------------
+// Offset and length of the text of the element named name
+void valueAt(const std::string& document, const char *name, size_t& offset,
+             size_t& length){
+    size_t tag = document.find(std::string("name=\"")+name+'"');
+    offset = document.find('>',tag)+1;
+    length = document.find('<',offset)-offset;
+}
+//------------------------------------------------------------------------------
+// Deterministic byte corruption: count bytes of text replaced
+std::string corrupted(const std::string& text, uint32_t& seed, int count){
+    std::string result = text;
+    for(int i=0;i<count;++i){
+        seed = seed*1664525u+1013904223u;
+        size_t pos = (seed>>8)%result.size();
+        seed = seed*1664525u+1013904223u;
+        result[pos] = char(seed>>24);
+    }
+    return result;
+}
+//------------------------------------------------------------------------------
+void stationImage(){
+    const std::string document(station);
+
+    // Round trip, the file itself as the layout
+    StationImage image;
+    std::string data, decoded;
+    CHECK(image.compile(ByteView(document),data));
+    uint32_t layoutCrc = image.layoutCrc(), imageLayoutCrc = 0;
+    CHECK(StationImage::imageLayoutCrc(ByteView(data),imageLayoutCrc) &&
+          imageLayoutCrc==layoutCrc);
+    CHECK(data.size()<document.size());
+    CHECK(image.decode(ByteView(data),ByteView(document),decoded) &&
+          decoded==document);
+
+    // Any file with the same markup is the layout
+    std::string other = document;
+    size_t offset, length;
+    valueAt(other,"Gateway",offset,length);
+    other.replace(offset,length,"0");
+    valueAt(other,"Label",offset,length);
+    other.replace(offset,length,"Site C");
+    StationImage otherImage;
+    std::string otherData;
+    CHECK(otherImage.compile(ByteView(other),otherData) &&
+          otherImage.layoutCrc()==layoutCrc);
+    CHECK(image.decode(ByteView(data),ByteView(other),decoded) &&
+          decoded==document);
+    CHECK(image.decode(ByteView(otherData),ByteView(document),decoded) &&
+          decoded==other);
+
+    // Not with another markup
+    std::string foreign = document;
+    foreign.replace(foreign.find("name=\"Label\""),12,"name=\"Title\"");
+    CHECK(!image.decode(ByteView(data),ByteView(foreign),decoded));
+
+    // Same for a file size out of all proportion
+    std::string oversized = data;
+    oversized.replace(5,4,"\xff\xff\xff\xff");
+    CHECK(!image.decode(ByteView(oversized),ByteView(document),decoded));
+
+    // Truncated images
+    for(size_t size=0;size<data.size();++size)
+        CHECK(!image.decode(ByteView(data.data(),size),ByteView(document),decoded));
+
+    // Corrupted images: the file or nothing
+    uint32_t seed = 7;
+    for(int i=0;i<5000;++i){
+        std::string bad = corrupted(data,seed,1+i%3);
+        if(image.decode(ByteView(bad),ByteView(document),decoded))
+            CHECK(decoded==document);
+    }
+
+    // Truncated files: compiled or not, what compiles decodes back
+    for(size_t size=0;size<document.size();++size){
+        ByteView part(document.data(),size);
+        if(image.compile(part,data))
+            CHECK(image.decode(ByteView(data),part,decoded) &&
+                  ByteView(decoded)==part);
+    }
+}
+//------------------------------------------------------------------------------
+
+} // namespace
+
+//------------------------------------------------------------------------------
+int main(){
+    stationImage();
+    std::printf("%s: %d failed checks\n",failures ? "FAIL" : "PASS",failures);
+    return failures;
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,14 @@
+# Round trip, truncations and corruptions of the core library's station
+# image format (no Qt needed). Built by ../qMiraProbeXMLCheckAll.pro, after the
+# core library it links; run by 'make check' or on its own: ./stationImageTest
+# (exit status: failed checks).
+
+CONFIG += console c++14 testcase
+CONFIG -= qt app_bundle
+
+TARGET = stationImageTest
+
+SOURCES += \
+        stationImageTest.cpp
+
+include(../core/core.pri)
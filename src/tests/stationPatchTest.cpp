@@ -0,0 +1,142 @@
+#include "stationPatch.h"
+
+#include <cstdio>
+#include <string>
+
+
+//------------------------------------------------------------------------------
+// Station patch tests
+//------------------------------------------------------------------------------
+// A round trip of the core station patch format, then every truncation and
+// a series of byte corruptions of the patch text: applying it either fails or
+// gives back the very same fixed file, never anything else (and never reads
+// out of the buffers: run it under a sanitizer build too). Exit status is the
+// number of failed checks.
+//------------------------------------------------------------------------------
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition) check((condition),#condition,__LINE__)
+
+//------------------------------------------------------------------------------
+void check(bool condition, const char *text, int line){
+    if(!condition){
+        std::printf("FAIL line %d: %s\n",line,text);
+        ++failures;
+    }
+}
+//------------------------------------------------------------------------------
+const char station[] =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<ConfigurationEntries version=\"1.5.6\">\n"
+    "  <Category name=\"System\">\n"
+    "    <Entry name=\"SerialNr\" id=\"0x0101\" type=\"uint32\">30290</Entry>\n"
+    "    <Entry name=\"StationId\" id=\"0x0102\" type=\"uint32\">30290</Entry>\n"
+    "  </Category>\n"
+    "  <Category name=\"Devices\">\n"
+    "    <Category name=\"Ethernet\">\n"
+    "      <Entry name=\"UseDHCP\" id=\"0x2f0b\" type=\"bool\">1</Entry>\n"
+    "      <Entry name=\"StaticIp\" id=\"0x2f0c\">\n"
+    "        <Element name=\"Ip Address\" type=\"ipv4\">167772161</Element>\n"
+    "        <Element name=\"Subnet Mask\" type=\"ipv4\">16777215</Element>\n"
+    "        <Element name=\"Gateway\" type=\"ipv4\">-1062731519</Element>\n"
+    "        <Element name=\"Label\" type=\"string\">Site A &amp; B</Element>\n"
+    "      </Entry>\n"
+    "    </Category>\n"
+    "  </Category>\n"
+    "</ConfigurationEntries>\n";
+
+//------------------------------------------------------------------------------
+// Offset and length of the text of the element named name
+void valueAt(const std::string& document, const char *name, size_t& offset,
+             size_t& length){
+    size_t tag = document.find(std::string("name=\"")+name+'"');
+    offset = document.find('>',tag)+1;
+    length = document.find('<',offset)-offset;
+}
+//------------------------------------------------------------------------------
+// Deterministic byte corruption: count bytes of text replaced
+std::string corrupted(const std::string& text, uint32_t& seed, int count){
+    std::string result = text;
+    for(int i=0;i<count;++i){
+        seed = seed*1664525u+1013904223u;
+        size_t pos = (seed>>8)%result.size();
+        seed = seed*1664525u+1013904223u;
+        result[pos] = char(seed>>24);
+    }
+    return result;
+}
+//------------------------------------------------------------------------------
+void stationPatch(){
+    const std::string base(station);
+    size_t ipOffset, ipLength, gatewayOffset, gatewayLength;
+    valueAt(base,"Ip Address",ipOffset,ipLength);
+    valueAt(base,"Gateway",gatewayOffset,gatewayLength);
+    std::string expected = base;
+    expected.replace(gatewayOffset,gatewayLength,"-1062731263");
+    expected.replace(ipOffset,ipLength,"167772417");
+
+    StationPatch patch;
+    patch.begin(ByteView(base));
+    patch.add(ipOffset,ipLength,ByteView::fromCString("167772417"),
+              ByteView::fromCString("ConfigurationEntries(*)/Element(Ip Address)"));
+    patch.add(gatewayOffset,gatewayLength,ByteView::fromCString("-1062731263"),
+              ByteView::fromCString("ConfigurationEntries(*)/Element(Gateway)"));
+    patch.end();
+    CHECK(patch.resultSize()==expected.size());
+    CHECK(patch.resultCrc()==StationPatch::crc32(ByteView(expected)));
+    std::string text;
+    patch.write(text);
+
+    // Round trip
+    StationPatch read;
+    std::string result;
+    CHECK(read.read(ByteView(text)));
+    CHECK(read.hunks().size()==2);
+    CHECK(read.hunks().size()==2 && read.hunks()[0].entryId=="0x2f0c");
+    CHECK(read.apply(ByteView(base),result) && result==expected);
+
+    // Not onto another base file
+    std::string otherBase = base;
+    otherBase[base.size()-2] = ' ';
+    CHECK(!read.apply(ByteView(otherBase),result));
+    CHECK(!read.apply(ByteView(expected),result));
+
+    // A result size out of all proportion is refused, not allocated
+    std::string oversized = text;
+    size_t resultSize = oversized.find("result ")+7;
+    oversized.replace(resultSize,oversized.find(' ',resultSize)-resultSize,
+                      "9999999999999999");
+    StationPatch bad;
+    CHECK(bad.read(ByteView(oversized)) && !bad.apply(ByteView(base),result));
+
+    // Truncated: no shorter text gives the fixed file
+    for(size_t size=0;size<text.size();++size){
+        StationPatch truncated;
+        bool applied = truncated.read(ByteView(text.data(),size)) &&
+                       truncated.apply(ByteView(base),result);
+        CHECK(!applied);
+    }
+
+    // Corrupted: the fixed file or nothing (paths and entry ids are for
+    // people, a change there still applies)
+    uint32_t seed = 1;
+    for(int i=0;i<5000;++i){
+        StationPatch bad;
+        std::string badText = corrupted(text,seed,1+i%3);
+        if(bad.read(ByteView(badText)) && bad.apply(ByteView(base),result))
+            CHECK(result==expected);
+    }
+}
+//------------------------------------------------------------------------------
+
+} // namespace
+
+//------------------------------------------------------------------------------
+int main(){
+    stationPatch();
+    std::printf("%s: %d failed checks\n",failures ? "FAIL" : "PASS",failures);
+    return failures;
+}
+//------------------------------------------------------------------------------
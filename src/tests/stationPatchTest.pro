@@ -0,0 +1,14 @@
+# Round trip, truncations and corruptions of the core library's station
+# patch format (no Qt needed). Built by ../qMiraProbeXMLCheckAll.pro, after the
+# core library it links; run by 'make check' or on its own: ./stationPatchTest
+# (exit status: failed checks).
+
+CONFIG += console c++14 testcase
+CONFIG -= qt app_bundle
+
+TARGET = stationPatchTest
+
+SOURCES += \
+        stationPatchTest.cpp
+
+include(../core/core.pri)
@@ -0,0 +1,214 @@
+#include "traceRecorder.h"
+
+#ifdef EXPRIVIA_TRACE
+
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+
+//------------------------------------------------------------------------------
+// Recording data
+//------------------------------------------------------------------------------
+namespace {
+
+enum {
+    cChunkEvents = 4096,    // 128 KiB
+    cMaxChunks = 2048,      // 8M events per thread
+    cWriteBufferSize = 1<<20,
+};
+
+struct Event {
+    const char *name;
+    int64_t arg;            // -1: none
+    uint64_t begin;         // ns
+    uint64_t duration;      // ns
+};
+
+// Written by its own thread only; the exporter reads the first 'count'
+// events, published with release stores
+struct ThreadBuffer {
+    int tid;
+    const char *name;
+    std::unique_ptr<Event[]> chunks[cMaxChunks];
+    std::atomic<size_t> count;
+};
+
+std::atomic<bool> enabled;
+std::atomic<uint64_t> epoch;
+std::atomic<uint64_t> dropped;
+std::mutex registryMutex;
+
+thread_local ThreadBuffer *threadBuffer;
+
+//------------------------------------------------------------------------------
+std::vector<std::unique_ptr<ThreadBuffer>>& registry(){
+    static std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    return buffers;
+}
+//------------------------------------------------------------------------------
+ThreadBuffer& currentBuffer(){
+    if(!threadBuffer){
+        // Kept after the thread exits: its spans still get written
+        std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer());
+        std::lock_guard<std::mutex> lock(registryMutex);
+        buffer->tid = int(registry().size())+1;
+        buffer->name = nullptr;
+        threadBuffer = buffer.get();
+        registry().push_back(std::move(buffer));
+    }
+    return *threadBuffer;
+}
+//------------------------------------------------------------------------------
+bool flushTo(QFile& file, QByteArray& out){
+    bool ok = file.write(out)==out.size();
+    out.truncate(0);
+    return ok;
+}
+//------------------------------------------------------------------------------
+
+} // namespace
+
+
+//------------------------------------------------------------------------------
+// class TraceRecorder implementation
+//------------------------------------------------------------------------------
+// Span
+//------------------------------------------------------------------------------
+TraceRecorder::Span::Span(const char *name, int64_t arg) :
+    _name(enabled.load(std::memory_order_relaxed) ? name : nullptr),_arg(arg),
+    _begin(_name ? now() : 0)
+{
+}
+//------------------------------------------------------------------------------
+TraceRecorder::Span::~Span(){
+    if(_name)
+        record(_name,_arg,_begin,now());
+}
+//------------------------------------------------------------------------------
+// Accessors
+//------------------------------------------------------------------------------
+bool TraceRecorder::isEnabled(){
+    return enabled.load(std::memory_order_relaxed);
+}
+//------------------------------------------------------------------------------
+uint64_t TraceRecorder::eventCount(){
+    uint64_t count = 0;
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for(size_t i=0;i<registry().size();++i)
+        count += registry().at(i)->count.load(std::memory_order_acquire);
+    return count;
+}
+//------------------------------------------------------------------------------
+uint64_t TraceRecorder::droppedCount(){
+    return dropped.load();
+}
+//------------------------------------------------------------------------------
+// Methods
+//------------------------------------------------------------------------------
+void TraceRecorder::start(){
+    if(!epoch.load())
+        epoch.store(now());
+    enabled.store(true);
+}
+//------------------------------------------------------------------------------
+void TraceRecorder::stop(){
+    enabled.store(false);
+}
+//------------------------------------------------------------------------------
+void TraceRecorder::setThreadName(const char *name){
+    currentBuffer().name = name;
+}
+//------------------------------------------------------------------------------
+void TraceRecorder::record(const char *name, int64_t arg, uint64_t begin,
+    uint64_t end)
+{
+    ThreadBuffer& buffer = currentBuffer();
+    size_t count = buffer.count.load(std::memory_order_relaxed);
+    size_t chunk = count/cChunkEvents;
+    if(chunk>=cMaxChunks){
+        dropped.fetch_add(1,std::memory_order_relaxed);
+        return;
+    }
+    if(!buffer.chunks[chunk])
+        buffer.chunks[chunk].reset(new Event[cChunkEvents]);
+
+    Event& event = buffer.chunks[chunk][count%cChunkEvents];
+    event.name = name;
+    event.arg = arg;
+    event.begin = begin;
+    event.duration = end-begin;
+    buffer.count.store(count+1,std::memory_order_release);
+}
+//------------------------------------------------------------------------------
+uint64_t TraceRecorder::now(){
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+//------------------------------------------------------------------------------
+bool TraceRecorder::write(const QString& filename){
+    // Chrome trace "complete" events, timestamps in us since start()
+    QFile file(filename);
+    if(!file.open(QIODevice::Truncate | QIODevice::WriteOnly))
+        return false;
+
+    uint64_t origin = epoch.load();
+    QByteArray out;
+    out.reserve(cWriteBufferSize+256);
+    out += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,"
+           "\"args\":{\"name\":\"qMiraProbeXMLCheck\"}}";
+    bool ok = true;
+    char line[256];
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for(size_t b=0;ok && b<registry().size();++b){
+        const ThreadBuffer& buffer = *registry().at(b);
+        size_t count = buffer.count.load(std::memory_order_acquire);
+        if(buffer.name)
+            snprintf(line,sizeof(line),
+                     ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                     "\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                     buffer.tid,buffer.name);
+        else
+            snprintf(line,sizeof(line),
+                     ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                     "\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}",
+                     buffer.tid,buffer.tid);
+        out += line;
+
+        for(size_t i=0;ok && i<count;++i){
+            const Event& event = buffer.chunks[i/cChunkEvents][i%cChunkEvents];
+            uint64_t ts = event.begin>origin ? event.begin-origin : 0;
+            int length = snprintf(line,sizeof(line),
+                ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+                "\"ts\":%" PRIu64 ".%03u,\"dur\":%" PRIu64 ".%03u",
+                event.name,buffer.tid,ts/1000,unsigned(ts%1000),
+                event.duration/1000,unsigned(event.duration%1000));
+            out.append(line,length);
+            if(event.arg>=0){
+                length = snprintf(line,sizeof(line),
+                                  ",\"args\":{\"serial\":%" PRId64 "}",
+                                  event.arg);
+                out.append(line,length);
+            }
+            out += '}';
+            if(out.size()>=cWriteBufferSize)
+                ok = flushTo(file,out);
+        }
+    }
+    out += "\n]}\n";
+    ok = ok && flushTo(file,out);
+    file.close();
+    return ok && file.error()==QFile::NoError;
+}
+//------------------------------------------------------------------------------
+
+#endif // EXPRIVIA_TRACE
@@ -0,0 +1,74 @@
+#ifndef TRACERECORDER_H
+#define TRACERECORDER_H
+
+#include <cstdint>
+
+//------------------------------------------------------------------------------
+// Forwards
+//------------------------------------------------------------------------------
+class QString;
+
+
+//------------------------------------------------------------------------------
+// class TraceRecorder
+//------------------------------------------------------------------------------
+// Timeline tracing, compiled in with EXPRIVIA_TRACE and enabled at run time
+// (check --trace FILE): spans (run phases, station read/check/write, log
+// flushes, progress emissions...) are recorded with their thread and written
+// as Chrome trace JSON, to be opened in Perfetto or chrome://tracing.
+//
+// Every thread records into its own buffer of fixed size chunks, published
+// with a single release store: no lock nor shared cache line on the
+// recording path, which costs two clock reads and a 32 bytes store per span.
+// Recording stops at 8M spans per thread (the rest is counted as dropped).
+// Without EXPRIVIA_TRACE the macros expand to nothing.
+//------------------------------------------------------------------------------
+class TraceRecorder
+{
+    public:
+        // Types
+        class Span {
+        public:
+            explicit Span(const char *name, int64_t arg = -1);
+            ~Span();
+        private:
+            const char *_name; // nullptr: not recording
+            int64_t _arg;
+            uint64_t _begin;
+        };
+        // Accessors
+        static bool isEnabled();
+        static uint64_t eventCount();
+        static uint64_t droppedCount();
+        // Methods
+        static void start();
+        static void stop();
+        static void setThreadName(const char *name);
+        static void record(const char *name, int64_t arg, uint64_t begin,
+                           uint64_t end);
+        static uint64_t now(); // ns
+        static bool write(const QString& filename);
+    private:
+        // Private constructor (unimplemented!)
+        TraceRecorder();
+};
+
+
+//------------------------------------------------------------------------------
+// Span macros: 'name' must be a string literal (kept by pointer), 'arg' is
+// shown in the span details (station serial)
+//------------------------------------------------------------------------------
+#define TRACE_CONCAT2(a,b) a##b
+#define TRACE_CONCAT(a,b) TRACE_CONCAT2(a,b)
+
+#ifdef EXPRIVIA_TRACE
+#define TRACE_SPAN(name) \
+    TraceRecorder::Span TRACE_CONCAT(traceSpan,__LINE__)(name)
+#define TRACE_SPAN_ARG(name,arg) \
+    TraceRecorder::Span TRACE_CONCAT(traceSpan,__LINE__)(name,int64_t(arg))
+#else
+#define TRACE_SPAN(name)
+#define TRACE_SPAN_ARG(name,arg)
+#endif
+
+#endif // TRACERECORDER_H
@@ -0,0 +1,373 @@
+#include "typedValidator.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <QtEndian>
+#include <QXmlStreamAttributes>
+
+
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+namespace {
+
+inline bool isBlank(ushort c){
+    return c==' ' || c=='\t' || c=='\n' || c=='\r';
+}
+//------------------------------------------------------------------------------
+inline bool fourDigits(const ushort *p, quint32& value){
+    // SWAR over four UTF-16 lanes, first character in the low lane: every
+    // lane must be '0'..'9' (no bit above 0x7F, >= '0', < ':'); no carry
+    // crosses a lane since a lane is at most 0x7F + 0x7FD0.
+    quint64 chunk;
+    memcpy(&chunk,p,sizeof(chunk));
+    chunk = qFromLittleEndian(chunk);
+    const quint64 high = Q_UINT64_C(0x8000800080008000);
+    if((chunk & Q_UINT64_C(0xFF80FF80FF80FF80)) ||
+       ((chunk+Q_UINT64_C(0x7FD07FD07FD07FD0)) & high)!=high ||
+       ((chunk+Q_UINT64_C(0x7FC67FC67FC67FC6)) & high))
+        return false;
+    // d0 d1 d2 d3 -> (d0*10+d1) (d2*10+d3) -> d0d1*100+d2d3
+    quint64 digits = chunk-Q_UINT64_C(0x0030003000300030);
+    digits = (digits*10+(digits>>16)) & Q_UINT64_C(0x0000FFFF0000FFFF);
+    value = quint32(((digits*100)+(digits>>32)) & 0xFFFFFFFF);
+    return true;
+}
+
+} // namespace
+//------------------------------------------------------------------------------
+// class TypedValidator implementation
+//------------------------------------------------------------------------------
+// Static data
+//------------------------------------------------------------------------------
+const TypedValidator::TypeDef TypedValidator::_typeDefs[] = {
+    { "uint8",   tkInteger, 0,          0xFF,       0xFF },
+    { "int8",    tkInteger, -0x80,      0x7F,       0xFF },
+    { "uint16",  tkInteger, 0,          0xFFFF,     0xFFFF },
+    { "int16",   tkInteger, -0x8000,    0x7FFF,     0xFFFF },
+    { "uint32",  tkInteger, 0,          0xFFFFFFFF, 0xFFFFFFFF },
+    { "int32",   tkInteger, -0x80000000LL, 0x7FFFFFFF, 0xFFFFFFFF },
+    // Addresses are written as signed int32, ports and masks as unsigned
+    { "ipv4",    tkInteger, -0x80000000LL, 0xFFFFFFFF, 0xFFFFFFFF },
+    { "bool",    tkInteger, 0,          1,          1 },
+    { "float32", tkFloat,   0,          0,          0 },
+    { "string",  tkString,  0,          0,          0 },
+    { nullptr,   tkInteger, 0,          0,          0 },
+};
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+TypedValidator::TypedValidator() : _listCount(0), _openList(-1),
+    _openListDepth(0), _depth(0), _inId(false), _type(nullptr), _size(-1),
+    _list(-1), _bitmask(false), _valueSeen(false), _checkedValueCount(0),
+    _violationCount(0)
+{
+    _listCandidate.reserve(64);
+}
+//------------------------------------------------------------------------------
+// Methods
+//------------------------------------------------------------------------------
+void TypedValidator::beginStation(){
+    // Lists are defined by each file: the storage is kept, not the content
+    _listCount = 0;
+    _openList = -1;
+    _depth = 0;
+    _inId = false;
+    _listCandidate.truncate(0);
+    _type = nullptr;
+    _checkedValueCount = 0;
+    _violationCount = 0;
+}
+//------------------------------------------------------------------------------
+void TypedValidator::startElement(const QStringRef& tag,
+    const QXmlStreamAttributes& attributes)
+{
+    ++_depth;
+    _type = nullptr; // a parent with children holds no value itself
+
+    if(tag==QLatin1String("Id")){
+        // <IdList name="Intervals"><Id>, or <DirectoryLevels><Id>
+        if(_openList<0 && !_listCandidate.isEmpty()){
+            openList(_listCandidate);
+            _openListDepth = _depth-1;
+        }
+        _inId = _openList>=0;
+        return;
+    }
+    if(tag==QLatin1String("IdList")){
+        _listCandidate = attributes.value(QLatin1String("name")).toString();
+        return;
+    }
+    if(tag!=QLatin1String("Element") && tag!=QLatin1String("Entry")){
+        if(attributes.isEmpty())
+            _listCandidate = tag.toString();
+        else
+            _listCandidate.truncate(0);
+        return;
+    }
+
+    // One pass over the attributes: size="..." wins over EntrySize="..."
+    const TypeDef *type = nullptr;
+    int size = -1, entrySize = -1;
+    _list = -1;
+    _bitmask = false;
+    for(int i=0;i<attributes.size();++i){
+        const QStringRef name = attributes.at(i).name();
+        const QStringRef value = attributes.at(i).value();
+        if(name==QLatin1String("type"))
+            type = typeDef(value);
+        else if(name==QLatin1String("size") ||
+                name==QLatin1String("EntrySize")){
+            const QStringRef trimmed = value.trimmed();
+            qint64 declared;
+            if(parseInteger(trimmed.constData(),
+                            trimmed.constData()+trimmed.size(),declared) &&
+               declared>=0 && declared<=std::numeric_limits<int>::max())
+                (name.size()==4 ? size : entrySize) = int(declared);
+        }else if(name==QLatin1String("list"))
+            _list = findList(value);
+        else if(name==QLatin1String("editor"))
+            _bitmask = value==QLatin1String("bitmask");
+    }
+    _type = type;
+    _size = size>=0 ? size : entrySize;
+    _valueSeen = false;
+    _listCandidate.truncate(0);
+}
+//------------------------------------------------------------------------------
+TypedValidator::Violation TypedValidator::characters(const QStringRef& text){
+    if(_inId){
+        qint64 value;
+        const QStringRef trimmed = text.trimmed();
+        IdList& list = _lists[_openList];
+        if(parseInteger(trimmed.constData(),trimmed.constData()+trimmed.size(),
+                        value)){
+            list.values.append(value);
+            list.mask |= quint64(value);
+        }else
+            list.numeric = false;
+        return tvNone;
+    }
+    if(!_type)
+        return tvNone;
+    if(_type->kind==tkString){
+        _valueSeen = true;
+        return checkString(text);
+    }
+
+    // Blanks only: the indentation before the children of a parent
+    const QChar *p = text.constData(), *end = p+text.size();
+    while(p<end && isBlank(p->unicode()))
+        ++p;
+    if(p==end)
+        return tvNone;
+    _valueSeen = true;
+    return _type->kind==tkInteger ? checkIntegers(text) : checkFloats(text);
+}
+//------------------------------------------------------------------------------
+TypedValidator::Violation TypedValidator::endElement(){
+    Violation result = tvNone;
+    if(_inId)
+        _inId = false;
+    else if(_type && !_valueSeen && _type->kind!=tkString && _size>0)
+        result = violation(tvSize,QString::asprintf("no value, %d declared",
+                                                    _size));
+    if(_openList>=0 && _depth==_openListDepth)
+        closeList();
+    --_depth;
+    _type = nullptr;
+    return result;
+}
+//------------------------------------------------------------------------------
+bool TypedValidator::parseInteger(const QChar *begin, const QChar *end,
+    qint64& value)
+{
+    // Decimal or 0x hexadecimal, optionally signed; magnitudes beyond the
+    // int64 range saturate, so that they fail the type range check
+    const ushort *p = reinterpret_cast<const ushort *>(begin);
+    const ushort *e = reinterpret_cast<const ushort *>(end);
+    bool negative = false;
+    if(p<e && (*p=='-' || *p=='+'))
+        negative = *p++=='-';
+    if(p==e)
+        return false;
+
+    quint64 magnitude = 0;
+    bool saturated = false;
+    if(e-p>2 && p[0]=='0' && (p[1]=='x' || p[1]=='X')){
+        p += 2;
+        for(;p<e;++p){
+            ushort c = *p, digit;
+            if(c>='0' && c<='9')
+                digit = c-'0';
+            else if((c|0x20)>='a' && (c|0x20)<='f')
+                digit = (c|0x20)-'a'+10;
+            else
+                return false;
+            saturated |= magnitude>>60!=0;
+            magnitude = (magnitude<<4) | digit;
+        }
+    }else{
+        const ushort *digits = p;
+        while(p<e && *p=='0')
+            ++p;
+        // At most 19 significant digits fit, the rest is validated only
+        const ushort *significantEnd = e-p>19 ? p+19 : e;
+        saturated = significantEnd!=e;
+        while(significantEnd-p>=4){
+            quint32 four;
+            if(!fourDigits(p,four))
+                return false;
+            magnitude = magnitude*10000+four;
+            p += 4;
+        }
+        for(;p<e;++p){
+            if(*p<'0' || *p>'9')
+                return false;
+            if(p<significantEnd)
+                magnitude = magnitude*10+(*p-'0');
+        }
+        if(p==digits)
+            return false;
+    }
+
+    const quint64 limit = quint64(std::numeric_limits<qint64>::max());
+    if(saturated || magnitude>limit)
+        magnitude = limit;
+    value = negative ? -qint64(magnitude) : qint64(magnitude);
+    return true;
+}
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+const TypedValidator::TypeDef *TypedValidator::typeDef(const QStringRef& name){
+    for(const TypeDef *type=_typeDefs;type->name;++type)
+        if(name==QLatin1String(type->name))
+            return type;
+    return nullptr; // struct, begin, end: nothing to check
+}
+//------------------------------------------------------------------------------
+int TypedValidator::findList(const QStringRef& name)const{
+    for(int i=0;i<_listCount;++i){
+        const IdList& list = _lists.at(i);
+        if(list.name.size()==name.size() && list.name==name)
+            return list.numeric ? i : -1;
+    }
+    return -1;
+}
+//------------------------------------------------------------------------------
+void TypedValidator::openList(const QString& name){
+    if(_listCount==_lists.size())
+        _lists.resize(_listCount+1);
+    IdList& list = _lists[_listCount];
+    list.name = name;
+    list.values.resize(0);
+    list.mask = 0;
+    list.numeric = true;
+    _openList = _listCount++;
+}
+//------------------------------------------------------------------------------
+void TypedValidator::closeList(){
+    QVector<qint64>& values = _lists[_openList].values;
+    std::sort(values.begin(),values.end());
+    _openList = -1;
+}
+//------------------------------------------------------------------------------
+TypedValidator::Violation TypedValidator::checkIntegers(const QStringRef& text){
+    // Whitespace separated values: "0 1 2 255"
+    const QChar *p = text.constData(), *end = p+text.size();
+    int count = 0;
+    Violation result = tvNone;
+    while(true){
+        while(p<end && isBlank(p->unicode()))
+            ++p;
+        if(p==end)
+            break;
+        const QChar *token = p;
+        while(p<end && !isBlank(p->unicode()))
+            ++p;
+        ++count;
+        ++_checkedValueCount;
+        if(result!=tvNone)
+            continue;
+
+        qint64 value;
+        if(!parseInteger(token,p,value)){
+            result = violation(tvSyntax,QString::asprintf("'%s' is not a %s",
+                QString(token,int(p-token)).toLatin1().constData(),_type->name));
+        }else if(value<_type->min || value>_type->max){
+            result = violation(tvRange,QString::asprintf(
+                "%lld is out of the %s range [%lld,%lld]",(long long)value,
+                _type->name,(long long)_type->min,(long long)_type->max));
+        }else if(_list>=0){
+            const IdList& list = _lists.at(_list);
+            if(_bitmask ? (quint64(value) & _type->bits & ~list.mask)!=0
+                        : !std::binary_search(list.values.begin(),
+                                              list.values.end(),value))
+                result = violation(tvList,QString::asprintf(
+                    _bitmask ? "%lld has bits outside IdList '%s'"
+                             : "%lld is not in IdList '%s'",
+                    (long long)value,list.name.toLatin1().constData()));
+        }
+    }
+    if(result==tvNone && _size>=0 && count!=_size)
+        result = violation(tvSize,QString::asprintf("%d values, %d declared",
+                                                    count,_size));
+    return result;
+}
+//------------------------------------------------------------------------------
+TypedValidator::Violation TypedValidator::checkFloats(const QStringRef& text){
+    const QChar *p = text.constData(), *end = p+text.size();
+    int count = 0;
+    Violation result = tvNone;
+    while(true){
+        while(p<end && isBlank(p->unicode()))
+            ++p;
+        if(p==end)
+            break;
+        const QChar *token = p;
+        while(p<end && !isBlank(p->unicode()))
+            ++p;
+        ++count;
+        ++_checkedValueCount;
+        if(result!=tvNone)
+            continue;
+
+        bool ok;
+        const QStringRef value = text.mid(int(token-text.constData()),
+                                          int(p-token));
+        value.toFloat(&ok);
+        if(!ok){
+            value.toDouble(&ok);
+            result = ok ? violation(tvRange,QString::asprintf(
+                              "%s is out of the float32 range",
+                              value.toLatin1().constData()))
+                        : violation(tvSyntax,QString::asprintf(
+                              "'%s' is not a float32",
+                              value.toLatin1().constData()));
+        }
+    }
+    if(result==tvNone && _size>=0 && count!=_size)
+        result = violation(tvSize,QString::asprintf("%d values, %d declared",
+                                                    count,_size));
+    return result;
+}
+//------------------------------------------------------------------------------
+TypedValidator::Violation TypedValidator::checkString(const QStringRef& text){
+    // The size counts the terminator; files are single byte encoded
+    ++_checkedValueCount;
+    if(_size>=0 && text.size()>=_size)
+        return violation(tvSize,QString::asprintf(
+            "%d characters, at most %d fit",text.size(),_size>0 ? _size-1 : 0));
+    return tvNone;
+}
+//------------------------------------------------------------------------------
+TypedValidator::Violation TypedValidator::violation(Violation kind,
+    const QString& detail)
+{
+    ++_violationCount;
+    _detail = detail;
+    return kind;
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,104 @@
+#ifndef TYPEDVALIDATOR_H
+#define TYPEDVALIDATOR_H
+
+#include <QString>
+#include <QVector>
+
+//------------------------------------------------------------------------------
+// Forwards
+//------------------------------------------------------------------------------
+class QStringRef;
+class QXmlStreamAttributes;
+
+
+//------------------------------------------------------------------------------
+// class TypedValidator
+//------------------------------------------------------------------------------
+// Validates every typed value of a station file against its declarations,
+// fed with the tokens of the check pass: Element/Entry texts against the
+// range of their type="..." (uint8 ... int32, bool, ipv4, float32), the
+// number of values against size="..." (or EntrySize="..."), strings against
+// their size (terminator included) and values referencing a list="..."
+// against the Ids of that IdList collected earlier in the same file (the
+// union of its bits for editor="bitmask"). Types without a value range
+// (struct, begin, end) and lists that are not defined, or not numeric, are
+// not checked. Type ranges come from a static table and integers are parsed
+// four UTF-16 digits at a time.
+//------------------------------------------------------------------------------
+class TypedValidator
+{
+    public:
+        // Types
+        enum Violation {
+            tvNone,
+            tvSyntax,   // not a value of the declared type
+            tvRange,    // outside the range of the declared type
+            tvSize,     // value count or string length against the size
+            tvList,     // not in (or not a mask of) the referenced IdList
+        };
+        // Constructor
+        TypedValidator();
+        // Accessors
+        inline const QString& detail()const { return _detail; }
+        inline uint checkedValueCount()const { return _checkedValueCount; }
+        inline uint violationCount()const { return _violationCount; }
+        // Methods
+        void beginStation();
+        void startElement(const QStringRef& tag,
+                          const QXmlStreamAttributes& attributes);
+        Violation characters(const QStringRef& text);
+        Violation endElement();
+        static bool parseInteger(const QChar *begin, const QChar *end,
+                                 qint64& value);
+    private:
+        // Types
+        enum TypeKind {
+            tkInteger,
+            tkFloat,
+            tkString,
+        };
+        struct TypeDef {
+            const char *name;
+            TypeKind kind;
+            qint64 min;
+            qint64 max;
+            quint64 bits;   // value bits a bitmask may use
+        };
+        struct IdList {
+            QString name;
+            QVector<qint64> values; // sorted once the list is complete
+            quint64 mask;           // union of the values
+            bool numeric;
+        };
+        // Data
+        static const TypeDef _typeDefs[];
+        QVector<IdList> _lists; // kept from one station to the next
+        int _listCount;
+        int _openList;          // collecting Ids, -1: none
+        int _openListDepth;
+        int _depth;
+        bool _inId;
+        QString _listCandidate; // name of the list Ids would belong to
+        const TypeDef *_type;   // value to check, null: none
+        int _size;              // declared size, -1: none
+        int _list;              // referenced list, -1: none
+        bool _bitmask;
+        bool _valueSeen;
+        uint _checkedValueCount;
+        uint _violationCount;
+        QString _detail;
+        // Private copy constructor and assignment (unimplemented!)
+        TypedValidator(const TypedValidator&);
+        TypedValidator& operator=(const TypedValidator&);
+        // Helpers
+        static const TypeDef *typeDef(const QStringRef& name);
+        int findList(const QStringRef& name)const;
+        void openList(const QString& name);
+        void closeList();
+        Violation checkIntegers(const QStringRef& text);
+        Violation checkFloats(const QStringRef& text);
+        Violation checkString(const QStringRef& text);
+        Violation violation(Violation kind, const QString& detail);
+};
+
+#endif // TYPEDVALIDATOR_H
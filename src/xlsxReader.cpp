@@ -0,0 +1,458 @@
+#include "xlsxReader.h"
+
+#include "stationPatch.h"
+#include <QtEndian>
+
+
+//------------------------------------------------------------------------------
+// Zip container layout (APPNOTE.TXT, little endian)
+//------------------------------------------------------------------------------
+namespace {
+
+enum {
+    cEndOfCentralDirSignature   = 0x06054b50,
+    cEndOfCentralDirSize        = 22,
+    cMaxCommentSize             = 0xFFFF,
+    cCentralDirEntrySignature   = 0x02014b50,
+    cCentralDirEntrySize        = 46,
+    cLocalHeaderSignature       = 0x04034b50,
+    cLocalHeaderSize            = 30,
+    cMethodStored               = 0,
+    cMethodDeflated             = 8,
+    cFlagEncrypted              = 0x0001,
+};
+
+// Spreadsheet limits: columns A to XFD, and the smallest shared string
+// ("<si/>") for sizing the table
+enum {
+    cMaxColumnCount             = 16384,
+    cMinSharedStringSize        = 5,
+};
+
+inline quint16 u16(const char *data){
+    return qFromLittleEndian<quint16>(reinterpret_cast<const uchar *>(data));
+}
+inline quint32 u32(const char *data){
+    return qFromLittleEndian<quint32>(reinterpret_cast<const uchar *>(data));
+}
+
+const QString relationshipsNamespace =
+    "http://schemas.openxmlformats.org/officeDocument/2006/relationships";
+
+} // namespace
+
+
+//------------------------------------------------------------------------------
+// class XlsxReader::EntryDevice implementation
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+XlsxReader::EntryDevice::EntryDevice(QFile& zip) : _zip(zip), _offset(0),
+    _compressedLeft(0), _size(0), _sizeRead(0), _crc(0), _entryCrc(0),
+    _deflated(false), _corrupted(false)
+{
+}
+//------------------------------------------------------------------------------
+// Accessors
+//------------------------------------------------------------------------------
+qint64 XlsxReader::EntryDevice::size()const{
+    return _size;
+}
+//------------------------------------------------------------------------------
+// Methods
+//------------------------------------------------------------------------------
+bool XlsxReader::EntryDevice::openEntry(const Entry& entry){
+    close();
+
+    char header[cLocalHeaderSize];
+    if(!_zip.seek(entry.headerOffset) ||
+       _zip.read(header,cLocalHeaderSize)!=cLocalHeaderSize ||
+       u32(header)!=cLocalHeaderSignature)
+        return false;
+
+    // Sizes come from the central directory: the local ones may be deferred
+    // to a data descriptor
+    _offset = entry.headerOffset+cLocalHeaderSize+u16(header+26)+u16(header+28);
+    _compressedLeft = entry.compressedSize;
+    _size = entry.size;
+    _sizeRead = 0;
+    _crc = 0;
+    _entryCrc = entry.crc;
+    _deflated = entry.method==cMethodDeflated;
+    _corrupted = false;
+    if(_deflated)
+        _inflater.reset(&readCompressed,this);
+    return QIODevice::open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+qint64 XlsxReader::EntryDevice::readData(char *data, qint64 maxSize){
+    if(_corrupted)
+        return -1;
+    uint8_t *out = reinterpret_cast<uint8_t *>(data);
+    long produced = _deflated ? _inflater.read(out,size_t(maxSize)) :
+                                long(readCompressed(this,out,size_t(maxSize)));
+    if(produced<0 || quint64(produced)>_size-_sizeRead){
+        _corrupted = true;
+        return -1;
+    }
+    _sizeRead += quint32(produced);
+    _crc = StationPatch::crc32(ByteView(data,size_t(produced)),_crc);
+
+    // At the end of the data (stored data cut short ends there too), what
+    // the central directory says it is: zip uses the CRC-32 of the station
+    // patches
+    bool atEnd = _deflated ? _inflater.atEnd() : !_compressedLeft || !produced;
+    if(atEnd && (_sizeRead!=_size || _crc!=_entryCrc)){
+        _corrupted = true;
+        return -1;
+    }
+    return produced;
+}
+//------------------------------------------------------------------------------
+qint64 XlsxReader::EntryDevice::writeData(const char *data, qint64 maxSize){
+    Q_UNUSED(data)
+    Q_UNUSED(maxSize)
+    return -1;
+}
+//------------------------------------------------------------------------------
+size_t XlsxReader::EntryDevice::readCompressed(void *opaque, uint8_t *buffer,
+    size_t size)
+{
+    EntryDevice *device = static_cast<EntryDevice *>(opaque);
+    if(size>device->_compressedLeft)
+        size = device->_compressedLeft;
+    if(!size || !device->_zip.seek(device->_offset))
+        return 0;
+    qint64 read = device->_zip.read(reinterpret_cast<char *>(buffer),qint64(size));
+    if(read<=0)
+        return 0;
+    device->_offset += read;
+    device->_compressedLeft -= quint32(read);
+    return size_t(read);
+}
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+// class XlsxReader implementation
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+XlsxReader::XlsxReader() : _entryDevice(_zip), _rowNumber(0), _columnCount(0)
+{
+}
+//------------------------------------------------------------------------------
+// Accessors
+//------------------------------------------------------------------------------
+const QString& XlsxReader::errorString()const{
+    return _errorString;
+}
+//------------------------------------------------------------------------------
+int XlsxReader::rowNumber()const{
+    return _rowNumber;
+}
+//------------------------------------------------------------------------------
+// Methods
+//------------------------------------------------------------------------------
+bool XlsxReader::open(const QString& filename){
+    close();
+
+    _zip.setFileName(filename);
+    if(!_zip.open(QIODevice::ReadOnly))
+        return fail("Cannot open "+filename);
+
+    QString sheetName, sharedStringsName;
+    if(!readCentralDirectory() ||
+       !findFirstSheet(sheetName,sharedStringsName) ||
+       !readSharedStrings(sharedStringsName) ||
+       !openEntry(sheetName))
+        return false;
+
+    // Leave the reader on the rows container
+    while(!_xml.atEnd())
+        if(_xml.readNext()==QXmlStreamReader::StartElement &&
+           _xml.name()==QLatin1String("sheetData"))
+            return true;
+    return _xml.hasError() ? failXml() : fail(sheetName+": no sheet data");
+}
+//------------------------------------------------------------------------------
+void XlsxReader::close(){
+    _xml.clear();
+    _entryDevice.close();
+    _zip.close();
+    _entries.clear();
+    _entryName.clear();
+    _sharedStrings.clear();
+    _errorString.clear();
+    _rowNumber = 0;
+    _columnCount = 0;
+}
+//------------------------------------------------------------------------------
+bool XlsxReader::readRow(QStringList& row){
+    // Returns false at the end of the sheet or on error (errorString() set)
+    row.clear();
+    while(!_xml.atEnd()){
+        QXmlStreamReader::TokenType token = _xml.readNext();
+        if(token==QXmlStreamReader::EndElement &&
+           _xml.name()==QLatin1String("sheetData")){
+            readEntryToEnd();
+            return false;
+        }
+        if(token!=QXmlStreamReader::StartElement ||
+           _xml.name()!=QLatin1String("row"))
+            continue;
+
+        // Empty rows are not stored at all: r tells which one this is
+        bool ok;
+        int rowNumber = _xml.attributes().value(QLatin1String("r")).toInt(&ok);
+        _rowNumber = ok ? rowNumber : _rowNumber+1;
+
+        int column = -1;
+        while(_xml.readNextStartElement()){
+            if(_xml.name()!=QLatin1String("c")){
+                _xml.skipCurrentElement();
+                continue;
+            }
+            QXmlStreamAttributes attributes = _xml.attributes();
+            int cellColumn = columnIndex(attributes.value(QLatin1String("r")));
+            column = cellColumn>column ? cellColumn : column+1;
+            if(column>=cMaxColumnCount)
+                return fail(QString("%1: row %2, cell past column XFD")
+                            .arg(_entryName).arg(_rowNumber));
+            QStringRef type = attributes.value(QLatin1String("t"));
+
+            QString value;
+            while(_xml.readNextStartElement()){
+                if(_xml.name()==QLatin1String("v"))
+                    value = _xml.readElementText();
+                else if(_xml.name()==QLatin1String("is"))
+                    value = readRichText();
+                else
+                    _xml.skipCurrentElement();
+            }
+
+            if(type==QLatin1String("s")){
+                int index = value.toInt(&ok);
+                if(!ok || index<0 || index>=_sharedStrings.size())
+                    return fail(QString("%1: row %2, invalid shared string index")
+                                .arg(_entryName).arg(_rowNumber));
+                value = _sharedStrings.at(index);
+            }else if(type==QLatin1String("b"))
+                value = value==QLatin1String("1") ? "TRUE" : "FALSE";
+
+            while(row.size()<column)
+                row.append(QString());
+            row.append(value);
+        }
+        if(_xml.hasError())
+            break;
+
+        if(row.size()>_columnCount)
+            _columnCount = row.size();
+        while(row.size()<_columnCount)
+            row.append(QString());
+        return true;
+    }
+    if(_xml.hasError())
+        failXml();
+    return false;
+}
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+bool XlsxReader::fail(const QString& msg){
+    _errorString = msg;
+    return false;
+}
+//------------------------------------------------------------------------------
+bool XlsxReader::failXml(){
+    if(_entryDevice.corrupted())
+        return fail(_entryName+": corrupted compressed data");
+    return fail(QString("%1: %2 (line %3)").arg(_entryName,_xml.errorString())
+                .arg(_xml.lineNumber()));
+}
+//------------------------------------------------------------------------------
+bool XlsxReader::readCentralDirectory(){
+    // The end of central directory record closes the file, followed only by
+    // an optional comment
+    qint64 fileSize = _zip.size();
+    qint64 tailSize = qMin<qint64>(fileSize,cEndOfCentralDirSize+cMaxCommentSize);
+    if(tailSize<cEndOfCentralDirSize || !_zip.seek(fileSize-tailSize))
+        return fail(_zip.fileName()+": not a zip file");
+    QByteArray tail = _zip.read(tailSize);
+    int end = tail.size()-cEndOfCentralDirSize;
+    while(end>=0 && u32(tail.constData()+end)!=cEndOfCentralDirSignature)
+        --end;
+    if(end<0)
+        return fail(_zip.fileName()+": not a zip file");
+
+    const char *record = tail.constData()+end;
+    quint16 entryCount = u16(record+10);
+    quint32 directorySize = u32(record+12);
+    quint32 directoryOffset = u32(record+16);
+    if(entryCount==0xFFFF || directoryOffset==0xFFFFFFFF)
+        return fail(_zip.fileName()+": ZIP64 archives are not supported");
+
+    // Both from the record: within the file, before the record itself
+    if(qint64(directoryOffset)+directorySize>fileSize-tailSize+end)
+        return fail(_zip.fileName()+": corrupted central directory");
+    if(!_zip.seek(directoryOffset))
+        return fail(_zip.fileName()+": truncated central directory");
+    QByteArray directory = _zip.read(directorySize);
+    if(qint64(directory.size())!=qint64(directorySize))
+        return fail(_zip.fileName()+": truncated central directory");
+
+    _entries.reserve(entryCount);
+    int pos = 0;
+    for(uint i=0;i<entryCount;++i){
+        const char *header = directory.constData()+pos;
+        if(pos+cCentralDirEntrySize>directory.size() ||
+           u32(header)!=cCentralDirEntrySignature)
+            return fail(_zip.fileName()+": corrupted central directory");
+        int nameLength = u16(header+28);
+        int nextPos = pos+cCentralDirEntrySize+nameLength+u16(header+30)+
+                      u16(header+32);
+        if(nextPos>directory.size())
+            return fail(_zip.fileName()+": corrupted central directory");
+
+        Entry entry;
+        entry.flags = u16(header+8);
+        entry.method = u16(header+10);
+        entry.compressedSize = u32(header+20);
+        entry.size = u32(header+24);
+        entry.crc = u32(header+16);
+        entry.headerOffset = u32(header+42);
+        _entries.insert(QString::fromUtf8(header+cCentralDirEntrySize,nameLength),
+                        entry);
+        pos = nextPos;
+    }
+    return true;
+}
+//------------------------------------------------------------------------------
+bool XlsxReader::openEntry(const QString& name){
+    _entryName = name;
+    QHash<QString,Entry>::const_iterator it = _entries.constFind(name);
+    if(it==_entries.constEnd())
+        return fail(_zip.fileName()+": missing "+name);
+    if(it->flags & cFlagEncrypted)
+        return fail(name+": encrypted entries are not supported");
+    if(it->method!=cMethodStored && it->method!=cMethodDeflated)
+        return fail(QString("%1: unsupported compression method %2")
+                    .arg(name).arg(it->method));
+    if(!_entryDevice.openEntry(*it))
+        return fail(name+": cannot read entry");
+    _xml.setDevice(&_entryDevice);
+    return true;
+}
+//------------------------------------------------------------------------------
+bool XlsxReader::readEntryToEnd(){
+    // What the XML reader left of the entry: its size and CRC-32 are checked
+    // with the last bytes
+    char buffer[4096];
+    qint64 read;
+    while((read=_entryDevice.read(buffer,sizeof(buffer)))>0)
+        ;
+    return read<0 ? fail(_entryName+": corrupted compressed data") : true;
+}
+//------------------------------------------------------------------------------
+bool XlsxReader::findFirstSheet(QString& sheetName, QString& sharedStringsName){
+    QString sheetId;
+    if(!openEntry("xl/workbook.xml"))
+        return false;
+    while(!_xml.atEnd() && sheetId.isEmpty())
+        if(_xml.readNext()==QXmlStreamReader::StartElement &&
+           _xml.name()==QLatin1String("sheet"))
+            sheetId = _xml.attributes().value(relationshipsNamespace,
+                                              QLatin1String("id")).toString();
+    if(_xml.hasError())
+        return failXml();
+    if(!readEntryToEnd())
+        return false;
+
+    // Relationship targets are relative to the workbook part
+    if(!openEntry("xl/_rels/workbook.xml.rels"))
+        return false;
+    while(!_xml.atEnd()){
+        if(_xml.readNext()!=QXmlStreamReader::StartElement ||
+           _xml.name()!=QLatin1String("Relationship"))
+            continue;
+        QXmlStreamAttributes attributes = _xml.attributes();
+        QString target = attributes.value(QLatin1String("Target")).toString();
+        target = target.startsWith('/') ? target.mid(1) : "xl/"+target;
+        if(!sheetId.isEmpty() && attributes.value(QLatin1String("Id"))==sheetId)
+            sheetName = target;
+        else if(attributes.value(QLatin1String("Type")).endsWith(
+                    QLatin1String("/sharedStrings")))
+            sharedStringsName = target;
+    }
+    if(_xml.hasError())
+        return failXml();
+    if(!readEntryToEnd())
+        return false;
+
+    if(sheetName.isEmpty())
+        sheetName = "xl/worksheets/sheet1.xml";
+    return true;
+}
+//------------------------------------------------------------------------------
+bool XlsxReader::readSharedStrings(const QString& name){
+    // Workbooks without any text cell have none
+    if(name.isEmpty())
+        return true;
+    if(!openEntry(name))
+        return false;
+    while(!_xml.atEnd()){
+        QXmlStreamReader::TokenType token = _xml.readNext();
+        if(token==QXmlStreamReader::StartElement){
+            if(_xml.name()==QLatin1String("si"))
+                _sharedStrings.append(readRichText());
+            else if(_xml.name()==QLatin1String("sst")){
+                // The count is the file's word: no more than the entry holds
+                qint64 count = _xml.attributes().value(
+                                   QLatin1String("uniqueCount")).toInt();
+                count = qMin(count,_entryDevice.size()/cMinSharedStringSize);
+                if(count>0)
+                    _sharedStrings.reserve(int(count));
+            }
+        }
+    }
+    return _xml.hasError() ? failXml() : readEntryToEnd();
+}
+//------------------------------------------------------------------------------
+QString XlsxReader::readRichText(){
+    // Plain (<t>) or rich (<r><rPr/><t/></r>...) text of the current <si> or
+    // <is> element, phonetic runs (<rPh>) left out
+    QString text;
+    int depth = 0;
+    while(!_xml.atEnd()){
+        QXmlStreamReader::TokenType token = _xml.readNext();
+        if(token==QXmlStreamReader::StartElement){
+            if(_xml.name()==QLatin1String("t"))
+                text += _xml.readElementText();
+            else if(_xml.name()==QLatin1String("rPh"))
+                _xml.skipCurrentElement();
+            else
+                ++depth;
+        }else if(token==QXmlStreamReader::EndElement && !depth--)
+            break;
+    }
+    return text;
+}
+//------------------------------------------------------------------------------
+int XlsxReader::columnIndex(const QStringRef& cellRef){
+    // "A1" is 0, "Z7" 25, "AA3" 26...; -1 without a column, cMaxColumnCount
+    // past XFD
+    int index = 0;
+    for(int i=0;i<cellRef.size();++i){
+        ushort ch = cellRef.at(i).unicode();
+        if(ch<'A' || ch>'Z')
+            break;
+        index = index*26+(ch-'A'+1);
+        if(index>cMaxColumnCount)
+            return cMaxColumnCount;
+    }
+    return index-1;
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,100 @@
+#ifndef XLSXREADER_H
+#define XLSXREADER_H
+
+#include <QFile>
+#include <QHash>
+#include <QIODevice>
+#include <QStringList>
+#include <QXmlStreamReader>
+#include "inflater.h"
+
+
+//------------------------------------------------------------------------------
+// class XlsxReader
+//------------------------------------------------------------------------------
+// Row by row reader of the first worksheet of an .xlsx workbook, straight
+// from the zip container: the sheet XML is inflated while QXmlStreamReader
+// pulls it, so memory use does not grow with the row count (only the shared
+// strings table is kept). Cells are placed by their column reference, missing
+// ones are empty; every row is padded to the widest one read so far, header
+// included. Values are the cells' text as stored: shared/inline strings
+// resolved, numbers unformatted. Every entry read is checked against the
+// size and CRC-32 of its central directory record, once read to its end.
+// ZIP64 and encrypted containers are not supported.
+//------------------------------------------------------------------------------
+class XlsxReader
+{
+    public:
+        // Constructor
+        XlsxReader();
+        // Accessors
+        const QString& errorString()const;
+        int rowNumber()const; // of the last row read, 1 based
+        // Methods
+        bool open(const QString& filename);
+        void close();
+        bool readRow(QStringList& row);
+    private:
+        // Types
+        struct Entry {
+            qint64 headerOffset;
+            quint32 compressedSize;
+            quint32 size;
+            quint32 crc;
+            quint16 method;
+            quint16 flags;
+        };
+        class EntryDevice : public QIODevice {
+            public:
+                // Constructor
+                EntryDevice(QFile& zip);
+                // Accessors
+                virtual qint64 size()const;
+                inline bool corrupted()const { return _corrupted; }
+                // Methods
+                bool openEntry(const Entry& entry);
+            protected:
+                virtual qint64 readData(char *data, qint64 maxSize);
+                virtual qint64 writeData(const char *data, qint64 maxSize);
+            private:
+                // Data
+                QFile& _zip;
+                qint64 _offset;
+                quint32 _compressedLeft;
+                quint32 _size;
+                quint32 _sizeRead;
+                quint32 _crc;
+                quint32 _entryCrc;
+                bool _deflated;
+                bool _corrupted;
+                Inflater _inflater;
+                // Helpers
+                static size_t readCompressed(void *opaque, uint8_t *buffer,
+                                             size_t size);
+        };
+        // Data
+        QFile _zip;
+        QHash<QString,Entry> _entries;
+        EntryDevice _entryDevice;
+        QXmlStreamReader _xml;
+        QString _entryName;
+        QStringList _sharedStrings;
+        QString _errorString;
+        int _rowNumber;
+        int _columnCount;
+        // Private copy constructor and assignment (unimplemented!)
+        XlsxReader(const XlsxReader&);
+        XlsxReader& operator=(const XlsxReader&);
+        // Helpers
+        bool fail(const QString& msg);
+        bool failXml();
+        bool readCentralDirectory();
+        bool openEntry(const QString& name);
+        bool readEntryToEnd();
+        bool findFirstSheet(QString& sheetName, QString& sharedStringsName);
+        bool readSharedStrings(const QString& name);
+        QString readRichText();
+        static int columnIndex(const QStringRef& cellRef);
+};
+
+#endif // XLSXREADER_H